@@ -31,20 +31,143 @@
 #include <iostream>
 #include <fstream>
 #include <cassert>
+#include <cstring>
+#include <algorithm>
+#include <map>
+#include <vector>
+#include <unordered_map>
+#include <mutex>
+#include <chrono>
 
 #include "dxcallback.h"
 
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <ctime>
+
 #ifdef _WINDOWS
   #include <windows.h>
+  #include <io.h>
 #else
   #include "IBM_SPSS_Copyright.h"
+  #include <unistd.h>
 #endif
 
 #if UNX_LINUX || UNX_MACOSX
 #include <pthread.h>
 #include <stdio.h>
+#include <dlfcn.h>
 #endif
 
+// compiled program blocks, keyed by nest level and source.
+struct CodeKey {
+    int         nestLevel;
+    std::string source;
+
+    bool operator==(const CodeKey& other) const {
+        return nestLevel == other.nestLevel && source == other.source;
+    }
+};
+
+struct CodeKeyHash {
+    size_t operator()(const CodeKey& key) const {
+        return std::hash<std::string>()(key.source) ^ ((size_t)key.nestLevel * 0x9e3779b9);
+    }
+};
+
+typedef std::unordered_map<CodeKey, PyObject*, CodeKeyHash> CodeCache;
+
+static CodeCache codeCache;
+static const size_t CODE_CACHE_MAX = 64;
+
+// compiled script files of Execute_Python_Ex, by path. A file whose size and modification
+// time are unchanged is not read again. Otherwise it is read, and compiled again only when
+// its text hashes differently. st_mtime has one-second resolution, so a file modified in
+// the last two seconds is always read, an edit later in the same second is not missed.
+typedef struct {
+    long long   size;
+    time_t      modified;
+    size_t      sourceHash;
+    PyObject*   code;
+} ScriptEntry;
+
+static std::map<std::string, ScriptEntry> scriptCache;
+
+// preaction.start and postaction.end of the main interpreter, kept by the WarmStart mode.
+static PyObject* preactionStart = NULL;
+static PyObject* postactionEnd = NULL;
+
+// a sub-interpreter kept for one nest level.
+typedef struct {
+    PyThreadState*              threadState;    // made with the interpreter by init_embedded_x
+    std::vector<PyThreadState*> threadStates;   // made for the other threads that run the nest level
+    CodeCache                   codeCache;
+} NestInterpreter;
+
+// the pool of SubInterpreters, created by init_embedded_x and ended by stop_embedded_x.
+static std::vector<NestInterpreter*> nestInterpreters;
+static int nestPoolGeneration = 0;         // counts the pools created
+
+// the thread states of this thread in the sub-interpreters, by nest level.
+typedef struct {
+    int                         generation;     // the nestPoolGeneration of threadStates
+    std::vector<PyThreadState*> threadStates;
+} NestThreadStates;
+
+static thread_local NestThreadStates nestThreadStates;
+
+// the [InvokePython] section of spssdxcfg.ini.
+static std::map<std::string, std::string> configValues;
+static bool configLoaded = false;
+
+// held only while the interpreter itself changes: Py_Initialize, Py_Finalize and the sub-interpreters.
+static std::mutex transitionMutex;
+
+// LockMode in spssdxcfg.ini. 0 serializes sessions with the library lock,
+// 1 serializes only the program blocks, from pre_action to post_action, with blockMutex.
+// A block changes state that every interpreter thread sees: sys.stdout and sys.stderr,
+// the output buffer, the sub-interpreters and the module state of PyInvokeSpss. Those
+// are the interpreter-global transitions, so a block holds the mutex while it runs and
+// a session between blocks does not hold up the others.
+static int lockMode = -1;
+static std::mutex blockMutex;
+static std::vector<PyObject*> topLevelDicts;   // the topLevelDict of every session, released by stop_embedded_x
+static unsigned long initThread = 0;
+static PyThreadState* initThreadState = NULL;
+static int pythonGeneration = 0;       // counts Py_Initialize calls
+
+// the state of the session running on this thread.
+typedef struct {
+    int         callDepth;          // entry points on the stack of this thread
+    int         lockDepth;          // GetLibraryLock calls not yet released
+    bool        inBlock;            // blockMutex is held for this thread, when LockMode=1
+    int         blockNestLevel;     // the nest level of the block that took blockMutex
+    PyObject*   topLevelDict;       // the namespace of top-level blocks, when LockMode=1, borrowed from topLevelDicts
+    int         generation;         // the pythonGeneration of topLevelDict
+    std::chrono::steady_clock::time_point lockedAt;
+} SessionState;
+
+static thread_local SessionState session = {0, 0, false, 0, NULL, 0, std::chrono::steady_clock::time_point()};
+
+// holds the GIL for the calling thread while an entry point runs.
+class PythonCall {
+public:
+    PythonCall() : ensured(false) {
+        if(session.callDepth++ == 0 && Py_IsInitialized()) {
+            gilState = PyGILState_Ensure();
+            ensured = true;
+        }
+    }
+    ~PythonCall() {
+        if(--session.callDepth == 0 && ensured && Py_IsInitialized()) {
+            PyGILState_Release(gilState);
+        }
+    }
+private:
+    bool             ensured;
+    PyGILState_STATE gilState;
+};
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -52,11 +175,14 @@ extern "C" {
 #ifdef _WINDOWS
 
 HANDLE hMutex = NULL;
+HINSTANCE hModule = NULL;
 
 // dll entry point for Windows
 BOOL WINAPI DllMain (HINSTANCE hinstDLL, DWORD fdwReason, LPVOID lpvReserved)
 {
     if (fdwReason == DLL_PROCESS_ATTACH) {
+        hModule = hinstDLL;
+
         // Create a mutex with no initial owner.
         hMutex = CreateMutex(NULL, // default security attributes
                             FALSE, // initially not owned
@@ -138,8 +264,168 @@ void SPSS_Trace(const char* msg)
     DxHandle->Trace(msg);
 }
 
+static int GetConfigInt(const char* key, int defaultValue);
+
+static int GetLockMode()
+{
+    if(lockMode < 0) {
+        lockMode = GetConfigInt("LockMode", 0);
+    }
+    return lockMode;
+}
+
+static double ElapsedMs(std::chrono::steady_clock::time_point since)
+{
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - since).count();
+}
+
+// TraceSpans in spssdxcfg.ini. N > 0 times the entry points and the lock, keeping the
+// last SPAN_RING_SIZE spans, and traces a summary of the last N spans every N spans.
+// 0 records nothing.
+enum SpanKind {
+    SPAN_INIT, SPAN_PRE_ACTION, SPAN_COMPILE, SPAN_RUN, SPAN_POST_ACTION, SPAN_LOCK_WAIT, SPAN_LOCK_HOLD, SPAN_KINDS
+};
+static const char* spanNames[SPAN_KINDS] = {
+    "init_embedded_x", "pre_action", "execute_x compile", "execute_x run", "post_action", "lock wait", "lock hold"
+};
+
+typedef struct {
+    int     kind;
+    int     nestLevel;
+    size_t  bytes;              // source of execute_x, output posted by post_action
+    double  ms;
+} TraceSpan;
+
+static const size_t SPAN_RING_SIZE = 4096;
+static TraceSpan spanRing[SPAN_RING_SIZE];
+static size_t spanCount = 0;            // spans recorded, the ring keeps the last SPAN_RING_SIZE
+static size_t spanSummarized = 0;       // spanCount at the last summary
+static int spanInterval = -1;           // read from spssdxcfg.ini on first use
+static std::mutex spanMutex;
+
+// upper bounds of the histogram buckets, in ms. The last bucket has no bound.
+static const double spanBuckets[] = {0.1, 1.0, 10.0, 100.0, 1000.0};
+static const char* spanBucketNames[] = {"<0.1ms", "<1ms", "<10ms", "<100ms", "<1s", ">=1s"};
+static const int SPAN_BUCKETS = 6;
+
+static bool IsSpanTracing()
+{
+    if(spanInterval < 0) {
+        spanInterval = std::min(std::max(GetConfigInt("TraceSpans", 0), 0), (int)SPAN_RING_SIZE);
+    }
+    return spanInterval > 0;
+}
+
+//summary lines of the spans recorded since the last summary, one per kind. spanMutex is held.
+static std::vector<std::string> SummarizeSpans()
+{
+    std::vector<std::string> lines;
+    size_t first = std::max(spanSummarized, spanCount > SPAN_RING_SIZE ? spanCount - SPAN_RING_SIZE : 0);
+    for(int kind = 0; kind < SPAN_KINDS; kind++) {
+        int count = 0, nested = 0;
+        int histogram[SPAN_BUCKETS] = {0};
+        double total = 0.0, longest = 0.0;
+        size_t bytes = 0;
+        for(size_t i = first; i < spanCount; i++) {
+            const TraceSpan& span = spanRing[i % SPAN_RING_SIZE];
+            if(span.kind != kind) {
+                continue;
+            }
+            int bucket = 0;
+            while(bucket < SPAN_BUCKETS - 1 && span.ms >= spanBuckets[bucket]) {
+                bucket++;
+            }
+            histogram[bucket]++;
+            count++;
+            nested += span.nestLevel > 0;
+            total += span.ms;
+            longest = std::max(longest, span.ms);
+            bytes += span.bytes;
+        }
+        if(count == 0) {
+            continue;
+        }
+        char msg[256];
+        int length = sprintf(msg, "span %s: n=%d nested=%d total=%.3f ms max=%.3f ms bytes=%lu",
+                             spanNames[kind], count, nested, total, longest, (unsigned long)bytes);
+        for(int bucket = 0; bucket < SPAN_BUCKETS; bucket++) {
+            length += sprintf(msg + length, " %s:%d", spanBucketNames[bucket], histogram[bucket]);
+        }
+        lines.push_back(msg);
+    }
+    spanSummarized = spanCount;
+    return lines;
+}
+
+static void TraceSpanSummary(const std::vector<std::string>& lines)
+{
+    if(DxHandle) {
+        for(size_t i = 0; i < lines.size(); i++) {
+            SPSS_Trace(lines[i].c_str());
+        }
+    }
+}
+
+static void RecordSpan(int kind, int nestLevel, size_t bytes, double ms)
+{
+    std::vector<std::string> summary;
+    {
+        std::lock_guard<std::mutex> guard(spanMutex);
+        TraceSpan& span = spanRing[spanCount++ % SPAN_RING_SIZE];
+        span.kind = kind;
+        span.nestLevel = nestLevel;
+        span.bytes = bytes;
+        span.ms = ms;
+        if(spanCount - spanSummarized >= (size_t)spanInterval) {
+            summary = SummarizeSpans();
+        }
+    }
+    TraceSpanSummary(summary);
+}
+
+//trace the spans not summarized yet, when Python stops.
+static void FlushSpans()
+{
+    std::vector<std::string> summary;
+    {
+        std::lock_guard<std::mutex> guard(spanMutex);
+        if(spanCount > spanSummarized) {
+            summary = SummarizeSpans();
+        }
+    }
+    TraceSpanSummary(summary);
+}
+
+// records the time from its construction to its destruction as a span.
+class SpanTimer {
+public:
+    SpanTimer(int kind, int nestLevel, size_t bytes = 0)
+        : kind(kind), nestLevel(nestLevel), bytes(bytes), enabled(IsSpanTracing()) {
+        if(enabled) {
+            start = std::chrono::steady_clock::now();
+        }
+    }
+    ~SpanTimer() {
+        if(enabled) {
+            RecordSpan(kind, nestLevel, bytes, ElapsedMs(start));
+        }
+    }
+    void SetBytes(size_t value) { bytes = value; }
+private:
+    int     kind;
+    int     nestLevel;
+    size_t  bytes;
+    bool    enabled;
+    std::chrono::steady_clock::time_point start;
+};
+
 //acquire the library lock.
 INVOKEPYTHON_API int  GetLibraryLock() {
+    if(GetLockMode() == 1) {
+        // the program blocks take blockMutex themselves, see EnterProgramBlock.
+        return 1; // true
+    }
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
 #ifdef _WINDOWS
 
     DWORD dwWaitResult;
@@ -162,11 +448,23 @@ INVOKEPYTHON_API int  GetLibraryLock() {
         return 0; // false
     }
 #endif
+    if(session.lockDepth++ == 0) {
+        session.lockedAt = std::chrono::steady_clock::now();
+        if(IsSpanTracing()) {
+            RecordSpan(SPAN_LOCK_WAIT, 0, 0, ElapsedMs(start));
+        }
+    }
     return 1; // true
 }
 
 //release the library lock.
 INVOKEPYTHON_API int  ReleaseLibraryLock() {
+    if(GetLockMode() == 1) {
+        return 1; // true
+    }
+    if(session.lockDepth > 0 && --session.lockDepth == 0 && IsSpanTracing()) {
+        RecordSpan(SPAN_LOCK_HOLD, 0, 0, ElapsedMs(session.lockedAt));
+    }
 #ifdef _WINDOWS
     if(0 == ReleaseMutex(hMutex))
     {
@@ -185,18 +483,449 @@ INVOKEPYTHON_API int  ReleaseLibraryLock() {
     return 1; // true
 }
 
+//take blockMutex for the program block starting on this thread when LockMode=1. A nested
+//block runs inside the block of its thread. Call it without the GIL, the holder may wait for it.
+static void EnterProgramBlock(int nestLevel)
+{
+    if(GetLockMode() != 1 || session.inBlock) {
+        return;
+    }
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    blockMutex.lock();
+    session.inBlock = true;
+    session.blockNestLevel = nestLevel;
+    session.lockedAt = std::chrono::steady_clock::now();
+    if(IsSpanTracing()) {
+        RecordSpan(SPAN_LOCK_WAIT, 0, 0, ElapsedMs(start));
+    }
+}
+
+//release blockMutex when the block that took it ends, or when its pre_action fails. The
+//post_action of a block whose pre_action failed then finds nothing to release.
+static void LeaveProgramBlock(int nestLevel)
+{
+    if(GetLockMode() != 1 || !session.inBlock || session.blockNestLevel != nestLevel) {
+        return;
+    }
+    session.inBlock = false;
+    if(IsSpanTracing()) {
+        RecordSpan(SPAN_LOCK_HOLD, 0, 0, ElapsedMs(session.lockedAt));
+    }
+    blockMutex.unlock();
+}
+
 //execute the X lanaguage command.
 INVOKEPYTHON_API int  Execute_Python(char *cmd) {
 
     int errlvl=0;
     if (cmd != 0) {
         SPSS_Trace(cmd);
+        PythonCall call;
         errlvl=PyRun_SimpleString(cmd);
     }
 
     return errlvl;
 }
 
+//the folder of spssdxcfg.ini. The library is installed in SPSS_HOME on Windows
+//and in SPSS_HOME/lib on UNIX, the config file is in SPSS_HOME and SPSS_HOME/bin.
+static std::string GetConfigFile()
+{
+    std::string dir;
+#ifdef _WINDOWS
+    char path[MAX_PATH];
+    if(hModule && GetModuleFileNameA(hModule, path, MAX_PATH) > 0) {
+        dir = std::string(path);
+        dir = dir.substr(0, dir.find_last_of("\\/"));
+    } else if(getenv("SPSS_HOME")) {
+        dir = std::string(getenv("SPSS_HOME"));
+    }
+    return dir + "\\spssdxcfg.ini";
+#else
+    Dl_info info;
+    if(dladdr((void*)&GetConfigFile, &info) && info.dli_fname && strchr(info.dli_fname, '/')) {
+        dir = std::string(info.dli_fname);
+        dir = dir.substr(0, dir.find_last_of("/")) + "/../bin";
+    }
+    std::ifstream probe((dir + "/spssdxcfg.ini").c_str());
+    if(!probe.is_open() && getenv("SPSS_HOME")) {
+        dir = std::string(getenv("SPSS_HOME")) + "/bin";
+    }
+    return dir + "/spssdxcfg.ini";
+#endif
+}
+
+//read the [InvokePython] section of spssdxcfg.ini once.
+static void LoadConfig()
+{
+    if(configLoaded) {
+        return;
+    }
+    configLoaded = true;
+
+    std::ifstream fin(GetConfigFile().c_str());
+    std::string line;
+    bool inSection = false;
+    while(std::getline(fin, line)) {
+        std::string::size_type first = line.find_first_not_of(" \t\r");
+        if(first == std::string::npos || line[first] == ';' || line[first] == '#') {
+            continue;
+        }
+        line = line.substr(first, line.find_last_not_of(" \t\r") - first + 1);
+        if(line[0] == '[') {
+            inSection = (line == "[InvokePython]");
+            continue;
+        }
+        std::string::size_type eq = line.find('=');
+        if(inSection && eq != std::string::npos) {
+            std::string key = line.substr(0, eq);
+            key = key.substr(0, key.find_last_not_of(" \t") + 1);
+            std::string value = line.substr(eq + 1);
+            value = value.substr(std::min(value.size(), value.find_first_not_of(" \t")));
+            configValues[key] = value;
+        }
+    }
+}
+
+//an integer setting of the [InvokePython] section, or defaultValue when it is not set.
+static int GetConfigInt(const char* key, int defaultValue)
+{
+    LoadConfig();
+    std::map<std::string, std::string>::const_iterator it = configValues.find(key);
+    if(it == configValues.end() || it->second.empty()) {
+        return defaultValue;
+    }
+    return atoi(it->second.c_str());
+}
+
+static void ClearCodeCache(CodeCache& cache)
+{
+    for(CodeCache::iterator it = cache.begin(); it != cache.end(); ++it) {
+        Py_XDECREF(it->second);
+    }
+    cache.clear();
+}
+
+//create the sub-interpreters of SubInterpreters, each with the spss package imported.
+//The caller holds the GIL. returns -1 when one of them can not be made.
+static int CreateNestInterpreters()
+{
+    int count = GetConfigInt("SubInterpreters", 0);
+    if(count <= 0 || !nestInterpreters.empty()) {
+        return 0;
+    }
+
+    std::lock_guard<std::mutex> transition(transitionMutex);
+    nestPoolGeneration++;
+    PyThreadState* previous = PyThreadState_Get();
+    for(int nestLevel = 1; nestLevel <= count; nestLevel++) {
+        PyThreadState* threadState = Py_NewInterpreter();
+        if(threadState == NULL) {
+            PyThreadState_Swap(previous);
+            SPSS_Trace("init_embedded_x: a sub-interpreter can not be created");
+            return -1;
+        }
+        NestInterpreter* nest = new NestInterpreter();
+        nest->threadState = threadState;
+        nestInterpreters.push_back(nest);
+        if(PyRun_SimpleString("import spss") != 0) {
+            PyThreadState_Swap(previous);
+            SPSS_Trace("init_embedded_x: import spss failed in a sub-interpreter");
+            return -1;
+        }
+        PyThreadState_Swap(previous);
+    }
+    return 0;
+}
+
+//the thread state of this thread in the sub-interpreter of the nest level. A thread other
+//than the one that made the pool gets a thread state of its own on first use, so a nest level
+//runs in the same interpreter whichever thread runs it. returns NULL when nested blocks of the
+//level run in the main interpreter.
+static PyThreadState* GetNestThreadState(int nestLevel, bool& failed)
+{
+    failed = false;
+    if(nestLevel <= 0 || (size_t)nestLevel > nestInterpreters.size()) {
+        return NULL;
+    }
+    NestInterpreter* nest = nestInterpreters[nestLevel - 1];
+    if(nest->threadState->thread_id == PyThread_get_thread_ident()) {
+        return nest->threadState;
+    }
+
+    if(nestThreadStates.generation != nestPoolGeneration) {
+        // the thread states of an earlier pool went away with it.
+        nestThreadStates.generation = nestPoolGeneration;
+        nestThreadStates.threadStates.clear();
+    }
+    if(nestThreadStates.threadStates.size() < (size_t)nestLevel) {
+        nestThreadStates.threadStates.resize(nestLevel, NULL);
+    }
+    PyThreadState*& threadState = nestThreadStates.threadStates[nestLevel - 1];
+    if(threadState == NULL) {
+        threadState = PyThreadState_New(PyThreadState_GetInterpreter(nest->threadState));
+        if(threadState == NULL) {
+            SPSS_Trace("a thread state can not be created in the sub-interpreter");
+            failed = true;
+            return NULL;
+        }
+        nest->threadStates.push_back(threadState);
+    }
+    return threadState;
+}
+
+//switch to the interpreter of the nest level. previous is the thread state to restore,
+//or NULL when the level runs in the main interpreter. returns -1 when the switch fails.
+static int EnterNestInterpreter(int nestLevel, PyThreadState*& previous)
+{
+    bool failed = false;
+    PyThreadState* threadState = GetNestThreadState(nestLevel, failed);
+    previous = threadState ? PyThreadState_Swap(threadState) : NULL;
+    return failed ? -1 : 0;
+}
+
+static void LeaveNestInterpreter(PyThreadState* previous)
+{
+    if(previous) {
+        PyThreadState_Swap(previous);
+    }
+}
+
+static void EndNestInterpreters()
+{
+    std::lock_guard<std::mutex> transition(transitionMutex);
+    PyThreadState* previous = PyThreadState_Get();
+    for(size_t i = 0; i < nestInterpreters.size(); i++) {
+        NestInterpreter* nest = nestInterpreters[i];
+        PyThreadState_Swap(nest->threadState);
+        // Py_EndInterpreter wants the thread state it is given to be the last one.
+        for(size_t j = 0; j < nest->threadStates.size(); j++) {
+            PyThreadState_Clear(nest->threadStates[j]);
+            PyThreadState_Delete(nest->threadStates[j]);
+        }
+        ClearCodeCache(nest->codeCache);
+        Py_EndInterpreter(nest->threadState);
+        delete nest;
+    }
+    nestInterpreters.clear();
+    nestPoolGeneration++;
+    PyThreadState_Swap(previous);
+}
+
+//return a new reference to the compiled source, compiling it on first use.
+static PyObject* GetCompiledCode(CodeCache& codeCache, const std::string& source, int nestLevel)
+{
+    CodeKey key = {nestLevel, source};
+    CodeCache::iterator it = codeCache.find(key);
+    if(it != codeCache.end()) {
+        Py_INCREF(it->second);
+        return it->second;
+    }
+
+    PyObject* code = Py_CompileString(source.c_str(), "<string>", Py_file_input);
+    if(code == NULL) {
+        return NULL;
+    }
+    if(codeCache.size() >= CODE_CACHE_MAX) {
+        ClearCodeCache(codeCache);
+    }
+    Py_INCREF(code);
+    codeCache[key] = code;
+    return code;
+}
+
+//run the source in the given dictionary. errors are printed like PyRun_SimpleString does.
+static int RunCompiledCode(CodeCache& cache, const std::string& source, int nestLevel, PyObject* globals)
+{
+    // the reference keeps the code alive when a nested block clears the cache.
+    PyObject* code = NULL;
+    {
+        SpanTimer span(SPAN_COMPILE, nestLevel, source.size());
+        code = GetCompiledCode(cache, source, nestLevel);
+    }
+    if(code == NULL) {
+        PyErr_Print();
+        return -1;
+    }
+
+    PyObject* result = NULL;
+    {
+        SpanTimer span(SPAN_RUN, nestLevel, source.size());
+        result = PyEval_EvalCode(code, globals, globals);
+    }
+    Py_DECREF(code);
+    if(result == NULL) {
+        PyErr_Print();
+        return -1;
+    }
+    Py_DECREF(result);
+    return 0;
+}
+
+//the namespace of top-level blocks. A session on another thread than the one that
+//initialized Python has its own namespace when LockMode=1. Returns a borrowed reference.
+static PyObject* GetTopLevelDict()
+{
+    PyObject* mainModule = PyImport_AddModule("__main__");
+    if(mainModule == NULL) {
+        return NULL;
+    }
+    PyObject* mainDict = PyModule_GetDict(mainModule);
+    if(GetLockMode() != 1 || PyThread_get_thread_ident() == initThread) {
+        return mainDict;
+    }
+
+    if(session.generation != pythonGeneration) {
+        // the dictionary went away with an earlier Py_Finalize.
+        session.topLevelDict = NULL;
+        session.generation = pythonGeneration;
+    }
+    if(session.topLevelDict == NULL) {
+        PyObject* dict = PyDict_New();
+        if(dict == NULL) {
+            return NULL;
+        }
+        PyDict_SetItemString(dict, "__builtins__", PyEval_GetBuiltins());
+        PyDict_SetItemString(dict, "__name__", PyDict_GetItemString(mainDict, "__name__"));
+        topLevelDicts.push_back(dict);
+        session.topLevelDict = dict;
+    }
+    return session.topLevelDict;
+}
+
+// output of print statements waiting to be posted to the log, in UTF-8.
+// OutputBuffer in spssdxcfg.ini turns it on; preaction.start then sends
+// sys.stdout and sys.stderr here instead of to the temp file.
+static std::string outputBuffer;
+static int outputLines = 0;             // complete lines in outputBuffer
+static size_t outputPosted = 0;         // bytes posted to the log so far
+static int outputBufferMode = -1;       // read from spssdxcfg.ini on first use
+static int outputFlushLines = 0;
+static int outputFlushBytes = 0;
+static const int OUTPUT_LINE_WIDTH = 255;
+
+static bool IsOutputBuffered()
+{
+    if(outputBufferMode < 0) {
+        outputBufferMode = GetConfigInt("OutputBuffer", 0) ? 1 : 0;
+        outputFlushLines = std::max(1, GetConfigInt("OutputFlushLines", 256));
+        outputFlushBytes = std::max(OUTPUT_LINE_WIDTH, GetConfigInt("OutputFlushBytes", 65536));
+    }
+    return outputBufferMode == 1;
+}
+
+//post one line to the log in pieces of at most OUTPUT_LINE_WIDTH characters,
+//never splitting a UTF-8 sequence.
+static void PostOutputLine(const char* text, size_t length)
+{
+    if(length == 0) {
+        DxHandle->PostSpssOutput("", 0);
+        return;
+    }
+    size_t start = 0;
+    while(start < length) {
+        size_t end = start;
+        int chars = 0;
+        while(end < length && chars < OUTPUT_LINE_WIDTH) {
+            end++;
+            while(end < length && (text[end] & 0xC0) == 0x80) {
+                end++;
+            }
+            chars++;
+        }
+        std::string piece(text + start, end - start);
+        DxHandle->PostSpssOutput(piece.c_str(), (int)piece.size());
+        start = end;
+    }
+}
+
+//post the complete lines of the buffer. finish also posts a last line without a newline.
+//returns the number of bytes posted.
+static size_t FlushOutputBuffer(bool finish)
+{
+    if(outputBuffer.empty() || DxHandle == 0 || DxHandle->PostSpssOutput == 0) {
+        return 0;
+    }
+    const char* text = outputBuffer.data();
+    size_t length = outputBuffer.size();
+    size_t start = 0;
+    const char* newline;
+    while((newline = (const char*)memchr(text + start, '\n', length - start)) != NULL) {
+        size_t end = newline - text;
+        PostOutputLine(text + start, end - start);
+        start = end + 1;
+    }
+    if(finish && start < length) {
+        PostOutputLine(text + start, length - start);
+        start = length;
+    }
+    outputBuffer.erase(0, start);
+    outputLines = 0;
+    outputPosted += start;
+    return start;
+}
+
+//_spssdxoutput.write(text): buffer the text, posting it once enough lines or bytes are waiting.
+static PyObject* OutputWrite(PyObject* self, PyObject* text)
+{
+    if(!PyUnicode_Check(text)) {
+        PyErr_Format(PyExc_TypeError, "write() argument must be str, not %.100s", Py_TYPE(text)->tp_name);
+        return NULL;
+    }
+    Py_ssize_t size = 0;
+    const char* utf8 = PyUnicode_AsUTF8AndSize(text, &size);
+    PyObject* replaced = NULL;
+    if(utf8 == NULL) {
+        // lone surrogates, written the way the temp file does with errors="replace".
+        PyErr_Clear();
+        replaced = PyUnicode_AsEncodedString(text, "utf-8", "replace");
+        if(replaced == NULL) {
+            return NULL;
+        }
+        utf8 = PyBytes_AS_STRING(replaced);
+        size = PyBytes_GET_SIZE(replaced);
+    }
+    for(const char* p = utf8; (p = (const char*)memchr(p, '\n', utf8 + size - p)) != NULL; p++) {
+        outputLines++;
+    }
+    outputBuffer.append(utf8, size);
+    Py_XDECREF(replaced);
+
+    if(outputLines >= outputFlushLines || outputBuffer.size() >= (size_t)outputFlushBytes) {
+        FlushOutputBuffer(false);
+    }
+    return PyLong_FromSsize_t(PyUnicode_GET_LENGTH(text));
+}
+
+//_spssdxoutput.flush(): post the complete lines.
+static PyObject* OutputFlush(PyObject* self, PyObject* unused)
+{
+    FlushOutputBuffer(false);
+    Py_RETURN_NONE;
+}
+
+//_spssdxoutput.enabled(): True when OutputBuffer=1.
+static PyObject* OutputEnabled(PyObject* self, PyObject* unused)
+{
+    return PyBool_FromLong(IsOutputBuffered() && DxHandle && DxHandle->PostSpssOutput);
+}
+
+static PyMethodDef outputMethods[] = {
+    {"write", OutputWrite, METH_O, "Buffer text for the log."},
+    {"flush", OutputFlush, METH_NOARGS, "Post the complete lines to the log."},
+    {"enabled", OutputEnabled, METH_NOARGS, "Whether print output goes through this module."},
+    {NULL, NULL, 0, NULL}
+};
+
+static struct PyModuleDef outputModule = {
+    PyModuleDef_HEAD_INIT, "_spssdxoutput", "Buffered output of BEGIN PROGRAM blocks.", -1, outputMethods
+};
+
+static PyObject* InitOutputModule(void)
+{
+    return PyModule_Create(&outputModule);
+}
+
 //check if python initialized
 INVOKEPYTHON_API int  Python_IsInitialized()
 {
@@ -210,18 +939,129 @@ INVOKEPYTHON_API void PostSpssOutput(FPPostSpssOutput fpSpssOutput) {
 //initialize the X language environment.
 INVOKEPYTHON_API int Init_Embedded_Python(int argc, char **argv)
 {
+    std::lock_guard<std::mutex> transition(transitionMutex);
     if (! Py_IsInitialized()) {
+        static bool outputModuleAdded = false;
+        if(!outputModuleAdded) {
+            PyImport_AppendInittab("_spssdxoutput", InitOutputModule);
+            outputModuleAdded = true;
+        }
         Py_Initialize();
+        // each entry point takes the GIL for its own thread from now on.
+        initThread = PyThread_get_thread_ident();
+        pythonGeneration++;
+        initThreadState = PyEval_SaveThread();
     }
 
     return 0;
 }
 
-//execute the python code file and redirects all output to log file.
-//returns 0 on success, -1 on failure and -2 when scriptLogFile can not be opened.
-INVOKEPYTHON_API int  Execute_Python_Ex(char *scriptFileName, char *logFileName) {
+//return a new reference to the compiled script file, compiling it when it is new or has changed.
+//The script is compiled with Py_CompileString rather than run with PyRun_FileExFlags, which
+//compiles the file on every call and keeps no code object to reuse.
+static PyObject* GetCompiledScript(const std::string& fileName)
+{
+#ifdef _WINDOWS
+    struct _stat64 info;
+    int statErr = _stat64(fileName.c_str(), &info);
+#else
+    struct stat info;
+    int statErr = stat(fileName.c_str(), &info);
+#endif
+    if(statErr != 0) {
+        PyErr_SetFromErrnoWithFilename(PyExc_OSError, fileName.c_str());
+        return NULL;
+    }
+
+    std::map<std::string, ScriptEntry>::iterator it = scriptCache.find(fileName);
+    bool settled = info.st_mtime < time(NULL) - 1;
+    if(it != scriptCache.end() && settled &&
+       it->second.size == (long long)info.st_size && it->second.modified == info.st_mtime) {
+        Py_INCREF(it->second.code);
+        return it->second.code;
+    }
+
+    FILE* fp = fopen(fileName.c_str(), "rb");
+    if(fp == NULL) {
+        PyErr_SetFromErrnoWithFilename(PyExc_OSError, fileName.c_str());
+        return NULL;
+    }
+    std::string source;
+    char buffer[65536];
+    size_t n;
+    while((n = fread(buffer, 1, sizeof(buffer), fp)) > 0) {
+        source.append(buffer, n);
+    }
+    fclose(fp);
+    size_t sourceHash = std::hash<std::string>()(source);
+
+    if(it != scriptCache.end()) {
+        if(it->second.sourceHash == sourceHash) {
+            it->second.size = (long long)info.st_size;
+            it->second.modified = info.st_mtime;
+            Py_INCREF(it->second.code);
+            return it->second.code;
+        }
+        Py_DECREF(it->second.code);
+        scriptCache.erase(it);
+    }
+
+    PyObject* code = Py_CompileString(source.c_str(), fileName.c_str(), Py_file_input);
+    if(code == NULL) {
+        return NULL;
+    }
+    if(scriptCache.size() >= CODE_CACHE_MAX) {
+        for(it = scriptCache.begin(); it != scriptCache.end(); ++it) {
+            Py_DECREF(it->second.code);
+        }
+        scriptCache.clear();
+    }
+    ScriptEntry entry = {(long long)info.st_size, info.st_mtime, sourceHash, code};
+    scriptCache[fileName] = entry;
+    Py_INCREF(code);
+    return code;
+}
+
+//set line_buffering of sys.stdout or sys.stderr, returning the previous setting.
+static bool SetLineBuffering(const char* name, bool lineBuffering)
+{
+    bool previous = false;
+    PyObject* stream = PySys_GetObject(name);
+    if(stream == NULL || stream == Py_None) {
+        return previous;
+    }
+    PyObject* current = PyObject_GetAttrString(stream, "line_buffering");
+    if(current) {
+        previous = PyObject_IsTrue(current) == 1;
+        Py_DECREF(current);
+    }
+    PyObject* reconfigure = PyObject_GetAttrString(stream, "reconfigure");
+    PyObject* args = PyTuple_New(0);
+    PyObject* kwargs = Py_BuildValue("{s:O}", "line_buffering", lineBuffering ? Py_True : Py_False);
+    PyObject* result = (reconfigure && args && kwargs) ? PyObject_Call(reconfigure, args, kwargs) : NULL;
+    Py_XDECREF(result);
+    Py_XDECREF(kwargs);
+    Py_XDECREF(args);
+    Py_XDECREF(reconfigure);
+    PyErr_Clear();
+    return previous;
+}
+
+static void FlushPythonStreams()
+{
+    PyObject* result = PyRun_String("import sys\n"
+                                    "for s in (sys.stdout, sys.stderr):\n"
+                                    "    if s is not None: s.flush()\n",
+                                    Py_file_input, PyEval_GetBuiltins(), NULL);
+    Py_XDECREF(result);
+    PyErr_Clear();
+}
+
+//run the python code file with stdout and stderr sent to the log file.
+static int RunScriptFile(char *scriptFileName, char *logFileName) {
 
     int errlvl=0;
+    PythonCall call;
     if (scriptFileName != 0 && logFileName != 0) {
         std::string scriptCodeFile = std::string(scriptFileName);
         std::string scriptLogFile = std::string(logFileName);
@@ -234,47 +1074,178 @@ INVOKEPYTHON_API int  Execute_Python_Ex(char *scriptFileName, char *logFileName)
             scriptLogFile.replace(idx,1,"/");
         }
 
-        std::fstream fin;
-        fin.open(scriptLogFile.c_str(),std::ios::in);
-        if( !fin.is_open() )
+        FILE* log = fopen(scriptLogFile.c_str(), "w");
+        if(log == NULL)
         {
             fprintf(stderr, "\nScript log file can not be opened.");
-            fin.close();
             return -2;
         }
-        fin.close();
-
-        std::string cmdAll("");
-        cmdAll = std::string("exec '''\nimport traceback, sys\nwop = open(\"");
-        cmdAll.append(scriptLogFile);
-        cmdAll.append("\", 'w')\noldstdout=sys.stdout\noldstderr=sys.stderr\nsys.stdout=wop\nsys.stderr=wop\ntry:\n    f = open(\"");
-        cmdAll.append(scriptCodeFile);
-        cmdAll.append("\")\n    exec f\nexcept Exception, e:\n    info = sys.exc_info()\n    print info[0]\n    print info[1]\n    traceback.print_tb(info[2])\nwop.flush()\nsys.stdout=oldstdout\nsys.stderr=oldstderr\n''' in globals().copy(), locals().copy()");
 
-        const int iLen = cmdAll.size() + 1;
-        char* cmdFinal = new char[iLen];
-        strcpy(cmdFinal, cmdAll.c_str());
+        // send everything written to stdout and stderr, by Python or by C, to the log file.
+        // the Python streams are block buffered meanwhile, so each print is not a write.
+        FlushPythonStreams();
+        fflush(stdout);
+        fflush(stderr);
+        int savedOut = dup(fileno(stdout));
+        int savedErr = dup(fileno(stderr));
+        dup2(fileno(log), fileno(stdout));
+        dup2(fileno(log), fileno(stderr));
+        bool outLines = SetLineBuffering("stdout", false);
+        bool errLines = SetLineBuffering("stderr", false);
 
-        errlvl=PyRun_SimpleString(cmdFinal);
+        PyObject* code = GetCompiledScript(scriptCodeFile);
+        PyObject* mainModule = PyImport_AddModule("__main__");
+        PyObject* globals = mainModule ? PyDict_Copy(PyModule_GetDict(mainModule)) : NULL;
+        PyObject* result = NULL;
+        if(code && globals) {
+            PyObject* file = PyUnicode_DecodeFSDefault(scriptCodeFile.c_str());
+            if(file) {
+                PyDict_SetItemString(globals, "__file__", file);
+                Py_DECREF(file);
+            }
+            result = PyEval_EvalCode(code, globals, globals);
+        }
+        if(result == NULL) {
+            if(PyErr_ExceptionMatches(PyExc_SystemExit)) {
+                // sys.exit() ends the script, not the process.
+                PyErr_Clear();
+            } else {
+                PyErr_Print();
+                errlvl = -1;
+            }
+        }
+        Py_XDECREF(result);
+        Py_XDECREF(globals);
+        Py_XDECREF(code);
 
-        delete [] cmdFinal;
+        SetLineBuffering("stdout", outLines);
+        SetLineBuffering("stderr", errLines);
+        FlushPythonStreams();
+        fflush(stdout);
+        fflush(stderr);
+        dup2(savedOut, fileno(stdout));
+        dup2(savedErr, fileno(stderr));
+        close(savedOut);
+        close(savedErr);
+        fclose(log);
     }
 
     return errlvl;
 }
 
+//execute the python code file and redirects all output to log file.
+//The output is redirected with dup2 on file descriptors 1 and 2, which belong to the process:
+//while the script runs, whatever other threads write to stdout and stderr, the backend
+//included, goes to the log as well. With LockMode=1 the script holds blockMutex like a
+//program block, so the blocks of other sessions do not run meanwhile.
+//returns 0 on success, -1 on failure and -2 when scriptLogFile can not be opened.
+INVOKEPYTHON_API int  Execute_Python_Ex(char *scriptFileName, char *logFileName) {
+    bool locked = GetLockMode() == 1 && !session.inBlock;
+    if(locked) {
+        blockMutex.lock();
+    }
+    int errlvl = RunScriptFile(scriptFileName, logFileName);
+    if(locked) {
+        blockMutex.unlock();
+    }
+    return errlvl;
+}
+
 // 
 INVOKEPYTHON_API void setup_dxcallback(void* dxhandle)
 {
     DxHandle = (DXCallBackHandle)dxhandle;
 }
 
+//a new reference to module.attribute, or NULL.
+static PyObject* ImportAttribute(const char* module, const char* attribute)
+{
+    PyObject* mod = PyImport_ImportModule(module);
+    if(mod == NULL) {
+        return NULL;
+    }
+    PyObject* attr = PyObject_GetAttrString(mod, attribute);
+    Py_DECREF(mod);
+    return attr;
+}
+
+//bind every XD API function now, they are bound on first call otherwise, and trace the
+//ones the backend does not export.
+static void BindXDSymbols()
+{
+    PyObject* report = ImportAttribute("spss.PyInvokeSpss", "GetXDSymbolReport");
+    PyObject* result = report ? PyObject_CallFunction(report, "i", 1) : NULL;
+    Py_XDECREF(report);
+    if(result == NULL) {
+        PyErr_Print();
+        return;
+    }
+    PyObject* missing = PyDict_GetItemString(result, "missing");
+    if(missing && PyList_Check(missing) && PyList_GET_SIZE(missing) > 0) {
+        std::string msg("init_embedded_x: XD API functions not found:");
+        for(Py_ssize_t i = 0; i < PyList_GET_SIZE(missing); i++) {
+            const char* name = PyUnicode_AsUTF8(PyList_GET_ITEM(missing, i));
+            msg.append(i ? ", " : " ").append(name ? name : "?");
+        }
+        PyErr_Clear();
+        SPSS_Trace(msg.c_str());
+    }
+    Py_DECREF(result);
+}
+
+//import the spss package, bind the XD API and keep the pre and post action callables.
+static int WarmStart()
+{
+    PythonCall call;
+    if(preactionStart == NULL) {
+        preactionStart = ImportAttribute("spss.preaction", "start");
+    }
+    if(postactionEnd == NULL && preactionStart) {
+        postactionEnd = ImportAttribute("spss.postaction", "end");
+    }
+    if(preactionStart == NULL || postactionEnd == NULL) {
+        PyErr_Print();
+        Py_CLEAR(preactionStart);
+        Py_CLEAR(postactionEnd);
+        return -1;
+    }
+    BindXDSymbols();
+    return 0;
+}
+
+//call a cached callable, reporting errors the way PyRun_SimpleString does.
+static int CallAction(PyObject* callable, PyObject* args)
+{
+    PyObject* result = args ? PyObject_CallObject(callable, args) : NULL;
+    if(result == NULL) {
+        PyErr_Print();
+        return -1;
+    }
+    Py_DECREF(result);
+    return 0;
+}
+
 //initialize the X language environment.
 INVOKEPYTHON_API int init_embedded_x(int argc, char **argv)
 {
     SPSS_Trace("init_embedded_x");
+    SpanTimer span(SPAN_INIT, 0);
     int err = Init_Embedded_Python(argc, argv);
 
+    if(err == 0) {
+        PythonCall call;
+        if(CreateNestInterpreters() != 0) {
+            EndNestInterpreters();
+            err = -1;
+        }
+    }
+
+    // a failed warm start leaves pre_action and post_action to import as usual.
+    if(err == 0 && GetConfigInt("WarmStart", 0)) {
+        SPSS_Trace("init_embedded_x: warm start");
+        WarmStart();
+    }
+
     return err;
 }
 
@@ -294,69 +1265,83 @@ INVOKEPYTHON_API int  execute_x(char* cmd)
     singleCmd.append(codePage).append("\n");
     singleCmd.append(cmd);
     
-    int curnest = SPSS_GetNestLevel();
-    if(curnest)
-    {
-        char buffer[8];
-        sprintf(buffer, "%d", curnest) ;
-        std::string depth( buffer );
-        std::string codeVar("spss_code_temp_");
-        codeVar.append(depth);
+    SPSS_Trace(cmd);
 
-        std::string nestCmd(codeVar);
-        nestCmd.append(" = compile(\"\"\"\n");    
-        while(true)
-        {
-            std::size_t pos = singleCmd.find("\"\"\"");
-            if(pos != std::string::npos)
-            {
-                singleCmd.replace(pos,3,"\\\"\\\"\\\"");
-            }
-            else
-            {
-                break;
-            }
-        }
-        nestCmd.append(singleCmd);
-        nestCmd.append("\"\"\",\"\",\"exec\")\n");
-        nestCmd.append("exec(\"theDict={}\")\n");    
-        nestCmd.append("exec(");
-        nestCmd.append(codeVar);
-        nestCmd.append(") in globals(),theDict\n");
-        nestCmd.append("del ");
-        nestCmd.append(codeVar);
+    PythonCall call;
+    int curnest = SPSS_GetNestLevel();
+    PyThreadState* previous = NULL;
+    if(EnterNestInterpreter(curnest, previous) != 0) {
+        return -1;
+    }
+    CodeCache& cache = previous ? nestInterpreters[curnest - 1]->codeCache : codeCache;
 
-        err = Execute_Python((char*)nestCmd.c_str());
+    PyObject* mainDict = NULL;
+    if(previous) {
+        PyObject* mainModule = PyImport_AddModule("__main__");
+        mainDict = mainModule ? PyModule_GetDict(mainModule) : NULL;
+    } else {
+        mainDict = GetTopLevelDict();
     }
-    else
-    {
-        err = Execute_Python((char*)singleCmd.c_str());
+    if(mainDict == NULL) {
+        PyErr_Print();
+        LeaveNestInterpreter(previous);
+        return -1;
     }
+
+    // nested blocks run in __main__ like top-level ones; only the compile is cached.
+    err = RunCompiledCode(cache, singleCmd, curnest, mainDict);
+    LeaveNestInterpreter(previous);
     return err;
 }
 
 INVOKEPYTHON_API int  stop_embedded_x()
 {
     SPSS_Trace("stop_embedded_x");
+    if(!Py_IsInitialized()) {
+        return 0;
+    }
+    if(PyThread_get_thread_ident() == initThread && session.callDepth == 0) {
+        PyEval_RestoreThread(initThreadState);
+    } else {
+        PyGILState_Ensure();
+    }
+    FlushOutputBuffer(true);
+    FlushSpans();
+    Py_CLEAR(preactionStart);
+    Py_CLEAR(postactionEnd);
+    EndNestInterpreters();
+    ClearCodeCache(codeCache);
+    for(std::map<std::string, ScriptEntry>::iterator it = scriptCache.begin(); it != scriptCache.end(); ++it) {
+        Py_DECREF(it->second.code);
+    }
+    scriptCache.clear();
+    for(size_t i = 0; i < topLevelDicts.size(); i++) {
+        Py_DECREF(topLevelDicts[i]);
+    }
+    topLevelDicts.clear();
+    session.topLevelDict = NULL;
+
+    std::lock_guard<std::mutex> transition(transitionMutex);
     Py_Finalize();
+    initThreadState = NULL;
     return 0;
 }
 
-INVOKEPYTHON_API int  pre_action()
+//run preaction.start. pre_action takes the program block before the GIL.
+static int StartProgramBlock(int curnest)
 {
     int err = 0;
 
-    int curnest = SPSS_GetNestLevel();
-    
     std::string script_preaction(
         "from spss import preaction\n"
         "preaction.start(");
+    std::string tempdir;
     if(curnest)
     {
         char buffer[8];
         sprintf(buffer, "%d", curnest) ;
         std::string depth( buffer );
-        std::string tempdir( SPSS_GetDXTempDir() );
+        tempdir = SPSS_GetDXTempDir();
     #if _WINDOWS
         std::string::size_type idx;
         while((idx = tempdir.find_first_of("\\")) != std::string::npos) {
@@ -370,17 +1355,72 @@ INVOKEPYTHON_API int  pre_action()
     }   
     script_preaction.append(")");
     
-    err = Execute_Python((char*)script_preaction.c_str());
+    SpanTimer span(SPAN_PRE_ACTION, curnest);
+    PythonCall call;
+    PyThreadState* previous = NULL;
+    if(EnterNestInterpreter(curnest, previous) != 0) {
+        return -1;
+    }
+    if(preactionStart && previous == NULL) {
+        SPSS_Trace(script_preaction.c_str());
+        PyObject* args = curnest ? Py_BuildValue("(is)", curnest, tempdir.c_str()) : PyTuple_New(0);
+        err = CallAction(preactionStart, args);
+        Py_XDECREF(args);
+    } else {
+        err = Execute_Python((char*)script_preaction.c_str());
+    }
+    LeaveNestInterpreter(previous);
 
     return err;
 }
 
-INVOKEPYTHON_API int  post_action()
+INVOKEPYTHON_API int  pre_action()
+{
+    int curnest = SPSS_GetNestLevel();
+    EnterProgramBlock(curnest);
+    int err = StartProgramBlock(curnest);
+    if(err != 0) {
+        // the host need not call post_action for a block that did not start.
+        LeaveProgramBlock(curnest);
+    }
+    return err;
+}
+
+//run postaction.end. post_action releases the program block once the GIL is released.
+static int EndProgramBlock()
 {
     char* script_postaction = 
         (char *)"from spss import postaction\n"
         "postaction.end()";
-    return Execute_Python(script_postaction);
+    int curnest = SPSS_GetNestLevel();
+    SpanTimer span(SPAN_POST_ACTION, curnest);
+    size_t posted = outputPosted;
+    PythonCall call;
+    PyThreadState* previous = NULL;
+    if(EnterNestInterpreter(curnest, previous) != 0) {
+        return -1;
+    }
+    int err;
+    if(postactionEnd && previous == NULL) {
+        SPSS_Trace(script_postaction);
+        PyObject* args = PyTuple_New(0);
+        err = CallAction(postactionEnd, args);
+        Py_XDECREF(args);
+    } else {
+        err = Execute_Python(script_postaction);
+    }
+    // what postaction.end left over, such as a last line without a newline.
+    FlushOutputBuffer(true);
+    span.SetBytes(outputPosted - posted);
+    LeaveNestInterpreter(previous);
+    return err;
+}
+
+INVOKEPYTHON_API int  post_action()
+{
+    int err = EndProgramBlock();
+    LeaveProgramBlock(SPSS_GetNestLevel());
+    return err;
 }
 
 #ifdef __cplusplus
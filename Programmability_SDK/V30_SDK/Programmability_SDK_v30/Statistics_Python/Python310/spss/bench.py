@@ -0,0 +1,570 @@
+#/***********************************************************************
+# * Licensed Materials - Property of IBM
+# *
+# * IBM SPSS Products: Statistics Common
+# *
+# * (C) Copyright IBM Corp. 1989, 2021
+# *
+# * US Government Users Restricted Rights - Use, duplication or disclosure
+# * restricted by GSA ADP Schedule Contract with IBM Corp.
+# ************************************************************************/
+
+#!/usr/bin/python
+
+"""
+Timing workloads for the XD API calls made by the spss package.
+
+Run measures a list of workloads (reading with the classic and the binary
+cursor and several fetch sizes, appending cases, writing new variables,
+random cell access in a data step with and without the dataset cache, pivot
+table emission, XPath queries and direct calls of the per-case functions of
+PyInvokeSpss) and reports the throughput, the peak RSS
+and the Python allocations of each. Save and Load keep a report as JSON and
+Compare lines two reports up, so a change can be checked against a baseline:
+
+    python -m spss.bench run --out before.json
+    python -m spss.bench run --out after.json
+    python -m spss.bench compare before.json after.json
+"""
+
+import gc
+import json
+import random
+import sys
+import time
+import tracemalloc
+from . import PyInvokeSpss
+from . import spss
+from . import cursors
+from . import dataStep
+from .errMsg import SpssError, errCode
+from .pivotTable import BasePivotTable, Dimension, CellText, SetDeferredPivotTables, FlushPivotTables
+from . import FormatSpec
+
+def PivotEmission(tables=10, rows=100, columns=10, deferred=False):
+    """Builds pivot tables cell by cell and reports the elapsed time.
+       The tables are built inside the current procedure.
+       --usage
+          PivotEmission(tables=10, rows=100, columns=10, deferred=False)
+       --arguments
+          tables: The number of pivot tables.
+          rows: The number of row categories of each table.
+          columns: The number of column categories of each table.
+          deferred: If True, the tables are deferred and flushed once.
+       --returns
+          A dictionary with the elapsed seconds, the number of cells and
+          the pivot table counters of the native module.
+       --examples
+          import spss, spss.bench
+          spss.StartProcedure("bench")
+          print(spss.bench.PivotEmission(deferred=False))
+          print(spss.bench.PivotEmission(deferred=True))
+          spss.EndProcedure()
+    """
+    before = PyInvokeSpss.GetPivotTableStats()
+    SetDeferredPivotTables(deferred)
+    start = time.perf_counter()
+    try:
+        rowCats = [CellText.String("row%d" % i) for i in range(rows)]
+        colCats = [CellText.String("col%d" % j) for j in range(columns)]
+        for t in range(tables):
+            table = BasePivotTable("bench table %d" % t, "BenchTable")
+            rowDim = table.Append(Dimension.Place.row, "rows")
+            colDim = table.Append(Dimension.Place.column, "columns")
+            for i in range(rows):
+                for j in range(columns):
+                    table[(rowCats[i], colCats[j])] = CellText.Number(i * columns + j, FormatSpec.Count)
+        FlushPivotTables()
+    finally:
+        SetDeferredPivotTables(False)
+    elapsed = time.perf_counter() - start
+    after = PyInvokeSpss.GetPivotTableStats()
+
+    result = {"seconds": elapsed, "cells": tables * rows * columns, "deferred": bool(deferred)}
+    for key in ("recordedCalls", "backendCalls", "denseTables"):
+        result[key] = after[key] - before[key]
+    return result
+
+class Workload(object):
+    """A timed piece of work.
+       --arguments
+          name: The name that identifies the workload in a report.
+          unit: What run counts, for example "case" or "cell".
+          run: A function that does the work and returns the number of units done.
+          prepare: A function called before each run, outside the timing; for
+                   example to rebuild the data a run changes.
+          params: The settings of the workload, kept in the report.
+    """
+    def __init__(self, name, unit, run, prepare=None, **params):
+        self.name = name
+        self.unit = unit
+        self.run = run
+        self.prepare = prepare
+        self.params = params
+
+def MakeData(cases=10000, numeric=8, strings=2, width=8):
+    """Replaces the active dataset with a generated one, built in a data step
+       so that it works with any backend.
+       --usage
+          MakeData(cases=10000, numeric=8, strings=2, width=8)
+       --arguments
+          cases: The number of cases.
+          numeric: The number of numeric variables n1, n2, ...
+          strings: The number of string variables s1, s2, ...
+          width: The width of the string variables.
+    """
+    spss.StartDataStep()
+    try:
+        ds = dataStep.Dataset(name=None)
+        for i in range(numeric):
+            ds.varlist.append("n%d" % (i + 1), 0)
+        for i in range(strings):
+            ds.varlist.append("s%d" % (i + 1), width)
+        for r in range(cases):
+            row = [r * 0.5 + i for i in range(numeric)]
+            row.extend([("r%dc%d" % (r, i))[:width] for i in range(strings)])
+            ds.cases.append(row)
+        spss.SetActive(ds)
+    finally:
+        spss.EndDataStep()
+
+def _Read(isBinary, fetch):
+    def run():
+        cur = cursors.Cursor(isBinary=isBinary)
+        try:
+            count = 0
+            if fetch is None:
+                count = len(cur.fetchall())
+            elif fetch == 1:
+                while cur.fetchone() is not None:
+                    count += 1
+            else:
+                while True:
+                    rows = cur.fetchmany(fetch)
+                    if not rows:
+                        break
+                    count += len(rows)
+            return count
+        finally:
+            cur.close()
+    return run
+
+def _RawRead(fetch):
+    def run():
+        cur = cursors.RawCursor()
+        try:
+            count = 0
+            while True:
+                rows = cur.fetchmany(fetch)
+                if not rows:
+                    break
+                count += len(rows)
+            return count
+        finally:
+            cur.close()
+    return run
+
+def _VariableNames():
+    return [(spss.GetVariableName(i), spss.GetVariableType(i)) for i in range(spss.GetVariableCount())]
+
+def _Append(cases):
+    def run():
+        variables = _VariableNames()
+        cur = cursors.Cursor(accessType="a")
+        try:
+            for r in range(cases):
+                for i, (name, varType) in enumerate(variables):
+                    if varType == 0:
+                        cur.SetValueNumeric(name, r + i)
+                    else:
+                        cur.SetValueChar(name, ("a%d" % r)[:varType])
+                cur.CommitCase()
+            cur.EndChanges()
+        finally:
+            cur.close()
+        return cases
+    return run
+
+def _WriteNewVars(count):
+    def run():
+        names = ["bench%d" % (i + 1) for i in range(count)]
+        cur = cursors.Cursor(accessType="w")
+        try:
+            cur.SetVarNameAndType(names, [0] * count)
+            cur.CommitDictionary()
+            cases = 0
+            while cur.fetchone() is not None:
+                for i, name in enumerate(names):
+                    cur.SetValueNumeric(name, cases + i)
+                cur.CommitCase()
+                cases += 1
+        finally:
+            cur.close()
+        return cases
+    return run
+
+def _RandomAccess(reads, cache, optimized, seed):
+    def run():
+        rng = random.Random(seed)
+        spss.StartDataStep()
+        try:
+            ds = dataStep.Dataset()
+            ds.cache = cache
+            ds.optimized = optimized
+            cases = len(ds.cases)
+            variables = len(ds.varlist)
+            for n in range(reads):
+                ds.cases[rng.randrange(cases), rng.randrange(variables)]
+        finally:
+            spss.EndDataStep()
+        return reads
+    return run
+
+def _Pivot(tables, rows, columns, deferred):
+    def run():
+        spss.StartProcedure("bench")
+        try:
+            return PivotEmission(tables, rows, columns, deferred)["cells"]
+        finally:
+            spss.EndProcedure()
+    return run
+
+def _XPath(queries):
+    def run():
+        handle = "spssbench"
+        spss.CreateXPathDictionary(handle)
+        try:
+            for n in range(queries):
+                spss.EvaluateXPath(handle, "/dictionary", "variable/@name")
+        finally:
+            spss.DeleteXPathHandle(handle)
+        return queries
+    return run
+
+def _Check(errLevel):
+    """Raises SpssError for the return code of a failed call."""
+    if errLevel:
+        err = errCode()
+        err.SetErrorCode(errLevel)
+        raise SpssError(err)
+
+# the end of the data for NextCase
+NO_MORE_DATA = 23
+
+def _CaseCalls(function, calls):
+    """NextCase steps through one pass of the data at most. The other functions
+       need a write cursor on a case: they set or commit the new variables benchn
+       and benchs calls / cases times on each case, so the time includes one
+       NextCase per case.
+    """
+    cur = cursors.Cursor(accessType="r" if function == "NextCase" else "w", isBinary=False)
+    try:
+        if function == "NextCase":
+            call = PyInvokeSpss.NextCase
+            done = 0
+            while done < calls:
+                errLevel = call()
+                if errLevel == NO_MORE_DATA:
+                    break
+                _Check(errLevel)
+                done += 1
+            return done
+        cur.SetVarNameAndType(["benchn", "benchs"], [0, 8])
+        cur.CommitDictionary()
+        call = getattr(PyInvokeSpss, function)
+        args = {"SetValueNumeric": ("benchn", 1.5), "SetValueChar": ("benchs", "abc"),
+                "CommitCaseRecord": ()}[function]
+        perCase = max(1, calls // max(1, spss.GetCaseCount()))
+        done = 0
+        while done < calls:
+            errLevel = PyInvokeSpss.NextCase()
+            if errLevel == NO_MORE_DATA:
+                break
+            _Check(errLevel)
+            for n in range(perCase):
+                _Check(call(*args))
+            done += perCase
+        return done
+    finally:
+        cur.close()
+
+def _Calls(function, calls):
+    """Calls a per-case or per-cell function of PyInvokeSpss directly, to time
+       the cost of one call through the extension module, and returns the
+       number of calls made. The first call that fails raises SpssError, so a
+       workload the backend can not run is skipped or reported as an error
+       instead of timing the failure.
+    """
+    def run():
+        if function in ("NextCase", "SetValueNumeric", "SetValueChar", "CommitCaseRecord"):
+            return _CaseCalls(function, calls)
+        spss.StartDataStep()
+        try:
+            dsName = dataStep.Dataset().name
+            call = getattr(PyInvokeSpss, function)
+            if function == "GetNCellValue":
+                for n in range(calls):
+                    _Check(call(dsName, 0, 0)[1])
+            else:
+                for n in range(calls):
+                    _Check(call(dsName, 0, 0, 1.5))
+        finally:
+            spss.EndDataStep()
+        return calls
+    return run
+
+CALL_FUNCTIONS = ("GetNCellValue", "SetNCellValue", "NextCase", "SetValueNumeric", "SetValueChar",
+                  "CommitCaseRecord")
+
+def DefaultWorkloads(cases=10000, numeric=8, strings=2, width=8):
+    """Returns the standard workloads over a generated dataset of the given shape.
+       --usage
+          DefaultWorkloads(cases=10000, numeric=8, strings=2, width=8)
+       --returns
+          A list of Workload.
+    """
+    def data():
+        MakeData(cases, numeric, strings, width)
+    shape = {"cases": cases, "numeric": numeric, "strings": strings, "width": width}
+    workloads = []
+    for isBinary in (False, True):
+        mode = "binary" if isBinary else "classic"
+        for fetch in (1, 100, 1000, None):
+            size = "fetchall" if fetch is None else ("fetchone" if fetch == 1 else "fetchmany%d" % fetch)
+            workloads.append(Workload("read/%s/%s" % (mode, size), "case", _Read(isBinary, fetch), data,
+                                      isBinary=isBinary, fetch=fetch, **shape))
+    workloads.append(Workload("read/raw/fetchmany1000", "case", _RawRead(1000), data, fetch=1000, **shape))
+    workloads.append(Workload("append", "case", _Append(max(1, cases // 10)), data,
+                              appended=max(1, cases // 10), **shape))
+    workloads.append(Workload("write_new_vars", "case", _WriteNewVars(4), data, newVariables=4, **shape))
+    for cache in (False, True):
+        for optimized in (False, True):
+            name = "datastep_random/%s/%s" % ("cache" if cache else "nocache",
+                                              "optimized" if optimized else "plain")
+            workloads.append(Workload(name, "cell", _RandomAccess(cases, cache, optimized, 1), data,
+                                      reads=cases, cache=cache, optimized=optimized, **shape))
+    for deferred in (False, True):
+        workloads.append(Workload("pivot/%s" % ("deferred" if deferred else "direct"), "cell",
+                                  _Pivot(10, 100, 10, deferred), None,
+                                  tables=10, rows=100, columns=10, deferred=deferred))
+    workloads.append(Workload("xpath", "query", _XPath(1000), data, queries=1000, **shape))
+    for function in CALL_FUNCTIONS:
+        # NextCase can not step past the data
+        calls = cases if function == "NextCase" else cases * 10
+        workloads.append(Workload("calls/%s" % function, "call", _Calls(function, calls), data,
+                                  calls=calls, **shape))
+    return workloads
+
+def _PeakRss():
+    """The peak resident set size of the process in kilobytes, None where unknown."""
+    try:
+        import resource
+    except ImportError:
+        return None
+    peak = resource.getrusage(resource.RUSAGE_SELF).ru_maxrss
+    # bytes on macOS, kilobytes elsewhere
+    return peak // 1024 if sys.platform == "darwin" else peak
+
+def _Measure(workload, repeat, memory):
+    result = {"name": workload.name, "unit": workload.unit, "params": workload.params}
+    runs = []
+    count = 0
+    try:
+        for n in range(repeat):
+            if workload.prepare:
+                workload.prepare()
+            gc.collect()
+            start = time.perf_counter()
+            count = workload.run()
+            runs.append(time.perf_counter() - start)
+        if memory:
+            if workload.prepare:
+                workload.prepare()
+            gc.collect()
+            collections = sum(stat["collections"] for stat in gc.get_stats())
+            blocks = sys.getallocatedblocks()
+            tracemalloc.start()
+            try:
+                workload.run()
+                traced, tracedPeak = tracemalloc.get_traced_memory()
+            finally:
+                tracemalloc.stop()
+            result["tracedPeakBytes"] = tracedPeak
+            result["allocatedBlocks"] = sys.getallocatedblocks() - blocks
+            result["gcCollections"] = sum(stat["collections"] for stat in gc.get_stats()) - collections
+    except SpssError as e:
+        # 1076: the backend does not have a function the workload needs
+        result["status"] = "skipped" if e.errLevel == 1076 else "error"
+        result["detail"] = str(e)
+        return result
+    except Exception as e:
+        result["status"] = "error"
+        result["detail"] = "%s: %s" % (type(e).__name__, e)
+        return result
+
+    best = min(runs)
+    result["status"] = "ok"
+    result["count"] = count
+    result["runs"] = runs
+    result["seconds"] = best
+    result["medianSeconds"] = sorted(runs)[len(runs) // 2]
+    result["perSec"] = count / best if best > 0 else 0.0
+    result["peakRssKb"] = _PeakRss()
+    return result
+
+def Run(workloads=None, repeat=3, memory=True, only=None, out=None, verbose=False):
+    """Measures workloads and returns the report.
+       --usage
+          Run(workloads=None, repeat=3, memory=True, only=None, out=None, verbose=False)
+       --arguments
+          workloads: A list of Workload; DefaultWorkloads() when None.
+          repeat: How many times each workload runs; the fastest run is reported.
+          memory: If True, each workload runs once more under tracemalloc to
+                  measure its Python allocations. The timed runs are not traced.
+          only: If given, only the workloads whose name contains it are run.
+          out: If given, the report is also saved to this file.
+          verbose: If True, a line is printed for each workload.
+       --returns
+          A dictionary with the environment and one result per workload:
+          status (ok, skipped when the backend lacks a function, or error),
+          count (units per run), seconds (the fastest run), medianSeconds,
+          perSec, peakRssKb (the peak RSS of the process so far), and with
+          memory tracedPeakBytes (the peak of the Python allocations),
+          allocatedBlocks (the net change of the allocated Python blocks) and
+          gcCollections (the garbage collections, a measure of the objects
+          allocated and freed).
+       --details
+          The peak RSS only grows within a process; run a workload alone
+          (only=name) to see its own peak.
+       --examples
+          import spss, spss.bench
+          report = spss.bench.Run(only="read/", out="read.json")
+    """
+    if workloads is None:
+        workloads = DefaultWorkloads()
+    report = {"tool": "spss.bench",
+              "format": 1,
+              "time": time.time(),
+              "python": sys.version.split()[0],
+              "platform": sys.platform,
+              "repeat": repeat,
+              "results": []}
+    for workload in workloads:
+        if only and only not in workload.name:
+            continue
+        result = _Measure(workload, repeat, memory)
+        report["results"].append(result)
+        if verbose:
+            print(_FormatResult(result))
+    if out:
+        Save(report, out)
+    return report
+
+def _FormatResult(result):
+    if result["status"] != "ok":
+        return "%-40s %s %s" % (result["name"], result["status"], result.get("detail", ""))
+    line = "%-40s %14.0f %s/s" % (result["name"], result["perSec"], result["unit"])
+    if "tracedPeakBytes" in result:
+        line += " %10d KB traced %8d gc" % (result["tracedPeakBytes"] // 1024, result["gcCollections"])
+    return line
+
+def Save(report, path):
+    """Writes a report of Run to a JSON file."""
+    with open(path, "w") as f:
+        json.dump(report, f, indent=1)
+
+def Load(path):
+    """Reads a report written by Save."""
+    with open(path) as f:
+        return json.load(f)
+
+def Compare(baseline, current, threshold=0.05):
+    """Lines up the workloads of two reports.
+       --usage
+          Compare(baseline, current, threshold=0.05)
+       --arguments
+          baseline, current: Reports of Run, or the files they were saved to.
+          threshold: The relative change of the throughput below which a
+                     workload counts as unchanged.
+       --returns
+          A list with one dictionary per workload of either report: name,
+          baseline and current throughput (None when it did not run), ratio
+          (current over baseline) and change: faster, slower, same, or
+          missing when it ran in only one report.
+    """
+    if not isinstance(baseline, dict):
+        baseline = Load(baseline)
+    if not isinstance(current, dict):
+        current = Load(current)
+    def rates(report):
+        return dict((r["name"], r.get("perSec") if r["status"] == "ok" else None) for r in report["results"])
+    before = rates(baseline)
+    after = rates(current)
+    names = [r["name"] for r in baseline["results"]]
+    names += [r["name"] for r in current["results"] if r["name"] not in before]
+    rows = []
+    for name in names:
+        row = {"name": name, "baseline": before.get(name), "current": after.get(name), "ratio": None}
+        if row["baseline"] and row["current"]:
+            row["ratio"] = row["current"] / row["baseline"]
+            if row["ratio"] > 1 + threshold:
+                row["change"] = "faster"
+            elif row["ratio"] < 1 - threshold:
+                row["change"] = "slower"
+            else:
+                row["change"] = "same"
+        else:
+            row["change"] = "missing"
+        rows.append(row)
+    return rows
+
+def FormatComparison(rows):
+    """Formats the result of Compare as a text table."""
+    lines = ["%-40s %14s %14s %8s  %s" % ("workload", "baseline/s", "current/s", "ratio", "change")]
+    for row in rows:
+        def rate(value):
+            return "-" if value is None else "%.0f" % value
+        ratio = "-" if row["ratio"] is None else "%.3f" % row["ratio"]
+        lines.append("%-40s %14s %14s %8s  %s" % (row["name"], rate(row["baseline"]), rate(row["current"]),
+                                                  ratio, row["change"]))
+    return "\n".join(lines)
+
+def main(argv=None):
+    """The command line: run [options] or compare baseline.json current.json."""
+    import argparse
+    parser = argparse.ArgumentParser(prog="python -m spss.bench")
+    commands = parser.add_subparsers(dest="command", required=True)
+    runParser = commands.add_parser("run", help="measure the workloads")
+    runParser.add_argument("--cases", type=int, default=10000)
+    runParser.add_argument("--numeric", type=int, default=8)
+    runParser.add_argument("--strings", type=int, default=2)
+    runParser.add_argument("--width", type=int, default=8)
+    runParser.add_argument("--repeat", type=int, default=3)
+    runParser.add_argument("--only", default=None, help="run the workloads whose name contains this")
+    runParser.add_argument("--no-memory", action="store_true", help="skip the traced run")
+    runParser.add_argument("--out", default=None, help="save the report to this JSON file")
+    compareParser = commands.add_parser("compare", help="compare two saved reports")
+    compareParser.add_argument("baseline")
+    compareParser.add_argument("current")
+    compareParser.add_argument("--threshold", type=float, default=0.05)
+    args = parser.parse_args(argv)
+
+    if args.command == "compare":
+        rows = Compare(args.baseline, args.current, args.threshold)
+        print(FormatComparison(rows))
+        return 1 if any(row["change"] == "slower" for row in rows) else 0
+
+    if not PyInvokeSpss.IsBackendReady():
+        spss.StartSPSS()
+    try:
+        workloads = DefaultWorkloads(args.cases, args.numeric, args.strings, args.width)
+        report = Run(workloads, args.repeat, not args.no_memory, args.only, args.out, verbose=True)
+    finally:
+        spss.StopSPSS()
+    return 2 if any(r["status"] == "error" for r in report["results"]) else 0
+
+if __name__ == "__main__":
+    sys.exit(main())
+
+__all__ = ["PivotEmission", "Workload", "MakeData", "DefaultWorkloads", "Run", "Save", "Load",
+           "Compare", "FormatComparison"]
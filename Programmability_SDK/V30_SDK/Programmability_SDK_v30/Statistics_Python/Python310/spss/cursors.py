@@ -2559,6 +2559,181 @@ class AppendCursor(BaseCursor,BaseWriteAppendCursor):
             if error.IsError():
                 raise SpssError(error)
 
+class RawCursor(object):
+    """Reads cases of the active dataset as raw case buffers.
+
+       --usage
+         RawCursor(var)
+
+       --arguments
+         var: A list or tuple, indicating the position of the variables in the
+              active dataset to decode, starting with 0 for the first variable in
+              the file order. When var is None, all variables are decoded.
+
+       --details
+         fetchraw returns a read-only memoryview over a copy of the next case.
+         The memoryview is released when the cursor moves; a view made from it,
+         or a copy made with bytes(), keeps the case. The copy is reused for the
+         next case once nothing refers to it. fetchblock copies the next n cases
+         into one buffer.
+         In a case buffer a numeric value is a double and a string value is its
+         bytes padded to a multiple of 8. offsets gives the byte offset of each
+         variable in var. fetchone and fetchmany decode the cases natively into
+         tuples, with the system missing value as None. User missing values are
+         returned as values.
+
+       --example
+         import spss, struct
+         spss.Submit("GET FILE='demo.sav'.")
+         cur = spss.RawCursor([0])
+         total = 0.0
+         while True:
+             block = cur.fetchblock(1000)
+             if not block:
+                 break
+             for value in block.cast('d')[cur.offsets[0]//8::cur.caseSize//8]:
+                 total += value
+         cur.close()
+
+    """
+    def __init__(self, var = None):
+        self.running = False
+        if not spss.IsBackendReady():
+            spss.StartSPSS()
+        error.Reset()
+        varCount = spss.GetVariableCount()
+        if 0 == varCount:
+            error.SetErrorCode(1024)
+            raise SpssError(error)
+        if var is None:
+            var = list(range(varCount))
+        elif not isinstance(var,(tuple,list)):
+            error.SetErrorCode(1027)
+            raise SpssError(error)
+        for i in var:
+            if not isinstance(i,int):
+                error.SetErrorCode(1026)
+                raise SpssError(error)
+            if i < 0 or i >= varCount:
+                error.SetErrorCode(1028)
+                raise SpssError(error)
+        self.var = list(var)
+        self.varType = [spss.GetVariableType(i) for i in self.var]
+
+        # the obs index of each variable, from the backend when it knows them,
+        # otherwise from the dictionary order.
+        name = PyInvokeSpss.GetActive()[0]
+        obsList,caseLength,errLevel = PyInvokeSpss.GetRawCaseLayout(spssutil.CheckStr(name),self.var)
+        if errLevel:
+            obs = []
+            nextObs = 0
+            for i in range(varCount):
+                obs.append(nextObs)
+                vtype = spss.GetVariableType(i)
+                nextObs += 1 if 0 == vtype else (vtype + 7) // 8
+            obsList = [obs[i] for i in self.var]
+        self.obs = obsList
+        self.offsets = [x * 8 for x in obsList]
+        self.caseSize = 0
+        self.systemMissingValue = PyInvokeSpss.GetSystemMissingValue()
+        self._utf8mode = PyInvokeSpss.IsUTF8mode()
+        self._view = None
+
+        error.SetErrorCode(PyInvokeSpss.MakeRawCursor())
+        if error.IsError():
+            raise SpssError(error)
+        self.running = True
+        self.__id = id(self)
+        PythonCursors[self.__id] = self
+
+    def __del__(self):
+        if self.running:
+            self.close()
+
+    def __IsClose__(self):
+        error.Reset()
+        if not self.running:
+            error.SetErrorCode(1030)
+            raise SpssError(error)
+
+    def __release(self):
+        if self._view is not None:
+            try:
+                self._view.release()
+            except BufferError:
+                # an object made from the view still holds it, with its own copy of the case
+                pass
+            self._view = None
+
+    def fetchraw(self):
+        """Returns a read-only memoryview over a copy of the next case, or
+        None when there are no more cases. The memoryview is released when the
+        cursor moves or closes.
+        """
+        self.__IsClose__()
+        self.__release()
+        view,caseSize,errLevel = PyInvokeSpss.NextCasePtr()
+        if 23 == errLevel:
+            return None
+        error.SetErrorCode(errLevel)
+        if error.IsError():
+            raise SpssError(error)
+        self.caseSize = caseSize
+        self._view = view
+        return view
+
+    def fetchblock(self, size):
+        """Returns a memoryview over a copy of the next size cases, one after
+        another, or None when there are no more cases. The number of cases is
+        len(block) // caseSize.
+        """
+        self.__IsClose__()
+        self.__release()
+        if not isinstance(size,int) or size <= 0:
+            error.SetErrorCode(1035)
+            raise SpssError(error)
+        block,rows,caseSize,errLevel = PyInvokeSpss.NextCaseBlock(size)
+        if 23 == errLevel and 0 == rows:
+            return None
+        error.SetErrorCode(errLevel)
+        if error.IsError():
+            raise SpssError(error)
+        self.caseSize = caseSize
+        return memoryview(block)
+
+    def decode(self, buffer):
+        """Decodes a buffer returned by fetchraw or fetchblock into a list of
+        tuples, one for each case.
+        """
+        return PyInvokeSpss.DecodeCases(buffer,self.caseSize,self.obs,self.varType,
+                                        self.systemMissingValue,self._utf8mode)
+
+    def fetchone(self):
+        """Returns the next case as a tuple, or None when there are no more cases."""
+        view = self.fetchraw()
+        if view is None:
+            return None
+        return self.decode(view)[0]
+
+    def fetchmany(self, size):
+        """Returns the next size cases as a list of tuples."""
+        block = self.fetchblock(size)
+        if block is None:
+            return []
+        return self.decode(block)
+
+    def close(self):
+        """Close the cursor."""
+        error.Reset()
+        if self.running:
+            self.__release()
+            PyInvokeSpss.close()
+            try:
+                PythonCursors.pop(self.__id)
+            except KeyError:
+                pass
+        self.running = False
+
 class Cursor(object):
     """This class provides the ability to read cases, append cases, and add
     new variables to the active data source. There are three usage modes:
@@ -2666,6 +2841,6 @@ class Cursor(object):
             error.SetErrorCode(1034)
             raise SpssError(error)
 
-__all__ = ["Cursor"]
+__all__ = ["Cursor", "RawCursor"]
 from . import version
 __version__ = version.version
@@ -24,6 +24,7 @@ from . import spssutil
 import time
 import datetime
 import operator
+import itertools
 
 class BasePivotTable(object):
     def __init__(self,title,templateName,outline="",isSplit=True,caption=""):
@@ -940,13 +941,23 @@ class BasePivotTable(object):
         if len(rows) != len(rowlabels):
             error.SetErrorCode(1038)
             raise SpssError(error)
-        for i in range(len(rows)):
-            rows[i]._Dimension__SetCategory(rowlabels[i])
 
         if len(col.categories) != len(cells):
             error.SetErrorCode(1032)
             raise SpssError(error)
 
+        #Sends the whole row in one call when it only holds numbers under string categories.
+        if self.__SetNumberCells(rows + [col], [[x] for x in rowlabels] + [col.categories], cells):
+            for i in range(len(rows)):
+                rows[i]._Dimension__KeepCategory(rowlabels[i])
+            col._Dimension__KeepCategory(col.categories[-1])
+            for (i,cat) in enumerate(col.categories):
+                self.cells[rowlabels + (cat,)] = cells[i]
+            return
+
+        for i in range(len(rows)):
+            rows[i]._Dimension__SetCategory(rowlabels[i])
+
         for (i,cat) in enumerate(col.categories):
             col._Dimension__SetCategory(cat)
             col._Dimension__SetCell(cells[i])
@@ -1020,18 +1031,158 @@ class BasePivotTable(object):
         if len(cols) != len(collabels):
             error.SetErrorCode(1038)
             raise SpssError(error)
-        for i in range(len(cols)):
-            cols[i]._Dimension__SetCategory(collabels[i])
 
         if len(row.categories) != len(cells):
             error.SetErrorCode(1032)
             raise SpssError(error)
 
+        #Sends the whole column in one call when it only holds numbers under string categories.
+        if self.__SetNumberCells(cols + [row], [[x] for x in collabels] + [row.categories], cells):
+            for i in range(len(cols)):
+                cols[i]._Dimension__KeepCategory(collabels[i])
+            row._Dimension__KeepCategory(row.categories[-1])
+            for (i,cat) in enumerate(row.categories):
+                self.cells[collabels + (cat,)] = cells[i]
+            return
+
+        for i in range(len(cols)):
+            cols[i]._Dimension__SetCategory(collabels[i])
+
         for (i,cat) in enumerate(row.categories):
             row._Dimension__SetCategory(cat)
             row._Dimension__SetCell(cells[i])
             self.cells[collabels + (cat,)] = cells[i]
 
+    def SetCellMatrix(self,cells,formatSpecs=None,varIndexes=None):
+        """
+        Sets the numeric cells of the whole pivot table in one call.
+
+        --usage
+          SetCellMatrix(cells,formatSpecs=None,varIndexes=None)
+
+        --arguments
+          cells: The numeric cell values in row-major order over the categories of the dimensions,
+                 taken in the order the dimensions were added, with the last dimension varying fastest.
+                 Can be a list or tuple of numbers, or a C-contiguous buffer of doubles such as
+                 array.array('d',...) or a float64 numpy array.
+          formatSpecs: Optional. The formatSpec of each cell, as a list, tuple or buffer of C ints.
+                 If omitted, the default formatSpec of the pivot table is used for every cell.
+          varIndexes: Optional. The variable index of each cell, used by the formatSpecs
+                 Mean, Variable, StdDev, Difference and Sum.
+
+        --details
+          The categories must be set before calling this method. When all of them are CellText.String,
+          the cells are sent to the backend in a single call. The cells are not kept for retrieval
+          with table[categories].
+
+        --example
+          import spss, array
+          try:
+              spss.StartSPSS()
+              spss.Submit("get file='demo.sav'.")
+              spss.StartProcedure("proc")
+              table = spss.BasePivotTable("table","mytable")
+              row = table.Append(spss.Dimension.Place.row,"rowdim")
+              column = table.Append(spss.Dimension.Place.column,"coldim")
+              table.SetCategories(row,[spss.CellText.String("a"),spss.CellText.String("b")])
+              table.SetCategories(column,[spss.CellText.String("c"),spss.CellText.String("d")])
+              table.SetCellMatrix(array.array('d',[23,24,25,26]),[spss.FormatSpec.Count]*4)
+              spss.EndProcedure()
+              spss.StopSPSS()
+          except spss.SpssError:
+              print("Error.")
+          print(spss.GetLastErrorMessage())
+        """
+        error.Reset()
+
+        if not self.dims:
+            error.SetErrorCode(1038)
+            raise SpssError(error)
+
+        size = 1
+        for dim in self.dims:
+            size *= len(dim.categories)
+
+        if formatSpecs is None:
+            format = CellText._CellText__GetDefaultFormatSpec()
+            CellText._CellText__CheckFormatSpec(format)
+            formatSpecs = [format[0]] * size
+            if varIndexes is None and len(format) > 1 and format[1] is not None:
+                varIndexes = [format[1]] * size
+
+        if all(isinstance(cat, CellText.String) for dim in self.dims for cat in dim.categories):
+            error.SetErrorCode(PyInvokeSpss.SetNumberCells(spssutil.CheckStr(self.outline),
+                                                           spssutil.CheckStr(self.title),
+                                                           spssutil.CheckStr(self.templateName),
+                                                           self.isSplit,
+                                                           self.__DimensionList(self.dims, [dim.categories for dim in self.dims]),
+                                                           cells,
+                                                           formatSpecs,
+                                                           varIndexes))
+            if error.IsError():
+                raise SpssError(error)
+            for dim in self.dims:
+                dim._Dimension__KeepCategory(dim.categories[-1])
+            return
+
+        #Other category types go through the backend one cell at a time.
+        if not isinstance(cells, (tuple,list)):
+            cells = memoryview(cells).cast('B').cast('d').tolist()
+        if not isinstance(formatSpecs, (tuple,list)):
+            formatSpecs = memoryview(formatSpecs).cast('B').cast('i').tolist()
+        if varIndexes is not None and not isinstance(varIndexes, (tuple,list)):
+            varIndexes = memoryview(varIndexes).cast('B').cast('i').tolist()
+        if len(cells) != size or len(formatSpecs) != size or (varIndexes is not None and len(varIndexes) != size):
+            error.SetErrorCode(1032)
+            raise SpssError(error)
+
+        for (i,categories) in enumerate(itertools.product(*[dim.categories for dim in self.dims])):
+            varIndex = varIndexes[i] if varIndexes is not None else None
+            self[categories] = CellText.Number(cells[i],formatSpecs[i],varIndex)
+
+    def __DimensionList(self, dims, categories):
+        """
+        Describes dimensions and their string categories for PyInvokeSpss.SetNumberCells.
+        """
+        return [(spssutil.CheckStr(dim.name), dim.place, dim.position, dim.hideName, dim.hideLabels,
+                 [spssutil.CheckStr(cat.data["value"]) for cat in cats])
+                for (dim, cats) in zip(dims, categories)]
+
+    def __SetNumberCells(self, dims, categories, cells):
+        """
+        Sends CellText.Number cells under CellText.String categories in one call.
+        Returns False, without sending anything, for any other kind of category or cell.
+        """
+        if not cells:
+            return False
+        for cats in categories:
+            for cat in cats:
+                if not isinstance(cat, CellText.String):
+                    return False
+
+        values = []
+        formatSpecs = []
+        varIndexes = []
+        for cell in cells:
+            if not isinstance(cell, CellText.Number):
+                return False
+            formatSpec, varIndex = CellText._CellText__FormatArgs(cell.data["format"])
+            values.append(cell.data["value"])
+            formatSpecs.append(formatSpec)
+            varIndexes.append(varIndex)
+
+        error.SetErrorCode(PyInvokeSpss.SetNumberCells(spssutil.CheckStr(self.outline),
+                                                       spssutil.CheckStr(self.title),
+                                                       spssutil.CheckStr(self.templateName),
+                                                       self.isSplit,
+                                                       self.__DimensionList(dims, categories),
+                                                       values,
+                                                       formatSpecs,
+                                                       varIndexes))
+        if error.IsError():
+            raise SpssError(error)
+        return True
+
     def SetCell(self,cell):
         """
         Sets the cell value of the current category of the pivot table.
@@ -1350,24 +1501,23 @@ class Dimension(object):
         error.Reset()
         CellText._CellText__CheckType(category)
 
-        if category not in self.categories:
-            self.categories.append(category)
-        self.current = category
+        self.__KeepCategory(category)
 
         if 0 == category.data["type"]: #Number
-            format = category.data["format"]
-            CellText._CellText__SetFormatSpec(format)
-
-            error.SetErrorCode(PyInvokeSpss.AddNumberCategory(spssutil.CheckStr(self.tableAttr["outline"]),
-                                                              spssutil.CheckStr(self.tableAttr["title"]),
-                                                              spssutil.CheckStr(self.tableAttr["templateName"]),
-                                                              self.tableAttr["isSplit"],
-                                                              spssutil.CheckStr(self.name),
-                                                              self.place,
-                                                              self.position,
-                                                              self.hideName,
-                                                              self.hideLabels,
-                                                              category.data["value"]))
+            formatSpec, varIndex = CellText._CellText__FormatArgs(category.data["format"])
+
+            error.SetErrorCode(PyInvokeSpss.AddNumberCategoryWithFormat(spssutil.CheckStr(self.tableAttr["outline"]),
+                                                                        spssutil.CheckStr(self.tableAttr["title"]),
+                                                                        spssutil.CheckStr(self.tableAttr["templateName"]),
+                                                                        self.tableAttr["isSplit"],
+                                                                        spssutil.CheckStr(self.name),
+                                                                        self.place,
+                                                                        self.position,
+                                                                        self.hideName,
+                                                                        self.hideLabels,
+                                                                        category.data["value"],
+                                                                        formatSpec,
+                                                                        varIndex))
             if error.IsError():
                 raise SpssError(error)
 
@@ -1427,6 +1577,14 @@ class Dimension(object):
                 if error.IsError():
                     raise SpssError(error)
 
+    def __KeepCategory(self,category):
+        """
+        Records category as the current category of the dimension, without calling the backend.
+        """
+        if category not in self.categories:
+            self.categories.append(category)
+        self.current = category
+
     def __SetCell(self,cell):
         """
         Sets cell in the current category.
@@ -1435,19 +1593,20 @@ class Dimension(object):
         CellText._CellText__CheckType(cell)
 
         if 0 == cell.data["type"]: #Number
-            format = cell.data["format"]
-            CellText._CellText__SetFormatSpec(format)
-
-            error.SetErrorCode(PyInvokeSpss.SetNumberCell(spssutil.CheckStr(self.tableAttr["outline"]),
-                                                          spssutil.CheckStr(self.tableAttr["title"]),
-                                                          spssutil.CheckStr(self.tableAttr["templateName"]),
-                                                          self.tableAttr["isSplit"],
-                                                          spssutil.CheckStr(self.name),
-                                                          self.place,
-                                                          self.position,
-                                                          self.hideName,
-                                                          self.hideLabels,
-                                                          cell.data["value"]))
+            formatSpec, varIndex = CellText._CellText__FormatArgs(cell.data["format"])
+
+            error.SetErrorCode(PyInvokeSpss.SetNumberCellWithFormat(spssutil.CheckStr(self.tableAttr["outline"]),
+                                                                    spssutil.CheckStr(self.tableAttr["title"]),
+                                                                    spssutil.CheckStr(self.tableAttr["templateName"]),
+                                                                    self.tableAttr["isSplit"],
+                                                                    spssutil.CheckStr(self.name),
+                                                                    self.place,
+                                                                    self.position,
+                                                                    self.hideName,
+                                                                    self.hideLabels,
+                                                                    cell.data["value"],
+                                                                    formatSpec,
+                                                                    varIndex))
             if error.IsError():
                 raise SpssError(error)
 
@@ -1682,6 +1841,14 @@ class CellText(object):
             # The others have not the argument requirement.
             CellText._CellText__formatDict[format[0]]()
 
+    def __FormatArgs(format):
+        """
+        Returns the (formatSpec, varIndex) pair for the fused number setters.
+        """
+        CellText._CellText__CheckFormatSpec(format)
+        varIndex = format[1] if len(format) > 1 else None
+        return (format[0], 0 if varIndex is None else varIndex)
+
     def __SetDefaultFormatSpec(format):
         error.Reset()
         CellText._CellText__CheckFormatSpec(format)
@@ -1707,6 +1874,7 @@ class CellText(object):
     __CheckFormatSpec = staticmethod(__CheckFormatSpec)
 
     __SetFormatSpec = staticmethod(__SetFormatSpec)
+    __FormatArgs = staticmethod(__FormatArgs)
     __SetDefaultFormatSpec = staticmethod(__SetDefaultFormatSpec)
     __GetDefaultFormatSpec = staticmethod(__GetDefaultFormatSpec)
     __ToCellText = staticmethod(__ToCellText)
@@ -1967,7 +2135,8 @@ class TextBlock(object):
 
         --arguments
           name: The string name of the TextBlock.
-          content: The string content of the TextBlock.
+          content: The string content of the TextBlock, or a list of strings
+                   which are added as separate lines in one call.
           outline: The optional string outline title for the TextBlock.
                    If the outline title is not specified, the TextBlock will be placed one level under
                    the root item for the procedure that created it. Otherwise, the TextBlock will be
@@ -1987,9 +2156,14 @@ class TextBlock(object):
         error.Reset()
         self.__outline = outline
         self.__name = name
-        self.__content = content
         self.__skip = 1
 
+        if isinstance(content,(list,tuple)):
+            self.__content = ""
+            self.__AddLines(content,self.__skip)
+            return
+
+        self.__content = content
         error.SetErrorCode(PyInvokeSpss.AddTextBlock(spssutil.CheckStr(self.__outline),
                                                      spssutil.CheckStr(self.__name),
                                                      spssutil.CheckStr(self.__content),
@@ -2037,11 +2211,105 @@ class TextBlock(object):
         if error.IsError():
             raise SpssError(error)
 
+    def extend(self,lines,skip=1):
+        """
+        Appends several lines to an existing TextBlock object in one call.
+
+        --usage
+          extend(lines,skip=1)
+
+        --arguments
+          lines: A list of strings to append to the TextBlock.
+          skip: The number of new lines to skip before each line, or a list
+                with the number for each line.
+
+        --example
+            import spss
+            try:
+                spss.Submit("get file='demo.sav'.")
+                spss.StartProcedure("proc")
+                text = spss.TextBlock("text","hello")
+                text.extend(["world","again"],skip=1)
+            finally:
+                spss.EndProcedure()
+                spss.StopSPSS()
+
+        """
+        error.Reset()
+        if not isinstance(lines,(list,tuple)):
+            error.SetErrorCode(1000)
+            if error.IsError():
+                raise SpssError(error)
+        self.__AddLines(lines,skip)
+
+    def __AddLines(self,lines,skip):
+        """
+        Sends lines to the backend with one AddTextBlockLines call.
+        """
+        if isinstance(skip,int):
+            skips = None if 1 == skip else [skip] * len(lines)
+        elif isinstance(skip,(list,tuple)) and all(isinstance(n,int) for n in skip):
+            skips = skip
+        else:
+            error.SetErrorCode(1000)
+            raise SpssError(error)
+        if not lines:
+            return
+
+        lines = [spssutil.CheckStr(line) for line in lines]
+        error.SetErrorCode(PyInvokeSpss.AddTextBlockLines(spssutil.CheckStr(self.__outline),
+                                                          spssutil.CheckStr(self.__name),
+                                                          lines,
+                                                          skips))
+        if error.IsError():
+            raise SpssError(error)
+
+        if self.__content:
+            self.__content += "\n"
+        self.__content += "\n".join(lines)
+        self.__skip = skips[-1] if skips else 1
+
     def __del__(self): self.__content = ""
     def __repr__(self): return repr(self.__content.split('\n'))
 
 
-__all__ = ["BasePivotTable","Dimension","CellText","TextBlock"]
+def SetDeferredPivotTables(deferred=True):
+    """Defers pivot table output until the tables are flushed.
+       While deferred, the calls that build pivot tables are kept in memory
+       and sent to the backend when FlushPivotTables, TextBlock, SplitChange or
+       EndProcedure is called. Tables with a complete grid of number cells are
+       sent as one block. Errors from the backend are raised at flush time.
+       Turning deferral off flushes the pending tables.
+       --examples:
+          import spss
+          try:
+              spss.Submit("GET FILE='demo.sav'.")
+              spss.SetDeferredPivotTables(True)
+              spss.StartProcedure("procname")
+              table = spss.BasePivotTable("table","tableTemplate")
+              table.SimplePivotTable(cells=[1,2,3,4])
+              spss.EndProcedure()
+          except spss.SpssError:
+              print("Error.")
+          finally:
+              spss.SetDeferredPivotTables(False)
+    """
+    error.Reset()
+    error.SetErrorCode(PyInvokeSpss.SetDeferredPivotTables(bool(deferred)))
+    if error.IsError():
+        raise SpssError(error)
+
+def FlushPivotTables():
+    """Sends the deferred pivot tables to the backend.
+       See SetDeferredPivotTables.
+    """
+    error.Reset()
+    error.SetErrorCode(PyInvokeSpss.FlushPivotTables())
+    if error.IsError():
+        raise SpssError(error)
+
+__all__ = ["BasePivotTable","Dimension","CellText","TextBlock",
+           "SetDeferredPivotTables","FlushPivotTables"]
 
 from . import version
 __version__ = version.version
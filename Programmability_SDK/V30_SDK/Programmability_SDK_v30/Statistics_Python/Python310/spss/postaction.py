@@ -42,26 +42,30 @@ def end():
     if n < 1:
         return
     
-    preaction.wop[-1].stream.flush()
-    preaction.rop[-1].stream.seek(preaction.rop[-1].stream.tell())
-    k=preaction.rop[-1].stream.read().split("\n")
-    if not k[len(k)-1]:
-        del k[len(k)-1]   
-    for item in k:
-        if not item:
-            spss.PostOutput(item)
-        else:
-            length = len(item)
-            loop = length//width
-            rm=length%width
-            for i in range(loop):
-                spss.PostOutput(item[i*width:(i+1)*width])
-            if rm > 0:
-                spss.PostOutput(item[-rm:])
-    preaction.wop[-1].stream.seek(0,0)
-    #preaction.wop[-1].truncate(0)
-    preaction.wop[-1].stream.close()
-    preaction.rop[-1].stream.close()
+    if preaction.rop[-1] is None:
+        ## native output sink, InvokePython posts the rest after end returns
+        preaction.wop[-1].flush()
+    else:
+        preaction.wop[-1].stream.flush()
+        preaction.rop[-1].stream.seek(preaction.rop[-1].stream.tell())
+        k=preaction.rop[-1].stream.read().split("\n")
+        if not k[len(k)-1]:
+            del k[len(k)-1]   
+        for item in k:
+            if not item:
+                spss.PostOutput(item)
+            else:
+                length = len(item)
+                loop = length//width
+                rm=length%width
+                for i in range(loop):
+                    spss.PostOutput(item[i*width:(i+1)*width])
+                if rm > 0:
+                    spss.PostOutput(item[-rm:])
+        preaction.wop[-1].stream.seek(0,0)
+        #preaction.wop[-1].truncate(0)
+        preaction.wop[-1].stream.close()
+        preaction.rop[-1].stream.close()
     del preaction.wop[-1]
     del preaction.rop[-1]
 
@@ -79,14 +79,26 @@ def start(nestedDepth=0,spssTemp=None):
     ## Always using utf-8 encoding    
     fileenc = codecs.lookup("raw_unicode_escape")
 
-    filew = open(tempfullname,'wb')
-    filer = open(tempfullname,'r')
-
     if isU8mode:
         PyInvokeSpss.SetDefaultEncoding("utf-8")
     elif locale.getlocale()[1] is not None:
         PyInvokeSpss.SetDefaultEncoding(locale.getlocale()[1])
 
+    ## The output goes to the native buffer of InvokePython, there is no temp file to read.
+    sink = spssutil.GetOutputSink()
+    if sink is not None:
+        wop.append(sink)
+        rop.append(None)
+        if nestedDepth == 0:
+            oldstdout = sys.stdout
+            oldstderr = sys.stderr
+        sys.stdout = sink
+        sys.stderr = sink
+        return
+
+    filew = open(tempfullname,'wb')
+    filer = open(tempfullname,'r')
+
     from .spssutil import ConvertibleStreamRecoder
     cSRwriter = ConvertibleStreamRecoder(filew, dataenc.encode, dataenc.decode, 
             fileenc.streamreader, fileenc.streamwriter, "replace")
@@ -40,6 +40,14 @@ runStartSPSS=False
 global ProcDictionary
 ProcDictionary = {}
 
+#Futures of SubmitAsync that have not completed
+global PendingSubmits
+PendingSubmits = set()
+
+#The Future class of SubmitAsync, created on first use
+global SubmitFutureClass
+SubmitFutureClass = None
+
 
 def fixMacCert():
     """Set ssl certificate path on Mac"""
@@ -91,7 +99,10 @@ def __PostOuputToPython():
 def __PostOutputToSpss():
     #Create output to spss log when spss drive mode
     #if not isPythonDrive():
-    if len(preaction.wop) > 0:
+    if len(preaction.wop) > 0 and preaction.rop[-1] is None:
+        ## native output sink of InvokePython
+        preaction.wop[-1].flush()
+    elif len(preaction.wop) > 0:
         preaction.wop[-1].stream.flush()
         preaction.rop[-1].stream.seek(preaction.rop[-1].tell())
         text=preaction.rop[-1].stream.read().split("\n")
@@ -1496,6 +1507,45 @@ def Submit(cmdList):
         error.SetErrorCode(1004)
         raise SpssError(error)
 
+    #One entry, run as a single submission: its lines are queued and the last is submitted
+    cmds = ["\n".join(__CommandLines(cmdList))]
+
+    #Create output to spss log when has spss output
+    __PostOutputToSpss()
+
+    #Queue the lines and submit the last one in one call
+    errLevel = PyInvokeSpss.SubmitBatch(cmds)[0]
+    error.SetErrorCode(errLevel)
+
+    if error.IsError():
+        raise SpssError(error)
+
+    if not PyInvokeSpss.IsUTF8mode():
+        error.SetErrorCode(1075)
+        raise SpssError(error)
+
+    spssutil.cmnglb.update(utf8mode = bool(PyInvokeSpss.IsUTF8mode()))
+
+    if sys.platform == 'win32':
+        cLocale = (PyInvokeSpss.GetCLocale())[0]
+        locale.setlocale(locale.LC_ALL,cLocale)
+
+    #Create output to external language log when external language drive mode
+    if spssutil.cmnglb._cmnglb__xdriven and runStartSPSS:
+        __PostOuputToPython()
+
+    if error.IsError():
+        raise SpssError(error)
+
+
+def __CommandLines(cmdList):
+    """This function is not part of the programmability API.
+    Calling this function directly may have unexpected side effects.
+    The interface of this function may change in future releases
+    without prior notice.
+
+    Splits cmdList into lines.
+    """
     tempList = []
     if isinstance((cmdList),str):
         cmdList = spssutil.CheckStr(cmdList)
@@ -1507,39 +1557,177 @@ def Submit(cmdList):
             #Every element of command list or tuple must be string
             x = spssutil.CheckStr(x)
             tempList += x.split("\n")
+    return tempList
+
+def __QueueCommandLines(cmdList):
+    """This function is not part of the programmability API.
+    Calling this function directly may have unexpected side effects.
+    The interface of this function may change in future releases
+    without prior notice.
+
+    Splits cmdList into lines, queues all of them except the last one
+    and returns the list of lines.
+    """
+    tempList = __CommandLines(cmdList)
 
     #Queue all command lines except the last one
     for cmd in tempList[:-1]:
         error.SetErrorCode(PyInvokeSpss.QueueCommandPart(cmd,len(cmd.encode('utf-8'))))
         if error.IsError():
-            raise SpssError
+            raise SpssError(error)
+    return tempList
 
-    #Create output to spss log when has spss output
-    __PostOutputToSpss()
+def SubmitAsync(cmdList):
+    """Submits the command text to IBM SPSS Statistics and returns without waiting
+    for it to run.
+
+        --usage
+          future = SubmitAsync(cmdList)
 
-    #Queue the last command and execute all
-    error.SetErrorCode(PyInvokeSpss.Submit(tempList[-1],len(tempList[-1].encode('utf-8'))))
+        --arguments
+          cmdList: A string, list, or tuple of command lines, as for Submit.
 
-    if error.IsError():
+        --details
+          The commands are queued on a backend worker thread and run in the order
+          they were submitted. The return value is a concurrent.futures.Future whose
+          result is None when the commands have run, or which raises SpssError.
+          To await it in asyncio code, use AwaitSubmit or asyncio.wrap_future.
+          While the commands run, do work that does not use IBM SPSS Statistics,
+          for example reading OMS output files. The other functions of this module
+          wait until the queued commands have run. The output of the commands is
+          written to the Python output by the thread that first calls result() or
+          exception() of the future, not by the thread that ran them.
+          SubmitAsync can not be called inside a BEGIN PROGRAM block, and the
+          commands can not contain one: the worker thread can not share the block
+          of the caller.
+
+        --example
+          import spss
+          future = spss.SubmitAsync("FREQUENCIES VARIABLES=ALL.")
+          # prepare the next job here
+          future.result()
+
+    """
+    error.Reset()
+
+    if not IsBackendReady(): StartSPSS()
+
+    #Check the type of the argument
+    if not isinstance(cmdList,(str,list,tuple)):
+        error.SetErrorCode(1004)
         raise SpssError(error)
 
-    if not PyInvokeSpss.IsUTF8mode():
-        error.SetErrorCode(1075)
+    #A nested BEGIN PROGRAM would run on the worker thread, which would wait for
+    #the block the caller runs in and get a namespace of its own
+    tempList = __CommandLines(cmdList)
+    depth,errLevel = PyInvokeSpss.GetNestDepth()
+    if not spssutil.cmnglb._cmnglb__xdriven or (0 == errLevel and depth > 0) or \
+       any(line.lstrip().upper().startswith("BEGIN PROGRAM") for line in tempList):
+        error.SetErrorCode(1077)
         raise SpssError(error)
 
-    spssutil.cmnglb.update(utf8mode = bool(PyInvokeSpss.IsUTF8mode()))
+    tempList = __QueueCommandLines(tempList)
 
-    if sys.platform == 'win32':
-        cLocale = (PyInvokeSpss.GetCLocale())[0]
-        locale.setlocale(locale.LC_ALL,cLocale)
+    #Create output to spss log when has spss output
+    __PostOutputToSpss()
 
-    #Create output to external language log when external language drive mode
-    if spssutil.cmnglb._cmnglb__xdriven and runStartSPSS:
-        __PostOuputToPython()
+    future = __SubmitFuture()
+    future.set_running_or_notify_cancel()
+    def completed(ticket, errLevel):
+        #Called on the backend worker thread when the commands have run
+        err = errCode()
+        err.SetErrorCode(errLevel)
+        if err.IsError():
+            future.set_exception(SpssError(err))
+        else:
+            future.set_result(None)
+
+    #Wait for the queued commands at exit, before the backend is stopped
+    if not PendingSubmits:
+        atexit.register(__WaitPendingSubmits)
+    PendingSubmits.add(future)
+    future.add_done_callback(PendingSubmits.discard)
 
+    last = tempList[-1]
+    ticket,errLevel = PyInvokeSpss.SubmitAsync(last,len(last.encode('utf-8')),completed)
+    error.SetErrorCode(errLevel)
     if error.IsError():
+        PendingSubmits.discard(future)
         raise SpssError(error)
+    return future
+
+def __SubmitFuture():
+    """This function is not part of the programmability API.
+    Calling this function directly may have unexpected side effects.
+    The interface of this function may change in future releases
+    without prior notice.
+
+    """
+    global SubmitFutureClass
+    if SubmitFutureClass is None:
+        import concurrent.futures
+        def collect():
+            #Apply the locale and post the output on the collecting thread
+            PyInvokeSpss.ResetSubmitLocale()
+            if spssutil.cmnglb._cmnglb__xdriven and runStartSPSS:
+                __PostOuputToPython()
+
+        class SubmitFuture(concurrent.futures.Future):
+            def __init__(self):
+                super().__init__()
+                self.collected = False
+
+            def collectOnce(self):
+                with self._condition:
+                    if self.collected:
+                        return
+                    self.collected = True
+                collect()
+
+            def result(self, timeout=None):
+                value = super().result(timeout)
+                self.collectOnce()
+                return value
+
+            def exception(self, timeout=None):
+                exc = super().exception(timeout)
+                if exc is None:
+                    self.collectOnce()
+                return exc
+
+        SubmitFutureClass = SubmitFuture
+    return SubmitFutureClass()
+
+def __WaitPendingSubmits():
+    """This function is not part of the programmability API.
+    Calling this function directly may have unexpected side effects.
+    The interface of this function may change in future releases
+    without prior notice.
+
+    """
+    import concurrent.futures
+    atexit.unregister(__WaitPendingSubmits)
+    concurrent.futures.wait(list(PendingSubmits))
+
+async def AwaitSubmit(cmdList):
+    """Submits the command text to IBM SPSS Statistics from asyncio code.
+
+        --usage
+          await AwaitSubmit(cmdList)
+
+        --details
+          Runs SubmitAsync and awaits its future, so the event loop keeps running
+          other tasks while the commands run. Raises SpssError when the commands fail.
 
+        --example
+          import asyncio, spss
+          async def job():
+              await spss.AwaitSubmit("GET FILE='demo.sav'.")
+          asyncio.run(job())
+
+    """
+    import asyncio
+    return await asyncio.wrap_future(SubmitAsync(cmdList))
 
 def __toString(value):
     """This function is not part of the programmability API.
@@ -2504,6 +2692,8 @@ __all__ = ["CreateXPathDictionary",
            "StartSPSS",
            "StopSPSS",
            "Submit",
+           "SubmitAsync",
+           "AwaitSubmit",
            "IsBackendReady",
            "GetLastErrorLevel",
            "GetLastErrorMessage",
@@ -40,6 +40,37 @@ class __cmnglb:
     def __repr__(self):
         return " ".join([str(self.__utf8mode), str(self.__xdriven), str(self.__backendready)])
 
+## Stands in for sys.stdout and sys.stderr when InvokePython buffers the
+## output itself (OutputBuffer=1 in spssdxcfg.ini). write and flush are the
+## native functions, so print does not run any Python code.
+class NativeOutputSink(object):
+    encoding = "utf-8"
+    errors = "replace"
+
+    def __init__(self, native):
+        self.write = native.write
+        self.flush = native.flush
+
+    def writelines(self, lines):
+        for line in lines:
+            self.write(line)
+
+    def isatty(self):
+        return False
+
+    def writable(self):
+        return True
+
+def GetOutputSink():
+    """Return a NativeOutputSink when InvokePython buffers the output, otherwise None."""
+    try:
+        import _spssdxoutput
+    except ImportError:
+        return None
+    if not _spssdxoutput.enabled():
+        return None
+    return NativeOutputSink(_spssdxoutput)
+
 ##StreamRecoder convert codepage string into unicode string
 class ConvertibleStreamRecoder(codecs.StreamRecoder):
     def __init__(self, stream, encode, decode, Reader, Writer,
@@ -339,11 +370,21 @@ def findLocalizedErrfile(language):
 def SetErrorMessage():
     """Read the error messages from spsspy.properties file,
     and initial global object 'errTable' with the error messages.
+    The English messages are read first, so a message that is not
+    translated yet is shown in English.
     """
     # read error messages from messages.err file
     language = GetLanguage()
-    errfile = findLocalizedErrfile(language)
+    if language != "en":
+        ReadErrorMessages(findLocalizedErrfile("en"))
+    ReadErrorMessages(findLocalizedErrfile(language))
+
+    noError = errTable['okay'][str(0)]
 
+def ReadErrorMessages(errfile):
+    """Add the error messages of one spsspy.properties file to 'errTable',
+    replacing the messages it already has.
+    """
     fp = codecs.open(errfile,"rb", "utf8")
     #fp = open(errfile,"r")
     errLines = fp.readlines()
@@ -367,8 +408,6 @@ def SetErrorMessage():
         else:
             errTable[errType] = {errLevel:errMsg}
 
-    noError = errTable['okay'][str(0)]
-
 __all__ = ["CheckStr","CheckStr16","CvtSpssDatetime"]
 
 
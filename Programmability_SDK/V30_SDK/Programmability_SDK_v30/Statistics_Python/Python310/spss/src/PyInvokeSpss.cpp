@@ -23,6 +23,20 @@
 
 #include "PyInvokeSpss.h"
 #include <locale.h>
+#include <limits.h>
+#include <stdio.h>
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <map>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+#include <atomic>
+#include <algorithm>
+#include <type_traits>
 #include "wchar.h"
 
 #ifdef MS_WINDOWS
@@ -35,684 +49,504 @@
 
 extern "C"{
 
+  static void DrainSubmitQueue();
+
+extern "C++" {
+  //a module function that first waits for the commands queued by SubmitAsync,
+  //so that the submit worker is the only thread using the backend while they run.
+  template<PyObject* (*F)(PyObject*, PyObject*)>
+  static PyObject* AfterSubmits(PyObject* self, PyObject* args)
+  {
+      DrainSubmitQueue();
+      return F(self, args);
+  }
+
+  template<PyObject* (*F)(PyObject*, PyObject* const*, Py_ssize_t)>
+  static PyObject* AfterSubmitsFast(PyObject* self, PyObject* const* args, Py_ssize_t nargs)
+  {
+      DrainSubmitQueue();
+      return F(self, args, nargs);
+  }
+}
+
+  #define XD_METHOD(f) AfterSubmits<f>
+  #define XD_FASTCALL_METHOD(f) (PyCFunction)(void(*)(void))AfterSubmitsFast<f>
+
+    // every function but the ones that collect a SubmitAsync ticket waits for the queued commands.
     static PyMethodDef PyInvokeSpss_methods[] = {
-    {"QueueCommandPart", ext_QueueCommandPart, METH_VARARGS,
+    {"QueueCommandPart", XD_METHOD(ext_QueueCommandPart), METH_VARARGS,
      "Queue a command."},
-    {"CreateXPathDictionary", ext_CreateXPathDictionary, METH_VARARGS,
+    {"CreateXPathDictionary", XD_METHOD(ext_CreateXPathDictionary), METH_VARARGS,
      "Create a xpath dictionary."},
-    {"RemoveXPathHandle", ext_RemoveXPathHandle, METH_VARARGS,
+    {"RemoveXPathHandle", XD_METHOD(ext_RemoveXPathHandle), METH_VARARGS,
      "Remove a xpath dictionary."},
-    {"EvaluateXPath", ext_EvaluateXPath, METH_VARARGS,
+    {"EvaluateXPath", XD_METHOD(ext_EvaluateXPath), METH_VARARGS,
      "Search xpath with the given context."},
-    {"Submit", ext_Submit, METH_VARARGS,
+    {"Submit", XD_METHOD(ext_Submit), METH_VARARGS,
      "Submit a command."},
-    {"GetCaseCount", ext_GetCaseCount, METH_VARARGS,
+    {"GetCaseCount", XD_METHOD(ext_GetCaseCount), METH_VARARGS,
      "Get the number of cases."},
-    {"GetVariableCount", ext_GetVariableCount, METH_VARARGS,
+    {"GetVariableCount", XD_METHOD(ext_GetVariableCount), METH_VARARGS,
      "Get the number of variables."},
-    {"GetVariableFormat", ext_GetVariableFormat, METH_VARARGS,
+    {"GetVariableFormat", XD_METHOD(ext_GetVariableFormat), METH_VARARGS,
      "Get the format of the given variable."},
-    {"GetVariableLabel", ext_GetVariableLabel, METH_VARARGS,
+    {"GetVariableLabel", XD_METHOD(ext_GetVariableLabel), METH_VARARGS,
      "Get the label of the given variable."},
-    {"GetVariableMeasurementLevel", ext_GetVariableMeasurementLevel, METH_VARARGS,
+    {"GetVariableMeasurementLevel", XD_METHOD(ext_GetVariableMeasurementLevel), METH_VARARGS,
      "Get the measurement level of the given variable."},
-    {"GetVariableName", ext_GetVariableName, METH_VARARGS,
+    {"GetVariableName", XD_METHOD(ext_GetVariableName), METH_VARARGS,
      "Get the name of the given variable."},
-    {"GetVariableType", ext_GetVariableType, METH_VARARGS,
+    {"GetVariableType", XD_METHOD(ext_GetVariableType), METH_VARARGS,
      "Get the type of the given variable."},
-    {"IsXDriven", ext_IsXDriven, METH_VARARGS,
+    {"IsXDriven", XD_METHOD(ext_IsXDriven), METH_VARARGS,
      "An integer indicating how the backend is being run. A return value of 1 indicates that Python controls the backend. A return value of 0 indicates that PASW Statistics controls the backend."},
-    {"PostSpssOutput", ext_PostSpssOutput, METH_VARARGS,
+    {"PostSpssOutput", XD_METHOD(ext_PostSpssOutput), METH_VARARGS,
      "Post output to PASW Statistics."},
-    {"StartSpss", ext_StartSpss, METH_VARARGS,
+    {"StartSpss", XD_METHOD(ext_StartSpss), METH_VARARGS,
      "Start PASW Statistics."},
-    {"StopSpss", ext_StopSpss, METH_VARARGS,
+    {"StopSpss", XD_METHOD(ext_StopSpss), METH_VARARGS,
      "Stop PASW Statistics."},
-    {"IsBackendReady", ext_IsBackendReady, METH_VARARGS,
+    {"IsBackendReady", XD_METHOD(ext_IsBackendReady), METH_VARARGS,
      "Report if backend ready."},
-    {"GetXmlUtf16", ext_GetXmlUtf16, METH_VARARGS,
+    {"GetXmlUtf16", XD_METHOD(ext_GetXmlUtf16), METH_VARARGS,
      "Get xml From xml work space with encoding utf-16."},
-    {"GetImage", ext_GetImage, METH_VARARGS,
+    {"GetImage", XD_METHOD(ext_GetImage), METH_VARARGS,
     "Get the images from XML workspace."},
-    {"GetSetting", ext_GetSetting, METH_VARARGS,
+    {"GetSetting", XD_METHOD(ext_GetSetting), METH_VARARGS,
     "Get the value of an options setting"},
-    {"GetOMSTagList", ext_GetOMSTagList, METH_VARARGS,
+    {"GetOMSTagList", XD_METHOD(ext_GetOMSTagList), METH_VARARGS,
     "Returns a list of tags associated with any active OMS requests"},
-    {"GetHandleList", ext_GetHandleList, METH_VARARGS,
+    {"GetHandleList", XD_METHOD(ext_GetHandleList), METH_VARARGS,
      "Get handle list from TransSpace."},
-    {"GetFileHandles", ext_GetFileHandles, METH_VARARGS,
+    {"GetFileHandles", XD_METHOD(ext_GetFileHandles), METH_VARARGS,
      "Get file handle list."},
-    {"fetchone", ext_fetchone, METH_VARARGS,
+    {"fetchone", XD_METHOD(ext_fetchone), METH_VARARGS,
      "get the data from data source."},
-    {"fetchmany", ext_fetchmany, METH_VARARGS,
+    {"fetchmany", XD_METHOD(ext_fetchmany), METH_VARARGS,
      "get many data from data source."},
-    {"fetchall", ext_fetchall, METH_VARARGS,
+    {"fetchall", XD_METHOD(ext_fetchall), METH_VARARGS,
      "get all data from data source."},
-    {"close", ext_close, METH_VARARGS,
+    {"close", XD_METHOD(ext_close), METH_VARARGS,
      "clsoe the case cursor."},
-    {"cursor", ext_cursor, METH_VARARGS,
+    {"MakeRawCursor", XD_METHOD(ext_MakeRawCursor), METH_VARARGS,
+     "MakeRawCursor."},
+    {"NextCasePtr", XD_METHOD(ext_NextCasePtr), METH_VARARGS,
+     "NextCasePtr."},
+    {"NextCaseBlock", XD_METHOD(ext_NextCaseBlock), METH_VARARGS,
+     "NextCaseBlock."},
+    {"GetRawCaseLayout", XD_METHOD(ext_GetRawCaseLayout), METH_VARARGS,
+     "GetRawCaseLayout."},
+    {"DecodeCases", XD_METHOD(ext_DecodeCases), METH_VARARGS,
+     "DecodeCases."},
+    {"cursor", XD_METHOD(ext_cursor), METH_VARARGS,
      "intialize the cursor object."},
-    {"StartProcedure", ext_StartProcedure, METH_VARARGS,
+    {"StartProcedure", XD_METHOD(ext_StartProcedure), METH_VARARGS,
      "StartProcedure."},
-    {"SplitChange", ext_SplitChange, METH_VARARGS,
+    {"SplitChange", XD_METHOD(ext_SplitChange), METH_VARARGS,
      "SplitChange."},
-    {"EndProcedure", ext_EndProcedure, METH_VARARGS,
+    {"EndProcedure", XD_METHOD(ext_EndProcedure), METH_VARARGS,
      "EndProcedure."},
 
-    {"StartPivotTable", ext_StartPivotTable, METH_VARARGS,
+    {"StartPivotTable", XD_METHOD(ext_StartPivotTable), METH_VARARGS,
      "StartPivotTable."},
-    {"HidePivotTableTitle", ext_HidePivotTableTitle, METH_VARARGS,
+    {"HidePivotTableTitle", XD_METHOD(ext_HidePivotTableTitle), METH_VARARGS,
      "HidePivotTableTitle."},
-    {"PivotTableCaption", ext_PivotTableCaption, METH_VARARGS,
+    {"PivotTableCaption", XD_METHOD(ext_PivotTableCaption), METH_VARARGS,
      "PivotTableCaption."},
-    {"AddDimension", ext_AddDimension, METH_VARARGS,
+    {"AddDimension", XD_METHOD(ext_AddDimension), METH_VARARGS,
      "AddDimension."},
 
-    {"SetFormatSpecCoefficient", ext_SetFormatSpecCoefficient, METH_VARARGS,
+    {"SetFormatSpecCoefficient", XD_METHOD(ext_SetFormatSpecCoefficient), METH_VARARGS,
      "SetFormatSpecCoefficient."},
-    {"SetFormatSpecCoefficientSE", ext_SetFormatSpecCoefficientSE, METH_VARARGS,
+    {"SetFormatSpecCoefficientSE", XD_METHOD(ext_SetFormatSpecCoefficientSE), METH_VARARGS,
      "SetFormatSpecCoefficientSE."},
-    {"SetFormatSpecCoefficientVar", ext_SetFormatSpecCoefficientVar, METH_VARARGS,
+    {"SetFormatSpecCoefficientVar", XD_METHOD(ext_SetFormatSpecCoefficientVar), METH_VARARGS,
      "SetFormatSpecCoefficientVar."},
-    {"SetFormatSpecCorrelation", ext_SetFormatSpecCorrelation, METH_VARARGS,
+    {"SetFormatSpecCorrelation", XD_METHOD(ext_SetFormatSpecCorrelation), METH_VARARGS,
      "SetFormatSpecCorrelation."},
-    {"SetFormatSpecGeneralStat", ext_SetFormatSpecGeneralStat, METH_VARARGS,
+    {"SetFormatSpecGeneralStat", XD_METHOD(ext_SetFormatSpecGeneralStat), METH_VARARGS,
      "SetFormatSpecGeneralStat."},
-    {"SetFormatSpecMean", ext_SetFormatSpecMean, METH_VARARGS,
+    {"SetFormatSpecMean", XD_METHOD(ext_SetFormatSpecMean), METH_VARARGS,
      "SetFormatSpecMean."},
-    {"SetFormatSpecCount", ext_SetFormatSpecCount, METH_VARARGS,
+    {"SetFormatSpecCount", XD_METHOD(ext_SetFormatSpecCount), METH_VARARGS,
      "SetFormatSpecCount."},
-    {"SetFormatSpecPercent", ext_SetFormatSpecPercent, METH_VARARGS,
+    {"SetFormatSpecPercent", XD_METHOD(ext_SetFormatSpecPercent), METH_VARARGS,
      "SetFormatSpecPercent."},
-    {"SetFormatSpecPercentNoSign", ext_SetFormatSpecPercentNoSign, METH_VARARGS,
+    {"SetFormatSpecPercentNoSign", XD_METHOD(ext_SetFormatSpecPercentNoSign), METH_VARARGS,
      "SetFormatSpecPercentNoSign."},
-    {"SetFormatSpecProportion", ext_SetFormatSpecProportion, METH_VARARGS,
+    {"SetFormatSpecProportion", XD_METHOD(ext_SetFormatSpecProportion), METH_VARARGS,
      "SetFormatSpecProportion."},
-    {"SetFormatSpecSignificance", ext_SetFormatSpecSignificance, METH_VARARGS,
+    {"SetFormatSpecSignificance", XD_METHOD(ext_SetFormatSpecSignificance), METH_VARARGS,
      "SetFormatSpecSignificance."},
-    {"SetFormatSpecResidual", ext_SetFormatSpecResidual, METH_VARARGS,
+    {"SetFormatSpecResidual", XD_METHOD(ext_SetFormatSpecResidual), METH_VARARGS,
      "SetFormatSpecResidual."},
-    {"SetFormatSpecVariable", ext_SetFormatSpecVariable, METH_VARARGS,
+    {"SetFormatSpecVariable", XD_METHOD(ext_SetFormatSpecVariable), METH_VARARGS,
      "SetFormatSpecVariable."},
-    {"SetFormatSpecStdDev", ext_SetFormatSpecStdDev, METH_VARARGS,
+    {"SetFormatSpecStdDev", XD_METHOD(ext_SetFormatSpecStdDev), METH_VARARGS,
      "SetFormatSpecStdDev."},
-    {"SetFormatSpecDifference", ext_SetFormatSpecDifference, METH_VARARGS,
+    {"SetFormatSpecDifference", XD_METHOD(ext_SetFormatSpecDifference), METH_VARARGS,
      "SetFormatSpecDifference."},
-    {"SetFormatSpecSum", ext_SetFormatSpecSum, METH_VARARGS,
+    {"SetFormatSpecSum", XD_METHOD(ext_SetFormatSpecSum), METH_VARARGS,
      "SetFormatSpecSum."},
 
-    {"AddNumberCategory", ext_AddNumberCategory, METH_VARARGS,
+    {"AddNumberCategory", XD_METHOD(ext_AddNumberCategory), METH_VARARGS,
      "AddNumberCategory."},
-    {"AddStringCategory", ext_AddStringCategory, METH_VARARGS,
+    {"AddStringCategory", XD_METHOD(ext_AddStringCategory), METH_VARARGS,
      "AddStringCategory."},
-    {"AddVarNameCategory", ext_AddVarNameCategory, METH_VARARGS,
+    {"AddVarNameCategory", XD_METHOD(ext_AddVarNameCategory), METH_VARARGS,
      "AddVarNameCategory."},
-    {"AddVarValueDoubleCategory", ext_AddVarValueDoubleCategory, METH_VARARGS,
+    {"AddVarValueDoubleCategory", XD_METHOD(ext_AddVarValueDoubleCategory), METH_VARARGS,
      "AddVarValueDoubleCategory."},
-    {"AddVarValueStringCategory", ext_AddVarValueStringCategory, METH_VARARGS,
+    {"AddVarValueStringCategory", XD_METHOD(ext_AddVarValueStringCategory), METH_VARARGS,
      "AddVarValueStringCategory."},
-    {"SetNumberCell", ext_SetNumberCell, METH_VARARGS,
+    {"SetNumberCell", XD_METHOD(ext_SetNumberCell), METH_VARARGS,
      "SetNumberCell."},
-    {"SetStringCell", ext_SetStringCell, METH_VARARGS,
+    {"SetStringCell", XD_METHOD(ext_SetStringCell), METH_VARARGS,
      "SetStringCell."},
-    {"SetVarNameCell", ext_SetVarNameCell, METH_VARARGS,
+    {"SetVarNameCell", XD_METHOD(ext_SetVarNameCell), METH_VARARGS,
      "SetVarNameCell."},
-    {"SetVarValueDoubleCell", ext_SetVarValueDoubleCell, METH_VARARGS,
+    {"SetVarValueDoubleCell", XD_METHOD(ext_SetVarValueDoubleCell), METH_VARARGS,
      "SetVarValueDoubleCell."},
-    {"SetVarValueStringCell", ext_SetVarValueStringCell, METH_VARARGS,
+    {"SetVarValueStringCell", XD_METHOD(ext_SetVarValueStringCell), METH_VARARGS,
      "SetVarValueStringCell."},
-
-    {"AddCellFootnotes", ext_AddCellFootnotes, METH_VARARGS,
+    {"SetNumberCellWithFormat", XD_METHOD(ext_SetNumberCellWithFormat), METH_VARARGS,
+     "SetNumberCellWithFormat."},
+    {"AddNumberCategoryWithFormat", XD_METHOD(ext_AddNumberCategoryWithFormat), METH_VARARGS,
+     "AddNumberCategoryWithFormat."},
+    {"SetNumberCells", XD_METHOD(ext_SetNumberCells), METH_VARARGS,
+     "SetNumberCells."},
+    {"AddTextBlockLines", XD_METHOD(ext_AddTextBlockLines), METH_VARARGS,
+     "AddTextBlockLines."},
+    {"SetDeferredPivotTables", XD_METHOD(ext_SetDeferredPivotTables), METH_VARARGS,
+     "SetDeferredPivotTables."},
+    {"FlushPivotTables", XD_METHOD(ext_FlushPivotTables), METH_VARARGS,
+     "FlushPivotTables."},
+    {"GetPivotTableStats", XD_METHOD(ext_GetPivotTableStats), METH_VARARGS,
+     "GetPivotTableStats."},
+    {"GetXDSymbolReport", XD_METHOD(ext_GetXDSymbolReport), METH_VARARGS,
+     "GetXDSymbolReport."},
+    {"GetCallStats", XD_METHOD(ext_GetCallStats), METH_VARARGS,
+     "GetCallStats."},
+    {"SubmitBatch", XD_METHOD(ext_SubmitBatch), METH_VARARGS,
+     "SubmitBatch."},
+    {"SubmitAsync", ext_SubmitAsync, METH_VARARGS,
+     "SubmitAsync."},
+    {"PollSubmit", ext_PollSubmit, METH_VARARGS,
+     "PollSubmit."},
+    {"WaitSubmit", ext_WaitSubmit, METH_VARARGS,
+     "WaitSubmit."},
+    {"ResetSubmitLocale", ext_ResetSubmitLocale, METH_VARARGS,
+     "ResetSubmitLocale."},
+
+    {"AddCellFootnotes", XD_METHOD(ext_AddCellFootnotes), METH_VARARGS,
      "AddCellFootnotes."},
 
-    {"AddProcFootnotes", ext_AddProcFootnotes, METH_VARARGS,
+    {"AddProcFootnotes", XD_METHOD(ext_AddProcFootnotes), METH_VARARGS,
      "AddProcFootnotes."},
-    {"AddOutlineFootnotes", ext_AddOutlineFootnotes, METH_VARARGS,
+    {"AddOutlineFootnotes", XD_METHOD(ext_AddOutlineFootnotes), METH_VARARGS,
      "AddOutlineFootnotes."},
-    {"AddTitleFootnotes", ext_AddTitleFootnotes, METH_VARARGS,
+    {"AddTitleFootnotes", XD_METHOD(ext_AddTitleFootnotes), METH_VARARGS,
      "AddTitleFootnotes."},
-    {"AddDimFootnotes", ext_AddDimFootnotes, METH_VARARGS,
+    {"AddDimFootnotes", XD_METHOD(ext_AddDimFootnotes), METH_VARARGS,
      "AddDimFootnotes."},
-    {"AddCategoryFootnotes", ext_AddCategoryFootnotes, METH_VARARGS,
+    {"AddCategoryFootnotes", XD_METHOD(ext_AddCategoryFootnotes), METH_VARARGS,
      "AddCategoryFootnotes."},
 
 
-    {"AddTextBlock", ext_AddTextBlock, METH_VARARGS,
+    {"AddTextBlock", XD_METHOD(ext_AddTextBlock), METH_VARARGS,
      "AddTextBlock."},
 
-    {"SetVarName", ext_SetVarName, METH_VARARGS,
+    {"SetVarName", XD_METHOD(ext_SetVarName), METH_VARARGS,
      "SetVarName."},
-    {"SetVarLabel", ext_SetVarLabel, METH_VARARGS,
+    {"SetVarLabel", XD_METHOD(ext_SetVarLabel), METH_VARARGS,
      "SetVarLabel."},
-    {"CommitHeader", ext_CommitHeader, METH_VARARGS,
+    {"CommitHeader", XD_METHOD(ext_CommitHeader), METH_VARARGS,
      "CommitHeader."},
-    {"SetValueChar", ext_SetValueChar, METH_VARARGS,
+    {"SetValueChar", XD_FASTCALL_METHOD(ext_SetValueChar), METH_FASTCALL,
      "SetValueChar."},
-    {"SetValueNumeric", ext_SetValueNumeric, METH_VARARGS,
+    {"SetValueNumeric", XD_FASTCALL_METHOD(ext_SetValueNumeric), METH_FASTCALL,
      "SetValueNumeric."},
-    {"CommitCaseRecord", ext_CommitCaseRecord, METH_VARARGS,
+    {"CommitCaseRecord", XD_METHOD(ext_CommitCaseRecord), METH_NOARGS,
      "CommitCaseRecord."},
-     {"CommitManyCases", ext_CommitManyCases, METH_VARARGS,
+     {"CommitManyCases", XD_METHOD(ext_CommitManyCases), METH_VARARGS,
      "CommitManyCases."},
-    {"CommitNewCase", ext_CommitNewCase, METH_VARARGS,
+    {"CommitNewCase", XD_METHOD(ext_CommitNewCase), METH_VARARGS,
      "CommitNewCase."},
-    {"EndChanges", ext_EndChanges, METH_VARARGS,
+    {"EndChanges", XD_METHOD(ext_EndChanges), METH_VARARGS,
      "EndChagnes."},
-    {"SetVarCValueLabel", ext_SetVarCValueLabel, METH_VARARGS,
+    {"SetVarCValueLabel", XD_METHOD(ext_SetVarCValueLabel), METH_VARARGS,
      "SetVarCValueLabel."},
-    {"SetVarNValueLabel", ext_SetVarNValueLabel, METH_VARARGS,
+    {"SetVarNValueLabel", XD_METHOD(ext_SetVarNValueLabel), METH_VARARGS,
      "SetVarNValueLabel."},
-    {"SetVarCMissingValues", ext_SetVarCMissingValues, METH_VARARGS,
+    {"SetVarCMissingValues", XD_METHOD(ext_SetVarCMissingValues), METH_VARARGS,
      "SetVarCMissingValues."},
-    {"SetVarNMissingValues", ext_SetVarNMissingValues, METH_VARARGS,
+    {"SetVarNMissingValues", XD_METHOD(ext_SetVarNMissingValues), METH_VARARGS,
      "SetVarNMissingValues."},
-    {"SetVarMeasureLevel", ext_SetVarMeasureLevel, METH_VARARGS,
+    {"SetVarMeasureLevel", XD_METHOD(ext_SetVarMeasureLevel), METH_VARARGS,
      "SetVarMeasureLevel."},
-    {"SetVarAlignment", ext_SetVarAlignment, METH_VARARGS,
+    {"SetVarAlignment", XD_METHOD(ext_SetVarAlignment), METH_VARARGS,
      "SetVarAlignment."},
-    {"SetVarFormat", ext_SetVarFormat, METH_VARARGS,
+    {"SetVarFormat", XD_METHOD(ext_SetVarFormat), METH_VARARGS,
      "SetVarFormat."},
-    {"HasCursor", ext_HasCursor, METH_VARARGS,
+    {"HasCursor", XD_METHOD(ext_HasCursor), METH_VARARGS,
      "HasCursor."},
-    {"IsEndSplit", ext_IsEndSplit, METH_VARARGS,
+    {"IsEndSplit", XD_METHOD(ext_IsEndSplit), METH_VARARGS,
      "IsEndSplit."},
-    {"GetVarCMissingValues", ext_GetVarCMissingValues, METH_VARARGS,
+    {"GetVarCMissingValues", XD_METHOD(ext_GetVarCMissingValues), METH_VARARGS,
      "GetVarCMissingValues."},
-    {"GetVarNMissingValues", ext_GetVarNMissingValues, METH_VARARGS,
+    {"GetVarNMissingValues", XD_METHOD(ext_GetVarNMissingValues), METH_VARARGS,
      "GetVarNMissingValues."},
-    {"GetVarAttributeNames", ext_GetVarAttributeNames, METH_VARARGS,
+    {"GetVarAttributeNames", XD_METHOD(ext_GetVarAttributeNames), METH_VARARGS,
      "GetVarAttributeNames."},
-    {"GetVarAttributes", ext_GetVarAttributes, METH_VARARGS,
+    {"GetVarAttributes", XD_METHOD(ext_GetVarAttributes), METH_VARARGS,
      "GetVarAttributes."},
-    {"SetVarAttributes", ext_SetVarAttributes, METH_VARARGS,
+    {"SetVarAttributes", XD_METHOD(ext_SetVarAttributes), METH_VARARGS,
      "SetVarAttributes."},
-    {"SetVarAttributes", ext_SetVarAttributes, METH_VARARGS,
+    {"SetVarAttributes", XD_METHOD(ext_SetVarAttributes), METH_VARARGS,
      "SetVarAttributes."},
-    {"GetCaseCountInProcDS", ext_GetCaseCountInProcDS, METH_VARARGS,
+    {"GetCaseCountInProcDS", XD_METHOD(ext_GetCaseCountInProcDS), METH_VARARGS,
      "GetCaseCountInProcDS."},
-    {"GetVariableCountInProcDS", ext_GetVariableCountInProcDS, METH_VARARGS,
+    {"GetVariableCountInProcDS", XD_METHOD(ext_GetVariableCountInProcDS), METH_VARARGS,
      "GetVariableCountInProcDS."},
-    {"GetVariableFormatInProcDS", ext_GetVariableFormatInProcDS, METH_VARARGS,
+    {"GetVariableFormatInProcDS", XD_METHOD(ext_GetVariableFormatInProcDS), METH_VARARGS,
      "GetVariableFormatInProcDS."},
-    {"GetVariableLabelInProcDS", ext_GetVariableLabelInProcDS, METH_VARARGS,
+    {"GetVariableLabelInProcDS", XD_METHOD(ext_GetVariableLabelInProcDS), METH_VARARGS,
      "GetVariableLabelInProcDS."},
-    {"GetVariableMeasurementLevelInProcDS", ext_GetVariableMeasurementLevelInProcDS, METH_VARARGS,
+    {"GetVariableMeasurementLevelInProcDS", XD_METHOD(ext_GetVariableMeasurementLevelInProcDS), METH_VARARGS,
      "GetVariableMeasurementLevelInProcDS."},
-    {"GetVariableNameInProcDS", ext_GetVariableNameInProcDS, METH_VARARGS,
+    {"GetVariableNameInProcDS", XD_METHOD(ext_GetVariableNameInProcDS), METH_VARARGS,
      "GetVariableNameInProcDS."},
-    {"GetVariableTypeInProcDS", ext_GetVariableTypeInProcDS, METH_VARARGS,
+    {"GetVariableTypeInProcDS", XD_METHOD(ext_GetVariableTypeInProcDS), METH_VARARGS,
      "GetVariableTypeInProcDS."},
-    {"GetVarCMissingValuesInProcDS", ext_GetVarCMissingValuesInProcDS, METH_VARARGS,
+    {"GetVarCMissingValuesInProcDS", XD_METHOD(ext_GetVarCMissingValuesInProcDS), METH_VARARGS,
      "GetVarCMissingValuesInProcDS."},
-    {"GetVarNMissingValuesInProcDS", ext_GetVarNMissingValuesInProcDS, METH_VARARGS,
+    {"GetVarNMissingValuesInProcDS", XD_METHOD(ext_GetVarNMissingValuesInProcDS), METH_VARARGS,
      "GetVarNMissingValuesInProcDS."},
-    {"GetVarAttributeNamesInProcDS", ext_GetVarAttributeNamesInProcDS, METH_VARARGS,
+    {"GetVarAttributeNamesInProcDS", XD_METHOD(ext_GetVarAttributeNamesInProcDS), METH_VARARGS,
      "GetVarAttributeNamesInProcDS."},
-    {"GetVarAttributesInProcDS", ext_GetVarAttributesInProcDS, METH_VARARGS,
+    {"GetVarAttributesInProcDS", XD_METHOD(ext_GetVarAttributesInProcDS), METH_VARARGS,
      "GetVarAttributesInProcDS."},
-    {"SetUserMissingInclude", ext_SetUserMissingInclude, METH_VARARGS,
+    {"SetUserMissingInclude", XD_METHOD(ext_SetUserMissingInclude), METH_VARARGS,
      "SetUserMissingInclude."},
-    {"HasProcedure", ext_HasProcedure, METH_VARARGS,
+    {"HasProcedure", XD_METHOD(ext_HasProcedure), METH_VARARGS,
      "HasProcedure."},
-    {"GetSPSSLowHigh", ext_GetSPSSLowHigh, METH_VARARGS,
+    {"GetSPSSLowHigh", XD_METHOD(ext_GetSPSSLowHigh), METH_VARARGS,
      "GetSPSSLowHigh."},
-    {"GetWeightVar", ext_GetWeightVar, METH_VARARGS,
+    {"GetWeightVar", XD_METHOD(ext_GetWeightVar), METH_VARARGS,
      "GetWeightVar."},
-    {"ResetDataPass", ext_ResetDataPass, METH_VARARGS,
+    {"ResetDataPass", XD_METHOD(ext_ResetDataPass), METH_VARARGS,
      "ResetDataPass."},
-    {"ResetDataPassWrite", ext_ResetDataPassWrite, METH_VARARGS,
+    {"ResetDataPassWrite", XD_METHOD(ext_ResetDataPassWrite), METH_VARARGS,
      "ResetDataPassWrite."},
-    {"AllocNewVarsBuffer", ext_AllocNewVarsBuffer, METH_VARARGS,
+    {"AllocNewVarsBuffer", XD_METHOD(ext_AllocNewVarsBuffer), METH_VARARGS,
      "AllocNewVarsBuffer."},
-    {"SetOneVarNameAndType", ext_SetOneVarNameAndType, METH_VARARGS,
+    {"SetOneVarNameAndType", XD_METHOD(ext_SetOneVarNameAndType), METH_VARARGS,
      "SetOneVarNameAndType."},
-    {"SetFetchVarList", ext_SetFetchVarList, METH_VARARGS,
+    {"SetFetchVarList", XD_METHOD(ext_SetFetchVarList), METH_VARARGS,
      "SetFetchVarList."},
 
-    {"StartDataStep", ext_StartDataStep, METH_VARARGS,
+    {"StartDataStep", XD_METHOD(ext_StartDataStep), METH_VARARGS,
      "StartDataStep."},
-    {"EndDataStep", ext_EndDataStep, METH_VARARGS,
+    {"EndDataStep", XD_METHOD(ext_EndDataStep), METH_VARARGS,
      "EndDataStep."},
-    {"CreateDataset", ext_CreateDataset, METH_VARARGS,
+    {"CreateDataset", XD_METHOD(ext_CreateDataset), METH_VARARGS,
      "CreateDataset."},
-    {"SetDatasetName", ext_SetDatasetName, METH_VARARGS,
+    {"SetDatasetName", XD_METHOD(ext_SetDatasetName), METH_VARARGS,
      "SetDatasetName."},
-    {"GetNewDatasetName", ext_GetNewDatasetName, METH_VARARGS,
+    {"GetNewDatasetName", XD_METHOD(ext_GetNewDatasetName), METH_VARARGS,
      "GetNewDatasetName."},
-    {"GetActive", ext_GetActive, METH_VARARGS,
+    {"GetActive", XD_METHOD(ext_GetActive), METH_VARARGS,
      "GetActive."},
-    {"SetActive", ext_SetActive, METH_VARARGS,
+    {"SetActive", XD_METHOD(ext_SetActive), METH_VARARGS,
      "SetActive."},
-    {"CopyDataset", ext_CopyDataset, METH_VARARGS,
+    {"CopyDataset", XD_METHOD(ext_CopyDataset), METH_VARARGS,
      "CopyDataset."},
-    {"GetSpssDatasets", ext_GetSpssDatasets, METH_VARARGS,
+    {"GetSpssDatasets", XD_METHOD(ext_GetSpssDatasets), METH_VARARGS,
      "GetSpssDatasets."},
-    {"GetDatastepDatasets", ext_GetDatastepDatasets, METH_VARARGS,
+    {"GetDatastepDatasets", XD_METHOD(ext_GetDatastepDatasets), METH_VARARGS,
      "GetDatastepDatasets."},
-    {"CloseDataset", ext_CloseDataset, METH_VARARGS,
+    {"CloseDataset", XD_METHOD(ext_CloseDataset), METH_VARARGS,
      "CloseDataset."},
-    {"InsertVariable", ext_InsertVariable, METH_VARARGS,
+    {"InsertVariable", XD_METHOD(ext_InsertVariable), METH_VARARGS,
      "InsertVariable."},
-    {"DeleteVariable", ext_DeleteVariable, METH_VARARGS,
+    {"DeleteVariable", XD_METHOD(ext_DeleteVariable), METH_VARARGS,
      "DeleteVariable."},
-    {"GetVarCountInDS", ext_GetVarCountInDS, METH_VARARGS,
+    {"GetVarCountInDS", XD_METHOD(ext_GetVarCountInDS), METH_VARARGS,
      "GetVarCountInDS."},
-    {"GetVarNameInDS", ext_GetVarNameInDS, METH_VARARGS,
+    {"GetVarNameInDS", XD_METHOD(ext_GetVarNameInDS), METH_VARARGS,
      "GetVarNameInDS."},
-    {"SetVarNameInDS", ext_SetVarNameInDS, METH_VARARGS,
+    {"SetVarNameInDS", XD_METHOD(ext_SetVarNameInDS), METH_VARARGS,
      "SetVarNameInDS."},
-    {"GetVarLabelInDS", ext_GetVarLabelInDS, METH_VARARGS,
+    {"GetVarLabelInDS", XD_METHOD(ext_GetVarLabelInDS), METH_VARARGS,
      "GetVarLabelInDS."},
-    {"SetVarLabelInDS", ext_SetVarLabelInDS, METH_VARARGS,
+    {"SetVarLabelInDS", XD_METHOD(ext_SetVarLabelInDS), METH_VARARGS,
      "SetVarLabelInDS."},
-    {"GetVarTypeInDS", ext_GetVarTypeInDS, METH_VARARGS,
+    {"GetVarTypeInDS", XD_METHOD(ext_GetVarTypeInDS), METH_VARARGS,
      "GetVarTypeInDS."},
-    {"SetVarTypeInDS", ext_SetVarTypeInDS, METH_VARARGS,
+    {"SetVarTypeInDS", XD_METHOD(ext_SetVarTypeInDS), METH_VARARGS,
      "SetVarTypeInDS."},
-    {"GetVarFormatInDS", ext_GetVarFormatInDS, METH_VARARGS,
+    {"GetVarFormatInDS", XD_METHOD(ext_GetVarFormatInDS), METH_VARARGS,
      "GetVarFormatInDS."},
-    {"SetVarFormatInDS", ext_SetVarFormatInDS, METH_VARARGS,
+    {"SetVarFormatInDS", XD_METHOD(ext_SetVarFormatInDS), METH_VARARGS,
      "SetVarFormatInDS."},
-    {"GetVarAlignmentInDS", ext_GetVarAlignmentInDS, METH_VARARGS,
+    {"GetVarAlignmentInDS", XD_METHOD(ext_GetVarAlignmentInDS), METH_VARARGS,
      "GetVarAlignmentInDS."},
-    {"SetVarAlignmentInDS", ext_SetVarAlignmentInDS, METH_VARARGS,
+    {"SetVarAlignmentInDS", XD_METHOD(ext_SetVarAlignmentInDS), METH_VARARGS,
      "SetVarAlignmentInDS."},
-    {"GetVarMeasurementLevelInDS", ext_GetVarMeasurementLevelInDS, METH_VARARGS,
+    {"GetVarMeasurementLevelInDS", XD_METHOD(ext_GetVarMeasurementLevelInDS), METH_VARARGS,
      "GetVarMeasurementLevelInDS."},
-    {"SetVarMeasurementLevelInDS", ext_SetVarMeasurementLevelInDS, METH_VARARGS,
+    {"SetVarMeasurementLevelInDS", XD_METHOD(ext_SetVarMeasurementLevelInDS), METH_VARARGS,
      "SetVarMeasurementLevelInDS."},
-    {"GetVarNMissingValuesInDS", ext_GetVarNMissingValuesInDS, METH_VARARGS,
+    {"GetVarNMissingValuesInDS", XD_METHOD(ext_GetVarNMissingValuesInDS), METH_VARARGS,
      "GetVarNMissingValuesInDS."},
-    {"GetVarCMissingValuesInDS", ext_GetVarCMissingValuesInDS, METH_VARARGS,
+    {"GetVarCMissingValuesInDS", XD_METHOD(ext_GetVarCMissingValuesInDS), METH_VARARGS,
      "GetVarCMissingValuesInDS."},
-    {"SetVarNMissingValuesInDS", ext_SetVarNMissingValuesInDS, METH_VARARGS,
+    {"SetVarNMissingValuesInDS", XD_METHOD(ext_SetVarNMissingValuesInDS), METH_VARARGS,
      "SetVarNMissingValuesInDS."},
-    {"SetVarCMissingValuesInDS", ext_SetVarCMissingValuesInDS, METH_VARARGS,
+    {"SetVarCMissingValuesInDS", XD_METHOD(ext_SetVarCMissingValuesInDS), METH_VARARGS,
      "SetVarCMissingValuesInDS."},
-    {"GetVarAttributesNameInDS", ext_GetVarAttributesNameInDS, METH_VARARGS,
+    {"GetVarAttributesNameInDS", XD_METHOD(ext_GetVarAttributesNameInDS), METH_VARARGS,
      "GetVarAttributesNameInDS."},
-    {"GetVarAttributesInDS", ext_GetVarAttributesInDS, METH_VARARGS,
+    {"GetVarAttributesInDS", XD_METHOD(ext_GetVarAttributesInDS), METH_VARARGS,
      "GetVarAttributesInDS."},
-    {"SetVarAttributesInDS", ext_SetVarAttributesInDS, METH_VARARGS,
+    {"SetVarAttributesInDS", XD_METHOD(ext_SetVarAttributesInDS), METH_VARARGS,
      "SetVarAttributesInDS."},
-    {"DelVarAttributesInDS", ext_DelVarAttributesInDS, METH_VARARGS,
+    {"DelVarAttributesInDS", XD_METHOD(ext_DelVarAttributesInDS), METH_VARARGS,
      "DelVarAttributesInDS."},
-    {"GetVarNValueLabelInDS", ext_GetVarNValueLabelInDS, METH_VARARGS,
+    {"GetVarNValueLabelInDS", XD_METHOD(ext_GetVarNValueLabelInDS), METH_VARARGS,
      "GetVarNValueLabelInDS."},
-    {"GetVarCValueLabelInDS", ext_GetVarCValueLabelInDS, METH_VARARGS,
+    {"GetVarCValueLabelInDS", XD_METHOD(ext_GetVarCValueLabelInDS), METH_VARARGS,
      "GetVarCValueLabelInDS."},
-    {"SetVarNValueLabelInDS", ext_SetVarNValueLabelInDS, METH_VARARGS,
+    {"SetVarNValueLabelInDS", XD_METHOD(ext_SetVarNValueLabelInDS), METH_VARARGS,
      "SetVarNValueLabelInDS."},
-    {"SetVarNValueLabelsInDS", ext_SetVarNValueLabelsInDS, METH_VARARGS,
+    {"SetVarNValueLabelsInDS", XD_METHOD(ext_SetVarNValueLabelsInDS), METH_VARARGS,
      "SetVarNValueLabelsInDS."},
-    {"SetVarCValueLabelInDS", ext_SetVarCValueLabelInDS, METH_VARARGS,
+    {"SetVarCValueLabelInDS", XD_METHOD(ext_SetVarCValueLabelInDS), METH_VARARGS,
      "SetVarCValueLabelInDS."},
-    {"SetVarCValueLabelsInDS", ext_SetVarCValueLabelsInDS, METH_VARARGS,
+    {"SetVarCValueLabelsInDS", XD_METHOD(ext_SetVarCValueLabelsInDS), METH_VARARGS,
      "SetVarCValueLabelsInDS."},
-    {"DelVarValueLabelInDS", ext_DelVarValueLabelInDS, METH_VARARGS,
+    {"DelVarValueLabelInDS", XD_METHOD(ext_DelVarValueLabelInDS), METH_VARARGS,
      "DelVarValueLabelInDS."},
-    {"DelVarNValueLabelInDS", ext_DelVarNValueLabelInDS, METH_VARARGS,
+    {"DelVarNValueLabelInDS", XD_METHOD(ext_DelVarNValueLabelInDS), METH_VARARGS,
      "DelVarNValueLabelInDS."},
-    {"DelVarCValueLabelInDS", ext_DelVarCValueLabelInDS, METH_VARARGS,
+    {"DelVarCValueLabelInDS", XD_METHOD(ext_DelVarCValueLabelInDS), METH_VARARGS,
      "DelVarCValueLabelInDS."},
-    {"InsertCase", ext_InsertCase, METH_VARARGS,
+    {"InsertCase", XD_FASTCALL_METHOD(ext_InsertCase), METH_FASTCALL,
      "InsertCase."},
-    {"DeleteCase", ext_DeleteCase, METH_VARARGS,
+    {"DeleteCase", XD_METHOD(ext_DeleteCase), METH_VARARGS,
      "DeleteCase."},
-    {"GetCaseCountInDS", ext_GetCaseCountInDS, METH_VARARGS,
+    {"GetCaseCountInDS", XD_METHOD(ext_GetCaseCountInDS), METH_VARARGS,
      "GetCaseCountInDS."},
-    {"GetNCellValue", ext_GetNCellValue, METH_VARARGS,
+    {"GetNCellValue", XD_FASTCALL_METHOD(ext_GetNCellValue), METH_FASTCALL,
      "GetNCellValue."},
-    {"GetCellsValue", ext_GetCellsValue, METH_VARARGS,
+    {"GetCellsValue", XD_METHOD(ext_GetCellsValue), METH_VARARGS,
      "GetCellsValue."},
-    {"GetCCellValue", ext_GetCCellValue, METH_VARARGS,
+    {"GetCCellValue", XD_FASTCALL_METHOD(ext_GetCCellValue), METH_FASTCALL,
      "GetCCellValue."},
-    {"SetNCellValue", ext_SetNCellValue, METH_VARARGS,
+    {"SetNCellValue", XD_FASTCALL_METHOD(ext_SetNCellValue), METH_FASTCALL,
      "SetNCellValue."},
-    {"SetCCellValue", ext_SetCCellValue, METH_VARARGS,
+    {"SetCCellValue", XD_FASTCALL_METHOD(ext_SetCCellValue), METH_FASTCALL,
      "SetCCellValue."},
-    {"SetXDriveMode", ext_SetXDriveMode, METH_VARARGS,
+    {"SetXDriveMode", XD_METHOD(ext_SetXDriveMode), METH_VARARGS,
      "SetXDriveMode."},
-    {"IsUTF8mode", ext_IsUTF8mode, METH_VARARGS,
+    {"IsUTF8mode", XD_METHOD(ext_IsUTF8mode), METH_VARARGS,
      "IsUTF8mode."},
-    {"GetSplitVariableNames", ext_GetSplitVariableNames, METH_VARARGS,
+    {"GetSplitVariableNames", XD_METHOD(ext_GetSplitVariableNames), METH_VARARGS,
      "GetSplitVariableNames."},
-    {"GetDataFileAttributeNames", ext_GetDataFileAttributeNames, METH_VARARGS,
+    {"GetDataFileAttributeNames", XD_METHOD(ext_GetDataFileAttributeNames), METH_VARARGS,
      "GetDataFileAttributeNames."},
-    {"GetDataFileAttributes", ext_GetDataFileAttributes, METH_VARARGS,
+    {"GetDataFileAttributes", XD_METHOD(ext_GetDataFileAttributes), METH_VARARGS,
      "GetDataFileAttributes."},
-   {"GetDataFileAttributeNamesInProcDS", ext_GetDataFileAttributeNamesInProcDS, METH_VARARGS,
+   {"GetDataFileAttributeNamesInProcDS", XD_METHOD(ext_GetDataFileAttributeNamesInProcDS), METH_VARARGS,
      "GetDataFileAttributeNamesInProcDS."},
-    {"GetDataFileAttributesInProcDS", ext_GetDataFileAttributesInProcDS, METH_VARARGS,
+    {"GetDataFileAttributesInProcDS", XD_METHOD(ext_GetDataFileAttributesInProcDS), METH_VARARGS,
      "GetDataFileAttributesInProcDS."},
-    {"GetMultiResponseSetNames", ext_GetMultiResponseSetNames, METH_VARARGS,
+    {"GetMultiResponseSetNames", XD_METHOD(ext_GetMultiResponseSetNames), METH_VARARGS,
      "GetMultiResponseSetNames."},
-    {"GetMultiResponseSet", ext_GetMultiResponseSet, METH_VARARGS,
+    {"GetMultiResponseSet", XD_METHOD(ext_GetMultiResponseSet), METH_VARARGS,
      "GetMultiResponseSet."},
-    {"GetMultiResponseSetNamesInProcDS", ext_GetMultiResponseSetNamesInProcDS, METH_VARARGS,
+    {"GetMultiResponseSetNamesInProcDS", XD_METHOD(ext_GetMultiResponseSetNamesInProcDS), METH_VARARGS,
      "GetMultiResponseSetNamesInProcDS."},
-    {"GetMultiResponseSetInProcDS", ext_GetMultiResponseSetInProcDS, METH_VARARGS,
+    {"GetMultiResponseSetInProcDS", XD_METHOD(ext_GetMultiResponseSetInProcDS), METH_VARARGS,
      "GetMultiResponseSetInProcDS."},
-    {"SetDataFileAttributesInDS", ext_SetDataFileAttributesInDS, METH_VARARGS,
+    {"SetDataFileAttributesInDS", XD_METHOD(ext_SetDataFileAttributesInDS), METH_VARARGS,
      "SetDataFileAttributesInDS."},
-    {"SetMultiResponseSetInDS", ext_SetMultiResponseSetInDS, METH_VARARGS,
+    {"SetMultiResponseSetInDS", XD_METHOD(ext_SetMultiResponseSetInDS), METH_VARARGS,
      "SetMultiResponseSetInDS."},
-    {"GetDataFileAttributeNamesInDS", ext_GetDataFileAttributeNamesInDS, METH_VARARGS,
+    {"GetDataFileAttributeNamesInDS", XD_METHOD(ext_GetDataFileAttributeNamesInDS), METH_VARARGS,
     "GetDataFileAttributeNamesInDS."},
-    {"GetDataFileAttributesInDS", ext_GetDataFileAttributesInDS, METH_VARARGS,
+    {"GetDataFileAttributesInDS", XD_METHOD(ext_GetDataFileAttributesInDS), METH_VARARGS,
     "GetDataFileAttributesInDS."},
-    {"GetMultiResponseSetNamesInDS", ext_GetMultiResponseSetNamesInDS, METH_VARARGS,
+    {"GetMultiResponseSetNamesInDS", XD_METHOD(ext_GetMultiResponseSetNamesInDS), METH_VARARGS,
     "GetMultiResponseSetNamesInDS."},
-    {"GetMultiResponseSetInDS", ext_GetMultiResponseSetInDS, METH_VARARGS,
+    {"GetMultiResponseSetInDS", XD_METHOD(ext_GetMultiResponseSetInDS), METH_VARARGS,
     "GetMultiResponseSetInDS."},
-    {"GetVarColumnWidthInDS", ext_GetVarColumnWidthInDS, METH_VARARGS,
+    {"GetVarColumnWidthInDS", XD_METHOD(ext_GetVarColumnWidthInDS), METH_VARARGS,
     "GetVarColumnWidthInDS."},
-    {"SetVarColumnWidthInDS", ext_SetVarColumnWidthInDS, METH_VARARGS,
+    {"SetVarColumnWidthInDS", XD_METHOD(ext_SetVarColumnWidthInDS), METH_VARARGS,
     "SetVarColumnWidthInDS."},
-    {"SaveFileInDS", ext_SaveFileInDS, METH_VARARGS,
+    {"SaveFileInDS", XD_METHOD(ext_SaveFileInDS), METH_VARARGS,
     "SaveFileInDS."},
-    {"DelDataFileAttributesInDS", ext_DelDataFileAttributesInDS, METH_VARARGS,
+    {"DelDataFileAttributesInDS", XD_METHOD(ext_DelDataFileAttributesInDS), METH_VARARGS,
     "DelDataFileAttributesInDS."},
-    {"DelMultiResponseSetInDS", ext_DelMultiResponseSetInDS, METH_VARARGS,
+    {"DelMultiResponseSetInDS", XD_METHOD(ext_DelMultiResponseSetInDS), METH_VARARGS,
     "DelMultiResponseSetInDS."},
-    {"GetXDriveMode", ext_GetXDriveMode, METH_VARARGS,
+    {"GetXDriveMode", XD_METHOD(ext_GetXDriveMode), METH_VARARGS,
     "GetXDriveMode."},
-    {"GetSPSSLocale", ext_GetSPSSLocale, METH_VARARGS,
+    {"GetSPSSLocale", XD_METHOD(ext_GetSPSSLocale), METH_VARARGS,
      "Get the current PASW Statistics locale."},
-    {"GetCLocale", ext_GetCLocale, METH_NOARGS,
+    {"GetCLocale", XD_METHOD(ext_GetCLocale), METH_NOARGS,
      "Get the current PASW Statistics C locale."},
-    {"SetOutputLanguage", ext_SetOutputLanguage, METH_VARARGS,
+    {"SetOutputLanguage", XD_METHOD(ext_SetOutputLanguage), METH_VARARGS,
      "Set the current PASW Statistics output language."},
-    {"GetSystemMissingValue", ext_GetSystemMissingValue, METH_VARARGS,
+    {"GetSystemMissingValue", XD_METHOD(ext_GetSystemMissingValue), METH_VARARGS,
      "Get the System missing value."},
-    {"GetNestDepth", ext_GetNestDepth, METH_VARARGS,
+    {"GetNestDepth", XD_METHOD(ext_GetNestDepth), METH_VARARGS,
     "Get nest depth."},
-    {"GetOutputLanguage", ext_GetOutputLanguage, METH_VARARGS,
+    {"GetOutputLanguage", XD_METHOD(ext_GetOutputLanguage), METH_VARARGS,
     "Get XD output language."},
-    {"TransCode", ext_TransCode, METH_VARARGS,
+    {"TransCode", XD_METHOD(ext_TransCode), METH_VARARGS,
     "Transform string to UTF."},
-    {"GetCellsValueCache", ext_GetCellsValueCache, METH_VARARGS,
+    {"GetCellsValueCache", XD_METHOD(ext_GetCellsValueCache), METH_VARARGS,
     "GetCellsValueCache"},
-    {"SetDefaultEncoding", ext_SetDefaultEncoding, METH_VARARGS,
+    {"SetDefaultEncoding", XD_METHOD(ext_SetDefaultEncoding), METH_VARARGS,
     "Sets the currently active default encoding."},
-    {"GetVariableRole", ext_GetVariableRole, METH_VARARGS,
+    {"GetVariableRole", XD_METHOD(ext_GetVariableRole), METH_VARARGS,
     "Get the role of the given variable."},
-    {"GetVariableRoleInProcDS", ext_GetVariableRoleInProcDS, METH_VARARGS,
+    {"GetVariableRoleInProcDS", XD_METHOD(ext_GetVariableRoleInProcDS), METH_VARARGS,
     "GetVariableRoleInProcDS."},
-    {"SetVarRole", ext_SetVarRole, METH_VARARGS,
+    {"SetVarRole", XD_METHOD(ext_SetVarRole), METH_VARARGS,
     "SetVarRole."},
-    {"GetVarRoleInDS", ext_GetVarRoleInDS, METH_VARARGS,
+    {"GetVarRoleInDS", XD_METHOD(ext_GetVarRoleInDS), METH_VARARGS,
     "GetVarRoleInDS."},
-    {"SetVarRoleInDS", ext_SetVarRoleInDS, METH_VARARGS,
+    {"SetVarRoleInDS", XD_METHOD(ext_SetVarRoleInDS), METH_VARARGS,
     "SetVarRoleInDS."},
-    {"NextCase", ext_NextCase, METH_VARARGS,
+    {"NextCase", XD_METHOD(ext_NextCase), METH_NOARGS,
     "NextCase."},
-    {"TransportData", ext_TransportData, METH_VARARGS,
+    {"TransportData", XD_METHOD(ext_TransportData), METH_VARARGS,
     "TransportData."},
-    {"GetDataFromTempFile", ext_GetDataFromTempFile, METH_VARARGS,
+    {"GetDataFromTempFile", XD_METHOD(ext_GetDataFromTempFile), METH_VARARGS,
     "GetDataFromTempFile."},
-    {"SaveDataToTempFile", ext_SaveDataToTempFile, METH_VARARGS,
+    {"SaveDataToTempFile", XD_METHOD(ext_SaveDataToTempFile), METH_VARARGS,
     "SaveDataToTempFile."},
-    {"GetSplitEndIndex", ext_GetSplitEndIndex, METH_VARARGS,
+    {"GetSplitEndIndex", XD_METHOD(ext_GetSplitEndIndex), METH_VARARGS,
     "GetSplitEndIndex."},
-    {"SetMode", ext_SetMode, METH_VARARGS,
+    {"SetMode", XD_METHOD(ext_SetMode), METH_VARARGS,
     "SetMode."},
-    {"GetRowCountInTempFile", ext_GetRowCountInTempFile, METH_VARARGS,
+    {"GetRowCountInTempFile", XD_METHOD(ext_GetRowCountInTempFile), METH_VARARGS,
     "GetRowCountInTempFile."},
-    {"GetCaseValue", ext_GetCaseValue, METH_VARARGS,
+    {"GetCaseValue", XD_FASTCALL_METHOD(ext_GetCaseValue), METH_FASTCALL,
     "GetCaseValue"},
-    {"SetCasePartValue", ext_SetCaseValue, METH_VARARGS,
+    {"SetCasePartValue", XD_METHOD(ext_SetCaseValue), METH_VARARGS,
     "SetCasePartValue"},
-    {"SetCacheInDS", ext_SetCacheInDS, METH_VARARGS,
+    {"SetCacheInDS", XD_METHOD(ext_SetCacheInDS), METH_VARARGS,
     "SetCacheInDS"},
-    {"IsDistributedMode", ext_IsDistributedMode, METH_VARARGS,
+    {"IsDistributedMode", XD_METHOD(ext_IsDistributedMode), METH_VARARGS,
      "Report if client is remote."},
-    {"IsUseOrFilter", ext_IsUseOrFilter, METH_VARARGS,
+    {"IsUseOrFilter", XD_METHOD(ext_IsUseOrFilter), METH_VARARGS,
     "IsUseOrFilter"},
     {NULL, NULL}
     };
-    //declare the function pointer.
-    static FP_IsBackendReady IsBackendReady = NULL;
-    static FP_IsXDriven IsXDriven = NULL;
-    static FP_SetXNameAndSHome SetXNameAndSHome = NULL;
-    static FP_StartSpss StartSpss = NULL;
-    static FP_StopSpss StopSpss = NULL;
-    static FP_Submit Submit = NULL;
-    static FP_QueueCommandPart QueueCommandPart = NULL;
-    static FP_PostSpssOutput PostSpssOutput = NULL;
-    static FP_GetVariableCount GetVariableCount = NULL;
-    static FP_GetRowCount GetRowCount = NULL;
-    static FP_GetVariableName GetVariableName = NULL;
-    static FP_GetVariableLabel GetVariableLabel = NULL;
-    static FP_GetVariableType GetVariableType = NULL;
-    static FP_GetVariableFormat GetVariableFormat = NULL;
-    static FP_GetVariableMeasurementLevel GetVariableMeasurementLevel = NULL;
-    static FP_CreateXPathDictionary CreateXPathDictionary = NULL;
-    static FP_RemoveXPathHandle RemoveXPathHandle = NULL;
-    static FP_EvaluateXPath EvaluateXPath = NULL;
-    static FP_GetStringListLength GetStringListLength = NULL;
-    static FP_GetStringFromList GetStringFromList = NULL;
-    static FP_RemoveStringList RemoveStringList = NULL;
-    static FP_GetXmlUtf16 GetXmlUtf16 = NULL;
-    static FP_GetImage GetImage = NULL;
-    static FP_GetSetting GetSetting = NULL;
-    static FP_GetOMSTagList GetOMSTagList = NULL;
-    static FP_GetHandleList GetHandleList = NULL;
-    static FP_GetFileHandles GetFileHandles = NULL;
-    static FP_GetNumericValue GetNumericValue = NULL;
-    static FP_GetStringValue GetStringValue = NULL;
-    static FP_NextCase NextCase = NULL;
-    static FP_RemoveCaseCursor RemoveCaseCursor = NULL;
-    static FP_GetVariableFormatType GetVariableFormatType = NULL;
-    static FP_GetCursorPosition GetCursorPosition = NULL;
-    static FP_MakeCaseCursor    MakeCaseCursor = NULL;
-    static FP_GetColumnCountInProcDS    GetColumnCountInProcDS = NULL;
-    static FP_StartProcedure StartProcedure = NULL;
-    static FP_SplitChange SplitChange = NULL;
-    static FP_EndProcedure  EndProcedure = NULL;
-    static FP_StartPivotTable  StartPivotTable = NULL;
-    static FP_HidePivotTableTitle  HidePivotTableTitle = NULL;
-    static FP_PivotTableCaption  PivotTableCaption = NULL;
-    static FP_AddDimension  AddDimension = NULL;
-
-    static FP_AddNumberCategory AddNumberCategory  = NULL;
-    static FP_AddStringCategory AddStringCategory  = NULL;
-    static FP_AddVarNameCategory AddVarNameCategory  = NULL;
-    static FP_AddVarValueDoubleCategory AddVarValueDoubleCategory  = NULL;
-    static FP_AddVarValueStringCategory AddVarValueStringCategory  = NULL;
-    static FP_SetNumberCell SetNumberCell = NULL;
-    static FP_SetStringCell SetStringCell   = NULL;
-    static FP_SetVarNameCell SetVarNameCell   = NULL;
-    static FP_SetVarValueDoubleCell SetVarValueDoubleCell   = NULL;
-    static FP_SetVarValueStringCell SetVarValueStringCell  = NULL;
-
-    static FP_SetFormatSpecCoefficient SetFormatSpecCoefficient = NULL;
-    static FP_SetFormatSpecCoefficientSE SetFormatSpecCoefficientSE  = NULL;
-    static FP_SetFormatSpecCoefficientVar SetFormatSpecCoefficientVar  = NULL;
-    static FP_SetFormatSpecCorrelation SetFormatSpecCorrelation  = NULL;
-    static FP_SetFormatSpecGeneralStat SetFormatSpecGeneralStat  = NULL;
-    static FP_SetFormatSpecMean SetFormatSpecMean  = NULL;
-    static FP_SetFormatSpecCount SetFormatSpecCount  = NULL;
-    static FP_SetFormatSpecPercent SetFormatSpecPercent  = NULL;
-    static FP_SetFormatSpecPercentNoSign SetFormatSpecPercentNoSign  = NULL;
-    static FP_SetFormatSpecProportion SetFormatSpecProportion  = NULL;
-    static FP_SetFormatSpecSignificance SetFormatSpecSignificance  = NULL;
-    static FP_SetFormatSpecResidual SetFormatSpecResidual = NULL;
-    static FP_SetFormatSpecVariable SetFormatSpecVariable  = NULL;
-    static FP_SetFormatSpecStdDev SetFormatSpecStdDev  = NULL;
-    static FP_SetFormatSpecDifference SetFormatSpecDifference  = NULL;
-    static FP_SetFormatSpecSum SetFormatSpecSum  = NULL;
-    static FP_AddCellFootnotes AddCellFootnotes = NULL;
-
-    static FP_AddProcFootnotes AddProcFootnotes = NULL;
-    static FP_AddOutlineFootnotes AddOutlineFootnotes = NULL;
-    static FP_AddTitleFootnotes AddTitleFootnotes = NULL;
-    static FP_AddDimFootnotes AddDimFootnotes = NULL;
-    static FP_AddCategoryFootnotes AddCategoryFootnotes = NULL;
-
-    static FP_AddTextBlock AddTextBlock = NULL;
-    static FP_MinDataColumnWidth MinDataColumnWidth = NULL;
-    static FP_MaxDataColumnWidth MaxDataColumnWidth = NULL;
-
-    static FP_HasCursor HasCursor = NULL;
-    static FP_GetRowCountInProcDS GetRowCountInProcDS = NULL;
-    static FP_GetVariableCountInProcDS GetVariableCountInProcDS = NULL;
-    static FP_GetVariableLabelInProcDS GetVariableLabelInProcDS = NULL;
-    static FP_GetVariableMeasurementLevelInProcDS GetVariableMeasurementLevelInProcDS = NULL;
-    static FP_GetVariableFormatTypeInProcDS GetVariableFormatTypeInProcDS = NULL;
-
-    static FP_GetVariableNameInProcDS GetVariableNameInProcDS  = NULL;
-    static FP_GetVariableTypeInProcDS GetVariableTypeInProcDS  = NULL;
-    static FP_GetVarAttributeNamesInProcDS GetVarAttributeNamesInProcDS  = NULL;
-    static FP_GetVarAttributesInProcDS GetVarAttributesInProcDS  = NULL;
-    static FP_GetVarCMissingValuesInProcDS GetVarCMissingValuesInProcDS  = NULL;
-    static FP_GetVarNMissingValuesInProcDS GetVarNMissingValuesInProcDS  = NULL;
-    static FP_GetVarCMissingValues GetVarCMissingValues = NULL;
-    static FP_GetVarNMissingValues GetVarNMissingValues = NULL;
-    static FP_GetVarAttributeNames GetVarAttributeNames  = NULL;
-    static FP_FreeAttributeNames FreeAttributeNames  = NULL;
-    static FP_GetVarAttributes GetVarAttributes  = NULL;
-    static FP_FreeAttributes FreeAttributes  = NULL;
-    static FP_SetVarAttributes SetVarAttributes  = NULL;
-    static FP_GetVariableFormatInProcDS GetVariableFormatInProcDS  = NULL;
-    static FP_SetVarNameAndType SetVarNameAndType  = NULL;
-    static FP_SetVarLabel SetVarLabel  = NULL;
-    static FP_SetVarCValueLabel SetVarCValueLabel  = NULL;
-    static FP_SetVarNValueLabel SetVarNValueLabel  = NULL;
-    static FP_SetVarCMissingValues SetVarCMissingValues  = NULL;
-    static FP_SetVarNMissingValues SetVarNMissingValues  = NULL;
-    static FP_SetVarMeasureLevel SetVarMeasureLevel  = NULL;
-    static FP_SetVarAlignment SetVarAlignment  = NULL;
-    static FP_SetVarFormat SetVarFormat  = NULL;
-    static FP_CommitHeader CommitHeader  = NULL;
-    static FP_SetValueChar SetValueChar  = NULL;
-    static FP_SetValueNumeric SetValueNumeric  = NULL;
-    static FP_CommitCaseRecord CommitCaseRecord  = NULL;
-    static FP_CommitNewCase CommitNewCase  = NULL;
-    static FP_CommitManyCases CommitManyCases  = NULL;
-    static FP_EndChanges EndChanges  = NULL;
-    static FP_IsEndSplit IsEndSplit  = NULL;
-    static FP_HasProcedure HasProcedure = NULL;
-    static FP_GetSPSSLowHigh GetSPSSLowHigh  = NULL;
-    static FP_GetWeightVar GetWeightVar = NULL;
-    static FP_ResetDataPass ResetDataPass = NULL;
-    static FP_AllocNewVarsBuffer AllocNewVarsBuffer = NULL;
-    static FP_SetOneVarNameAndType SetOneVarNameAndType = NULL;
-    static FP_SetXDriveMode SetXDriveMode = NULL;
-
-    static FP_StartDataStep StartDataStep = NULL;
-    static FP_EndDataStep EndDataStep = NULL;
-    static FP_CreateDataset CreateDataset = NULL;
-    static FP_SetDatasetName SetDatasetName = NULL;
-    static FP_GetNewDatasetName GetNewDatasetName = NULL;
-    static FP_GetActive GetActive = NULL;
-    static FP_SetActive SetActive = NULL;
-    static FP_CopyDataset CopyDataset = NULL;
-    static FP_GetSpssDatasets GetSpssDatasets = NULL;
-    static FP_GetDatastepDatasets GetDatastepDatasets = NULL;
-    static FP_FreeStringArray FreeStringArray = NULL;
-    static FP_CloseDataset CloseDataset = NULL;
-    static FP_InsertVariable InsertVariable = NULL;
-    static FP_DeleteVariable DeleteVariable = NULL;
-    static FP_GetVarCountInDS GetVarCountInDS = NULL;
-    static FP_GetVarNameInDS GetVarNameInDS = NULL;
-    static FP_SetVarNameInDS SetVarNameInDS = NULL;
-    static FP_GetVarLabelInDS GetVarLabelInDS = NULL;
-    static FP_SetVarLabelInDS SetVarLabelInDS = NULL;
-    static FP_GetVarTypeInDS GetVarTypeInDS = NULL;
-    static FP_SetVarTypeInDS SetVarTypeInDS = NULL;
-    static FP_GetVarFormatInDS GetVarFormatInDS = NULL;
-    static FP_SetVarFormatInDS SetVarFormatInDS = NULL;
-    static FP_GetVarAlignmentInDS GetVarAlignmentInDS = NULL;
-    static FP_SetVarAlignmentInDS SetVarAlignmentInDS = NULL;
-    static FP_GetVarMeasurementLevelInDS GetVarMeasurementLevelInDS = NULL;
-    static FP_SetVarMeasurementLevelInDS SetVarMeasurementLevelInDS = NULL;
-    static FP_GetVarNMissingValuesInDS GetVarNMissingValuesInDS = NULL;
-    static FP_GetVarCMissingValuesInDS GetVarCMissingValuesInDS = NULL;
-    static FP_SetVarNMissingValuesInDS SetVarNMissingValuesInDS = NULL;
-    static FP_SetVarCMissingValuesInDS SetVarCMissingValuesInDS = NULL;
-    static FP_GetVarAttributesNameInDS GetVarAttributesNameInDS = NULL;
-    static FP_GetVarAttributesInDS GetVarAttributesInDS = NULL;
-    static FP_SetVarAttributesInDS SetVarAttributesInDS = NULL;
-    static FP_DelVarAttributesInDS DelVarAttributesInDS = NULL;
-    static FP_GetVarNValueLabelInDS GetVarNValueLabelInDS = NULL;
-    static FP_FreeDoubleArray FreeDoubleArray = NULL;
-    static FP_GetVarCValueLabelInDS GetVarCValueLabelInDS = NULL;
-    static FP_SetVarNValueLabelInDS SetVarNValueLabelInDS = NULL;
-    static FP_SetVarCValueLabelInDS SetVarCValueLabelInDS = NULL;
-    static FP_DelVarValueLabelInDS DelVarValueLabelInDS = NULL;
-    static FP_DelVarNValueLabelInDS DelVarNValueLabelInDS = NULL;
-    static FP_DelVarCValueLabelInDS DelVarCValueLabelInDS = NULL;
-    static FP_InsertCase InsertCase = NULL;
-    static FP_DeleteCase DeleteCase = NULL;
-    static FP_GetCaseCountInDS GetCaseCountInDS = NULL;
-    static FP_GetNCellValue GetNCellValue = NULL;
-    static FP_GetCCellValue GetCCellValue = NULL;
-    static FP_SetNCellValue SetNCellValue = NULL;
-    static FP_SetCCellValue SetCCellValue = NULL;
-
-    static FP_IsUTF8mode IsUTF8mode = NULL;
-    static FP_GetSplitVariableNames GetSplitVariableNames = NULL;
-    static FP_GetDataFileAttributes GetDataFileAttributes = NULL;
-    static FP_GetDataFileAttributeNames GetDataFileAttributeNames = NULL;
-    static FP_GetDataFileAttributesInProcDS GetDataFileAttributesInProcDS = NULL;
-    static FP_GetDataFileAttributeNamesInProcDS GetDataFileAttributeNamesInProcDS = NULL;
-    static FP_GetMultiResponseSetNames GetMultiResponseSetNames  = NULL;
-    static FP_GetMultiResponseSet GetMultiResponseSet = NULL;
-    static FP_GetMultiResponseSetNamesInProcDS GetMultiResponseSetNamesInProcDS  = NULL;
-    static FP_GetMultiResponseSetInProcDS GetMultiResponseSetInProcDS = NULL;
-    static FP_SetDataFileAttributesInDS SetDataFileAttributesInDS = NULL;
-    static FP_SetMultiResponseSetInDS SetMultiResponseSetInDS = NULL;
-    static FP_FreeString FreeString = NULL;
-    static FP_GetDataFileAttributeNamesInDS GetDataFileAttributeNamesInDS = NULL;
-    static FP_GetDataFileAttributesInDS GetDataFileAttributesInDS = NULL;
-    static FP_GetMultiResponseSetNamesInDS GetMultiResponseSetNamesInDS = NULL;
-    static FP_GetMultiResponseSetInDS GetMultiResponseSetInDS = NULL;
-    static FP_GetVarColumnWidthInDS GetVarColumnWidthInDS = NULL;
-    static FP_SetVarColumnWidthInDS SetVarColumnWidthInDS = NULL;
-    static FP_SaveFileInDS SaveFileInDS = NULL;
-    static FP_DelDataFileAttributesInDS DelDataFileAttributesInDS = NULL;
-    static FP_DelMultiResponseSetInDS DelMultiResponseSetInDS = NULL;
-    static FP_GetXDriveMode GetXDriveMode = NULL;
-    static FP_GetSPSSLocale GetSPSSLocale = NULL;
-    static FP_GetCLocale GetCLocale = NULL;
-    static FP_SetOutputLanguage SetOutputLanguage = NULL;
-    static FP_GetNestDepth GetNestDepth = NULL;
-    static FP_GetOutputLanguage GetOutputLanguage = NULL;
-    
-    static FP_TransCode TransCode = NULL;
-    
-    static FP_GetNCellValueCache GetNCellValueCache = NULL;
-    static FP_GetCCellValueCache GetCCellValueCache = NULL;
-    static FP_GetRowList GetRowList = NULL;
-    static FP_GetVarTypeInDSCache GetVarTypeInDSCache = NULL;
-    static FP_ClearDatastepBatch ClearDatastepBatch = NULL;
-    
-    static FP_GetVariableRole GetVariableRole = NULL;
-    static FP_GetVariableRoleInProcDS GetVariableRoleInProcDS = NULL;
-    static FP_SetVarRole SetVarRole = NULL;
-    static FP_GetVarRoleInDS GetVarRoleInDS = NULL;
-    static FP_SetVarRoleInDS SetVarRoleInDS = NULL;
-    
-    static FP_TransportData TransportData = NULL;
-    static FP_GetDataFromTempFile GetDataFromTempFile = NULL;
-    static FP_SaveDataToTempFile SaveDataToTempFile = NULL;
-    static FP_GetSplitEndIndex GetSplitEndIndex = NULL;
-    static FP_SetMode SetMode = NULL;
-    static FP_GetRowCountInTempFile GetRowCountInTempFile = NULL;
-    
-    static FP_GetNCellValueFromCache GetNCellValueFromCache = NULL;
-    static FP_GetCCellValueFromCache GetCCellValueFromCache = NULL;
-    static FP_SetNCellValueFromCache SetNCellValueFromCache = NULL;
-    static FP_SetCCellValueFromCache SetCCellValueFromCache = NULL;
-    static FP_GetVarInfo GetVarInfo = NULL;
-    static FP_GetCaseValue GetCaseValue = NULL;
-    static FP_SetCasePartValue SetCasePartValue = NULL;
-    static FP_SetCacheInDS SetCacheInDS = NULL;
-    
-    static FP_IsDistributedMode IsDistributedMode = NULL;
-    static FP_GetXmlUtf16Length GetXmlUtf16Length = NULL;
-    static FP_IsUseOrFilter IsUseOrFilter = NULL;
     
     const char *dlError = NULL; /* Pointer to error string */
 #ifdef MS_WINDOWS
@@ -757,6 +591,7 @@ extern "C"{
   //const int CELL_ARGS_ERROR = 1032;   // Invalid pivot table cell values.
   const int PARSE_TUPLE_FAIL = 1033;
   const int SIZE_NOT_EQUAL = 1034;
+  const int SYMBOL_NOT_FOUND = 1076;    //the backend does not export the function.
 
   const int MISSING_VAL_LEN = 9;
   const int DS_MODE = 0;
@@ -764,252 +599,674 @@ extern "C"{
 
   static int (*StartReceivePyThread)() = 0;
 
-  //Initialize the function pointer
+  //the XD API functions of libspssxd_p, bound on first call. X(name) declares
+  //the pointer name of type FP_name, bound to the exported symbol name.
+  #define XD_SYMBOLS(X) \
+      X(IsBackendReady) \
+      X(IsXDriven) \
+      X(SetXNameAndSHome) \
+      X(StartSpss) \
+      X(StopSpss) \
+      X(Submit) \
+      X(QueueCommandPart) \
+      X(PostSpssOutput) \
+      X(GetVariableCount) \
+      X(GetRowCount) \
+      X(GetVariableName) \
+      X(GetVariableLabel) \
+      X(GetVariableType) \
+      X(GetVariableFormat) \
+      X(GetVariableMeasurementLevel) \
+      X(CreateXPathDictionary) \
+      X(RemoveXPathHandle) \
+      X(EvaluateXPath) \
+      X(GetStringListLength) \
+      X(GetStringFromList) \
+      X(RemoveStringList) \
+      X(GetXmlUtf16) \
+      X(GetImage) \
+      X(GetSetting) \
+      X(GetOMSTagList) \
+      X(GetHandleList) \
+      X(GetFileHandles) \
+      X(GetNumericValue) \
+      X(GetStringValue) \
+      X(NextCase) \
+      X(RemoveCaseCursor) \
+      X(GetVariableFormatType) \
+      X(GetCursorPosition) \
+      X(MakeCaseCursor) \
+      X(NextCasePtr) \
+      X(GetCaseLength) \
+      X(GetVarObsIndex) \
+      X(GetColumnCountInProcDS) \
+      X(StartProcedure) \
+      X(SplitChange) \
+      X(EndProcedure) \
+      X(StartPivotTable) \
+      X(HidePivotTableTitle) \
+      X(PivotTableCaption) \
+      X(AddDimension) \
+      X(AddNumberCategory) \
+      X(AddStringCategory) \
+      X(AddVarNameCategory) \
+      X(AddVarValueDoubleCategory) \
+      X(AddVarValueStringCategory) \
+      X(SetNumberCell) \
+      X(SetStringCell) \
+      X(SetVarNameCell) \
+      X(SetVarValueDoubleCell) \
+      X(SetVarValueStringCell) \
+      X(SetNumberCellWithFormat) \
+      X(AddNumberCategoryWithFormat) \
+      X(AddTextBlockLines) \
+      X(SetNumberCells) \
+      X(SetFormatSpecCoefficient) \
+      X(SetFormatSpecCoefficientSE) \
+      X(SetFormatSpecCoefficientVar) \
+      X(SetFormatSpecCorrelation) \
+      X(SetFormatSpecGeneralStat) \
+      X(SetFormatSpecMean) \
+      X(SetFormatSpecCount) \
+      X(SetFormatSpecPercent) \
+      X(SetFormatSpecPercentNoSign) \
+      X(SetFormatSpecProportion) \
+      X(SetFormatSpecSignificance) \
+      X(SetFormatSpecResidual) \
+      X(SetFormatSpecVariable) \
+      X(SetFormatSpecStdDev) \
+      X(SetFormatSpecDifference) \
+      X(SetFormatSpecSum) \
+      X(AddCellFootnotes) \
+      X(AddProcFootnotes) \
+      X(AddOutlineFootnotes) \
+      X(AddTitleFootnotes) \
+      X(AddDimFootnotes) \
+      X(AddCategoryFootnotes) \
+      X(AddTextBlock) \
+      X(MinDataColumnWidth) \
+      X(MaxDataColumnWidth) \
+      X(HasCursor) \
+      X(GetRowCountInProcDS) \
+      X(GetVariableCountInProcDS) \
+      X(GetVariableLabelInProcDS) \
+      X(GetVariableMeasurementLevelInProcDS) \
+      X(GetVariableFormatTypeInProcDS) \
+      X(GetVariableNameInProcDS) \
+      X(GetVariableTypeInProcDS) \
+      X(GetVarAttributeNamesInProcDS) \
+      X(GetVarAttributesInProcDS) \
+      X(GetVarCMissingValuesInProcDS) \
+      X(GetVarNMissingValuesInProcDS) \
+      X(GetVarCMissingValues) \
+      X(GetVarNMissingValues) \
+      X(GetVarAttributeNames) \
+      X(FreeAttributeNames) \
+      X(GetVarAttributes) \
+      X(FreeAttributes) \
+      X(SetVarAttributes) \
+      X(GetVariableFormatInProcDS) \
+      X(SetVarNameAndType) \
+      X(SetVarLabel) \
+      X(SetVarCValueLabel) \
+      X(SetVarNValueLabel) \
+      X(SetVarCMissingValues) \
+      X(SetVarNMissingValues) \
+      X(SetVarMeasureLevel) \
+      X(SetVarAlignment) \
+      X(SetVarFormat) \
+      X(CommitHeader) \
+      X(SetValueChar) \
+      X(SetValueNumeric) \
+      X(CommitCaseRecord) \
+      X(CommitNewCase) \
+      X(CommitManyCases) \
+      X(EndChanges) \
+      X(IsEndSplit) \
+      X(HasProcedure) \
+      X(GetSPSSLowHigh) \
+      X(GetWeightVar) \
+      X(ResetDataPass) \
+      X(AllocNewVarsBuffer) \
+      X(SetOneVarNameAndType) \
+      X(SetXDriveMode) \
+      X(StartDataStep) \
+      X(EndDataStep) \
+      X(CreateDataset) \
+      X(SetDatasetName) \
+      X(GetNewDatasetName) \
+      X(GetActive) \
+      X(SetActive) \
+      X(CopyDataset) \
+      X(GetSpssDatasets) \
+      X(GetDatastepDatasets) \
+      X(FreeStringArray) \
+      X(CloseDataset) \
+      X(InsertVariable) \
+      X(DeleteVariable) \
+      X(GetVarCountInDS) \
+      X(GetVarNameInDS) \
+      X(SetVarNameInDS) \
+      X(GetVarLabelInDS) \
+      X(SetVarLabelInDS) \
+      X(GetVarTypeInDS) \
+      X(SetVarTypeInDS) \
+      X(GetVarFormatInDS) \
+      X(SetVarFormatInDS) \
+      X(GetVarAlignmentInDS) \
+      X(SetVarAlignmentInDS) \
+      X(GetVarMeasurementLevelInDS) \
+      X(SetVarMeasurementLevelInDS) \
+      X(GetVarNMissingValuesInDS) \
+      X(GetVarCMissingValuesInDS) \
+      X(SetVarNMissingValuesInDS) \
+      X(SetVarCMissingValuesInDS) \
+      X(GetVarAttributesNameInDS) \
+      X(GetVarAttributesInDS) \
+      X(SetVarAttributesInDS) \
+      X(DelVarAttributesInDS) \
+      X(GetVarNValueLabelInDS) \
+      X(FreeDoubleArray) \
+      X(GetVarCValueLabelInDS) \
+      X(SetVarNValueLabelInDS) \
+      X(SetVarCValueLabelInDS) \
+      X(DelVarValueLabelInDS) \
+      X(DelVarNValueLabelInDS) \
+      X(DelVarCValueLabelInDS) \
+      X(InsertCase) \
+      X(DeleteCase) \
+      X(GetCaseCountInDS) \
+      X(GetNCellValue) \
+      X(GetCCellValue) \
+      X(SetNCellValue) \
+      X(SetCCellValue) \
+      X(IsUTF8mode) \
+      X(GetSplitVariableNames) \
+      X(GetDataFileAttributes) \
+      X(GetDataFileAttributeNames) \
+      X(GetDataFileAttributesInProcDS) \
+      X(GetDataFileAttributeNamesInProcDS) \
+      X(GetMultiResponseSetNames) \
+      X(GetMultiResponseSet) \
+      X(GetMultiResponseSetNamesInProcDS) \
+      X(GetMultiResponseSetInProcDS) \
+      X(SetDataFileAttributesInDS) \
+      X(SetMultiResponseSetInDS) \
+      X(FreeString) \
+      X(GetDataFileAttributeNamesInDS) \
+      X(GetDataFileAttributesInDS) \
+      X(GetMultiResponseSetNamesInDS) \
+      X(GetMultiResponseSetInDS) \
+      X(GetVarColumnWidthInDS) \
+      X(SetVarColumnWidthInDS) \
+      X(SaveFileInDS) \
+      X(DelDataFileAttributesInDS) \
+      X(DelMultiResponseSetInDS) \
+      X(GetXDriveMode) \
+      X(GetSPSSLocale) \
+      X(GetCLocale) \
+      X(GetCLocaleGeneration) \
+      X(SetOutputLanguage) \
+      X(GetNestDepth) \
+      X(GetOutputLanguage) \
+      X(TransCode) \
+      X(GetNCellValueCache) \
+      X(GetCCellValueCache) \
+      X(GetRowList) \
+      X(GetVarTypeInDSCache) \
+      X(ClearDatastepBatch) \
+      X(GetVariableRole) \
+      X(GetVariableRoleInProcDS) \
+      X(SetVarRole) \
+      X(GetVarRoleInDS) \
+      X(SetVarRoleInDS) \
+      X(TransportData) \
+      X(GetDataFromTempFile) \
+      X(SaveDataToTempFile) \
+      X(GetSplitEndIndex) \
+      X(SetMode) \
+      X(GetRowCountInTempFile) \
+      X(GetNCellValueFromCache) \
+      X(GetCCellValueFromCache) \
+      X(SetNCellValueFromCache) \
+      X(SetCCellValueFromCache) \
+      X(GetVarInfo) \
+      X(GetCaseValue) \
+      X(SetCasePartValue) \
+      X(SetCacheInDS) \
+      X(IsDistributedMode) \
+      X(GetXmlUtf16Length) \
+      X(IsUseOrFilter) \
+      X(SubmitAsync) \
+      X(PollSubmit) \
+      X(WaitSubmit) \
+      X(SetSubmitCallback) \
+      X(SubmitBatch)
+
+  enum XDSymbolIndex {
+  #define XD_SYMBOL_INDEX(name) SYM_##name,
+      XD_SYMBOLS(XD_SYMBOL_INDEX)
+      SYM_COUNT
+  };
+
+  enum XDSymbolState { XD_UNBOUND, XD_BOUND, XD_MISSING };
+
+  typedef struct {
+      const char*     name;
+      void**          slot;           // the function pointer of the symbol
+      XDSymbolState   state;
+  } XDSymbol;
+
+  static void* BindXDSymbol(int index);
+
+  // Call profiling.
+  //
+  // With SPSSXD_PROFILE set when the backend is loaded, each XD function is
+  // bound to a shim that counts and times its calls before forwarding them
+  // to the backend. GetCallStats reports the counts, and StopSpss writes a
+  // summary to stderr, or appends it to the file SPSSXD_PROFILE names when it
+  // is not "1".
+
+  static const int CALL_BUCKETS = 8;
+  // upper bounds of the latency buckets, in ns. The last bucket has no bound.
+  static const long long callBuckets[CALL_BUCKETS - 1] = {
+      1000LL, 10000LL, 100000LL, 1000000LL, 10000000LL, 100000000LL, 1000000000LL
+  };
+  static const char* callBucketNames[CALL_BUCKETS] = {
+      "<1us", "<10us", "<100us", "<1ms", "<10ms", "<100ms", "<1s", ">=1s"
+  };
+
+  typedef struct {
+      std::atomic<long long>  calls;
+      std::atomic<long long>  totalNs;
+      std::atomic<long long>  maxNs;
+      std::atomic<long long>  histogram[CALL_BUCKETS];
+  } XDCallStats;
+
+  static bool profiling = false;          // SPSSXD_PROFILE is set
+  static std::string profilePath;         // where StopSpss writes the summary, empty for stderr
+  static XDCallStats xdCallStats[SYM_COUNT];
+  static void* xdTargets[SYM_COUNT];      // the backend functions behind the shims
+
+  static void WriteCallStats();
+
+  static void RecordCall(int index, long long ns)
+  {
+      XDCallStats& stats = xdCallStats[index];
+      stats.calls.fetch_add(1, std::memory_order_relaxed);
+      stats.totalNs.fetch_add(ns, std::memory_order_relaxed);
+      long long longest = stats.maxNs.load(std::memory_order_relaxed);
+      while(ns > longest && !stats.maxNs.compare_exchange_weak(longest, ns, std::memory_order_relaxed)) {
+      }
+      int bucket = 0;
+      while(bucket < CALL_BUCKETS - 1 && ns >= callBuckets[bucket]) {
+          bucket++;
+      }
+      stats.histogram[bucket].fetch_add(1, std::memory_order_relaxed);
+  }
+
+extern "C++" {
+  //records the duration of one call of XD function N when it goes out of scope.
+  template<int N> struct XDCallTimer {
+      std::chrono::steady_clock::time_point start;
+      XDCallTimer() : start(std::chrono::steady_clock::now()) {}
+      ~XDCallTimer()
+      {
+          RecordCall(N, (long long)std::chrono::duration_cast<std::chrono::nanoseconds>(
+                            std::chrono::steady_clock::now() - start).count());
+      }
+  };
+
+  //the pointer of a profiled XD function.
+  template<int N, typename FP> struct XDProfiled;
+  template<int N, typename R, typename... A> struct XDProfiled<N, R (*)(A...)> {
+      static R call(A... args)
+      {
+          XDCallTimer<N> timer;
+          return ((R (*)(A...))xdTargets[N])(args...);
+      }
+  };
+}
+
+  // Call recording.
+  //
+  // With SPSSXD_RECORD=path set when the backend is loaded, each XD function is
+  // bound to a shim that appends the call to a binary trace at path, for
+  // xdreplay (XD_API/out_of_process/examples/benchmark) to issue again against
+  // another backend. A trace holds the shape of the calls, not the data: the
+  // integer arguments and results, the length of each string, and the time of
+  // each call. Strings and double values are kept only with SPSSXD_RECORD_VALUES=1.
+  // A string passed with a length argument is recorded up to that length.
+  //
+  // The trace starts with the magic "SPSSXDT1", the flags (1: values kept), the
+  // number of functions and their names. Each call follows as the index of the
+  // function, the start in ns from the previous call, the duration in ns, the
+  // number of arguments, each argument after the call, and the result. Numbers
+  // are LEB128 varints, zigzag encoded when signed; a value is a tag and its data:
+  //     TRACE_VOID     no result
+  //     TRACE_INT      an integer or bool, or one set through int& or long&
+  //     TRACE_DOUBLE   8 bytes, in the byte order of the recording machine
+  //     TRACE_STRING   the length + 1, or 0 for NULL, then the bytes
+  //     TRACE_LENGTH   as TRACE_STRING, without the bytes
+  //     TRACE_POINTER  any other pointer, not followed by data
+  //     TRACE_MASKED   a double not kept
+
+  enum XDTraceTag { TRACE_VOID, TRACE_INT, TRACE_DOUBLE, TRACE_STRING, TRACE_LENGTH, TRACE_POINTER, TRACE_MASKED };
+
+  static bool recording = false;          // SPSSXD_RECORD is set
+  static bool recordValues = false;       // SPSSXD_RECORD_VALUES is set
+  static FILE* traceFile = NULL;
+  static std::string traceBuffer;         // written to traceFile when it fills up
+  static std::mutex traceMutex;
+  static std::chrono::steady_clock::time_point traceLast;
+  static const size_t TRACE_BUFFER_SIZE = 1 << 16;
+
+  static void TraceVarint(unsigned long long value)
+  {
+      while(value >= 0x80) {
+          traceBuffer += (char)(0x80 | (value & 0x7f));
+          value >>= 7;
+      }
+      traceBuffer += (char)value;
+  }
+
+  static void TraceSigned(long long value)
+  {
+      TraceVarint(((unsigned long long)value << 1) ^ (unsigned long long)(value >> 63));
+  }
+
+  static void FlushTrace()
+  {
+      if(traceFile && !traceBuffer.empty()) {
+          fwrite(traceBuffer.data(), 1, traceBuffer.size(), traceFile);
+          fflush(traceFile);
+      }
+      traceBuffer.clear();
+  }
+
+  static void CloseTrace()
+  {
+      std::lock_guard<std::mutex> lock(traceMutex);
+      FlushTrace();
+      if(traceFile) {
+          fclose(traceFile);
+          traceFile = NULL;
+      }
+  }
+
+  static void TraceCallStart(int index, std::chrono::steady_clock::time_point start, long long ns, int argc)
+  {
+      TraceVarint(index);
+      TraceSigned((long long)std::chrono::duration_cast<std::chrono::nanoseconds>(start - traceLast).count());
+      TraceVarint(ns);
+      TraceVarint(argc);
+      traceLast = start;
+  }
+
+  static void TraceCallEnd()
+  {
+      if(traceBuffer.size() >= TRACE_BUFFER_SIZE) {
+          FlushTrace();
+      }
+  }
+
+extern "C++" {
+  static void TraceText(const char* value, size_t length)
+  {
+      traceBuffer += (char)(recordValues ? TRACE_STRING : TRACE_LENGTH);
+      if(NULL == value) {
+          TraceVarint(0);
+          return;
+      }
+      TraceVarint(length + 1);
+      if(recordValues) {
+          traceBuffer.append(value, length);
+      }
+  }
+
+  //a string without a length argument is NUL terminated.
+  static void TraceArg(const char* value)
+  {
+      TraceText(value, value ? strlen(value) : 0);
+  }
+
+  static void TraceArg(double value)
+  {
+      if(!recordValues) {
+          traceBuffer += (char)TRACE_MASKED;
+          return;
+      }
+      traceBuffer += (char)TRACE_DOUBLE;
+      traceBuffer.append((const char*)&value, sizeof(value));
+  }
+
+  //the result of a function returning void.
+  struct XDTraceVoid {};
+  static void TraceArg(XDTraceVoid)
+  {
+      traceBuffer += (char)TRACE_VOID;
+  }
+
+  template<typename T> static void TraceArg(T*)
+  {
+      traceBuffer += (char)TRACE_POINTER;
+  }
+
+  template<typename T> static typename std::enable_if<std::is_integral<T>::value || std::is_enum<T>::value>::type
+  TraceArg(T value)
+  {
+      traceBuffer += (char)TRACE_INT;
+      TraceSigned((long long)value);
+  }
+
+  //the arguments of a call, by the signature of the function.
+  template<typename... A> static void TraceArgs(A... args)
+  {
+      int expand[] = {0, (TraceArg(args), 0)...};
+      (void)expand;
+  }
+
+  //Submit, QueueCommandPart, SubmitAsync and PostSpssOutput take the text with its
+  //length, and the plug-in passes slices of a longer string to the first two.
+  static void TraceArgs(const char* text, int length)
+  {
+      TraceText(text, length > 0 ? (size_t)length : 0);
+      TraceArg(length);
+  }
+  static void TraceArgs(const char* text, int length, int& ticket)
+  {
+      TraceArgs(text, length);
+      TraceArg(ticket);
+  }
+
+  //the pointer of a recorded XD function, which profiles it as well when
+  //SPSSXD_PROFILE is set.
+  template<int N, typename FP> struct XDRecorded;
+  template<int N, typename R, typename... A> struct XDRecorded<N, R (*)(A...)> {
+      static R call(A... args)
+      {
+          std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+          R result = ((R (*)(A...))xdTargets[N])(args...);
+          Record(start, args..., result);
+          return result;
+      }
+      static void Record(std::chrono::steady_clock::time_point start, A... args, R result)
+      {
+          long long ns = (long long)std::chrono::duration_cast<std::chrono::nanoseconds>(
+                             std::chrono::steady_clock::now() - start).count();
+          if(profiling) {
+              RecordCall(N, ns);
+          }
+          std::lock_guard<std::mutex> lock(traceMutex);
+          TraceCallStart(N, start, ns, sizeof...(A));
+          TraceArgs(args...);
+          TraceArg(result);
+          TraceCallEnd();
+      }
+  };
+  template<int N, typename... A> struct XDRecorded<N, void (*)(A...)> {
+      static void call(A... args)
+      {
+          std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+          ((void (*)(A...))xdTargets[N])(args...);
+          XDRecorded<N, XDTraceVoid (*)(A...)>::Record(start, args..., XDTraceVoid());
+      }
+  };
+}
+
+extern "C++" {
+  //what a missing XD function returns: the error code for int, otherwise 0, NULL or false.
+  template<typename R> struct XDMissing { static R value() { return R(); } };
+  template<> struct XDMissing<int> { static int value() { return SYMBOL_NOT_FOUND; } };
+  template<> struct XDMissing<void> { static void value() {} };
+
+  //set the trailing int& argument of a missing XD function, the errCode of most of them.
+  inline void SetMissingErrCode() {}
+  template<typename T> inline void SetMissingErrCode(T&) {}
+  inline void SetMissingErrCode(int& errCode) { errCode = SYMBOL_NOT_FOUND; }
+  template<typename T, typename... Rest> inline void SetMissingErrCode(T&, Rest&... rest)
+  {
+      SetMissingErrCode(rest...);
+  }
+
+  //the initial value of each function pointer. The first call binds the symbol,
+  //which replaces the pointer, and forwards to it.
+  template<int N, typename FP> struct XDTrampoline;
+  template<int N, typename R, typename... A> struct XDTrampoline<N, R (*)(A...)> {
+      static R call(A... args)
+      {
+          void* address = BindXDSymbol(N);
+          if(NULL == address) {
+              SetMissingErrCode(args...);
+              return XDMissing<R>::value();
+          }
+          return ((R (*)(A...))address)(args...);
+      }
+  };
+}
+
+  //declare the function pointer.
+  #define XD_SYMBOL_POINTER(name) static FP_##name name = XDTrampoline<SYM_##name, FP_##name>::call;
+  XD_SYMBOLS(XD_SYMBOL_POINTER)
+
+  #define XD_SYMBOL_ENTRY(name) {#name, (void**)&name, XD_UNBOUND},
+  static XDSymbol xdSymbols[SYM_COUNT] = {
+      XD_SYMBOLS(XD_SYMBOL_ENTRY)
+  };
+
+  #define XD_PROFILE_SHIM(name) (void*)XDProfiled<SYM_##name, FP_##name>::call,
+  static void* xdProfileShims[SYM_COUNT] = {
+      XD_SYMBOLS(XD_PROFILE_SHIM)
+  };
+
+  #define XD_RECORD_SHIM(name) (void*)XDRecorded<SYM_##name, FP_##name>::call,
+  static void* xdRecordShims[SYM_COUNT] = {
+      XD_SYMBOLS(XD_RECORD_SHIM)
+  };
+
+  //open the trace and write its header. The trace stays open across
+  //StopSpss and StartSpss, and is closed when the process exits.
+  static bool OpenTrace(const char* path)
+  {
+      std::lock_guard<std::mutex> lock(traceMutex);
+      if(traceFile) {
+          return true;
+      }
+      traceFile = fopen(path, "wb");
+      if(NULL == traceFile) {
+          fprintf(stderr, "Cannot open the SPSSXD trace %s.\n", path);
+          return false;
+      }
+      atexit(CloseTrace);
+      traceBuffer.assign("SPSSXDT1");
+      TraceVarint(recordValues ? 1 : 0);
+      TraceVarint(SYM_COUNT);
+      for(int i = 0; i < SYM_COUNT; i++) {
+          size_t length = strlen(xdSymbols[i].name);
+          TraceVarint(length);
+          traceBuffer.append(xdSymbols[i].name, length);
+      }
+      traceLast = std::chrono::steady_clock::now();
+      return true;
+  }
+
+  //true when the backend exports the function, binding it if needed.
+  #define XD_AVAILABLE(name) (NULL != BindXDSymbol(SYM_##name))
+
+  static bool eagerBinding = false;       // SPSSXD_BIND_NOW is set
+
+  //bind one XD function. Returns its address, or NULL when the backend
+  //does not export it or is not loaded yet.
+  static void* BindXDSymbol(int index)
+  {
+      XDSymbol& symbol = xdSymbols[index];
+      if(XD_UNBOUND == symbol.state && pLib) {
+          void* address = (void*)GETADDRESS(pLib, symbol.name);
+          if(address) {
+              if(recording || profiling) {
+                  xdTargets[index] = address;
+                  address = recording ? xdRecordShims[index] : xdProfileShims[index];
+              }
+              *symbol.slot = address;
+              symbol.state = XD_BOUND;
+          } else {
+              symbol.state = XD_MISSING;
+          }
+      }
+      return XD_BOUND == symbol.state ? *symbol.slot : NULL;
+  }
+
+  //bind every XD function, returning the names the backend does not export.
+  static std::vector<const char*> BindAllXDSymbols()
+  {
+      std::vector<const char*> missing;
+      for(int i = 0; i < SYM_COUNT; i++) {
+          if(NULL == BindXDSymbol(i)) {
+              missing.push_back(xdSymbols[i].name);
+          }
+      }
+      return missing;
+  }
+
+  static bool fpInitialized = false;
+
+  //Initialize the function pointer. They are bound on first call unless
+  //SPSSXD_BIND_NOW is set, which binds them all now and reports the missing ones
+  //on stderr, stdout is the user's output when Statistics drives Python.
+  //SPSSXD_PROFILE binds them to the profiling shims, SPSSXD_RECORD to the recording ones.
+  //LoadLib runs at import, in each interpreter, and again in StartSpss; only the first
+  //call initializes.
   void InitializeFP()
   {
-    IsBackendReady = (FP_IsBackendReady)GETADDRESS(pLib,"IsBackendReady");
-    IsXDriven = (FP_IsXDriven)GETADDRESS(pLib,"IsXDriven");
-    SetXNameAndSHome = (FP_SetXNameAndSHome)GETADDRESS(pLib,"SetXNameAndSHome");
-    StartSpss = (FP_StartSpss)GETADDRESS(pLib ,"StartSpss");
-    StopSpss = (FP_StopSpss)GETADDRESS(pLib,"StopSpss");
-    Submit = (FP_Submit)GETADDRESS(pLib,"Submit");
-    QueueCommandPart = (FP_QueueCommandPart)GETADDRESS(pLib,"QueueCommandPart");
-    PostSpssOutput = (FP_PostSpssOutput)GETADDRESS(pLib,"PostSpssOutput");
-    GetVariableCount = (FP_GetVariableCount)GETADDRESS(pLib,"GetVariableCount");
-    GetRowCount = (FP_GetRowCount)GETADDRESS(pLib,"GetRowCount");
-    GetVariableName = (FP_GetVariableName)GETADDRESS(pLib,"GetVariableName");
-    GetVariableLabel = (FP_GetVariableLabel)GETADDRESS(pLib,"GetVariableLabel");
-    GetVariableType = (FP_GetVariableType)GETADDRESS(pLib,"GetVariableType");
-    GetVariableFormat = (FP_GetVariableFormat)GETADDRESS(pLib,"GetVariableFormat");
-    GetVariableMeasurementLevel = (FP_GetVariableMeasurementLevel)GETADDRESS(pLib,"GetVariableMeasurementLevel");
-    CreateXPathDictionary = (FP_CreateXPathDictionary)GETADDRESS(pLib,"CreateXPathDictionary");
-    RemoveXPathHandle = (FP_RemoveXPathHandle)GETADDRESS(pLib,"RemoveXPathHandle");
-    EvaluateXPath =(FP_EvaluateXPath)GETADDRESS(pLib,"EvaluateXPath");
-    GetStringListLength = (FP_GetStringListLength)GETADDRESS(pLib,"GetStringListLength");
-    GetStringFromList = (FP_GetStringFromList)GETADDRESS(pLib,"GetStringFromList");
-    RemoveStringList = (FP_RemoveStringList)GETADDRESS(pLib,"RemoveStringList");
-    GetXmlUtf16 = (FP_GetXmlUtf16)GETADDRESS(pLib,"GetXmlUtf16");
-    GetImage = (FP_GetImage)GETADDRESS(pLib,"GetImage");
-    GetSetting = (FP_GetSetting)GETADDRESS(pLib,"GetSetting");
-    GetOMSTagList = (FP_GetOMSTagList)GETADDRESS(pLib,"GetOMSTagList");
-    GetHandleList = (FP_GetHandleList)GETADDRESS(pLib,"GetHandleList");
-    GetFileHandles = (FP_GetFileHandles)GETADDRESS(pLib,"GetFileHandles");
-
-    GetNumericValue = (FP_GetNumericValue)GETADDRESS(pLib,"GetNumericValue");
-    GetStringValue = (FP_GetStringValue)GETADDRESS(pLib,"GetStringValue");
-    NextCase = (FP_NextCase)GETADDRESS(pLib,"NextCase");
-    RemoveCaseCursor = (FP_RemoveCaseCursor)GETADDRESS(pLib,"RemoveCaseCursor");
-    GetVariableFormatType = (FP_GetVariableFormatType)GETADDRESS(pLib,"GetVariableFormatType");
-    GetCursorPosition = (FP_GetCursorPosition)GETADDRESS(pLib,"GetCursorPosition");
-    MakeCaseCursor = (FP_MakeCaseCursor)GETADDRESS(pLib,"MakeCaseCursor");
-    GetColumnCountInProcDS = (FP_GetColumnCountInProcDS)GETADDRESS(pLib,"GetColumnCountInProcDS");
-    StartProcedure = (FP_StartProcedure)GETADDRESS(pLib,"StartProcedure");
-    SplitChange = (FP_SplitChange)GETADDRESS(pLib,"SplitChange");
-    EndProcedure = (FP_EndProcedure)GETADDRESS(pLib,"EndProcedure");
-
-    StartPivotTable = (FP_StartPivotTable)GETADDRESS(pLib,"StartPivotTable");
-    HidePivotTableTitle = (FP_HidePivotTableTitle)GETADDRESS(pLib,"HidePivotTableTitle");
-    PivotTableCaption = (FP_PivotTableCaption)GETADDRESS(pLib,"PivotTableCaption");
-    AddDimension = (FP_AddDimension)GETADDRESS(pLib,"AddDimension");
-
-    AddNumberCategory = (FP_AddNumberCategory)GETADDRESS(pLib,"AddNumberCategory");
-    AddStringCategory = (FP_AddStringCategory)GETADDRESS(pLib,"AddStringCategory");
-    AddVarNameCategory = (FP_AddVarNameCategory)GETADDRESS(pLib,"AddVarNameCategory");
-    AddVarValueDoubleCategory = (FP_AddVarValueDoubleCategory)GETADDRESS(pLib,"AddVarValueDoubleCategory");
-    AddVarValueStringCategory = (FP_AddVarValueStringCategory)GETADDRESS(pLib,"AddVarValueStringCategory");
-    SetNumberCell = (FP_SetNumberCell)GETADDRESS(pLib,"SetNumberCell");
-    SetStringCell = (FP_SetStringCell)GETADDRESS(pLib,"SetStringCell");
-    SetVarNameCell = (FP_SetVarNameCell)GETADDRESS(pLib,"SetVarNameCell");
-    SetVarValueDoubleCell = (FP_SetVarValueDoubleCell)GETADDRESS(pLib,"SetVarValueDoubleCell");
-    SetVarValueStringCell = (FP_SetVarValueStringCell)GETADDRESS(pLib,"SetVarValueStringCell");
-    AddCellFootnotes = (FP_AddCellFootnotes)GETADDRESS(pLib,"AddCellFootnotes");
-
-    AddProcFootnotes = (FP_AddProcFootnotes)GETADDRESS(pLib,"AddProcFootnotes");
-    AddOutlineFootnotes = (FP_AddOutlineFootnotes)GETADDRESS(pLib,"AddOutlineFootnotes");
-    AddTitleFootnotes = (FP_AddTitleFootnotes)GETADDRESS(pLib,"AddTitleFootnotes");
-    AddDimFootnotes = (FP_AddDimFootnotes)GETADDRESS(pLib,"AddDimFootnotes");
-    AddCategoryFootnotes = (FP_AddCategoryFootnotes)GETADDRESS(pLib,"AddCategoryFootnotes");
-
-
-    AddTextBlock = (FP_AddTextBlock)GETADDRESS(pLib,"AddTextBlock");
-    SetFormatSpecCoefficient = (FP_SetFormatSpecCoefficient)GETADDRESS(pLib,"SetFormatSpecCoefficient");
-    SetFormatSpecCoefficientSE = (FP_SetFormatSpecCoefficientSE)GETADDRESS(pLib,"SetFormatSpecCoefficientSE");
-    SetFormatSpecCoefficientVar = (FP_SetFormatSpecCoefficientVar)GETADDRESS(pLib,"SetFormatSpecCoefficientVar");
-    SetFormatSpecCorrelation = (FP_SetFormatSpecCorrelation)GETADDRESS(pLib,"SetFormatSpecCorrelation");
-    SetFormatSpecGeneralStat = (FP_SetFormatSpecGeneralStat)GETADDRESS(pLib,"SetFormatSpecGeneralStat");
-    SetFormatSpecMean = (FP_SetFormatSpecMean)GETADDRESS(pLib,"SetFormatSpecMean");
-    SetFormatSpecCount = (FP_SetFormatSpecCount)GETADDRESS(pLib,"SetFormatSpecCount");
-    SetFormatSpecPercent = (FP_SetFormatSpecPercent)GETADDRESS(pLib,"SetFormatSpecPercent");
-    SetFormatSpecPercentNoSign = (FP_SetFormatSpecPercentNoSign)GETADDRESS(pLib,"SetFormatSpecPercentNoSign");
-    SetFormatSpecProportion = (FP_SetFormatSpecProportion)GETADDRESS(pLib,"SetFormatSpecProportion");
-    SetFormatSpecSignificance = (FP_SetFormatSpecSignificance)GETADDRESS(pLib,"SetFormatSpecSignificance");
-    SetFormatSpecResidual = (FP_SetFormatSpecResidual)GETADDRESS(pLib,"SetFormatSpecResidual");
-    SetFormatSpecVariable = (FP_SetFormatSpecVariable)GETADDRESS(pLib,"SetFormatSpecVariable");
-    SetFormatSpecStdDev = (FP_SetFormatSpecStdDev)GETADDRESS(pLib,"SetFormatSpecStdDev");
-    SetFormatSpecDifference = (FP_SetFormatSpecDifference)GETADDRESS(pLib,"SetFormatSpecDifference");
-    SetFormatSpecSum = (FP_SetFormatSpecSum)GETADDRESS(pLib,"SetFormatSpecSum");
-
-    HasCursor = (FP_HasCursor)GETADDRESS(pLib,"HasCursor");
-    IsEndSplit = (FP_IsEndSplit)GETADDRESS(pLib,"IsEndSplit");
-
-    GetRowCountInProcDS = (FP_GetRowCountInProcDS)GETADDRESS(pLib,"GetRowCountInProcDS");
-    GetVariableCountInProcDS = (FP_GetVariableCountInProcDS)GETADDRESS(pLib,"GetVariableCountInProcDS");
-    GetVariableLabelInProcDS = (FP_GetVariableLabelInProcDS)GETADDRESS(pLib,"GetVariableLabelInProcDS");
-    GetVariableMeasurementLevelInProcDS = (FP_GetVariableMeasurementLevelInProcDS)GETADDRESS(pLib,"GetVariableMeasurementLevelInProcDS");
-    GetVariableNameInProcDS = (FP_GetVariableNameInProcDS)GETADDRESS(pLib,"GetVariableNameInProcDS");
-    GetVariableTypeInProcDS = (FP_GetVariableTypeInProcDS)GETADDRESS(pLib,"GetVariableTypeInProcDS");
-    GetVarAttributeNamesInProcDS = (FP_GetVarAttributeNamesInProcDS)GETADDRESS(pLib,"GetVarAttributeNamesInProcDS");
-    GetVarAttributesInProcDS = (FP_GetVarAttributesInProcDS)GETADDRESS(pLib,"GetVarAttributesInProcDS");
-    GetVarCMissingValuesInProcDS = (FP_GetVarCMissingValuesInProcDS)GETADDRESS(pLib,"GetVarCMissingValuesInProcDS");
-    GetVarNMissingValuesInProcDS = (FP_GetVarNMissingValuesInProcDS)GETADDRESS(pLib,"GetVarNMissingValuesInProcDS");
-    GetVariableFormatTypeInProcDS = (FP_GetVariableFormatTypeInProcDS)GETADDRESS(pLib,"GetVariableFormatTypeInProcDS");
-    GetVarCMissingValues = (FP_GetVarCMissingValues)GETADDRESS(pLib,"GetVarCMissingValues");
-    GetVarNMissingValues = (FP_GetVarNMissingValues)GETADDRESS(pLib,"GetVarNMissingValues");
-    GetVarAttributeNames = (FP_GetVarAttributeNames)GETADDRESS(pLib,"GetVarAttributeNames");
-    FreeAttributeNames = (FP_FreeAttributeNames)GETADDRESS(pLib,"FreeAttributeNames");
-    GetVarAttributes = (FP_GetVarAttributes)GETADDRESS(pLib,"GetVarAttributes");
-    FreeAttributes = (FP_FreeAttributes)GETADDRESS(pLib,"FreeAttributes");
-    SetVarAttributes = (FP_SetVarAttributes)GETADDRESS(pLib,"SetVarAttributes");
-    GetVariableFormatInProcDS = (FP_GetVariableFormatInProcDS)GETADDRESS(pLib,"GetVariableFormatInProcDS");
-
-    SetVarNameAndType = (FP_SetVarNameAndType)GETADDRESS(pLib,"SetVarNameAndType");
-    SetVarLabel = (FP_SetVarLabel)GETADDRESS(pLib,"SetVarLabel");
-    SetVarCValueLabel = (FP_SetVarCValueLabel)GETADDRESS(pLib,"SetVarCValueLabel");
-    SetVarNValueLabel = (FP_SetVarNValueLabel)GETADDRESS(pLib,"SetVarNValueLabel");
-    SetVarCMissingValues = (FP_SetVarCMissingValues)GETADDRESS(pLib,"SetVarCMissingValues");
-    SetVarNMissingValues = (FP_SetVarNMissingValues)GETADDRESS(pLib,"SetVarNMissingValues");
-    SetVarMeasureLevel = (FP_SetVarMeasureLevel)GETADDRESS(pLib,"SetVarMeasureLevel");
-    SetVarAlignment = (FP_SetVarAlignment)GETADDRESS(pLib,"SetVarAlignment");
-    SetVarFormat = (FP_SetVarFormat)GETADDRESS(pLib,"SetVarFormat");
-    CommitHeader = (FP_CommitHeader)GETADDRESS(pLib,"CommitHeader");
-    SetValueChar = (FP_SetValueChar)GETADDRESS(pLib,"SetValueChar");
-    SetValueNumeric = (FP_SetValueNumeric)GETADDRESS(pLib,"SetValueNumeric");
-    CommitCaseRecord = (FP_CommitCaseRecord)GETADDRESS(pLib,"CommitCaseRecord");
-    CommitNewCase = (FP_CommitNewCase)GETADDRESS(pLib,"CommitNewCase");
-    CommitManyCases = (FP_CommitManyCases)GETADDRESS(pLib,"CommitManyCases");
-    EndChanges = (FP_EndChanges)GETADDRESS(pLib,"EndChanges");
-    IsEndSplit = (FP_IsEndSplit)GETADDRESS(pLib,"IsEndSplit");
-    HasProcedure = (FP_HasProcedure)GETADDRESS(pLib,"HasProcedure");
-    GetSPSSLowHigh = (FP_GetSPSSLowHigh)GETADDRESS(pLib,"GetSPSSLowHigh");
-    GetWeightVar = (FP_GetWeightVar)GETADDRESS(pLib,"GetWeightVar");
-    ResetDataPass = (FP_ResetDataPass)GETADDRESS(pLib,"ResetDataPass");
-    AllocNewVarsBuffer = (FP_AllocNewVarsBuffer)GETADDRESS(pLib,"AllocNewVarsBuffer");
-    SetOneVarNameAndType = (FP_SetOneVarNameAndType)GETADDRESS(pLib,"SetOneVarNameAndType");
-    SetXDriveMode = (FP_SetXDriveMode)GETADDRESS(pLib,"SetXDriveMode");
-
-    StartDataStep = (FP_StartDataStep)GETADDRESS(pLib,"StartDataStep");
-    EndDataStep = (FP_EndDataStep)GETADDRESS(pLib,"EndDataStep");
-    CreateDataset = (FP_CreateDataset)GETADDRESS(pLib,"CreateDataset");
-    SetDatasetName = (FP_SetDatasetName)GETADDRESS(pLib,"SetDatasetName");
-    GetNewDatasetName = (FP_GetNewDatasetName)GETADDRESS(pLib,"GetNewDatasetName");
-    GetActive = (FP_GetActive)GETADDRESS(pLib,"GetActive");
-    SetActive = (FP_SetActive)GETADDRESS(pLib,"SetActive");
-    CopyDataset = (FP_CopyDataset)GETADDRESS(pLib,"CopyDataset");
-    GetSpssDatasets = (FP_GetSpssDatasets)GETADDRESS(pLib,"GetSpssDatasets");
-    GetDatastepDatasets = (FP_GetDatastepDatasets)GETADDRESS(pLib,"GetDatastepDatasets");
-    FreeStringArray = (FP_FreeStringArray)GETADDRESS(pLib,"FreeStringArray");
-    CloseDataset = (FP_CloseDataset)GETADDRESS(pLib,"CloseDataset");
-    InsertVariable = (FP_InsertVariable)GETADDRESS(pLib,"InsertVariable");
-    DeleteVariable = (FP_DeleteVariable)GETADDRESS(pLib,"DeleteVariable");
-    GetVarCountInDS = (FP_GetVarCountInDS)GETADDRESS(pLib,"GetVarCountInDS");
-    GetVarNameInDS = (FP_GetVarNameInDS)GETADDRESS(pLib,"GetVarNameInDS");
-    SetVarNameInDS = (FP_SetVarNameInDS)GETADDRESS(pLib,"SetVarNameInDS");
-    GetVarLabelInDS = (FP_GetVarLabelInDS)GETADDRESS(pLib,"GetVarLabelInDS");
-    SetVarLabelInDS = (FP_SetVarLabelInDS)GETADDRESS(pLib,"SetVarLabelInDS");
-    GetVarTypeInDS = (FP_GetVarTypeInDS)GETADDRESS(pLib,"GetVarTypeInDS");
-    SetVarTypeInDS = (FP_SetVarTypeInDS)GETADDRESS(pLib,"SetVarTypeInDS");
-    GetVarFormatInDS = (FP_GetVarFormatInDS)GETADDRESS(pLib,"GetVarFormatInDS");
-    SetVarFormatInDS = (FP_SetVarFormatInDS)GETADDRESS(pLib,"SetVarFormatInDS");
-    GetVarAlignmentInDS = (FP_GetVarAlignmentInDS)GETADDRESS(pLib,"GetVarAlignmentInDS");
-    SetVarAlignmentInDS = (FP_SetVarAlignmentInDS)GETADDRESS(pLib,"SetVarAlignmentInDS");
-    GetVarMeasurementLevelInDS = (FP_GetVarMeasurementLevelInDS)GETADDRESS(pLib,"GetVarMeasurementLevelInDS");
-    SetVarMeasurementLevelInDS = (FP_SetVarMeasurementLevelInDS)GETADDRESS(pLib,"SetVarMeasurementLevelInDS");
-    GetVarNMissingValuesInDS = (FP_GetVarNMissingValuesInDS)GETADDRESS(pLib,"GetVarNMissingValuesInDS");
-    GetVarCMissingValuesInDS = (FP_GetVarCMissingValuesInDS)GETADDRESS(pLib,"GetVarCMissingValuesInDS");
-    SetVarNMissingValuesInDS = (FP_SetVarNMissingValuesInDS)GETADDRESS(pLib,"SetVarNMissingValuesInDS");
-    SetVarCMissingValuesInDS = (FP_SetVarCMissingValuesInDS)GETADDRESS(pLib,"SetVarCMissingValuesInDS");
-    GetVarAttributesNameInDS = (FP_GetVarAttributesNameInDS)GETADDRESS(pLib,"GetVarAttributesNameInDS");
-    GetVarAttributesInDS = (FP_GetVarAttributesInDS)GETADDRESS(pLib,"GetVarAttributesInDS");
-    SetVarAttributesInDS = (FP_SetVarAttributesInDS)GETADDRESS(pLib,"SetVarAttributesInDS");
-    DelVarAttributesInDS = (FP_DelVarAttributesInDS)GETADDRESS(pLib,"DelVarAttributesInDS");
-    GetVarNValueLabelInDS = (FP_GetVarNValueLabelInDS)GETADDRESS(pLib,"GetVarNValueLabelInDS");
-    FreeDoubleArray = (FP_FreeDoubleArray)GETADDRESS(pLib,"FreeDoubleArray");
-    GetVarCValueLabelInDS = (FP_GetVarCValueLabelInDS)GETADDRESS(pLib,"GetVarCValueLabelInDS");
-    SetVarNValueLabelInDS = (FP_SetVarNValueLabelInDS)GETADDRESS(pLib,"SetVarNValueLabelInDS");
-    SetVarCValueLabelInDS = (FP_SetVarCValueLabelInDS)GETADDRESS(pLib,"SetVarCValueLabelInDS");
-    DelVarValueLabelInDS = (FP_DelVarValueLabelInDS)GETADDRESS(pLib,"DelVarValueLabelInDS");
-    DelVarNValueLabelInDS = (FP_DelVarNValueLabelInDS)GETADDRESS(pLib,"DelVarNValueLabelInDS");
-    DelVarCValueLabelInDS = (FP_DelVarCValueLabelInDS)GETADDRESS(pLib,"DelVarCValueLabelInDS");
-    InsertCase = (FP_InsertCase)GETADDRESS(pLib,"InsertCase");
-    DeleteCase = (FP_DeleteCase)GETADDRESS(pLib,"DeleteCase");
-    GetCaseCountInDS = (FP_GetCaseCountInDS)GETADDRESS(pLib,"GetCaseCountInDS");
-    GetNCellValue = (FP_GetNCellValue)GETADDRESS(pLib,"GetNCellValue");
-    GetCCellValue = (FP_GetCCellValue)GETADDRESS(pLib,"GetCCellValue");
-    SetNCellValue = (FP_SetNCellValue)GETADDRESS(pLib,"SetNCellValue");
-    SetCCellValue = (FP_SetCCellValue)GETADDRESS(pLib,"SetCCellValue");
-
-    IsUTF8mode = (FP_IsUTF8mode)GETADDRESS(pLib,"IsUTF8mode");
-    GetSplitVariableNames = (FP_GetSplitVariableNames)GETADDRESS(pLib,"GetSplitVariableNames");
-    GetDataFileAttributeNames = (FP_GetDataFileAttributeNames)GETADDRESS(pLib,"GetDataFileAttributeNames");
-    GetDataFileAttributes = (FP_GetDataFileAttributes)GETADDRESS(pLib,"GetDataFileAttributes");
-    GetDataFileAttributeNamesInProcDS = (FP_GetDataFileAttributeNamesInProcDS)GETADDRESS(pLib,"GetDataFileAttributeNamesInProcDS");
-    GetDataFileAttributesInProcDS = (FP_GetDataFileAttributesInProcDS)GETADDRESS(pLib,"GetDataFileAttributesInProcDS");
-    GetMultiResponseSetNames = (FP_GetMultiResponseSetNames)GETADDRESS(pLib,"GetMultiResponseSetNames");
-    GetMultiResponseSet = (FP_GetMultiResponseSet)GETADDRESS(pLib,"GetMultiResponseSet");
-    GetMultiResponseSetNamesInProcDS = (FP_GetMultiResponseSetNamesInProcDS)GETADDRESS(pLib,"GetMultiResponseSetNamesInProcDS");
-    GetMultiResponseSetInProcDS = (FP_GetMultiResponseSetInProcDS)GETADDRESS(pLib,"GetMultiResponseSetInProcDS");
-    SetDataFileAttributesInDS = (FP_SetDataFileAttributesInDS)GETADDRESS(pLib,"SetDataFileAttributesInDS");
-    SetMultiResponseSetInDS = (FP_SetMultiResponseSetInDS)GETADDRESS(pLib,"SetMultiResponseSetInDS");
-    FreeString = (FP_FreeString)GETADDRESS(pLib,"FreeString");
-    GetDataFileAttributeNamesInDS = (FP_GetDataFileAttributeNamesInDS)GETADDRESS(pLib,"GetDataFileAttributeNamesInDS");
-    GetDataFileAttributesInDS = (FP_GetDataFileAttributesInDS)GETADDRESS(pLib,"GetDataFileAttributesInDS");
-    GetMultiResponseSetNamesInDS = (FP_GetMultiResponseSetNamesInDS)GETADDRESS(pLib,"GetMultiResponseSetNamesInDS");
-    GetMultiResponseSetInDS = (FP_GetMultiResponseSetInDS)GETADDRESS(pLib,"GetMultiResponseSetInDS");
-    GetVarColumnWidthInDS = (FP_GetVarColumnWidthInDS)GETADDRESS(pLib,"GetVarColumnWidthInDS");
-    SetVarColumnWidthInDS = (FP_SetVarColumnWidthInDS)GETADDRESS(pLib,"SetVarColumnWidthInDS");
-    SaveFileInDS = (FP_SaveFileInDS)GETADDRESS(pLib,"SaveFileInDS");
-    DelDataFileAttributesInDS = (FP_DelDataFileAttributesInDS)GETADDRESS(pLib,"DelDataFileAttributesInDS");
-    DelMultiResponseSetInDS = (FP_DelMultiResponseSetInDS)GETADDRESS(pLib,"DelMultiResponseSetInDS");
-    GetXDriveMode = (FP_GetXDriveMode)GETADDRESS(pLib,"GetXDriveMode");
-    GetSPSSLocale = (FP_GetSPSSLocale)GETADDRESS(pLib,"GetSPSSLocale");
-    GetCLocale = (FP_GetCLocale)GETADDRESS(pLib,"GetCLocale");
-    SetOutputLanguage = (FP_SetOutputLanguage)GETADDRESS(pLib,"SetOutputLanguage");
-    GetNestDepth = (FP_GetNestDepth)GETADDRESS(pLib,"GetNestDepth");
-    GetOutputLanguage = (FP_GetOutputLanguage)GETADDRESS(pLib,"GetOutputLanguage");
-    
-    TransCode = (FP_TransCode)GETADDRESS(pLib, "TransCode");
+    if(fpInitialized) {
+        return;
+    }
+    fpInitialized = true;
 
-    GetNCellValueCache = (FP_GetNCellValueCache)GETADDRESS(pLib, "GetNCellValueCache");
-    GetCCellValueCache = (FP_GetCCellValueCache)GETADDRESS(pLib, "GetCCellValueCache");
-    GetRowList = (FP_GetRowList)GETADDRESS(pLib, "GetRowList");
-    GetVarTypeInDSCache = (FP_GetVarTypeInDSCache)GETADDRESS(pLib, "GetVarTypeInDSCache");
-    ClearDatastepBatch = (FP_ClearDatastepBatch)GETADDRESS(pLib, "ClearDatastepBatch");
-    
-    GetVariableRole = (FP_GetVariableRole)GETADDRESS(pLib, "GetVariableRole");
-    GetVariableRoleInProcDS = (FP_GetVariableRoleInProcDS)GETADDRESS(pLib, "GetVariableRoleInProcDS");
-    SetVarRole = (FP_SetVarRole)GETADDRESS(pLib, "SetVarRole");
-    GetVarRoleInDS = (FP_GetVarRoleInDS)GETADDRESS(pLib, "GetVarRoleInDS");
-    SetVarRoleInDS = (FP_SetVarRoleInDS)GETADDRESS(pLib, "SetVarRoleInDS");
-    
-    TransportData = (FP_TransportData)GETADDRESS(pLib,"TransportData");
-    GetDataFromTempFile = (FP_GetDataFromTempFile)GETADDRESS(pLib,"GetDataFromTempFile");
-    SaveDataToTempFile = (FP_SaveDataToTempFile)GETADDRESS(pLib,"SaveDataToTempFile");
-    GetSplitEndIndex = (FP_GetSplitEndIndex)GETADDRESS(pLib,"GetSplitEndIndex");
-    SetMode = (FP_SetMode)GETADDRESS(pLib,"SetMode");
-    GetRowCountInTempFile = (FP_GetRowCountInTempFile)GETADDRESS(pLib, "GetRowCountInTempFile");
-    
-    GetNCellValueFromCache = (FP_GetNCellValueFromCache)GETADDRESS(pLib,"GetNCellValueFromCache");
-    GetCCellValueFromCache = (FP_GetCCellValueFromCache)GETADDRESS(pLib,"GetCCellValueFromCache");
-    GetVarInfo = (FP_GetVarInfo)GETADDRESS(pLib,"GetVarInfo");
-    SetNCellValueFromCache = (FP_SetNCellValueFromCache)GETADDRESS(pLib,"SetNCellValueFromCache");
-    SetCCellValueFromCache = (FP_SetCCellValueFromCache)GETADDRESS(pLib,"SetCCellValueFromCache");
-    GetCaseValue = (FP_GetCaseValue)GETADDRESS(pLib,"GetCaseValue");
-    SetCasePartValue = (FP_SetCasePartValue)GETADDRESS(pLib,"SetCasePartValue");
-    SetCacheInDS = (FP_SetCacheInDS)GETADDRESS(pLib,"SetCacheInDS");
-    
-    IsDistributedMode = (FP_IsDistributedMode)GETADDRESS(pLib,"IsDistributedMode");
-    GetXmlUtf16Length = (FP_GetXmlUtf16Length)GETADDRESS(pLib,"GetXmlUtf16Length");
-    IsUseOrFilter = (FP_IsUseOrFilter)GETADDRESS(pLib,"IsUseOrFilter");
+    const char* profile = getenv("SPSSXD_PROFILE");
+    profiling = profile && *profile && strcmp(profile, "0") != 0;
+    profilePath = profiling && strcmp(profile, "1") != 0 ? profile : "";
+
+    const char* record = getenv("SPSSXD_RECORD");
+    const char* recordValuesEnv = getenv("SPSSXD_RECORD_VALUES");
+    if(NULL == traceFile) {
+        recordValues = recordValuesEnv && *recordValuesEnv && strcmp(recordValuesEnv, "0") != 0;
+    }
+    recording = record && *record && OpenTrace(record);
+
+    const char* bindNow = getenv("SPSSXD_BIND_NOW");
+    eagerBinding = bindNow && *bindNow && strcmp(bindNow, "0") != 0;
+    if(!eagerBinding) {
+        return;
+    }
+    std::vector<const char*> missing = BindAllXDSymbols();
+    if(!missing.empty()) {
+        std::string names;
+        for(size_t i = 0; i < missing.size(); i++) {
+            names.append(i ? ", " : "").append(missing[i]);
+        }
+        fprintf(stderr, "SPSSXD API functions not found: %s.\n", names.c_str());
+    }
   }
 
   //load spssxd.dll
@@ -1126,313 +1383,1090 @@ extern "C"{
 #endif
 
     pLib= NULL;
-    IsBackendReady = NULL;
-    IsXDriven = NULL;
-    SetXNameAndSHome = NULL;
-    StartSpss = NULL;
-    StopSpss = NULL;
-    Submit = NULL;
-    QueueCommandPart = NULL;
-    PostSpssOutput = NULL;
-    GetVariableCount = NULL;
-    GetRowCount = NULL;
-    GetVariableName = NULL;
-    GetVariableLabel = NULL;
-    GetVariableType = NULL;
-    GetVariableFormat = NULL;
-    GetVariableMeasurementLevel = NULL;
-    CreateXPathDictionary = NULL;
-    RemoveXPathHandle = NULL;
-    EvaluateXPath = NULL;
-    GetStringListLength = NULL;
-    GetStringFromList = NULL;
-    RemoveStringList = NULL;
-    GetXmlUtf16 = NULL;
-    GetImage = NULL;
-    GetSetting = NULL;
-    GetOMSTagList = NULL;
-    GetHandleList = NULL;
-    GetFileHandles = NULL;
-    GetNumericValue = NULL;
-    GetStringValue = NULL;
-    NextCase = NULL;
-    RemoveCaseCursor = NULL;
-    GetVariableFormatType = NULL;
-    GetCursorPosition = NULL;
-    MakeCaseCursor = NULL;
-    GetColumnCountInProcDS = NULL;
-    StartProcedure = NULL;
-    SplitChange = NULL;
-    EndProcedure = NULL;
-
-    StartPivotTable = NULL;
-    HidePivotTableTitle = NULL;
-    PivotTableCaption = NULL;
-    AddDimension = NULL;
-    AddNumberCategory = NULL;
-    AddStringCategory = NULL;
-    AddVarNameCategory = NULL;
-    AddVarValueDoubleCategory = NULL;
-    AddVarValueStringCategory = NULL;
-    SetNumberCell = NULL;
-    SetStringCell = NULL;
-    SetVarNameCell = NULL;
-    SetVarValueDoubleCell = NULL;
-    SetVarValueStringCell = NULL;
-    AddCellFootnotes = NULL;
-
-    AddProcFootnotes = NULL;
-    AddOutlineFootnotes = NULL;
-    AddTitleFootnotes = NULL;
-    AddDimFootnotes = NULL;
-    AddCategoryFootnotes = NULL;
-
-
-    AddTextBlock = NULL;
-    MinDataColumnWidth = NULL;
-    MaxDataColumnWidth = NULL;
-    SetFormatSpecCoefficient = NULL;
-    SetFormatSpecCoefficientSE = NULL;
-    SetFormatSpecCoefficientVar = NULL;
-    SetFormatSpecCorrelation = NULL;
-    SetFormatSpecGeneralStat = NULL;
-    SetFormatSpecMean = NULL;
-    SetFormatSpecCount = NULL;
-    SetFormatSpecPercent = NULL;
-    SetFormatSpecPercentNoSign = NULL;
-    SetFormatSpecProportion = NULL;
-    SetFormatSpecSignificance = NULL;
-    SetFormatSpecResidual = NULL;
-    SetFormatSpecVariable = NULL;
-    SetFormatSpecStdDev = NULL;
-    SetFormatSpecDifference = NULL;
-    SetFormatSpecSum = NULL;
-
-    CommitCaseRecord = NULL;
-    CommitNewCase = NULL;
-    CommitManyCases = NULL;
-    EndChanges = NULL;
-
-    HasCursor = NULL;
-    IsEndSplit = NULL;
-    HasProcedure = NULL;
-    GetSPSSLowHigh = NULL;
-    GetWeightVar = NULL;
-    ResetDataPass = NULL;
-    AllocNewVarsBuffer = NULL;
-    SetOneVarNameAndType = NULL;
-    GetRowCountInProcDS = NULL;
-    GetVariableCountInProcDS = NULL;
-    GetVariableLabelInProcDS = NULL;
-    GetVariableMeasurementLevelInProcDS = NULL;
-    GetVariableFormatTypeInProcDS = NULL;
-
-    GetVariableNameInProcDS  = NULL;
-    GetVariableTypeInProcDS  = NULL;
-    GetVarAttributeNamesInProcDS  = NULL;
-    GetVarAttributesInProcDS  = NULL;
-    GetVarCMissingValuesInProcDS  = NULL;
-    GetVarNMissingValuesInProcDS  = NULL;
-    SetXDriveMode = NULL;
-
-    StartDataStep = NULL;
-    EndDataStep = NULL;
-    CreateDataset = NULL;
-    SetDatasetName = NULL;
-    GetNewDatasetName = NULL;
-    GetActive = NULL;
-    SetActive = NULL;
-    CopyDataset = NULL;
-    GetSpssDatasets = NULL;
-    GetDatastepDatasets = NULL;
-    FreeStringArray = NULL;
-    CloseDataset = NULL;
-    InsertVariable = NULL;
-    DeleteVariable = NULL;
-    GetVarCountInDS = NULL;
-    GetVarNameInDS = NULL;
-    SetVarNameInDS = NULL;
-    GetVarLabelInDS = NULL;
-    SetVarLabelInDS = NULL;
-    GetVarTypeInDS = NULL;
-    SetVarTypeInDS = NULL;
-    GetVarFormatInDS = NULL;
-    SetVarFormatInDS = NULL;
-    GetVarAlignmentInDS = NULL;
-    SetVarAlignmentInDS = NULL;
-    GetVarMeasurementLevelInDS = NULL;
-    SetVarMeasurementLevelInDS = NULL;
-    GetVarNMissingValuesInDS = NULL;
-    GetVarCMissingValuesInDS = NULL;
-    SetVarNMissingValuesInDS = NULL;
-    SetVarCMissingValuesInDS = NULL;
-    GetVarAttributesNameInDS = NULL;
-    GetVarAttributesInDS = NULL;
-    SetVarAttributesInDS = NULL;
-    DelVarAttributesInDS = NULL;
-    GetVarNValueLabelInDS = NULL;
-    FreeDoubleArray = NULL;
-    GetVarCValueLabelInDS = NULL;
-    SetVarNValueLabelInDS = NULL;
-    SetVarCValueLabelInDS = NULL;
-    DelVarValueLabelInDS = NULL;
-    DelVarNValueLabelInDS = NULL;
-    DelVarCValueLabelInDS = NULL;
-    InsertCase = NULL;
-    DeleteCase = NULL;
-    GetCaseCountInDS = NULL;
-    GetNCellValue = NULL;
-    GetCCellValue = NULL;
-    SetNCellValue = NULL;
-    SetCCellValue = NULL;
-
-    IsUTF8mode = NULL;
-    GetDataFileAttributeNames = NULL;
-    GetDataFileAttributes = NULL;
-    GetDataFileAttributeNamesInProcDS = NULL;
-    GetDataFileAttributesInProcDS = NULL;
-    GetMultiResponseSetNames = NULL;
-    GetMultiResponseSet = NULL;
-    GetMultiResponseSetNamesInProcDS = NULL;
-    GetMultiResponseSetInProcDS = NULL;
-    SetDataFileAttributesInDS = NULL;
-    SetMultiResponseSetInDS = NULL;
-    FreeString = NULL;
-    GetDataFileAttributeNamesInDS = NULL;
-    GetDataFileAttributesInDS = NULL;
-    GetMultiResponseSetNamesInDS = NULL;
-    GetMultiResponseSetInDS = NULL;
-    GetVarColumnWidthInDS = NULL;
-    SetVarColumnWidthInDS = NULL;
-    SaveFileInDS = NULL;
-    DelDataFileAttributesInDS = NULL;
-    DelMultiResponseSetInDS = NULL;
-    GetXDriveMode = NULL;
-    GetSPSSLocale = NULL;
-    GetCLocale = NULL;
-    SetOutputLanguage = NULL;
-    GetNestDepth = NULL;
-    GetOutputLanguage = NULL;
-    TransCode = NULL;
-
-    GetNCellValueCache = NULL;
-    GetCCellValueCache = NULL;
-    GetRowList = NULL;
-    GetVarTypeInDSCache = NULL;
-    ClearDatastepBatch = NULL;
-    
-    GetVariableRole = NULL;
-    GetVariableRoleInProcDS = NULL;
-    SetVarRole = NULL;
-    GetVarRoleInDS = NULL;
-    SetVarRoleInDS = NULL;
-    
-    TransportData = NULL;
-    GetDataFromTempFile = NULL;
-    SaveDataToTempFile = NULL;
-    GetSplitEndIndex = NULL;
-    SetMode = NULL;
-    GetRowCountInTempFile = NULL;
-    
-    GetNCellValueFromCache = NULL;
-    GetCCellValueFromCache = NULL;
-    SetNCellValueFromCache = NULL;
-    SetCCellValueFromCache = NULL;
-    GetVarInfo = NULL;
-    GetCaseValue = NULL;
-    SetCasePartValue = NULL;
-    SetCacheInDS = NULL;
-    
-    IsDistributedMode = NULL;
-    GetXmlUtf16Length = NULL;
-    IsUseOrFilter = NULL;
+    if(recording) {
+        std::lock_guard<std::mutex> lock(traceMutex);
+        FlushTrace();
+    }
+    #define XD_SYMBOL_RESET(name) name = XDTrampoline<SYM_##name, FP_##name>::call;
+    XD_SYMBOLS(XD_SYMBOL_RESET)
+    for(int i = 0; i < SYM_COUNT; i++) {
+        xdSymbols[i].state = XD_UNBOUND;
+    }
   }
 
-    //======================================================================
-    PyObject *
-    GetCaseCountAll_XD(PyObject *self, PyObject *args, const int mode)
-    {
-        long count;
-        int errLevel;
-        if(mode == DS_MODE) {
-            count = GetRowCount(errLevel);
-        } else {
-            count = GetRowCountInProcDS(errLevel);
-        }
+  // Locale tracking.
+  //
+  // After a command has run, the C locale is reset to the backend's (xdlocale).
+  // The locale last applied is kept, and setlocale is called only when xdlocale
+  // differs from it or the process locale was changed since. When the backend
+  // exports GetCLocaleGeneration, GetCLocale itself is skipped while the
+  // generation is unchanged. With SPSSXD_THREAD_LOCALE set, xdlocale is applied
+  // to the calling thread with uselocale where the platform has it, leaving the
+  // process locale of other threads alone.
+
+#if defined(__UNX_LINUX__) || defined(__MACOSX__)
+  #define XD_HAVE_USELOCALE
+  #ifdef __MACOSX__
+    #include <xlocale.h>
+  #endif
+#endif
 
-        return Py_BuildValue("li", count, errLevel);
-    }
+  static std::string appliedXDLocale;         // the xdlocale last given to setlocale
+  static std::string appliedCLocale;          // the process locale setlocale reported for it
+  static int appliedLocaleGeneration = -1;    // -1 when not known
 
-    PyObject *
-    GetVariableCountAll_XD(PyObject *self, PyObject *args, const int mode)
-    {
-        int count;
-        int errLevel;
+#ifdef XD_HAVE_USELOCALE
+  static int threadLocaleMode = -1;           // SPSSXD_THREAD_LOCALE, read on first use
+  static thread_local std::string threadXDLocale;
+  static thread_local locale_t threadLocale = (locale_t)0;
+  static thread_local int threadLocaleGeneration = -1;
 
-        if(mode == DS_MODE) {
-            count = GetVariableCount(errLevel);
-        } else {
-            count = GetVariableCountInProcDS(errLevel);
-        }
+  //apply xdlocale to the calling thread only. Returns false when it is not a valid locale.
+  static bool ApplyThreadLocale(const char* xdlocale)
+  {
+      if ( threadLocale && threadXDLocale == xdlocale && uselocale((locale_t)0) == threadLocale ){
+          return true;
+      }
+      locale_t newLocale = newlocale(LC_ALL_MASK, xdlocale, (locale_t)0);
+      if ( !newLocale ){
+          return false;
+      }
+      uselocale(newLocale);
+      if ( threadLocale ){
+          freelocale(threadLocale);
+      }
+      threadLocale = newLocale;
+      threadXDLocale = xdlocale;
+      return true;
+  }
 
-        return Py_BuildValue("ii", count, errLevel);
-    }
+  static bool UseThreadLocale()
+  {
+      if ( threadLocaleMode < 0 ){
+          const char* mode = getenv("SPSSXD_THREAD_LOCALE");
+          threadLocaleMode = (mode && *mode && strcmp(mode, "0") != 0) ? 1 : 0;
+      }
+      return 1 == threadLocaleMode;
+  }
+#endif
 
-    PyObject *
-    GetVariableFormatAll_XD(PyObject *self, PyObject *args, const int mode)
-    {
-        int index;
-        const char* format;
-        if (!PyArg_ParseTuple(args, "i", &index)) {
-            return NULL;
-        }
+  //true when nothing has changed the process locale since it was last applied.
+  static bool ProcessLocaleUnchanged()
+  {
+      const char* current = setlocale(LC_ALL, NULL);
+      return current && !appliedCLocale.empty() && appliedCLocale == current;
+  }
 
-        int errLevel;
-        if(mode == DS_MODE) {
-            format = GetVariableFormat(index,errLevel);
-        } else {
-            format = GetVariableFormat(index,errLevel);
-        }
-        if(IsUTF8mode()&&(errLevel==0))
-        {
-            PyObject* pyValue = PyUnicode_Decode(format,strlen(format),"utf-8",NULL);
-            PyObject* r = Py_BuildValue("Oi", pyValue, errLevel);
-            Py_XDECREF(pyValue);
-            return r;
-        }
-        else
-        {
-            return Py_BuildValue("si", format, errLevel);
-        }
-    }
+  //true when the locale applied for this generation of xdlocale is still in use.
+  static bool LocaleUpToDate(int generation)
+  {
+#ifdef XD_HAVE_USELOCALE
+      if ( UseThreadLocale() ){
+          return threadLocale && generation == threadLocaleGeneration && uselocale((locale_t)0) == threadLocale;
+      }
+#endif
+      return generation == appliedLocaleGeneration && ProcessLocaleUnchanged();
+  }
 
-    PyObject *
-    GetVariableLabelAll_XD(PyObject *self, PyObject *args, const int mode)
-    {
-        int index;
-        const char* label;
-        if (!PyArg_ParseTuple(args, "i", &index)) {
-            return NULL;
-        }
+  static void ApplyXDLocale(const char* xdlocale, int generation)
+  {
+#ifdef XD_HAVE_USELOCALE
+      if ( UseThreadLocale() && ApplyThreadLocale(xdlocale) ){
+          threadLocaleGeneration = generation;
+          return;
+      }
+#endif
+      if ( appliedXDLocale != xdlocale || !ProcessLocaleUnchanged() ){
+          const char* result = setlocale(LC_ALL, xdlocale);
+          appliedXDLocale = xdlocale;
+          appliedCLocale = result ? result : "";
+      }
+      appliedLocaleGeneration = generation;
+  }
 
-        int errLevel;
+  //after a command has run, reset the locale to xdlocale.
+  static int ResetXDLocale()
+  {
+      int errLevel = 0;
+      if ( !XD_AVAILABLE(GetCLocale) ){
+          return errLevel;
+      }
+      int generation = -1;
+      if ( XD_AVAILABLE(GetCLocaleGeneration) ){
+          if ( 0 != GetCLocaleGeneration(generation) ){
+              generation = -1;
+          } else if ( generation >= 0 && LocaleUpToDate(generation) ){
+              return errLevel;
+          }
+      }
+      char *xdlocale = 0;
+      errLevel = GetCLocale(&xdlocale);
+      if ( xdlocale ){
+          ApplyXDLocale(xdlocale, generation);
+      }
+      FreeString( xdlocale );
+      return errLevel;
+  }
 
-        if(mode == DS_MODE) {
-            label = GetVariableLabel(index, errLevel);
-        } else {
-            label = GetVariableLabelInProcDS(index, errLevel);
-        }
-        if(IsUTF8mode()&&(errLevel==0))
-        {
-            PyObject* pyValue = PyUnicode_Decode(label,strlen(label),"utf-8",NULL);
-            PyObject* r = Py_BuildValue("Oi", pyValue, errLevel);
-            Py_XDECREF(pyValue);
-            return r;
-        }
-        else
-        {
-            return Py_BuildValue("si", label, errLevel);
-        }
+  // Arguments of METH_FASTCALL functions.
+  //
+  // The functions called for each case or cell get their arguments as an array
+  // (METH_FASTCALL) rather than as a tuple for PyArg_ParseTuple, and build their
+  // results without Py_BuildValue. These convert one argument each, raising the
+  // exception PyArg_ParseTuple raises for the same format.
+
+  static bool FastArgCount(const char* name, Py_ssize_t nargs, Py_ssize_t expected)
+  {
+      if(nargs != expected) {
+          PyErr_Format(PyExc_TypeError, "%s() takes exactly %d arguments (%d given)",
+                       name, (int)expected, (int)nargs);
+          return false;
+      }
+      return true;
+  }
+
+  //"s": a str without embedded NUL, as UTF-8.
+  static bool FastString(PyObject* arg, const char*& value)
+  {
+      if(!PyUnicode_Check(arg)) {
+          PyErr_Format(PyExc_TypeError, "argument must be str, not %.50s", Py_TYPE(arg)->tp_name);
+          return false;
+      }
+      Py_ssize_t size = 0;
+      value = PyUnicode_AsUTF8AndSize(arg, &size);
+      if(NULL == value) {
+          return false;
+      }
+      if((size_t)size != strlen(value)) {
+          PyErr_SetString(PyExc_ValueError, "embedded null character");
+          return false;
+      }
+      return true;
+  }
+
+  //"i"
+  static bool FastInt(PyObject* arg, int& value)
+  {
+      if(PyFloat_Check(arg)) {
+          PyErr_SetString(PyExc_TypeError, "integer argument expected, got float");
+          return false;
+      }
+      long number = PyLong_AsLong(arg);
+      if(-1 == number && PyErr_Occurred()) {
+          return false;
+      }
+      if(number > INT_MAX || number < INT_MIN) {
+          PyErr_SetString(PyExc_OverflowError, number > INT_MAX ? "signed integer is greater than maximum"
+                                                                : "signed integer is less than minimum");
+          return false;
+      }
+      value = (int)number;
+      return true;
+  }
+
+  //"d"
+  static bool FastDouble(PyObject* arg, double& value)
+  {
+      value = PyFloat_AsDouble(arg);
+      return !(-1.0 == value && PyErr_Occurred());
+  }
+
+  //a string from the backend, None for NULL.
+  static PyObject* StringOrNone(const char* value)
+  {
+      if(NULL == value) {
+          Py_INCREF(Py_None);
+          return Py_None;
+      }
+      return PyUnicode_FromString(value);
+  }
+
+  //the tuple (value, errLevel). Takes the reference to value.
+  static PyObject* ValueAndError(PyObject* value, int errLevel)
+  {
+      if(NULL == value) {
+          return NULL;
+      }
+      PyObject* error = PyLong_FromLong(errLevel);
+      PyObject* result = error ? PyTuple_New(2) : NULL;
+      if(NULL == result) {
+          Py_DECREF(value);
+          Py_XDECREF(error);
+          return NULL;
+      }
+      PyTuple_SET_ITEM(result, 0, value);
+      PyTuple_SET_ITEM(result, 1, error);
+      return result;
+  }
+
+  // Asynchronous submit.
+  //
+  // SubmitAsync queues a command and returns a ticket. When the backend exports
+  // SubmitAsync the tickets are its own; otherwise the commands are run here, in
+  // order, by one worker thread that calls Submit. Either way the outcome of a
+  // ticket is reported once, by PollSubmit, WaitSubmit or the completion callback.
+  //
+  // While the local worker runs, every other module function waits for it first
+  // (see AfterSubmits), so the backend is only used by one thread. The completion
+  // callback runs on the worker and may use the module directly. The worker reads
+  // the locale after each command, and the thread that collects the result applies it.
+
+  const int INVALID_SUBMIT_TICKET = 122;
+  const int SUBMIT_TIMEOUT = 123;
+
+  enum XDriveMode {
+      kInvalidMode = -1,
+      kSPSSMode,
+      kPythonMode,
+      kOthers
+  };
+
+  //before a command is submitted from Python.
+  static void PrepareSubmit()
+  {
+      SetXDriveMode(1);
+
+      int currMode=0, originMode=0;
+      GetXDriveMode(currMode, originMode);
+      if ( kPythonMode == originMode ){
+          if ( StartReceivePyThread ){
+              StartReceivePyThread();
+          }
+      }
+  }
+
+  typedef struct {
+      bool                done;
+      int                 errLevel;
+      FP_SubmitCallback   callback;
+      void*               userData;
+  } SubmitTicketState;
+
+  static std::mutex submitMutex;
+  static std::condition_variable submitCond;
+  static std::deque<std::pair<int, std::string> > submitQueue;
+  static std::map<int, SubmitTicketState> submitTickets;
+  static std::atomic<bool> submitWorkerRunning(false);
+  static std::thread::id submitWorkerThread;
+  static int nextSubmitTicket = 1;
+  static std::string submitXDLocale;          // the xdlocale after the last command of the worker
+  static int submitLocaleGeneration = -1;
+
+  //the local worker. It runs until the queue is empty, so no thread is left
+  //waiting when the process exits.
+  static void SubmitWorkerLoop()
+  {
+      std::unique_lock<std::mutex> lock(submitMutex);
+      while(!submitQueue.empty()) {
+          std::pair<int, std::string> job = submitQueue.front();
+          submitQueue.pop_front();
+          lock.unlock();
+          PrepareSubmit();
+          int errLevel = Submit(job.second.c_str(), (int)job.second.length());
+          int generation = -1;
+          char* xdlocale = 0;
+          if ( 0 == errLevel && XD_AVAILABLE(GetCLocale) ){
+              if ( !XD_AVAILABLE(GetCLocaleGeneration) || 0 != GetCLocaleGeneration(generation) ){
+                  generation = -1;
+              }
+              GetCLocale(&xdlocale);
+          }
+          lock.lock();
+          if ( xdlocale ){
+              submitXDLocale = xdlocale;
+              submitLocaleGeneration = generation;
+              FreeString( xdlocale );
+          }
+          SubmitTicketState& state = submitTickets[job.first];
+          state.done = true;
+          state.errLevel = errLevel;
+          FP_SubmitCallback callback = state.callback;
+          void* userData = state.userData;
+          if(callback) {
+              submitTickets.erase(job.first);
+          }
+          submitCond.notify_all();
+          if(callback) {
+              lock.unlock();
+              callback(job.first, errLevel, userData);
+              lock.lock();
+          }
+      }
+      submitWorkerRunning = false;
+      submitCond.notify_all();
+  }
+
+  static int LocalSubmitAsync(const char* command, int length, int& ticket)
+  {
+      std::lock_guard<std::mutex> lock(submitMutex);
+      ticket = nextSubmitTicket++;
+      SubmitTicketState state = {false, 0, NULL, NULL};
+      submitTickets[ticket] = state;
+      submitQueue.push_back(std::make_pair(ticket, std::string(command, length)));
+      if(!submitWorkerRunning) {
+          submitWorkerRunning = true;
+          std::thread worker(SubmitWorkerLoop);
+          submitWorkerThread = worker.get_id();
+          worker.detach();
+      }
+      return 0;
+  }
+
+  //apply the locale the worker read after its last command.
+  static void ApplySubmitLocale()
+  {
+      std::string xdlocale;
+      int generation = -1;
+      {
+          std::lock_guard<std::mutex> lock(submitMutex);
+          xdlocale = submitXDLocale;
+          generation = submitLocaleGeneration;
+      }
+      if ( !xdlocale.empty() && !(generation >= 0 && LocaleUpToDate(generation)) ){
+          ApplyXDLocale(xdlocale.c_str(), generation);
+      }
+  }
+
+  static int LocalPollSubmit(int ticket, int& done, int& errLevel)
+  {
+      std::lock_guard<std::mutex> lock(submitMutex);
+      std::map<int, SubmitTicketState>::iterator it = submitTickets.find(ticket);
+      if(it == submitTickets.end() || it->second.callback) {
+          return INVALID_SUBMIT_TICKET;
+      }
+      done = it->second.done;
+      errLevel = it->second.errLevel;
+      if(done) {
+          submitTickets.erase(it);
+      }
+      return 0;
+  }
+
+  static int LocalWaitSubmit(int ticket, int timeout, int& errLevel)
+  {
+      std::unique_lock<std::mutex> lock(submitMutex);
+      std::chrono::steady_clock::time_point deadline =
+          std::chrono::steady_clock::now() + std::chrono::milliseconds(timeout < 0 ? 0 : timeout);
+      for(;;) {
+          std::map<int, SubmitTicketState>::iterator it = submitTickets.find(ticket);
+          if(it == submitTickets.end() || it->second.callback) {
+              return INVALID_SUBMIT_TICKET;
+          }
+          if(it->second.done) {
+              errLevel = it->second.errLevel;
+              submitTickets.erase(it);
+              return 0;
+          }
+          if(timeout < 0) {
+              submitCond.wait(lock);
+          } else if(std::cv_status::timeout == submitCond.wait_until(lock, deadline)) {
+              return SUBMIT_TIMEOUT;
+          }
+      }
+  }
+
+  static int LocalSetSubmitCallback(int ticket, FP_SubmitCallback callback, void* userData)
+  {
+      std::unique_lock<std::mutex> lock(submitMutex);
+      std::map<int, SubmitTicketState>::iterator it = submitTickets.find(ticket);
+      if(it == submitTickets.end() || it->second.callback) {
+          return INVALID_SUBMIT_TICKET;
+      }
+      if(it->second.done) {
+          int errLevel = it->second.errLevel;
+          submitTickets.erase(it);
+          lock.unlock();
+          callback(ticket, errLevel, userData);
+      } else {
+          it->second.callback = callback;
+          it->second.userData = userData;
+      }
+      return 0;
+  }
+
+  //wait until the local worker has run every queued command and its callbacks.
+  //Called with the GIL held before anything else uses the backend; the
+  //completion callbacks need the GIL. The worker itself, running a callback,
+  //does not wait, its queue is not run until the callback returns.
+  static void DrainSubmitQueue()
+  {
+      if(!submitWorkerRunning.load(std::memory_order_acquire)) {
+          return;
+      }
+      {
+          std::lock_guard<std::mutex> lock(submitMutex);
+          if(submitWorkerRunning && std::this_thread::get_id() == submitWorkerThread) {
+              return;
+          }
+      }
+      Py_BEGIN_ALLOW_THREADS
+      {
+          std::unique_lock<std::mutex> lock(submitMutex);
+          while(submitWorkerRunning) {
+              submitCond.wait(lock);
+          }
+      }
+      Py_END_ALLOW_THREADS
+  }
+
+  //a Python completion callback and the interpreter it belongs to.
+  typedef struct {
+      PyInterpreterState* interp;
+      PyObject*           callable;
+  } PySubmitCallbackData;
+
+  static void CallSubmitCallback(PySubmitCallbackData* data, int ticket, int errLevel)
+  {
+      PyObject* result = PyObject_CallFunction(data->callable, "ii", ticket, errLevel);
+      if(NULL == result) {
+          PyErr_WriteUnraisable(data->callable);
+      }
+      Py_XDECREF(result);
+      Py_DECREF(data->callable);
+      delete data;
+  }
+
+  //the completion callback given to SetSubmitCallback. userData is a PySubmitCallbackData
+  //holding a new reference to the callable, which is called as callable(ticket, errLevel)
+  //in its own interpreter. PyGILState_Ensure only knows the main interpreter, so the
+  //callback of a sub-interpreter gets a thread state of its own.
+  static void PySubmitCallback(int ticket, int errLevel, void* userData)
+  {
+      PySubmitCallbackData* data = (PySubmitCallbackData*)userData;
+      PyThreadState* current = _PyThreadState_UncheckedGet();
+      if(current && current->thread_id == PyThread_get_thread_ident()) {
+          // the ticket was done already, SetSubmitCallback calls back on the submitting thread.
+          CallSubmitCallback(data, ticket, errLevel);
+          return;
+      }
+      if(data->interp == PyInterpreterState_Main()) {
+          PyGILState_STATE gilState = PyGILState_Ensure();
+          CallSubmitCallback(data, ticket, errLevel);
+          PyGILState_Release(gilState);
+          return;
+      }
+      PyThreadState* threadState = PyThreadState_New(data->interp);
+      PyEval_RestoreThread(threadState);
+      CallSubmitCallback(data, ticket, errLevel);
+      PyThreadState_Clear(threadState);
+      PyThreadState_DeleteCurrent();
+  }
+
+  // Deferred pivot tables.
+  //
+  // In deferred mode the pivot table calls are recorded into pivotModel instead of
+  // being forwarded one at a time. The record is sent to the backend in one pass by
+  // FlushPivotModel, which runs for FlushPivotTables, SplitChange, EndProcedure and
+  // anything else that must see the tables in the output first. Errors from the
+  // backend are therefore reported by the flush rather than by the recorded call.
+  //
+  // A table whose body is a complete grid of number cells under string categories
+  // is sent as one SetNumberCells call. Other tables are replayed call by call, and
+  // a category is not re-sent while its dimension stays on it.
+  enum {
+      PIVOT_START = 0,
+      PIVOT_HIDE_TITLE,
+      PIVOT_CAPTION,
+      PIVOT_OUTLINE_FOOTNOTES,
+      PIVOT_TITLE_FOOTNOTES,
+      PIVOT_DIMENSION,
+      PIVOT_FORMAT,
+      PIVOT_NUMBER_CATEGORY,
+      PIVOT_STRING_CATEGORY,
+      PIVOT_VARNAME_CATEGORY,
+      PIVOT_VARVALUE_DOUBLE_CATEGORY,
+      PIVOT_VARVALUE_STRING_CATEGORY,
+      PIVOT_NUMBER_CELL,
+      PIVOT_STRING_CELL,
+      PIVOT_VARNAME_CELL,
+      PIVOT_VARVALUE_DOUBLE_CELL,
+      PIVOT_VARVALUE_STRING_CELL,
+      PIVOT_CELL_FOOTNOTES,
+      PIVOT_DIM_FOOTNOTES,
+      PIVOT_CATEGORY_FOOTNOTES
+  };
+
+  typedef struct {
+      int       op;         // one of PIVOT_...
+      int       table;      // index into pivotModel.tables, -1 for PIVOT_FORMAT
+      int       dim;        // index into pivotModel.dims, -1 for table level records
+      int       text;       // offset into pivotModel.strings, -1 if none
+      int       intVal;     // variable index, or formatSpec for PIVOT_FORMAT
+      int       intVal2;    // varIndex for PIVOT_FORMAT
+      double    value;
+  } PivotRecord;
+
+  typedef struct {
+      int       outline;
+      int       title;
+      int       templateName;
+      bool      isSplit;
+  } PivotTableDef;
+
+  typedef struct {
+      int       table;
+      int       name;
+      int       place;
+      int       position;
+      bool      hideName;
+      bool      hideLabels;
+  } PivotDimDef;
+
+  typedef struct {
+      bool                                   deferred;
+      std::vector<PivotRecord>               records;
+      std::vector<PivotTableDef>             tables;
+      std::vector<PivotDimDef>               dims;
+      std::string                            strings;
+      std::unordered_map<std::string,int>    stringIndex;
+      std::unordered_map<std::string,int>    tableIndex;
+      std::unordered_map<std::string,int>    dimIndex;
+      long                                   recordedCalls;
+      long                                   backendCalls;
+      long                                   denseTables;
+  } PivotModel;
+
+  static PivotModel pivotModel = {false};
+
+  static int SetFormatSpecByType(int formatSpec, int varIndex);
+  static int SetNumberCellFormatted(const char* outline, const char* title, const char* templateName, bool isSplit,
+                             const char* dimName, int place, int position, bool hideName, bool hideLabels,
+                             double cellVal, int formatSpec, int varIndex);
+  int AddNumberCategoryFormatted(const char* outline, const char* title, const char* templateName, bool isSplit,
+                                 const char* dimName, int place, int position, bool hideName, bool hideLabels,
+                                 double category, int formatSpec, int varIndex);
+  int SetNumberCellsByCell(const char* outline, const char* title, const char* templateName, bool isSplit,
+                           int dimCount, const char* const dimNames[], const int places[], const int positions[],
+                           const bool hideNames[], const bool hideLabels[], const int categoryCounts[],
+                           const char* const categories[], const double cells[], int cellCount,
+                           const int formatSpecs[], const int varIndexes[]);
+
+  static int PivotString(const char* s)
+  {
+      std::string key(s);
+      std::unordered_map<std::string,int>::iterator it = pivotModel.stringIndex.find(key);
+      if(it != pivotModel.stringIndex.end()) {
+          return it->second;
+      }
+      int offset = (int)pivotModel.strings.size();
+      pivotModel.strings.append(key);
+      pivotModel.strings.push_back('\0');
+      pivotModel.stringIndex[key] = offset;
+      return offset;
+  }
+
+  static const char* PivotText(int offset)
+  {
+      return pivotModel.strings.c_str() + offset;
+  }
+
+  static int PivotTable(const char* outline, const char* title, const char* templateName, bool isSplit)
+  {
+      PivotTableDef t = {PivotString(outline), PivotString(title), PivotString(templateName), isSplit};
+      char key[64];
+      sprintf(key,"%d/%d/%d/%d",t.outline,t.title,t.templateName,(int)isSplit);
+      std::unordered_map<std::string,int>::iterator it = pivotModel.tableIndex.find(key);
+      if(it != pivotModel.tableIndex.end()) {
+          return it->second;
+      }
+      pivotModel.tables.push_back(t);
+      return pivotModel.tableIndex[key] = (int)pivotModel.tables.size() - 1;
+  }
+
+  static int PivotDim(int table, const char* dimName, int place, int position, bool hideName, bool hideLabels)
+  {
+      PivotDimDef d = {table, PivotString(dimName), place, position, hideName, hideLabels};
+      char key[96];
+      sprintf(key,"%d/%d/%d/%d/%d/%d",table,d.name,place,position,(int)hideName,(int)hideLabels);
+      std::unordered_map<std::string,int>::iterator it = pivotModel.dimIndex.find(key);
+      if(it != pivotModel.dimIndex.end()) {
+          return it->second;
+      }
+      pivotModel.dims.push_back(d);
+      return pivotModel.dimIndex[key] = (int)pivotModel.dims.size() - 1;
+  }
+
+  static int RecordPivotCall(int op, int table, int dim, const char* text, int intVal, int intVal2, double value)
+  {
+      PivotRecord r = {op, table, dim, text ? PivotString(text) : -1, intVal, intVal2, value};
+      pivotModel.records.push_back(r);
+      pivotModel.recordedCalls++;
+      return 0;
+  }
+
+  int RecordPivotTableCall(int op, const char* outline, const char* title, const char* templateName,
+                           bool isSplit, const char* text)
+  {
+      int table = PivotTable(outline,title,templateName,isSplit);
+      return RecordPivotCall(op,table,-1,text,0,0,0.0);
+  }
+
+  int RecordPivotDimCall(int op, const char* outline, const char* title, const char* templateName, bool isSplit,
+                         const char* dimName, int place, int position, bool hideName, bool hideLabels,
+                         const char* text, int intVal, double value)
+  {
+      int table = PivotTable(outline,title,templateName,isSplit);
+      int dim = PivotDim(table,dimName,place,position,hideName,hideLabels);
+      return RecordPivotCall(op,table,dim,text,intVal,0,value);
+  }
+
+  int RecordPivotFormat(int formatSpec, int varIndex)
+  {
+      return RecordPivotCall(PIVOT_FORMAT,-1,-1,NULL,formatSpec,varIndex,0.0);
+  }
+
+  static int ReplayPivotRecord(const PivotRecord& r)
+  {
+      if(PIVOT_FORMAT == r.op) {
+          return SetFormatSpecByType(r.intVal,r.intVal2);
+      }
+
+      const PivotTableDef& t = pivotModel.tables[r.table];
+      const char* outline = PivotText(t.outline);
+      const char* title = PivotText(t.title);
+      const char* templateName = PivotText(t.templateName);
+      const char* text = r.text >= 0 ? PivotText(r.text) : NULL;
+
+      switch(r.op) {
+          case PIVOT_START:
+              return StartPivotTable(outline,title,templateName,t.isSplit);
+          case PIVOT_HIDE_TITLE:
+              return HidePivotTableTitle(outline,title,templateName,t.isSplit);
+          case PIVOT_CAPTION:
+              return PivotTableCaption(outline,title,templateName,t.isSplit,text);
+          case PIVOT_OUTLINE_FOOTNOTES:
+              return AddOutlineFootnotes(outline,title,templateName,text,t.isSplit);
+          case PIVOT_TITLE_FOOTNOTES:
+              return AddTitleFootnotes(outline,title,templateName,text,t.isSplit);
+      }
+
+      const PivotDimDef& d = pivotModel.dims[r.dim];
+      const char* dimName = PivotText(d.name);
+
+      switch(r.op) {
+          case PIVOT_DIMENSION:
+              return AddDimension(outline,title,templateName,t.isSplit,dimName,d.place,d.position,d.hideName,d.hideLabels);
+          case PIVOT_NUMBER_CATEGORY:
+              return AddNumberCategory(outline,title,templateName,t.isSplit,dimName,d.place,d.position,d.hideName,d.hideLabels,r.value);
+          case PIVOT_STRING_CATEGORY:
+              return AddStringCategory(outline,title,templateName,t.isSplit,dimName,d.place,d.position,d.hideName,d.hideLabels,text);
+          case PIVOT_VARNAME_CATEGORY:
+              return AddVarNameCategory(outline,title,templateName,t.isSplit,dimName,d.place,d.position,d.hideName,d.hideLabels,r.intVal);
+          case PIVOT_VARVALUE_DOUBLE_CATEGORY:
+              return AddVarValueDoubleCategory(outline,title,templateName,t.isSplit,dimName,d.place,d.position,d.hideName,d.hideLabels,r.intVal,r.value);
+          case PIVOT_VARVALUE_STRING_CATEGORY:
+              return AddVarValueStringCategory(outline,title,templateName,t.isSplit,dimName,d.place,d.position,d.hideName,d.hideLabels,r.intVal,text);
+          case PIVOT_NUMBER_CELL:
+              return SetNumberCell(outline,title,templateName,t.isSplit,dimName,d.place,d.position,d.hideName,d.hideLabels,r.value);
+          case PIVOT_STRING_CELL:
+              return SetStringCell(outline,title,templateName,t.isSplit,dimName,d.place,d.position,d.hideName,d.hideLabels,text);
+          case PIVOT_VARNAME_CELL:
+              return SetVarNameCell(outline,title,templateName,t.isSplit,dimName,d.place,d.position,d.hideName,d.hideLabels,r.intVal);
+          case PIVOT_VARVALUE_DOUBLE_CELL:
+              return SetVarValueDoubleCell(outline,title,templateName,t.isSplit,dimName,d.place,d.position,d.hideName,d.hideLabels,r.intVal,r.value);
+          case PIVOT_VARVALUE_STRING_CELL:
+              return SetVarValueStringCell(outline,title,templateName,t.isSplit,dimName,d.place,d.position,d.hideName,d.hideLabels,r.intVal,text);
+          case PIVOT_CELL_FOOTNOTES:
+              return AddCellFootnotes(outline,title,templateName,t.isSplit,dimName,d.place,d.position,d.hideName,d.hideLabels,text);
+          case PIVOT_DIM_FOOTNOTES:
+              return AddDimFootnotes(outline,title,templateName,t.isSplit,dimName,d.place,d.position,d.hideName,d.hideLabels,text);
+          case PIVOT_CATEGORY_FOOTNOTES:
+              return AddCategoryFootnotes(outline,title,templateName,t.isSplit,dimName,d.place,d.position,d.hideName,d.hideLabels,text);
+      }
+      return ERROR_PARAMETER;
+  }
+
+  static int ReplayPivotRecordWithFormat(const PivotRecord& format, const PivotRecord& r)
+  {
+      const PivotTableDef& t = pivotModel.tables[r.table];
+      const PivotDimDef& d = pivotModel.dims[r.dim];
+      if(PIVOT_NUMBER_CATEGORY == r.op) {
+          return AddNumberCategoryFormatted(PivotText(t.outline),PivotText(t.title),PivotText(t.templateName),t.isSplit,
+                                            PivotText(d.name),d.place,d.position,d.hideName,d.hideLabels,
+                                            r.value,format.intVal,format.intVal2);
+      }
+      return SetNumberCellFormatted(PivotText(t.outline),PivotText(t.title),PivotText(t.templateName),t.isSplit,
+                                    PivotText(d.name),d.place,d.position,d.hideName,d.hideLabels,
+                                    r.value,format.intVal,format.intVal2);
+  }
+
+  // The body of a table that can go to the backend as one SetNumberCells call.
+  typedef struct {
+      bool                          dense;
+      int                           lastRecord;
+      int                           dimensionRecords;
+      int                           startRecords;
+      std::vector<int>              dims;           // dimensions in the order they were added
+      std::vector<std::vector<int> > categories;    // string offsets, per dimension
+      std::vector<int>              current;        // current category index, per dimension
+      std::vector<int>              cellIndex;      // category indexes of each cell, dims.size() per cell
+      std::vector<double>           cellValue;
+      std::vector<int>              cellFormat;
+      std::vector<int>              cellVarIndex;
+  } PivotDenseTable;
+
+  static int FindPivotDim(const PivotDenseTable& b, int dim)
+  {
+      for(size_t i = 0; i < b.dims.size(); i++) {
+          if(b.dims[i] == dim) {
+              return (int)i;
+          }
+      }
+      return -1;
+  }
+
+  // Decide which tables are dense, and collect their cells.
+  static void ScanPivotModel(std::vector<PivotDenseTable>& bodies)
+  {
+      bool hasFormat = false;
+      int formatSpec = 0, varIndex = 0;
+
+      bodies.resize(pivotModel.tables.size());
+      for(size_t i = 0; i < bodies.size(); i++) {
+          bodies[i].dense = true;
+          bodies[i].lastRecord = -1;
+          bodies[i].dimensionRecords = 0;
+          bodies[i].startRecords = 0;
+      }
+
+      for(size_t i = 0; i < pivotModel.records.size(); i++) {
+          const PivotRecord& r = pivotModel.records[i];
+          if(PIVOT_FORMAT == r.op) {
+              hasFormat = true;
+              formatSpec = r.intVal;
+              varIndex = r.intVal2;
+              continue;
+          }
+          PivotDenseTable& b = bodies[r.table];
+          b.lastRecord = (int)i;
+          if(!b.dense) {
+              continue;
+          }
+          switch(r.op) {
+              case PIVOT_START:
+                  b.startRecords++;
+                  break;
+              case PIVOT_HIDE_TITLE:
+              case PIVOT_CAPTION:
+              case PIVOT_OUTLINE_FOOTNOTES:
+              case PIVOT_TITLE_FOOTNOTES:
+                  break;
+              case PIVOT_DIMENSION:
+                  b.dimensionRecords++;
+                  if(FindPivotDim(b,r.dim) < 0) {
+                      if(!b.cellValue.empty()) {
+                          b.dense = false;
+                          break;
+                      }
+                      b.dims.push_back(r.dim);
+                      b.categories.push_back(std::vector<int>());
+                      b.current.push_back(-1);
+                  }
+                  break;
+              case PIVOT_STRING_CATEGORY: {
+                  int d = FindPivotDim(b,r.dim);
+                  if(d < 0) {
+                      b.dense = false;
+                      break;
+                  }
+                  std::vector<int>& cats = b.categories[d];
+                  size_t k = 0;
+                  while(k < cats.size() && cats[k] != r.text) {
+                      k++;
+                  }
+                  if(k == cats.size()) {
+                      cats.push_back(r.text);
+                  }
+                  b.current[d] = (int)k;
+                  break;
+              }
+              case PIVOT_NUMBER_CELL: {
+                  if(!hasFormat || FindPivotDim(b,r.dim) < 0) {
+                      b.dense = false;
+                      break;
+                  }
+                  for(size_t d = 0; d < b.dims.size() && b.dense; d++) {
+                      if(b.current[d] < 0) {
+                          b.dense = false;
+                      }
+                      b.cellIndex.push_back(b.current[d]);
+                  }
+                  b.cellValue.push_back(r.value);
+                  b.cellFormat.push_back(formatSpec);
+                  b.cellVarIndex.push_back(varIndex);
+                  break;
+              }
+              default:
+                  b.dense = false;
+          }
+      }
+
+      for(size_t t = 0; t < bodies.size(); t++) {
+          PivotDenseTable& b = bodies[t];
+          if(!b.dense || b.dims.empty() || b.cellValue.empty() || b.dimensionRecords != (int)b.dims.size() || b.startRecords > 1) {
+              b.dense = false;
+              continue;
+          }
+          // every category of every dimension must be used, and every cell of the grid set.
+          size_t total = 1;
+          for(size_t d = 0; d < b.dims.size(); d++) {
+              total *= b.categories[d].size();
+          }
+          std::vector<bool> seen(total,false);
+          size_t filled = 0;
+          for(size_t c = 0; c < b.cellValue.size(); c++) {
+              size_t slot = 0;
+              for(size_t d = 0; d < b.dims.size(); d++) {
+                  slot = slot * b.categories[d].size() + b.cellIndex[c*b.dims.size()+d];
+              }
+              if(!seen[slot]) {
+                  seen[slot] = true;
+                  filled++;
+              }
+          }
+          b.dense = (filled == total && total <= INT_MAX);
+      }
+  }
+
+  static int SendPivotDenseTable(int table, const PivotDenseTable& b)
+  {
+      const PivotTableDef& t = pivotModel.tables[table];
+      size_t dimCount = b.dims.size();
+      size_t total = 1;
+      std::vector<const char*> dimNames(dimCount), categories;
+      std::vector<int> places(dimCount), positions(dimCount), categoryCounts(dimCount);
+      bool *hideNames = new bool[dimCount];
+      bool *hideLabels = new bool[dimCount];
+
+      for(size_t d = 0; d < dimCount; d++) {
+          const PivotDimDef& def = pivotModel.dims[b.dims[d]];
+          dimNames[d] = PivotText(def.name);
+          places[d] = def.place;
+          positions[d] = def.position;
+          hideNames[d] = def.hideName;
+          hideLabels[d] = def.hideLabels;
+          categoryCounts[d] = (int)b.categories[d].size();
+          for(size_t k = 0; k < b.categories[d].size(); k++) {
+              categories.push_back(PivotText(b.categories[d][k]));
+          }
+          total *= b.categories[d].size();
+      }
+
+      // later writes to the same cell win, as they would have in the backend.
+      std::vector<double> cells(total);
+      std::vector<int> formatSpecs(total), varIndexes(total);
+      for(size_t c = 0; c < b.cellValue.size(); c++) {
+          size_t slot = 0;
+          for(size_t d = 0; d < dimCount; d++) {
+              slot = slot * b.categories[d].size() + b.cellIndex[c*dimCount+d];
+          }
+          cells[slot] = b.cellValue[c];
+          formatSpecs[slot] = b.cellFormat[c];
+          varIndexes[slot] = b.cellVarIndex[c];
+      }
+
+      int errLevel;
+      const char* outline = PivotText(t.outline);
+      const char* title = PivotText(t.title);
+      const char* templateName = PivotText(t.templateName);
+      if(XD_AVAILABLE(SetNumberCells)) {
+          errLevel = SetNumberCells(outline,title,templateName,t.isSplit,(int)dimCount,&dimNames[0],&places[0],&positions[0],
+                                    hideNames,hideLabels,&categoryCounts[0],&categories[0],&cells[0],&formatSpecs[0],&varIndexes[0]);
+          pivotModel.backendCalls++;
+      } else {
+          errLevel = SetNumberCellsByCell(outline,title,templateName,t.isSplit,(int)dimCount,&dimNames[0],&places[0],&positions[0],
+                                          hideNames,hideLabels,&categoryCounts[0],&categories[0],&cells[0],(int)total,
+                                          &formatSpecs[0],&varIndexes[0]);
+          pivotModel.backendCalls += (long)(dimCount + 3*total);
+      }
+      delete []hideNames;
+      delete []hideLabels;
+      return errLevel;
+  }
+
+  void ClearPivotModel()
+  {
+      pivotModel.records.clear();
+      pivotModel.tables.clear();
+      pivotModel.dims.clear();
+      pivotModel.strings.clear();
+      pivotModel.stringIndex.clear();
+      pivotModel.tableIndex.clear();
+      pivotModel.dimIndex.clear();
+  }
+
+  // Send everything recorded so far to the backend. Returns the first error.
+  int FlushPivotModel()
+  {
+      if(pivotModel.records.empty()) {
+          return 0;
+      }
+
+      int errLevel = 0;
+      std::vector<PivotDenseTable> bodies;
+      ScanPivotModel(bodies);
+      for(size_t t = 0; t < bodies.size(); t++) {
+          if(bodies[t].dense) {
+              pivotModel.denseTables++;
+          }
+      }
+
+      // the category last sent for each dimension, as the index of its record.
+      std::vector<int> sentCategory(pivotModel.dims.size(),-1);
+
+      for(size_t i = 0; i < pivotModel.records.size() && 0 == errLevel; i++) {
+          const PivotRecord& r = pivotModel.records[i];
+          const PivotDenseTable* b = r.table >= 0 ? &bodies[r.table] : NULL;
+          bool send = true;
+
+          if(b && b->dense) {
+              // SetNumberCells adds the dimensions, categories and cells itself.
+              send = (PIVOT_DIMENSION != r.op && PIVOT_STRING_CATEGORY != r.op && PIVOT_NUMBER_CELL != r.op);
+          } else if(!b) {
+              // a formatSpec only matters to the calls of a replayed table.
+              send = false;
+              for(size_t j = i + 1; j < pivotModel.records.size(); j++) {
+                  const PivotRecord& next = pivotModel.records[j];
+                  if(PIVOT_FORMAT == next.op) {
+                      break;
+                  }
+                  if(!bodies[next.table].dense &&
+                     (PIVOT_NUMBER_CELL == next.op || PIVOT_NUMBER_CATEGORY == next.op)) {
+                      send = true;
+                      break;
+                  }
+              }
+          } else if(r.op >= PIVOT_NUMBER_CATEGORY && r.op <= PIVOT_VARVALUE_STRING_CATEGORY) {
+              int last = sentCategory[r.dim];
+              if(last >= 0) {
+                  const PivotRecord& p = pivotModel.records[last];
+                  send = !(p.op == r.op && p.text == r.text && p.intVal == r.intVal && p.value == r.value &&
+                           PIVOT_NUMBER_CATEGORY != r.op);
+              }
+              sentCategory[r.dim] = (int)i;
+          } else if(PIVOT_DIMENSION == r.op) {
+              sentCategory[r.dim] = -1;
+          } else if(PIVOT_START == r.op) {
+              for(size_t d = 0; d < pivotModel.dims.size(); d++) {
+                  if(pivotModel.dims[d].table == r.table) {
+                      sentCategory[d] = -1;
+                  }
+              }
+          }
+
+          if(send) {
+              const PivotRecord* next = i + 1 < pivotModel.records.size() ? &pivotModel.records[i+1] : NULL;
+              if(PIVOT_FORMAT == r.op && next &&
+                 (PIVOT_NUMBER_CELL == next->op || PIVOT_NUMBER_CATEGORY == next->op) &&
+                 !bodies[next->table].dense) {
+                  // the formatSpec goes with the number that uses it.
+                  bool fused = (PIVOT_NUMBER_CELL == next->op) ? XD_AVAILABLE(SetNumberCellWithFormat)
+                                                               : XD_AVAILABLE(AddNumberCategoryWithFormat);
+                  errLevel = ReplayPivotRecordWithFormat(r,*next);
+                  if(PIVOT_NUMBER_CATEGORY == next->op) {
+                      sentCategory[next->dim] = (int)(i + 1);
+                  }
+                  pivotModel.backendCalls += fused ? 1 : 2;
+                  i++;
+                  continue;
+              }
+              errLevel = ReplayPivotRecord(r);
+              pivotModel.backendCalls++;
+          }
+          if(0 == errLevel && b && b->dense && b->lastRecord == (int)i) {
+              errLevel = SendPivotDenseTable(r.table,*b);
+          }
+      }
+
+      ClearPivotModel();
+      return errLevel;
+  }
+
+    //======================================================================
+    PyObject *
+    GetCaseCountAll_XD(PyObject *self, PyObject *args, const int mode)
+    {
+        long count;
+        int errLevel;
+        if(mode == DS_MODE) {
+            count = GetRowCount(errLevel);
+        } else {
+            count = GetRowCountInProcDS(errLevel);
+        }
+
+        return Py_BuildValue("li", count, errLevel);
+    }
+
+    PyObject *
+    GetVariableCountAll_XD(PyObject *self, PyObject *args, const int mode)
+    {
+        int count;
+        int errLevel;
+
+        if(mode == DS_MODE) {
+            count = GetVariableCount(errLevel);
+        } else {
+            count = GetVariableCountInProcDS(errLevel);
+        }
+
+        return Py_BuildValue("ii", count, errLevel);
+    }
+
+    PyObject *
+    GetVariableFormatAll_XD(PyObject *self, PyObject *args, const int mode)
+    {
+        int index;
+        const char* format;
+        if (!PyArg_ParseTuple(args, "i", &index)) {
+            return NULL;
+        }
+
+        int errLevel;
+        if(mode == DS_MODE) {
+            format = GetVariableFormat(index,errLevel);
+        } else {
+            format = GetVariableFormat(index,errLevel);
+        }
+        if(IsUTF8mode()&&(errLevel==0))
+        {
+            PyObject* pyValue = PyUnicode_Decode(format,strlen(format),"utf-8",NULL);
+            PyObject* r = Py_BuildValue("Oi", pyValue, errLevel);
+            Py_XDECREF(pyValue);
+            return r;
+        }
+        else
+        {
+            return Py_BuildValue("si", format, errLevel);
+        }
+    }
+
+    PyObject *
+    GetVariableLabelAll_XD(PyObject *self, PyObject *args, const int mode)
+    {
+        int index;
+        const char* label;
+        if (!PyArg_ParseTuple(args, "i", &index)) {
+            return NULL;
+        }
+
+        int errLevel;
+
+        if(mode == DS_MODE) {
+            label = GetVariableLabel(index, errLevel);
+        } else {
+            label = GetVariableLabelInProcDS(index, errLevel);
+        }
+        if(IsUTF8mode()&&(errLevel==0))
+        {
+            PyObject* pyValue = PyUnicode_Decode(label,strlen(label),"utf-8",NULL);
+            PyObject* r = Py_BuildValue("Oi", pyValue, errLevel);
+            Py_XDECREF(pyValue);
+            return r;
+        }
+        else
+        {
+            return Py_BuildValue("si", label, errLevel);
+        }
     }
 
     PyObject *
@@ -1977,34 +3011,196 @@ extern "C"{
     if (!PyArg_ParseTuple(args, "si", &command,&length)) {
         return NULL;
     }
-    SetXDriveMode(1);
+    PrepareSubmit();
 
-    enum XDriveMode {
-        kInvalidMode = -1,
-        kSPSSMode,
-        kPythonMode,
-        kOthers
-    };
+    errLevel = Submit(command,length);
+    if ( 0 == errLevel ){
+        errLevel = ResetXDLocale();
+    }
 
-    int currMode=0, originMode=0;
-    errLevel = GetXDriveMode(currMode, originMode);
-    if ( kPythonMode == originMode ){
-        if ( StartReceivePyThread ){
-            errLevel = StartReceivePyThread();
+    return Py_BuildValue("i", errLevel);
+  }
+  //SubmitBatch when the backend does not export it.
+  static int LocalSubmitBatch(const char* const* cmds, const int* lens, int n, int* perCommandErr)
+  {
+      int batchLevel = 0;
+      for(int i = 0; i < n; i++) {
+          const char* line = cmds[i];
+          const char* end = cmds[i] + lens[i];
+          const char* newline;
+          int errLevel = 0;
+          bool queued = false;
+          while(0 == errLevel && (newline = (const char*)memchr(line, '\n', end - line)) != NULL) {
+              errLevel = QueueCommandPart(line, (int)(newline - line));
+              queued = queued || 0 == errLevel;
+              line = newline + 1;
+          }
+          if(0 == errLevel) {
+              errLevel = Submit(line, (int)(end - line));
+          } else if(queued) {
+              //the backend can not discard the lines already queued, and running
+              //them would run part of the entry. They stay queued, as when Submit
+              //from Python fails to queue a line, and would lead any later entry,
+              //so the batch stops here.
+              for(int j = i; j < n && perCommandErr; j++) {
+                  perCommandErr[j] = errLevel;
+              }
+              return std::max(batchLevel, errLevel);
+          }
+          if(perCommandErr) {
+              perCommandErr[i] = errLevel;
+          }
+          if(errLevel > batchLevel) {
+              batchLevel = errLevel;
+          }
+      }
+      return batchLevel;
+  }
+  PyObject *
+  ext_SubmitBatch(PyObject *self, PyObject *args)
+  {
+    PyObject *cmdData;
+    if (!PyArg_ParseTuple(args, "O", &cmdData)) {
+        return NULL;
+    }
+    if(!PyList_Check(cmdData) && !PyTuple_Check(cmdData)) {
+        return Py_BuildValue("(iO)",PARSE_TUPLE_FAIL,Py_None);
+    }
+
+    //the utf-8 of each str is kept by the str itself, no command is copied.
+    int n = (int)PySequence_Fast_GET_SIZE(cmdData);
+    PyObject **items = PySequence_Fast_ITEMS(cmdData);
+    std::vector<const char*> cmds(n > 0 ? n : 1);
+    std::vector<int> lens(n > 0 ? n : 1);
+    std::vector<int> errs(n > 0 ? n : 1, 0);
+    for(int i = 0; i < n; i++) {
+        Py_ssize_t size = 0;
+        cmds[i] = PyUnicode_Check(items[i]) ? PyUnicode_AsUTF8AndSize(items[i], &size) : NULL;
+        if(!cmds[i]) {
+            PyErr_Clear();
+            return Py_BuildValue("(iO)",PARSE_TUPLE_FAIL,Py_None);
         }
+        lens[i] = (int)size;
     }
-    
-    errLevel = Submit(command,length);
-    if ( 0 == errLevel && GetCLocale){
-        //reset the locale to xdlocale.
-        char *xdlocale = 0;
-        errLevel = GetCLocale(&xdlocale);
-        if ( xdlocale ){
-            setlocale(LC_ALL, xdlocale);
+
+    int errLevel = 0;
+    if(n > 0) {
+        PrepareSubmit();
+        if(XD_AVAILABLE(SubmitBatch)) {
+            errLevel = SubmitBatch(&cmds[0], &lens[0], n, &errs[0]);
+        } else {
+            errLevel = LocalSubmitBatch(&cmds[0], &lens[0], n, &errs[0]);
+        }
+        if ( 0 == errLevel ){
+            errLevel = ResetXDLocale();
         }
-        FreeString( xdlocale );
     }
 
+    PyObject* levels = PyList_New(n);
+    if(NULL == levels) {
+        return NULL;
+    }
+    for(int i = 0; i < n; i++) {
+        PyList_SET_ITEM(levels, i, PyLong_FromLong(errs[i]));
+    }
+    return Py_BuildValue("(iN)", errLevel, levels);
+  }
+  PyObject *
+  ext_SubmitAsync(PyObject *self, PyObject *args)
+  {
+    char* command;
+    int length;
+    PyObject* callback = NULL;
+    int ticket = 0;
+    if (!PyArg_ParseTuple(args, "si|O", &command,&length,&callback)) {
+        return NULL;
+    }
+    if ( callback == Py_None ){
+        callback = NULL;
+    }
+    if ( callback && !PyCallable_Check(callback) ){
+        PyErr_SetString(PyExc_TypeError, "callback must be callable");
+        return NULL;
+    }
+    //the local worker prepares each command itself, the backend may be running one.
+    bool native = XD_AVAILABLE(SubmitAsync);
+    if ( native ){
+        PrepareSubmit();
+    }
+    int errLevel = native ? SubmitAsync(command,length,ticket)
+                          : LocalSubmitAsync(command,length,ticket);
+    if ( 0 == errLevel && callback ){
+        PySubmitCallbackData* data = new PySubmitCallbackData();
+        data->interp = PyInterpreterState_Get();
+        data->callable = callback;
+        Py_INCREF(callback);
+        errLevel = native ? SetSubmitCallback(ticket,PySubmitCallback,data)
+                          : LocalSetSubmitCallback(ticket,PySubmitCallback,data);
+        if ( 0 != errLevel ){
+            Py_DECREF(callback);
+            delete data;
+        }
+    }
+    return Py_BuildValue("ii", ticket, errLevel);
+  }
+  PyObject *
+  ext_PollSubmit(PyObject *self, PyObject *args)
+  {
+    int ticket = 0;
+    if (!PyArg_ParseTuple(args, "i", &ticket)) {
+        return NULL;
+    }
+    int done = 0, submitLevel = 0, errLevel = 0;
+    bool native = XD_AVAILABLE(PollSubmit);
+    if ( native ){
+        errLevel = PollSubmit(ticket,done,submitLevel);
+    } else {
+        errLevel = LocalPollSubmit(ticket,done,submitLevel);
+    }
+    if ( 0 == errLevel && done && 0 == submitLevel ){
+        if ( native ){
+            ResetXDLocale();
+        } else {
+            ApplySubmitLocale();
+        }
+    }
+    return Py_BuildValue("iii", done, submitLevel, errLevel);
+  }
+  PyObject *
+  ext_WaitSubmit(PyObject *self, PyObject *args)
+  {
+    int ticket = 0;
+    int timeout = -1;
+    if (!PyArg_ParseTuple(args, "i|i", &ticket, &timeout)) {
+        return NULL;
+    }
+    int submitLevel = 0, errLevel = 0;
+    bool native = XD_AVAILABLE(WaitSubmit);
+    Py_BEGIN_ALLOW_THREADS
+    if ( native ){
+        errLevel = WaitSubmit(ticket,timeout,submitLevel);
+    } else {
+        errLevel = LocalWaitSubmit(ticket,timeout,submitLevel);
+    }
+    Py_END_ALLOW_THREADS
+    if ( 0 == errLevel && 0 == submitLevel ){
+        if ( native ){
+            ResetXDLocale();
+        } else {
+            ApplySubmitLocale();
+        }
+    }
+    return Py_BuildValue("ii", submitLevel, errLevel);
+  }
+  PyObject *
+  ext_ResetSubmitLocale(PyObject *self, PyObject *args)
+  {
+    int errLevel = 0;
+    if ( XD_AVAILABLE(SubmitAsync) ){
+        errLevel = ResetXDLocale();
+    } else {
+        ApplySubmitLocale();
+    }
     return Py_BuildValue("i", errLevel);
   }
 
@@ -2053,7 +3249,7 @@ extern "C"{
       return NULL;
 
     int model;
-    if(NULL == IsXDriven) {
+    if(!XD_AVAILABLE(IsXDriven)) {
       model = PY_TRUE;
     } else {
       model = IsXDriven();
@@ -2101,18 +3297,147 @@ extern "C"{
   PyObject *
   ext_StopSpss(PyObject *self, PyObject *args)
   {
+    FlushPivotModel();
     StopSpss();
+    if(profiling) {
+      WriteCallStats();
+    }
     FreeLib();
 
     Py_INCREF(Py_None);
     return Py_None;
   }
+  //the summary of the profiled calls, the functions taking the most time first.
+  static void WriteCallStats()
+  {
+    std::vector<int> called;
+    for(int i = 0; i < SYM_COUNT; i++) {
+      if(xdCallStats[i].calls.load() > 0) {
+        called.push_back(i);
+      }
+    }
+    std::sort(called.begin(), called.end(), [](int a, int b) {
+      return xdCallStats[a].totalNs.load() > xdCallStats[b].totalNs.load();
+    });
+    FILE* out = profilePath.empty() ? stderr : fopen(profilePath.c_str(), "a");
+    if(NULL == out) {
+      return;
+    }
+    fprintf(out, "SPSSXD profile: %d functions called\n", (int)called.size());
+    for(size_t i = 0; i < called.size(); i++) {
+      const XDCallStats& stats = xdCallStats[called[i]];
+      long long calls = stats.calls.load();
+      double totalMs = stats.totalNs.load() / 1e6;
+      fprintf(out, "  %-32s n=%lld total=%.3f ms mean=%.3f us max=%.3f us",
+              xdSymbols[called[i]].name, calls, totalMs, totalMs * 1000.0 / calls, stats.maxNs.load() / 1e3);
+      for(int bucket = 0; bucket < CALL_BUCKETS; bucket++) {
+        fprintf(out, " %s:%lld", callBucketNames[bucket], stats.histogram[bucket].load());
+      }
+      fprintf(out, "\n");
+    }
+    if(out != stderr) {
+      fclose(out);
+    } else {
+      fflush(out);
+    }
+  }
+  PyObject *
+  ext_GetCallStats(PyObject *self, PyObject *args)
+  {
+    int reset = 0;
+    if (!PyArg_ParseTuple(args, "|i", &reset))
+      return NULL;
+
+    PyObject* result = PyDict_New();
+    if(NULL == result)
+      return NULL;
+    for(int i = 0; i < SYM_COUNT; i++) {
+      XDCallStats& stats = xdCallStats[i];
+      long long calls = stats.calls.load();
+      if(0 == calls) {
+        continue;
+      }
+      PyObject* histogram = PyDict_New();
+      if(NULL == histogram) {
+        Py_DECREF(result);
+        return NULL;
+      }
+      for(int bucket = 0; bucket < CALL_BUCKETS; bucket++) {
+        PyObject* count = PyLong_FromLongLong(stats.histogram[bucket].load());
+        if(NULL == count || PyDict_SetItemString(histogram, callBucketNames[bucket], count) < 0) {
+          Py_XDECREF(count);
+          Py_DECREF(histogram);
+          Py_DECREF(result);
+          return NULL;
+        }
+        Py_DECREF(count);
+      }
+      PyObject* entry = Py_BuildValue("{s:L,s:d,s:d,s:N}",
+                                      "calls", calls,
+                                      "totalSeconds", stats.totalNs.load() / 1e9,
+                                      "maxSeconds", stats.maxNs.load() / 1e9,
+                                      "histogram", histogram);
+      if(NULL == entry || PyDict_SetItemString(result, xdSymbols[i].name, entry) < 0) {
+        Py_XDECREF(entry);
+        Py_DECREF(result);
+        return NULL;
+      }
+      Py_DECREF(entry);
+    }
+    if(reset) {
+      for(int i = 0; i < SYM_COUNT; i++) {
+        XDCallStats& stats = xdCallStats[i];
+        stats.calls.store(0);
+        stats.totalNs.store(0);
+        stats.maxNs.store(0);
+        for(int bucket = 0; bucket < CALL_BUCKETS; bucket++) {
+          stats.histogram[bucket].store(0);
+        }
+      }
+    }
+    return result;
+  }
+  PyObject *
+  ext_GetXDSymbolReport(PyObject *self, PyObject *args)
+  {
+    int bindAll = 0;
+    if (!PyArg_ParseTuple(args, "|i", &bindAll))
+      return NULL;
+
+    if(bindAll) {
+      BindAllXDSymbols();
+    }
+    int bound = 0, unbound = 0;
+    PyObject* missing = PyList_New(0);
+    if(NULL == missing)
+      return NULL;
+    for(int i = 0; i < SYM_COUNT; i++) {
+      if(XD_BOUND == xdSymbols[i].state) {
+        bound++;
+      } else if(XD_UNBOUND == xdSymbols[i].state) {
+        unbound++;
+      } else {
+        PyObject* name = PyUnicode_FromString(xdSymbols[i].name);
+        if(NULL == name || PyList_Append(missing, name) < 0) {
+          Py_XDECREF(name);
+          Py_DECREF(missing);
+          return NULL;
+        }
+        Py_DECREF(name);
+      }
+    }
+    return Py_BuildValue("{s:i,s:i,s:i,s:N}",
+                         "eager", (int)eagerBinding,
+                         "bound", bound,
+                         "unbound", unbound,
+                         "missing", missing);
+  }
   PyObject *
   ext_IsBackendReady(PyObject *self, PyObject *args)
   {
     int errLevel;
 
-    if(NULL == IsBackendReady) {
+    if(!XD_AVAILABLE(IsBackendReady)) {
       errLevel = PY_FALSE;
     } else {
       errLevel = IsBackendReady();
@@ -2323,6 +3648,7 @@ ext_GetOMSTagList(PyObject *self, PyObject *args)
       return NULL;
 
     int errLevel;
+    ClearPivotModel();
     errLevel = StartProcedure(omsIdentifier,procName);
     PyObject* out = Py_BuildValue("i",errLevel);
     return out;
@@ -2335,7 +3661,10 @@ ext_GetOMSTagList(PyObject *self, PyObject *args)
       return NULL;
 
     int errLevel;
-    errLevel = SplitChange(procName);
+    errLevel = FlushPivotModel();
+    if(0 == errLevel) {
+        errLevel = SplitChange(procName);
+    }
     PyObject* out = Py_BuildValue("i",errLevel);
     return out;
   }
@@ -2344,7 +3673,11 @@ ext_GetOMSTagList(PyObject *self, PyObject *args)
   ext_EndProcedure(PyObject *self, PyObject *args)
   {
     int errLevel;
+    int flushLevel = FlushPivotModel();
     errLevel = EndProcedure();
+    if(0 != flushLevel) {
+        errLevel = flushLevel;
+    }
     PyObject* out = Py_BuildValue("i",errLevel);
     return out;
   }
@@ -2478,7 +3811,11 @@ ext_GetOMSTagList(PyObject *self, PyObject *args)
       if (!PyArg_ParseTuple(args, "sssb", &outline, &title, &templateTitle, &isSplit))
           return NULL;
 
-      errLevel = StartPivotTable(outline, title,templateTitle,isSplit);
+      if(pivotModel.deferred) {
+          errLevel = RecordPivotTableCall(PIVOT_START,outline,title,templateTitle,isSplit,NULL);
+      } else {
+          errLevel = StartPivotTable(outline, title,templateTitle,isSplit);
+      }
       return Py_BuildValue("i",errLevel);
   }
   PyObject *
@@ -2491,7 +3828,11 @@ ext_GetOMSTagList(PyObject *self, PyObject *args)
       if (!PyArg_ParseTuple(args, "sssb", &outline, &title, &templateTitle, &isSplit))
           return NULL;
 
-      errLevel = HidePivotTableTitle(outline, title,templateTitle,isSplit);
+      if(pivotModel.deferred) {
+          errLevel = RecordPivotTableCall(PIVOT_HIDE_TITLE,outline,title,templateTitle,isSplit,NULL);
+      } else {
+          errLevel = HidePivotTableTitle(outline, title,templateTitle,isSplit);
+      }
       return Py_BuildValue("i",errLevel);
   }
   PyObject *
@@ -2504,7 +3845,11 @@ ext_GetOMSTagList(PyObject *self, PyObject *args)
       if (!PyArg_ParseTuple(args, "sssbs", &outline, &title, &templateTitle, &isSplit, &caption))
           return NULL;
 
-      errLevel = PivotTableCaption(outline, title,templateTitle,isSplit,caption);
+      if(pivotModel.deferred) {
+          errLevel = RecordPivotTableCall(PIVOT_CAPTION,outline,title,templateTitle,isSplit,caption);
+      } else {
+          errLevel = PivotTableCaption(outline, title,templateTitle,isSplit,caption);
+      }
       return Py_BuildValue("i",errLevel);
   }
   PyObject *
@@ -2521,7 +3866,11 @@ ext_GetOMSTagList(PyObject *self, PyObject *args)
                                                &dimName, &place, &position, &hideName, &hideLabels))
           return NULL;
 
-      errLevel = AddDimension(outline,tableName,templateName,isSplit,dimName, place, position, hideName, hideLabels);
+      if(pivotModel.deferred) {
+          errLevel = RecordPivotDimCall(PIVOT_DIMENSION,outline,tableName,templateName,isSplit,dimName,place,position,hideName,hideLabels,NULL,0,0.0);
+      } else {
+          errLevel = AddDimension(outline,tableName,templateName,isSplit,dimName, place, position, hideName, hideLabels);
+      }
       return Py_BuildValue("i",errLevel);
   }
 
@@ -2533,7 +3882,11 @@ PyObject*
     if (!PyArg_ParseTuple(args, "", &check))
       return NULL;
 
-    errLevel = SetFormatSpecCoefficient();
+    if(pivotModel.deferred) {
+        errLevel = RecordPivotFormat(0,0);
+    } else {
+        errLevel = SetFormatSpecCoefficient();
+    }
     return Py_BuildValue("i",errLevel);
 }
 PyObject*
@@ -2544,7 +3897,11 @@ PyObject*
     if (!PyArg_ParseTuple(args, "", &check))
       return NULL;
 
-    errLevel = SetFormatSpecCoefficientSE();
+    if(pivotModel.deferred) {
+        errLevel = RecordPivotFormat(1,0);
+    } else {
+        errLevel = SetFormatSpecCoefficientSE();
+    }
     return Py_BuildValue("i",errLevel);
 }
 PyObject*
@@ -2555,7 +3912,11 @@ PyObject*
     if (!PyArg_ParseTuple(args, "", &check))
       return NULL;
 
-    errLevel = SetFormatSpecCoefficientVar();
+    if(pivotModel.deferred) {
+        errLevel = RecordPivotFormat(2,0);
+    } else {
+        errLevel = SetFormatSpecCoefficientVar();
+    }
     return Py_BuildValue("i",errLevel);
 }
 PyObject*
@@ -2566,7 +3927,11 @@ PyObject*
     if (!PyArg_ParseTuple(args, "", &check))
       return NULL;
 
-    errLevel = SetFormatSpecCorrelation();
+    if(pivotModel.deferred) {
+        errLevel = RecordPivotFormat(3,0);
+    } else {
+        errLevel = SetFormatSpecCorrelation();
+    }
     return Py_BuildValue("i",errLevel);
 }
 PyObject*
@@ -2577,7 +3942,11 @@ PyObject*
     if (!PyArg_ParseTuple(args, "", &check))
       return NULL;
 
-    errLevel = SetFormatSpecGeneralStat();
+    if(pivotModel.deferred) {
+        errLevel = RecordPivotFormat(4,0);
+    } else {
+        errLevel = SetFormatSpecGeneralStat();
+    }
     return Py_BuildValue("i",errLevel);
 }
 PyObject*
@@ -2588,7 +3957,11 @@ PyObject*
     if (!PyArg_ParseTuple(args, "i", &varIndex))
       return NULL;
 
-    errLevel = SetFormatSpecMean(varIndex);
+    if(pivotModel.deferred) {
+        errLevel = RecordPivotFormat(5,varIndex);
+    } else {
+        errLevel = SetFormatSpecMean(varIndex);
+    }
     return Py_BuildValue("i",errLevel);
 }
 PyObject*
@@ -2599,7 +3972,11 @@ PyObject*
     if (!PyArg_ParseTuple(args, "", &check))
       return NULL;
 
-    errLevel = SetFormatSpecCount();
+    if(pivotModel.deferred) {
+        errLevel = RecordPivotFormat(6,0);
+    } else {
+        errLevel = SetFormatSpecCount();
+    }
     return Py_BuildValue("i",errLevel);
 }
 PyObject*
@@ -2610,7 +3987,11 @@ PyObject*
     if (!PyArg_ParseTuple(args, "", &check))
       return NULL;
 
-    errLevel = SetFormatSpecPercent();
+    if(pivotModel.deferred) {
+        errLevel = RecordPivotFormat(7,0);
+    } else {
+        errLevel = SetFormatSpecPercent();
+    }
     return Py_BuildValue("i",errLevel);
 }
 PyObject*
@@ -2621,7 +4002,11 @@ PyObject*
     if (!PyArg_ParseTuple(args, "", &check))
       return NULL;
 
-    errLevel = SetFormatSpecPercentNoSign();
+    if(pivotModel.deferred) {
+        errLevel = RecordPivotFormat(8,0);
+    } else {
+        errLevel = SetFormatSpecPercentNoSign();
+    }
     return Py_BuildValue("i",errLevel);
 }
 PyObject*
@@ -2632,7 +4017,11 @@ PyObject*
     if (!PyArg_ParseTuple(args, "", &check))
       return NULL;
 
-    errLevel = SetFormatSpecProportion();
+    if(pivotModel.deferred) {
+        errLevel = RecordPivotFormat(9,0);
+    } else {
+        errLevel = SetFormatSpecProportion();
+    }
     return Py_BuildValue("i",errLevel);
 }
 PyObject*
@@ -2643,7 +4032,11 @@ PyObject*
     if (!PyArg_ParseTuple(args, "", &check))
       return NULL;
 
-    errLevel = SetFormatSpecSignificance();
+    if(pivotModel.deferred) {
+        errLevel = RecordPivotFormat(10,0);
+    } else {
+        errLevel = SetFormatSpecSignificance();
+    }
     return Py_BuildValue("i",errLevel);
 }
 PyObject*
@@ -2654,7 +4047,11 @@ PyObject*
     if (!PyArg_ParseTuple(args, "", &check))
       return NULL;
 
-    errLevel = SetFormatSpecResidual();
+    if(pivotModel.deferred) {
+        errLevel = RecordPivotFormat(11,0);
+    } else {
+        errLevel = SetFormatSpecResidual();
+    }
     return Py_BuildValue("i",errLevel);
 }
 PyObject*
@@ -2665,7 +4062,11 @@ PyObject*
     if (!PyArg_ParseTuple(args, "i", &varIndex))
       return NULL;
 
-    errLevel = SetFormatSpecVariable(varIndex);
+    if(pivotModel.deferred) {
+        errLevel = RecordPivotFormat(12,varIndex);
+    } else {
+        errLevel = SetFormatSpecVariable(varIndex);
+    }
     return Py_BuildValue("i",errLevel);
 }
 PyObject*
@@ -2676,7 +4077,11 @@ PyObject*
     if (!PyArg_ParseTuple(args, "i", &varIndex))
       return NULL;
 
-    errLevel = SetFormatSpecStdDev(varIndex);
+    if(pivotModel.deferred) {
+        errLevel = RecordPivotFormat(13,varIndex);
+    } else {
+        errLevel = SetFormatSpecStdDev(varIndex);
+    }
     return Py_BuildValue("i",errLevel);
 }
 PyObject*
@@ -2687,7 +4092,11 @@ PyObject*
     if (!PyArg_ParseTuple(args, "i", &varIndex))
       return NULL;
 
-    errLevel = SetFormatSpecDifference(varIndex);
+    if(pivotModel.deferred) {
+        errLevel = RecordPivotFormat(14,varIndex);
+    } else {
+        errLevel = SetFormatSpecDifference(varIndex);
+    }
     return Py_BuildValue("i",errLevel);
 }
 PyObject*
@@ -2698,7 +4107,11 @@ PyObject*
     if (!PyArg_ParseTuple(args, "i", &varIndex))
       return NULL;
 
-    errLevel = SetFormatSpecSum(varIndex);
+    if(pivotModel.deferred) {
+        errLevel = RecordPivotFormat(15,varIndex);
+    } else {
+        errLevel = SetFormatSpecSum(varIndex);
+    }
     return Py_BuildValue("i",errLevel);
 }
 
@@ -2720,9 +4133,47 @@ PyObject *
         return NULL;
     }
 
-    errLevel = AddNumberCategory(outline,tableName,templateName,isSplit,
-                                 dimName,place, position, hideName, hideLabels,
-                                 category);
+    if(pivotModel.deferred) {
+        errLevel = RecordPivotDimCall(PIVOT_NUMBER_CATEGORY,outline,tableName,templateName,isSplit,dimName,place,position,hideName,hideLabels,NULL,0,category);
+    } else {
+        errLevel = AddNumberCategory(outline,tableName,templateName,isSplit,
+                                     dimName,place, position, hideName, hideLabels,
+                                     category);
+    }
+    return Py_BuildValue("i",errLevel);
+}
+
+PyObject *
+    ext_AddNumberCategoryWithFormat(PyObject *self, PyObject *args)
+{
+    int errLevel;
+
+    char *outline,*tableName,*templateName;
+    bool isSplit;
+    char *dimName;
+    int place,position;
+    bool hideName, hideLabels;
+    double category;
+    int formatSpec, varIndex = 0;
+
+    if (!PyArg_ParseTuple(args, "sssbsiibbdi|i", &outline,&tableName,&templateName,&isSplit,
+                                          &dimName, &place, &position, &hideName, &hideLabels,
+                                          &category, &formatSpec, &varIndex)){
+        return NULL;
+    }
+
+    if(formatSpec < 0 || formatSpec > 15) {
+        errLevel = ERROR_PARAMETER;
+    } else if(pivotModel.deferred) {
+        errLevel = RecordPivotFormat(formatSpec,varIndex);
+        if(0 == errLevel) {
+            errLevel = RecordPivotDimCall(PIVOT_NUMBER_CATEGORY,outline,tableName,templateName,isSplit,dimName,place,position,hideName,hideLabels,NULL,0,category);
+        }
+    } else {
+        errLevel = AddNumberCategoryFormatted(outline,tableName,templateName,isSplit,
+                                              dimName,place, position, hideName, hideLabels,
+                                              category,formatSpec,varIndex);
+    }
     return Py_BuildValue("i",errLevel);
 }
 PyObject *
@@ -2742,9 +4193,13 @@ PyObject *
                                               &category)){
         return NULL;
     }
-    errLevel = AddStringCategory(outline,tableName,templateName,isSplit,
-                                 dimName,place, position, hideName, hideLabels,
-                                 category);
+    if(pivotModel.deferred) {
+        errLevel = RecordPivotDimCall(PIVOT_STRING_CATEGORY,outline,tableName,templateName,isSplit,dimName,place,position,hideName,hideLabels,category,0,0.0);
+    } else {
+        errLevel = AddStringCategory(outline,tableName,templateName,isSplit,
+                                     dimName,place, position, hideName, hideLabels,
+                                     category);
+    }
     return Py_BuildValue("i",errLevel);
 }
 PyObject *
@@ -2765,9 +4220,13 @@ PyObject *
         return NULL;
     }
 
-    errLevel = AddVarNameCategory(outline,tableName,templateName,isSplit,
-                                  dimName,place, position, hideName, hideLabels,
-                                  category);
+    if(pivotModel.deferred) {
+        errLevel = RecordPivotDimCall(PIVOT_VARNAME_CATEGORY,outline,tableName,templateName,isSplit,dimName,place,position,hideName,hideLabels,NULL,category,0.0);
+    } else {
+        errLevel = AddVarNameCategory(outline,tableName,templateName,isSplit,
+                                      dimName,place, position, hideName, hideLabels,
+                                      category);
+    }
     return Py_BuildValue("i",errLevel);
 }
 PyObject *
@@ -2789,9 +4248,13 @@ PyObject *
         return NULL;
     }
 
-    errLevel = AddVarValueDoubleCategory(outline,tableName,templateName,isSplit,
-                                        dimName,place, position, hideName, hideLabels,
-                                        category,d);
+    if(pivotModel.deferred) {
+        errLevel = RecordPivotDimCall(PIVOT_VARVALUE_DOUBLE_CATEGORY,outline,tableName,templateName,isSplit,dimName,place,position,hideName,hideLabels,NULL,category,d);
+    } else {
+        errLevel = AddVarValueDoubleCategory(outline,tableName,templateName,isSplit,
+                                            dimName,place, position, hideName, hideLabels,
+                                            category,d);
+    }
     return Py_BuildValue("i",errLevel);
 }
 PyObject *
@@ -2813,9 +4276,13 @@ PyObject *
         return NULL;
     }
 
-    errLevel = AddVarValueStringCategory(outline,tableName,templateName,isSplit,
-                                         dimName,place, position, hideName, hideLabels,
-                                         category,ch);
+    if(pivotModel.deferred) {
+        errLevel = RecordPivotDimCall(PIVOT_VARVALUE_STRING_CATEGORY,outline,tableName,templateName,isSplit,dimName,place,position,hideName,hideLabels,ch,category,0.0);
+    } else {
+        errLevel = AddVarValueStringCategory(outline,tableName,templateName,isSplit,
+                                             dimName,place, position, hideName, hideLabels,
+                                             category,ch);
+    }
     return Py_BuildValue("i",errLevel);
 }
 
@@ -2837,9 +4304,47 @@ PyObject *
         return NULL;
     }
 
-    errLevel = SetNumberCell(outline,tableName,templateName,isSplit,
-                             dimName,place, position, hideName, hideLabels,
-                             cell);
+    if(pivotModel.deferred) {
+        errLevel = RecordPivotDimCall(PIVOT_NUMBER_CELL,outline,tableName,templateName,isSplit,dimName,place,position,hideName,hideLabels,NULL,0,cell);
+    } else {
+        errLevel = SetNumberCell(outline,tableName,templateName,isSplit,
+                                 dimName,place, position, hideName, hideLabels,
+                                 cell);
+    }
+    return Py_BuildValue("i",errLevel);
+}
+
+PyObject *
+    ext_SetNumberCellWithFormat(PyObject *self, PyObject *args)
+{
+    int errLevel;
+
+    char *outline,*tableName,*templateName;
+    bool isSplit;
+    char *dimName;
+    int place,position;
+    bool hideName, hideLabels;
+    double cell;
+    int formatSpec, varIndex = 0;
+
+    if (!PyArg_ParseTuple(args, "sssbsiibbdi|i", &outline,&tableName,&templateName,&isSplit,
+                                          &dimName, &place, &position, &hideName, &hideLabels,
+                                          &cell, &formatSpec, &varIndex)){
+        return NULL;
+    }
+
+    if(formatSpec < 0 || formatSpec > 15) {
+        errLevel = ERROR_PARAMETER;
+    } else if(pivotModel.deferred) {
+        errLevel = RecordPivotFormat(formatSpec,varIndex);
+        if(0 == errLevel) {
+            errLevel = RecordPivotDimCall(PIVOT_NUMBER_CELL,outline,tableName,templateName,isSplit,dimName,place,position,hideName,hideLabels,NULL,0,cell);
+        }
+    } else {
+        errLevel = SetNumberCellFormatted(outline,tableName,templateName,isSplit,
+                                          dimName,place, position, hideName, hideLabels,
+                                          cell,formatSpec,varIndex);
+    }
     return Py_BuildValue("i",errLevel);
 }
 PyObject *
@@ -2860,9 +4365,13 @@ PyObject *
         return NULL;
     }
 
-    errLevel = SetStringCell(outline,tableName,templateName,isSplit,
-                             dimName,place, position, hideName, hideLabels,
-                             cell);
+    if(pivotModel.deferred) {
+        errLevel = RecordPivotDimCall(PIVOT_STRING_CELL,outline,tableName,templateName,isSplit,dimName,place,position,hideName,hideLabels,cell,0,0.0);
+    } else {
+        errLevel = SetStringCell(outline,tableName,templateName,isSplit,
+                                 dimName,place, position, hideName, hideLabels,
+                                 cell);
+    }
     return Py_BuildValue("i",errLevel);
 }
 PyObject *
@@ -2883,60 +4392,509 @@ PyObject *
         return NULL;
     }
 
-    errLevel = SetVarNameCell(outline,tableName,templateName,isSplit,
-                              dimName,place, position, hideName, hideLabels,
-                              cell);
+    if(pivotModel.deferred) {
+        errLevel = RecordPivotDimCall(PIVOT_VARNAME_CELL,outline,tableName,templateName,isSplit,dimName,place,position,hideName,hideLabels,NULL,cell,0.0);
+    } else {
+        errLevel = SetVarNameCell(outline,tableName,templateName,isSplit,
+                                  dimName,place, position, hideName, hideLabels,
+                                  cell);
+    }
+    return Py_BuildValue("i",errLevel);
+}
+PyObject *
+    ext_SetVarValueDoubleCell(PyObject *self, PyObject *args)
+{
+    int errLevel;
+
+    char *outline,*tableName,*templateName;
+    bool isSplit;
+    char *dimName;
+    int place,position;
+    bool hideName, hideLabels;
+    int cell;
+    double d;
+
+    if (!PyArg_ParseTuple(args, "sssbsiibbid", &outline,&tableName,&templateName,&isSplit,
+                                           &dimName, &place, &position, &hideName, &hideLabels,
+                                           &cell,&d)){
+        return NULL;
+    }
+
+    if(pivotModel.deferred) {
+        errLevel = RecordPivotDimCall(PIVOT_VARVALUE_DOUBLE_CELL,outline,tableName,templateName,isSplit,dimName,place,position,hideName,hideLabels,NULL,cell,d);
+    } else {
+        errLevel = SetVarValueDoubleCell(outline,tableName,templateName,isSplit,
+                                         dimName,place, position, hideName, hideLabels,
+                                         cell,d);
+    }
+    return Py_BuildValue("i",errLevel);
+}
+PyObject *
+    ext_SetVarValueStringCell(PyObject *self, PyObject *args)
+{
+    int errLevel;
+
+    char *outline,*tableName,*templateName;
+    bool isSplit;
+    char *dimName;
+    int place,position;
+    bool hideName, hideLabels;
+    int cell;
+    char *ch;
+
+    if (!PyArg_ParseTuple(args, "sssbsiibbis", &outline,&tableName,&templateName,&isSplit,
+                                           &dimName, &place, &position, &hideName, &hideLabels,
+                                           &cell,&ch)){
+        return NULL;
+    }
+
+    if(pivotModel.deferred) {
+        errLevel = RecordPivotDimCall(PIVOT_VARVALUE_STRING_CELL,outline,tableName,templateName,isSplit,dimName,place,position,hideName,hideLabels,ch,cell,0.0);
+    } else {
+        errLevel = SetVarValueStringCell(outline,tableName,templateName,isSplit,
+                                         dimName,place, position, hideName, hideLabels,
+                                         cell,ch);
+    }
+    return Py_BuildValue("i",errLevel);
+}
+
+    // Apply a numeric formatSpec given by its FormatSpec number (see FormatSpec.py).
+    // The varIndex is only used by Mean, Variable, StdDev, Difference and Sum.
+    static int SetFormatSpecByType(int formatSpec, int varIndex)
+    {
+        switch(formatSpec) {
+            case 0:  return SetFormatSpecCoefficient();
+            case 1:  return SetFormatSpecCoefficientSE();
+            case 2:  return SetFormatSpecCoefficientVar();
+            case 3:  return SetFormatSpecCorrelation();
+            case 4:  return SetFormatSpecGeneralStat();
+            case 5:  return SetFormatSpecMean(varIndex);
+            case 6:  return SetFormatSpecCount();
+            case 7:  return SetFormatSpecPercent();
+            case 8:  return SetFormatSpecPercentNoSign();
+            case 9:  return SetFormatSpecProportion();
+            case 10: return SetFormatSpecSignificance();
+            case 11: return SetFormatSpecResidual();
+            case 12: return SetFormatSpecVariable(varIndex);
+            case 13: return SetFormatSpecStdDev(varIndex);
+            case 14: return SetFormatSpecDifference(varIndex);
+            case 15: return SetFormatSpecSum(varIndex);
+            default: return ERROR_PARAMETER;
+        }
+    }
+
+    // A number cell and its formatSpec in one backend call, or in two when the backend has no fused setter.
+    static int SetNumberCellFormatted(const char* outline, const char* title, const char* templateName, bool isSplit,
+                               const char* dimName, int place, int position, bool hideName, bool hideLabels,
+                               double cellVal, int formatSpec, int varIndex)
+    {
+        if(formatSpec < 0 || formatSpec > 15) {
+            return ERROR_PARAMETER;
+        }
+        if(XD_AVAILABLE(SetNumberCellWithFormat)) {
+            return SetNumberCellWithFormat(outline,title,templateName,isSplit,
+                                           dimName,place,position,hideName,hideLabels,
+                                           cellVal,formatSpec,varIndex);
+        }
+        int errLevel = SetFormatSpecByType(formatSpec,varIndex);
+        if(0 == errLevel) {
+            errLevel = SetNumberCell(outline,title,templateName,isSplit,
+                                     dimName,place,position,hideName,hideLabels,
+                                     cellVal);
+        }
+        return errLevel;
+    }
+
+    int AddNumberCategoryFormatted(const char* outline, const char* title, const char* templateName, bool isSplit,
+                                   const char* dimName, int place, int position, bool hideName, bool hideLabels,
+                                   double category, int formatSpec, int varIndex)
+    {
+        if(formatSpec < 0 || formatSpec > 15) {
+            return ERROR_PARAMETER;
+        }
+        if(XD_AVAILABLE(AddNumberCategoryWithFormat)) {
+            return AddNumberCategoryWithFormat(outline,title,templateName,isSplit,
+                                               dimName,place,position,hideName,hideLabels,
+                                               category,formatSpec,varIndex);
+        }
+        int errLevel = SetFormatSpecByType(formatSpec,varIndex);
+        if(0 == errLevel) {
+            errLevel = AddNumberCategory(outline,title,templateName,isSplit,
+                                         dimName,place,position,hideName,hideLabels,
+                                         category);
+        }
+        return errLevel;
+    }
+
+    // Check the struct format of a buffer against a single native item code such as "d".
+    static bool IsNativeFormat(const Py_buffer *view, char code)
+    {
+        const char *format = view->format ? view->format : "B";
+        if('@' == *format || '=' == *format) {
+            format++;
+        }
+        return code == format[0] && '\0' == format[1];
+    }
+
+    // Get a double array from a C-contiguous buffer of doubles without copying,
+    // or from a list or tuple by copying. Release it with ReleaseDoubleArray.
+    int GetDoubleArray(PyObject *data, Py_buffer *view, double **result, int *size)
+    {
+        view->obj = NULL;
+        if(!PyObject_CheckBuffer(data)) {
+            return parse2DoubleStar(data,result,size);
+        }
+        if(0 != PyObject_GetBuffer(data,view,PyBUF_C_CONTIGUOUS|PyBUF_FORMAT)) {
+            PyErr_Clear();
+            view->obj = NULL;
+            return PARSE_TUPLE_FAIL;
+        }
+        if(!IsNativeFormat(view,'d') || sizeof(double) != view->itemsize) {
+            PyBuffer_Release(view);
+            view->obj = NULL;
+            return PARSE_TUPLE_FAIL;
+        }
+        *result = (double*)view->buf;
+        *size = (int)(view->len/sizeof(double));
+        return 0;
+    }
+
+    void ReleaseDoubleArray(Py_buffer *view, double *result)
+    {
+        if(view->obj) {
+            PyBuffer_Release(view);
+        } else if(result) {
+            PyMem_Del(result);
+        }
+    }
+
+    // The int counterpart of GetDoubleArray, for buffers of C ints.
+    int GetIntegerArray(PyObject *data, Py_buffer *view, int **result, int *size)
+    {
+        view->obj = NULL;
+        if(!PyObject_CheckBuffer(data)) {
+            return parse2IntegerStar(data,result,size);
+        }
+        if(0 != PyObject_GetBuffer(data,view,PyBUF_C_CONTIGUOUS|PyBUF_FORMAT)) {
+            PyErr_Clear();
+            view->obj = NULL;
+            return PARSE_TUPLE_FAIL;
+        }
+        if(!(IsNativeFormat(view,'i') || (sizeof(long) == sizeof(int) && IsNativeFormat(view,'l')))
+           || sizeof(int) != view->itemsize) {
+            PyBuffer_Release(view);
+            view->obj = NULL;
+            return PARSE_TUPLE_FAIL;
+        }
+        *result = (int*)view->buf;
+        *size = (int)(view->len/sizeof(int));
+        return 0;
+    }
+
+    void ReleaseIntegerArray(Py_buffer *view, int *result)
+    {
+        if(view->obj) {
+            PyBuffer_Release(view);
+        } else if(result) {
+            PyMem_Del(result);
+        }
+    }
+
+    // Emulate SetNumberCells with the per-cell functions for backends that do not export it.
+    // A category is only re-sent when the dimension moves to another category.
+    int SetNumberCellsByCell(const char* outline, const char* title, const char* templateName, bool isSplit,
+                             int dimCount, const char* const dimNames[], const int places[], const int positions[],
+                             const bool hideNames[], const bool hideLabels[], const int categoryCounts[],
+                             const char* const categories[], const double cells[], int cellCount,
+                             const int formatSpecs[], const int varIndexes[])
+    {
+        int errLevel = 0;
+        int d, c;
+        int last = dimCount - 1;
+        int *offset = PyMem_New(int,dimCount);
+        int *index = PyMem_New(int,dimCount);
+        int *current = PyMem_New(int,dimCount);
+        if(!offset || !index || !current) {
+            PyMem_Del(offset);
+            PyMem_Del(index);
+            PyMem_Del(current);
+            return NO_MEMORY;
+        }
+
+        for(d = 0; d < dimCount && 0 == errLevel; d++) {
+            offset[d] = (0 == d) ? 0 : offset[d-1] + categoryCounts[d-1];
+            index[d] = 0;
+            current[d] = -1;
+            errLevel = AddDimension(outline,title,templateName,isSplit,
+                                    dimNames[d],places[d],positions[d],hideNames[d],hideLabels[d]);
+        }
+
+        for(c = 0; c < cellCount && 0 == errLevel; c++) {
+            for(d = 0; d < dimCount && 0 == errLevel; d++) {
+                if(index[d] != current[d]) {
+                    errLevel = AddStringCategory(outline,title,templateName,isSplit,
+                                                 dimNames[d],places[d],positions[d],hideNames[d],hideLabels[d],
+                                                 categories[offset[d]+index[d]]);
+                    current[d] = index[d];
+                }
+            }
+            if(0 == errLevel && formatSpecs) {
+                errLevel = SetNumberCellFormatted(outline,title,templateName,isSplit,
+                                                  dimNames[last],places[last],positions[last],hideNames[last],hideLabels[last],
+                                                  cells[c],formatSpecs[c],varIndexes ? varIndexes[c] : 0);
+            } else if(0 == errLevel) {
+                errLevel = SetNumberCell(outline,title,templateName,isSplit,
+                                         dimNames[last],places[last],positions[last],hideNames[last],hideLabels[last],
+                                         cells[c]);
+            }
+            //advance the row-major index, the last dimension varies fastest.
+            for(d = last; d >= 0; d--) {
+                if(++index[d] < categoryCounts[d]) {
+                    break;
+                }
+                index[d] = 0;
+            }
+        }
+
+        PyMem_Del(offset);
+        PyMem_Del(index);
+        PyMem_Del(current);
+        return errLevel;
+    }
+
+PyObject *
+    ext_SetNumberCells(PyObject *self, PyObject *args)
+{
+    int errLevel = 0;
+
+    char *outline,*tableName,*templateName;
+    bool isSplit;
+    PyObject *dims, *cellData;
+    PyObject *formatData = Py_None, *varIndexData = Py_None;
+
+    if (!PyArg_ParseTuple(args, "sssbOO|OO", &outline,&tableName,&templateName,&isSplit,
+                                            &dims, &cellData, &formatData, &varIndexData)){
+        return NULL;
+    }
+    if(!PyList_Check(dims) && !PyTuple_Check(dims)) {
+        return Py_BuildValue("i",PARSE_TUPLE_FAIL);
+    }
+
+    int dimCount = (int)PySequence_Size(dims);
+    if(dimCount < 1) {
+        return Py_BuildValue("i",PARSE_TUPLE_FAIL);
+    }
+
+    const char **dimNames = PyMem_New(const char*,dimCount);
+    int *places = PyMem_New(int,dimCount);
+    int *positions = PyMem_New(int,dimCount);
+    bool *hideNames = PyMem_New(bool,dimCount);
+    bool *hideLabels = PyMem_New(bool,dimCount);
+    int *categoryCounts = PyMem_New(int,dimCount);
+    PyObject **categoryLists = PyMem_New(PyObject*,dimCount);
+    const char **categories = NULL;
+    double *cells = NULL;
+    int *formatSpecs = NULL, *varIndexes = NULL;
+    Py_buffer cellView, formatView, varIndexView;
+    cellView.obj = formatView.obj = varIndexView.obj = NULL;
+    int cellCount = 0, formatCount = 0, varIndexCount = 0;
+    long long totalCells = 1;
+    int totalCategories = 0;
+    int d, i, k;
+
+    if(!dimNames || !places || !positions || !hideNames || !hideLabels || !categoryCounts || !categoryLists) {
+        errLevel = NO_MEMORY;
+    }
+
+    for(d = 0; d < dimCount && 0 == errLevel; d++) {
+        PyObject *dim = PySequence_Fast_GET_ITEM(dims,d);
+        char *dimName;
+        if(!PyTuple_Check(dim) ||
+           !PyArg_ParseTuple(dim, "siibbO", &dimName, &places[d], &positions[d],
+                                            &hideNames[d], &hideLabels[d], &categoryLists[d])) {
+            PyErr_Clear();
+            errLevel = PARSE_TUPLE_FAIL;
+            break;
+        }
+        if(!PyList_Check(categoryLists[d]) && !PyTuple_Check(categoryLists[d])) {
+            errLevel = PARSE_TUPLE_FAIL;
+            break;
+        }
+        dimNames[d] = dimName;
+        categoryCounts[d] = (int)PySequence_Size(categoryLists[d]);
+        if(categoryCounts[d] < 1) {
+            errLevel = SIZE_NOT_EQUAL;
+            break;
+        }
+        totalCategories += categoryCounts[d];
+        totalCells *= categoryCounts[d];
+        if(totalCells > INT_MAX) {
+            errLevel = ERROR_PARAMETER;
+        }
+    }
+
+    if(0 == errLevel) {
+        categories = PyMem_New(const char*,totalCategories);
+        if(!categories) {
+            errLevel = NO_MEMORY;
+        }
+    }
+    for(d = 0, k = 0; d < dimCount && 0 == errLevel; d++) {
+        for(i = 0; i < categoryCounts[d]; i++, k++) {
+            char *category;
+            if(!PyArg_Parse(PySequence_Fast_GET_ITEM(categoryLists[d],i),"s",&category)) {
+                PyErr_Clear();
+                errLevel = PARSE_TUPLE_FAIL;
+                break;
+            }
+            categories[k] = category;
+        }
+    }
+
+    if(0 == errLevel) {
+        errLevel = GetDoubleArray(cellData,&cellView,&cells,&cellCount);
+        if(0 == errLevel && cellCount != totalCells) {
+            errLevel = SIZE_NOT_EQUAL;
+        }
+    }
+    if(0 == errLevel && Py_None != formatData) {
+        errLevel = GetIntegerArray(formatData,&formatView,&formatSpecs,&formatCount);
+        if(0 == errLevel && formatCount != cellCount) {
+            errLevel = SIZE_NOT_EQUAL;
+        }
+    }
+    if(0 == errLevel && Py_None != varIndexData) {
+        errLevel = GetIntegerArray(varIndexData,&varIndexView,&varIndexes,&varIndexCount);
+        if(0 == errLevel && varIndexCount != cellCount) {
+            errLevel = SIZE_NOT_EQUAL;
+        }
+    }
+
+    if(0 == errLevel) {
+        errLevel = FlushPivotModel();
+    }
+    if(0 == errLevel) {
+        if(XD_AVAILABLE(SetNumberCells)) {
+            errLevel = SetNumberCells(outline,tableName,templateName,isSplit,
+                                      dimCount,dimNames,places,positions,hideNames,hideLabels,
+                                      categoryCounts,categories,cells,formatSpecs,varIndexes);
+        } else {
+            errLevel = SetNumberCellsByCell(outline,tableName,templateName,isSplit,
+                                            dimCount,dimNames,places,positions,hideNames,hideLabels,
+                                            categoryCounts,categories,cells,cellCount,formatSpecs,varIndexes);
+        }
+    }
+
+    ReleaseDoubleArray(&cellView,cells);
+    ReleaseIntegerArray(&formatView,formatSpecs);
+    ReleaseIntegerArray(&varIndexView,varIndexes);
+    PyMem_Del(categories);
+    PyMem_Del(categoryLists);
+    PyMem_Del(categoryCounts);
+    PyMem_Del(hideLabels);
+    PyMem_Del(hideNames);
+    PyMem_Del(positions);
+    PyMem_Del(places);
+    PyMem_Del(dimNames);
+
     return Py_BuildValue("i",errLevel);
 }
+
 PyObject *
-    ext_SetVarValueDoubleCell(PyObject *self, PyObject *args)
+    ext_AddTextBlockLines(PyObject *self, PyObject *args)
 {
-    int errLevel;
-
-    char *outline,*tableName,*templateName;
-    bool isSplit;
-    char *dimName;
-    int place,position;
-    bool hideName, hideLabels;
-    int cell;
-    double d;
+    int errLevel = 0;
+    char *outline,*name;
+    PyObject *lineData, *skipData = NULL;
 
-    if (!PyArg_ParseTuple(args, "sssbsiibbid", &outline,&tableName,&templateName,&isSplit,
-                                           &dimName, &place, &position, &hideName, &hideLabels,
-                                           &cell,&d)){
+    if (!PyArg_ParseTuple(args, "ssO|O", &outline,&name,&lineData,&skipData)){
         return NULL;
     }
 
-    errLevel = SetVarValueDoubleCell(outline,tableName,templateName,isSplit,
-                                     dimName,place, position, hideName, hideLabels,
-                                     cell,d);
+    if(!PyList_Check(lineData) && !PyTuple_Check(lineData)) {
+        return Py_BuildValue("i",PARSE_TUPLE_FAIL);
+    }
+
+    //the utf-8 of each str is kept by the str itself, no line is copied.
+    int lineCount = (int)PySequence_Fast_GET_SIZE(lineData);
+    PyObject **items = PySequence_Fast_ITEMS(lineData);
+    const char **lines = PyMem_New(const char*,lineCount > 0 ? lineCount : 1);
+    if(!lines) {
+        return Py_BuildValue("i",NO_MEMORY);
+    }
+    for(int i = 0; i < lineCount && 0 == errLevel; i++) {
+        lines[i] = PyUnicode_Check(items[i]) ? PyUnicode_AsUTF8(items[i]) : NULL;
+        if(!lines[i]) {
+            PyErr_Clear();
+            errLevel = PARSE_TUPLE_FAIL;
+        }
+    }
+
+    int *nSkips = NULL;
+    int skipCount = lineCount;
+    Py_buffer skipView;
+    skipView.obj = NULL;
+    if(0 == errLevel && skipData && Py_None != skipData) {
+        errLevel = GetIntegerArray(skipData,&skipView,&nSkips,&skipCount);
+    }
+    if(0 == errLevel && skipCount != lineCount) {
+        errLevel = SIZE_NOT_EQUAL;
+    }
+
+    if(0 == errLevel) {
+        //keep the text block after the tables that were created before it.
+        errLevel = FlushPivotModel();
+    }
+    if(0 == errLevel && lineCount > 0) {
+        if(XD_AVAILABLE(AddTextBlockLines)) {
+            errLevel = AddTextBlockLines(outline,name,lines,nSkips,lineCount);
+        } else {
+            for(int i = 0; i < lineCount && 0 == errLevel; i++) {
+                errLevel = AddTextBlock(outline,name,lines[i],nSkips ? nSkips[i] : 1);
+            }
+        }
+    }
+
+    ReleaseIntegerArray(&skipView,nSkips);
+    PyMem_Del(lines);
     return Py_BuildValue("i",errLevel);
 }
+
 PyObject *
-    ext_SetVarValueStringCell(PyObject *self, PyObject *args)
+    ext_SetDeferredPivotTables(PyObject *self, PyObject *args)
 {
-    int errLevel;
-
-    char *outline,*tableName,*templateName;
-    bool isSplit;
-    char *dimName;
-    int place,position;
-    bool hideName, hideLabels;
-    int cell;
-    char *ch;
+    int errLevel = 0;
+    bool deferred;
 
-    if (!PyArg_ParseTuple(args, "sssbsiibbis", &outline,&tableName,&templateName,&isSplit,
-                                           &dimName, &place, &position, &hideName, &hideLabels,
-                                           &cell,&ch)){
+    if (!PyArg_ParseTuple(args, "b", &deferred)){
         return NULL;
     }
+    if(!deferred) {
+        errLevel = FlushPivotModel();
+    }
+    pivotModel.deferred = deferred;
+    return Py_BuildValue("i",errLevel);
+}
 
-    errLevel = SetVarValueStringCell(outline,tableName,templateName,isSplit,
-                                     dimName,place, position, hideName, hideLabels,
-                                     cell,ch);
+PyObject *
+    ext_FlushPivotTables(PyObject *self, PyObject *args)
+{
+    int errLevel;
+    errLevel = FlushPivotModel();
     return Py_BuildValue("i",errLevel);
 }
 
+PyObject *
+    ext_GetPivotTableStats(PyObject *self, PyObject *args)
+{
+    return Py_BuildValue("{s:i,s:l,s:l,s:l,s:n}",
+                         "deferred", (int)pivotModel.deferred,
+                         "recordedCalls", pivotModel.recordedCalls,
+                         "backendCalls", pivotModel.backendCalls,
+                         "denseTables", pivotModel.denseTables,
+                         "pendingRecords", (Py_ssize_t)pivotModel.records.size());
+}
+
   PyObject *
       ext_AddCellFootnotes(PyObject *self, PyObject *args)
   {
@@ -2956,9 +4914,13 @@ PyObject *
           return NULL;
       }
 
-      errLevel = AddCellFootnotes(outline,tableName,templateName,isSplit,
-                                  dimName,place, position, hideName, hideLabels,
-                                  footnotes);
+      if(pivotModel.deferred) {
+          errLevel = RecordPivotDimCall(PIVOT_CELL_FOOTNOTES,outline,tableName,templateName,isSplit,dimName,place,position,hideName,hideLabels,footnotes,0,0.0);
+      } else {
+          errLevel = AddCellFootnotes(outline,tableName,templateName,isSplit,
+                                      dimName,place, position, hideName, hideLabels,
+                                      footnotes);
+      }
       return Py_BuildValue("i",errLevel);
   }
 
@@ -2988,7 +4950,11 @@ PyObject *
           return NULL;
       }
 
-      errLevel = AddOutlineFootnotes(outline,tableName,templateName,footnotes,isSplit);
+      if(pivotModel.deferred) {
+          errLevel = RecordPivotTableCall(PIVOT_OUTLINE_FOOTNOTES,outline,tableName,templateName,isSplit,footnotes);
+      } else {
+          errLevel = AddOutlineFootnotes(outline,tableName,templateName,footnotes,isSplit);
+      }
       return Py_BuildValue("i",errLevel);
   }
 
@@ -3004,7 +4970,11 @@ PyObject *
           return NULL;
       }
 
-      errLevel = AddTitleFootnotes(outline,tableName,templateName,footnotes,isSplit);
+      if(pivotModel.deferred) {
+          errLevel = RecordPivotTableCall(PIVOT_TITLE_FOOTNOTES,outline,tableName,templateName,isSplit,footnotes);
+      } else {
+          errLevel = AddTitleFootnotes(outline,tableName,templateName,footnotes,isSplit);
+      }
       return Py_BuildValue("i",errLevel);
   }
 
@@ -3027,9 +4997,13 @@ PyObject *
           return NULL;
       }
 
-      errLevel = AddDimFootnotes(outline,tableName,templateName,isSplit,
-                                  dimName,place, position, hideName, hideLabels,
-                                  footnotes);
+      if(pivotModel.deferred) {
+          errLevel = RecordPivotDimCall(PIVOT_DIM_FOOTNOTES,outline,tableName,templateName,isSplit,dimName,place,position,hideName,hideLabels,footnotes,0,0.0);
+      } else {
+          errLevel = AddDimFootnotes(outline,tableName,templateName,isSplit,
+                                      dimName,place, position, hideName, hideLabels,
+                                      footnotes);
+      }
       return Py_BuildValue("i",errLevel);
   }
 
@@ -3052,9 +5026,13 @@ PyObject *
           return NULL;
       }
 
-      errLevel = AddCategoryFootnotes(outline,tableName,templateName,isSplit,
-                                      dimName,place, position, hideName, hideLabels,
-                                      footnotes);
+      if(pivotModel.deferred) {
+          errLevel = RecordPivotDimCall(PIVOT_CATEGORY_FOOTNOTES,outline,tableName,templateName,isSplit,dimName,place,position,hideName,hideLabels,footnotes,0,0.0);
+      } else {
+          errLevel = AddCategoryFootnotes(outline,tableName,templateName,isSplit,
+                                          dimName,place, position, hideName, hideLabels,
+                                          footnotes);
+      }
       return Py_BuildValue("i",errLevel);
   }
 
@@ -3070,7 +5048,11 @@ PyObject *
       if (!PyArg_ParseTuple(args, "sssi", &outline,&name,&line,&nSkip)){
           return NULL;
       }
-      errLevel = AddTextBlock(outline,name,line,nSkip);
+      //keep the text block after the tables that were created before it.
+      errLevel = FlushPivotModel();
+      if(0 == errLevel) {
+          errLevel = AddTextBlock(outline,name,line,nSkip);
+      }
       return Py_BuildValue("i",errLevel);
 }
 
@@ -3381,7 +5363,7 @@ PyObject *
     PyObject *
     ext_NextCase(PyObject *self, PyObject *args)
     {
-        return Py_BuildValue("i",NextCase());
+        return PyLong_FromLong(NextCase());
     }
 
     PyObject *
@@ -3450,7 +5432,7 @@ PyObject *
     {
         int errLevel = 0;
                 
-        if(RemoveCaseCursor) {
+        if(XD_AVAILABLE(RemoveCaseCursor)) {
             errLevel = RemoveCaseCursor();
             if(errLevel) {
                 return Py_BuildValue("i",errLevel);
@@ -3460,6 +5442,317 @@ PyObject *
         return Py_None;
     }
 
+    // Raw cursor.
+    //
+    // NextCasePtr gives the backend's buffer of the current case. A numeric
+    // value is a double and a string value is its bytes padded to a multiple of
+    // 8, each at 8 times the obs index of its variable. The buffer is only
+    // valid until the cursor moves, so the case is copied into a CaseBuffer and
+    // exported from there. A view kept past the move, or made from the memoryview
+    // by slicing or cast, reads its own copy. The CaseBuffer of the last case is
+    // filled again when nothing exports it any more.
+
+    typedef struct {
+        PyObject_HEAD
+        char*       data;
+        Py_ssize_t  size;
+        Py_ssize_t  capacity;
+        Py_ssize_t  exports;
+    } SPSS_CaseBuffer;
+
+    static int SPSS_CaseBuffer_getbuffer(SPSS_CaseBuffer *self, Py_buffer *view, int flags)
+    {
+        if(PyBuffer_FillInfo(view,(PyObject*)self,self->data,self->size,1,flags) < 0) {
+            return -1;
+        }
+        self->exports++;
+        return 0;
+    }
+
+    static void SPSS_CaseBuffer_releasebuffer(SPSS_CaseBuffer *self, Py_buffer *view)
+    {
+        self->exports--;
+    }
+
+    static void SPSS_CaseBuffer_dealloc(SPSS_CaseBuffer *self)
+    {
+        PyMem_Free(self->data);
+        PyObject_Del(self);
+    }
+
+    static PyBufferProcs SPSS_CaseBuffer_as_buffer = {
+        (getbufferproc)SPSS_CaseBuffer_getbuffer,
+        (releasebufferproc)SPSS_CaseBuffer_releasebuffer
+    };
+
+    static PyTypeObject SPSS_CaseBuffer_Type = {
+        PyVarObject_HEAD_INIT(NULL, 0)
+        "spss.casebuffer",
+        sizeof(SPSS_CaseBuffer),
+        0,
+        (destructor)SPSS_CaseBuffer_dealloc, /* tp_dealloc */
+        0, /* tp_vectorcall_offset */
+        0, /* tp_getattr */
+        0, /* tp_setattr */
+        0, /* tp_as_async */
+        0, /* tp_repr */
+        0, /* tp_as_number */
+        0, /* tp_as_sequence */
+        0, /* tp_as_mapping */
+        0, /* tp_hash */
+        0, /* tp_call */
+        0, /* tp_str */
+        0, /* tp_getattro */
+        0, /* tp_setattro */
+        &SPSS_CaseBuffer_as_buffer, /* tp_as_buffer */
+        Py_TPFLAGS_DEFAULT,
+        "A copy of one case of a raw cursor." /* tp_doc */
+    };
+
+    //the state of the module in one interpreter. Each sub-interpreter imports the module
+    //again and gets its own, so no Python object is shared between interpreters.
+    typedef struct {
+        SPSS_CaseBuffer* lastCaseBuffer;
+    } PyInvokeSpssState;
+
+    static PyInvokeSpssState* GetModuleState(PyObject* module)
+    {
+        return (PyInvokeSpssState*)PyModule_GetState(module);
+    }
+
+    //a CaseBuffer holding the case, the one of the last case when it is not exported.
+    static SPSS_CaseBuffer* FillCaseBuffer(PyObject* module, const void* casePtr, int caseSize)
+    {
+        SPSS_CaseBuffer*& lastCaseBuffer = GetModuleState(module)->lastCaseBuffer;
+        SPSS_CaseBuffer* buffer = lastCaseBuffer;
+        if(NULL == buffer || buffer->exports > 0 || Py_REFCNT(buffer) > 1) {
+            buffer = PyObject_New(SPSS_CaseBuffer,&SPSS_CaseBuffer_Type);
+            if(NULL == buffer) {
+                return NULL;
+            }
+            buffer->data = NULL;
+            buffer->size = 0;
+            buffer->capacity = 0;
+            buffer->exports = 0;
+            Py_XSETREF(lastCaseBuffer,buffer);
+        }
+        if(buffer->capacity < caseSize) {
+            char* data = (char*)PyMem_Realloc(buffer->data,caseSize);
+            if(NULL == data) {
+                PyErr_NoMemory();
+                return NULL;
+            }
+            buffer->data = data;
+            buffer->capacity = caseSize;
+        }
+        memcpy(buffer->data,casePtr,caseSize);
+        buffer->size = caseSize;
+        Py_INCREF(buffer);
+        return buffer;
+    }
+
+    PyObject *
+    ext_MakeRawCursor(PyObject *self, PyObject *args)
+    {
+        return Py_BuildValue("i",MakeCaseCursor("r"));
+    }
+
+    PyObject *
+    ext_NextCasePtr(PyObject *self, PyObject *args)
+    {
+        int caseSize = 0;
+        int errLevel = 0;
+        void* casePtr = NextCasePtr(caseSize,errLevel);
+        if(0 != errLevel || NULL == casePtr || caseSize <= 0) {
+            return Py_BuildValue("(Oii)",Py_None,caseSize,errLevel ? errLevel : NO_MORE_DATA);
+        }
+        SPSS_CaseBuffer* buffer = FillCaseBuffer(self,casePtr,caseSize);
+        if(NULL == buffer) {
+            return NULL;
+        }
+        PyObject* view = PyMemoryView_FromObject((PyObject*)buffer);
+        Py_DECREF(buffer);
+        if(NULL == view) {
+            return NULL;
+        }
+        return Py_BuildValue("(Nii)",view,caseSize,errLevel);
+    }
+
+    PyObject *
+    ext_NextCaseBlock(PyObject *self, PyObject *args)
+    {
+        int count = 0;
+        if(!PyArg_ParseTuple(args,"i",&count)) {
+            return NULL;
+        }
+        int caseSize = 0;
+        int errLevel = 0;
+        int rows = 0;
+        PyObject* block = PyByteArray_FromStringAndSize(NULL,0);
+        if(NULL == block) {
+            return NULL;
+        }
+        while(rows < count) {
+            int size = 0;
+            void* casePtr = NextCasePtr(size,errLevel);
+            if(0 != errLevel || NULL == casePtr || size <= 0) {
+                if(0 == errLevel) {
+                    errLevel = NO_MORE_DATA;
+                }
+                break;
+            }
+            if(0 == rows) {
+                caseSize = size;
+                if(PyByteArray_Resize(block,(Py_ssize_t)caseSize * count) < 0) {
+                    Py_DECREF(block);
+                    return NULL;
+                }
+            } else if(size != caseSize) {
+                errLevel = SIZE_NOT_EQUAL;
+                break;
+            }
+            memcpy(PyByteArray_AS_STRING(block) + (Py_ssize_t)rows * caseSize,casePtr,caseSize);
+            rows++;
+        }
+        if(rows < count && PyByteArray_Resize(block,(Py_ssize_t)rows * caseSize) < 0) {
+            Py_DECREF(block);
+            return NULL;
+        }
+        //the end of data after some cases is reported by the next call.
+        if(rows > 0 && NO_MORE_DATA == errLevel) {
+            errLevel = 0;
+        }
+        return Py_BuildValue("(Niii)",block,rows,caseSize,errLevel);
+    }
+
+    PyObject *
+    ext_GetRawCaseLayout(PyObject *self, PyObject *args)
+    {
+        char* dsName;
+        PyObject* varData;
+        if(!PyArg_ParseTuple(args,"sO",&dsName,&varData)) {
+            return NULL;
+        }
+        if(!PyList_Check(varData) && !PyTuple_Check(varData)) {
+            return Py_BuildValue("(Oii)",Py_None,0,PARSE_TUPLE_FAIL);
+        }
+        int errLevel = 0;
+        int caseLength = GetCaseLength(dsName,errLevel);
+        if(0 != errLevel) {
+            return Py_BuildValue("(Oii)",Py_None,0,errLevel);
+        }
+        Py_ssize_t n = PySequence_Fast_GET_SIZE(varData);
+        PyObject **items = PySequence_Fast_ITEMS(varData);
+        PyObject* obsList = PyList_New(n);
+        if(NULL == obsList) {
+            return NULL;
+        }
+        for(Py_ssize_t i = 0; i < n && 0 == errLevel; i++) {
+            long index = PyLong_AsLong(items[i]);
+            if(-1 == index && PyErr_Occurred()) {
+                PyErr_Clear();
+                errLevel = PARSE_TUPLE_FAIL;
+                break;
+            }
+            int obs = GetVarObsIndex(dsName,(int)index,errLevel);
+            PyList_SET_ITEM(obsList,i,PyLong_FromLong(obs));
+        }
+        if(0 != errLevel) {
+            Py_DECREF(obsList);
+            return Py_BuildValue("(Oii)",Py_None,caseLength,errLevel);
+        }
+        return Py_BuildValue("(Nii)",obsList,caseLength,errLevel);
+    }
+
+    PyObject *
+    ext_DecodeCases(PyObject *self, PyObject *args)
+    {
+        Py_buffer view;
+        int caseSize = 0;
+        PyObject *obsData, *typeData;
+        double sysmis = 0.0;
+        int utf8 = 1;
+        if(!PyArg_ParseTuple(args,"y*iOOd|i",&view,&caseSize,&obsData,&typeData,&sysmis,&utf8)) {
+            return NULL;
+        }
+        PyObject* obsSeq = PySequence_Fast(obsData,"obs indexes must be a sequence");
+        PyObject* typeSeq = obsSeq ? PySequence_Fast(typeData,"variable types must be a sequence") : NULL;
+        if(NULL == typeSeq) {
+            Py_XDECREF(obsSeq);
+            PyBuffer_Release(&view);
+            return NULL;
+        }
+        Py_ssize_t varCount = PySequence_Fast_GET_SIZE(obsSeq);
+        std::vector<Py_ssize_t> offsets(varCount);
+        std::vector<int> types(varCount);
+        const char* message = NULL;
+        if(varCount != PySequence_Fast_GET_SIZE(typeSeq)) {
+            message = "obs indexes and variable types differ in length";
+        }
+        if(caseSize <= 0) {
+            message = "case size must be positive";
+        }
+        for(Py_ssize_t i = 0; i < varCount && NULL == message; i++) {
+            offsets[i] = (Py_ssize_t)PyLong_AsLong(PySequence_Fast_GET_ITEM(obsSeq,i)) * 8;
+            types[i] = (int)PyLong_AsLong(PySequence_Fast_GET_ITEM(typeSeq,i));
+            if(PyErr_Occurred()) {
+                break;
+            }
+            Py_ssize_t width = 0 == types[i] ? (Py_ssize_t)sizeof(double) : types[i];
+            if(offsets[i] < 0 || types[i] < 0 || offsets[i] + width > caseSize) {
+                message = "variable outside of the case";
+            }
+        }
+        Py_DECREF(obsSeq);
+        Py_DECREF(typeSeq);
+        if(NULL == message && !PyErr_Occurred() && view.len % caseSize != 0) {
+            message = "buffer is not a whole number of cases";
+        }
+        if(NULL != message || PyErr_Occurred()) {
+            if(!PyErr_Occurred()) {
+                PyErr_SetString(PyExc_ValueError,message);
+            }
+            PyBuffer_Release(&view);
+            return NULL;
+        }
+
+        Py_ssize_t rows = view.len / caseSize;
+        PyObject* result = PyList_New(rows);
+        for(Py_ssize_t r = 0; result && r < rows; r++) {
+            const char* caseData = (const char*)view.buf + r * caseSize;
+            PyObject* row = PyTuple_New(varCount);
+            for(Py_ssize_t i = 0; row && i < varCount; i++) {
+                PyObject* value;
+                if(0 == types[i]) {
+                    double number;
+                    memcpy(&number,caseData + offsets[i],sizeof(double));
+                    if(number == sysmis) {
+                        Py_INCREF(Py_None);
+                        value = Py_None;
+                    } else {
+                        value = PyFloat_FromDouble(number);
+                    }
+                } else if(utf8) {
+                    value = PyUnicode_DecodeUTF8(caseData + offsets[i],types[i],"replace");
+                } else {
+                    value = PyBytes_FromStringAndSize(caseData + offsets[i],types[i]);
+                }
+                if(NULL == value) {
+                    Py_CLEAR(row);
+                    break;
+                }
+                PyTuple_SET_ITEM(row,i,value);
+            }
+            if(NULL == row) {
+                Py_CLEAR(result);
+                break;
+            }
+            PyList_SET_ITEM(result,r,row);
+        }
+        PyBuffer_Release(&view);
+        return result;
+    }
+
     int MakeVarDict(SPSS_ResultObject *datasrcInfo, PyObject *varTuple)
     {
         int errLevel = 0;
@@ -4049,36 +6342,38 @@ PyObject *
 
     PyObject*
     ext_SetValueChar(PyObject* self,
-                     PyObject* args)
+                     PyObject* const* args,
+                     Py_ssize_t nargs)
     {
         int error = 0;
-        char *varName;
-        char *value;
+        const char *varName;
+        const char *value;
 
-        if(!PyArg_ParseTuple(args,"ss",&varName,&value)) {
+        if(!FastArgCount("SetValueChar",nargs,2) || !FastString(args[0],varName) || !FastString(args[1],value)) {
             return NULL;
         }
 
         error = SetValueChar(varName,value,strlen(value));
 
-        return Py_BuildValue("i",error);
+        return PyLong_FromLong(error);
     }
 
     PyObject*
     ext_SetValueNumeric(PyObject* self,
-                        PyObject* args)
+                        PyObject* const* args,
+                        Py_ssize_t nargs)
     {
         int error = 0;
-        char *varName;
+        const char *varName;
         double value;
 
-        if(!PyArg_ParseTuple(args,"sd",&varName,&value)) {
+        if(!FastArgCount("SetValueNumeric",nargs,2) || !FastString(args[0],varName) || !FastDouble(args[1],value)) {
             return NULL;
         }
 
         error = SetValueNumeric(varName,value);
 
-        return Py_BuildValue("i",error);
+        return PyLong_FromLong(error);
     }
 
     PyObject*
@@ -4199,7 +6494,7 @@ PyObject *
 
         error = CommitCaseRecord();
 
-        return Py_BuildValue("i",error);
+        return PyLong_FromLong(error);
     }
 
     PyObject*
@@ -5607,13 +7902,14 @@ PyObject *
 
         PYINVOKESPSS_API PyObject * ext_InsertCase(
                                                       PyObject *self,
-                                                      PyObject *args)
+                                                      PyObject *const *args,
+                                                      Py_ssize_t nargs)
         {
-            char* dsName;
+            const char* dsName;
             int rowIndex;
-            if (!PyArg_ParseTuple(args, "si", &dsName, &rowIndex))
+            if (!FastArgCount("InsertCase", nargs, 2) || !FastString(args[0], dsName) || !FastInt(args[1], rowIndex))
                 return NULL;
-            return Py_BuildValue("i", InsertCase( dsName, rowIndex));
+            return PyLong_FromLong(InsertCase( dsName, rowIndex));
         }
 
         PYINVOKESPSS_API PyObject * ext_DeleteCase(
@@ -5642,21 +7938,25 @@ PyObject *
 
         PYINVOKESPSS_API PyObject * ext_GetNCellValue(
                                                       PyObject *self,
-                                                      PyObject *args)
+                                                      PyObject *const *args,
+                                                      Py_ssize_t nargs)
         {
-            char* dsName;
+            const char* dsName;
             int rowIndex;
             int columnIndex;
             int isMissing;
             int errLevel;
-            if (!PyArg_ParseTuple(args, "sii", &dsName, &rowIndex, &columnIndex))
+            if (!FastArgCount("GetNCellValue", nargs, 3) || !FastString(args[0], dsName) ||
+                !FastInt(args[1], rowIndex) || !FastInt(args[2], columnIndex))
                 return NULL;
             double value = GetNCellValue(dsName, rowIndex, columnIndex, isMissing, errLevel);
 
-            if (isMissing == 2)
-                return Py_BuildValue("Oi", Py_None, errLevel);
+            if (isMissing == 2) {
+                Py_INCREF(Py_None);
+                return ValueAndError(Py_None, errLevel);
+            }
             else
-                return Py_BuildValue("di", value, errLevel);
+                return ValueAndError(PyFloat_FromDouble(value), errLevel);
         }
         
         PYINVOKESPSS_API PyObject * ext_GetCellsValue(
@@ -5773,57 +8073,55 @@ PyObject *
             return r;
         }
 
+        //the value is UTF-8 whether or not the backend is in Unicode mode, as
+        //Py_BuildValue("s") decoded it, so IsUTF8mode is not asked for each cell.
         PYINVOKESPSS_API PyObject * ext_GetCCellValue(
                                                       PyObject *self,
-                                                      PyObject *args)
+                                                      PyObject *const *args,
+                                                      Py_ssize_t nargs)
         {
-            char* dsName;
+            const char* dsName;
             int rowIndex;
             int columnIndex;
             int isMissing;
             int errLevel;
-            if (!PyArg_ParseTuple(args, "sii", &dsName, &rowIndex, &columnIndex))
+            if (!FastArgCount("GetCCellValue", nargs, 3) || !FastString(args[0], dsName) ||
+                !FastInt(args[1], rowIndex) || !FastInt(args[2], columnIndex))
                 return NULL;
             const char* value = GetCCellValue(dsName, rowIndex, columnIndex, isMissing, errLevel);
-            if(IsUTF8mode()&&(errLevel==0))
-            {
-                PyObject* pyValue = PyUnicode_Decode(value,strlen(value),"utf-8",NULL);
-                PyObject* r = Py_BuildValue("Oi", pyValue, errLevel);
-                Py_XDECREF(pyValue);
-                return r;
-            }
-            else
-            {
-                return Py_BuildValue("si", value, errLevel);
-            }
+            return ValueAndError(StringOrNone(value), errLevel);
         }
 
         PYINVOKESPSS_API PyObject * ext_SetNCellValue(
                                                       PyObject *self,
-                                                      PyObject *args)
+                                                      PyObject *const *args,
+                                                      Py_ssize_t nargs)
         {
-            char* dsName;
+            const char* dsName;
             int rowIndex;
             int columnIndex;
             double value;
-            if (!PyArg_ParseTuple(args, "siid", &dsName, &rowIndex, &columnIndex, &value))
+            if (!FastArgCount("SetNCellValue", nargs, 4) || !FastString(args[0], dsName) ||
+                !FastInt(args[1], rowIndex) || !FastInt(args[2], columnIndex) || !FastDouble(args[3], value))
                 return NULL;
 
-            return Py_BuildValue("i", SetNCellValue(dsName, rowIndex, columnIndex, value));
+            return PyLong_FromLong(SetNCellValue(dsName, rowIndex, columnIndex, value));
         }
 
         PYINVOKESPSS_API PyObject * ext_SetCCellValue(
                                                       PyObject *self,
-                                                      PyObject *args)
+                                                      PyObject *const *args,
+                                                      Py_ssize_t nargs)
         {
-            char* dsName;
+            const char* dsName;
             int rowIndex;
             int columnIndex;
-            char* value;
-            if (!PyArg_ParseTuple(args, "siis", &dsName, &rowIndex, &columnIndex, &value))
+            const char* value;
+            if (!FastArgCount("SetCCellValue", nargs, 4) || !FastString(args[0], dsName) ||
+                !FastInt(args[1], rowIndex) || !FastInt(args[2], columnIndex) || !FastString(args[3], value))
                 return NULL;
 
-            return Py_BuildValue("i", SetCCellValue(dsName, rowIndex, columnIndex, value));
+            return PyLong_FromLong(SetCCellValue(dsName, rowIndex, columnIndex, value));
         }
 
         PYINVOKESPSS_API PyObject * ext_IsUTF8mode( PyObject *self,
@@ -6238,14 +8536,8 @@ PyObject *
         int errLevel = 0;
         const char *locale = GetSPSSLocale(errLevel);
 
-        if ( 0 == errLevel && GetCLocale){
-            //reset the locale to xdlocale.
-            char *xdlocale = 0;
-            errLevel = GetCLocale(&xdlocale);
-            if ( xdlocale ){
-                setlocale(LC_ALL, xdlocale);
-            }
-            FreeString( xdlocale );
+        if ( 0 == errLevel ){
+            errLevel = ResetXDLocale();
         }
 
         if(IsUTF8mode()&&(errLevel==0))
@@ -6444,12 +8736,24 @@ PyObject *
         return Py_BuildValue("ii", varRole, errLevel);
     }
 
+    static void PyInvokeSpss_free(void* module)
+    {
+        PyInvokeSpssState* state = GetModuleState((PyObject*)module);
+        if(state) {
+            Py_CLEAR(state->lastCaseBuffer);
+        }
+    }
+
 	static PyModuleDef PyInvokeSpssmodule = {
 		PyModuleDef_HEAD_INIT,
 		"PyInvokeSpss",
 		NULL,
-		-1,
-		PyInvokeSpss_methods
+		sizeof(PyInvokeSpssState),
+		PyInvokeSpss_methods,
+		NULL,
+		NULL,
+		NULL,
+		PyInvokeSpss_free
 	};
 
     PyMODINIT_FUNC
@@ -6463,6 +8767,10 @@ PyObject *
         SPSS_ResultObject_Type.tp_alloc = PyType_GenericAlloc;
         SPSS_ResultObject_Type.tp_new = PyType_GenericNew;
         SPSS_ResultObject_Type.tp_free = PyObject_GC_Del;
+        if(module && PyType_Ready(&SPSS_CaseBuffer_Type) < 0) {
+            Py_DECREF(module);
+            return NULL;
+        }
 
 		return module;
     }
@@ -6574,65 +8882,65 @@ PyObject *
         return Py_BuildValue("li", result, errLevel);
     }
     
-    PYINVOKESPSS_API PyObject * ext_GetCaseValue(PyObject *self, PyObject *args)
+    PYINVOKESPSS_API PyObject * ext_GetCaseValue(PyObject *self, PyObject *const *args, Py_ssize_t nargs)
     {
-        char* dsName;
+        const char* dsName;
         int rowIndex;
-        bool isCache;
+        int isCache;
         int isMissing;
         int errLevel = 0;
-        if (!PyArg_ParseTuple(args, "sib", &dsName, &rowIndex, &isCache))
+        if (!FastArgCount("GetCaseValue", nargs, 3) || !FastString(args[0], dsName) ||
+            !FastInt(args[1], rowIndex) || !FastInt(args[2], isCache))
             return NULL;
             
         int* varType = 0;
         int size = 0;
         
         GetVarInfo(dsName, &varType, size);
-        PyObject* result = NULL;
+        PyObject *pyValueList = NULL;
         if (size>0)
         {
             int len = 0;
-            GetCaseValue(dsName, rowIndex, isCache, len, errLevel);
+            GetCaseValue(dsName, rowIndex, 0 != isCache, len, errLevel);
             if (0 == errLevel){
-                PyObject *pyValueList = NULL;
                 pyValueList = PyList_New(size);
-                for (int i=0; i<size; i++){
+                for (int i=0; pyValueList && i<size; i++){
+                    PyObject* item = NULL;
                     if(0 == varType[i]){
                         double value = GetNCellValueFromCache(dsName, i, isMissing, errLevel);
                         if(isMissing){
                             Py_INCREF(Py_None);
-                            PyList_SetItem(pyValueList, i, Py_None);
+                            item = Py_None;
                         }
                         else{
-                            PyList_SetItem(pyValueList, i, Py_BuildValue("d", value));
+                            item = PyFloat_FromDouble(value);
                         }
                     }
                     else{
                         const char* value = GetCCellValueFromCache(dsName, i, errLevel);
-                        if (IsUTF8mode()&&(0==errLevel)){
-                            PyObject* pyValue = PyUnicode_Decode(value,strlen(value),"utf-8",NULL);
-                            PyList_SetItem(pyValueList, i, Py_BuildValue("O", pyValue));
-                            Py_XDECREF(pyValue);
-                        }
-                        else{
-                            PyList_SetItem(pyValueList, i, Py_BuildValue("s", value));
-                        }
+                        item = StringOrNone(value);
                         FreeString((char*)value);
                     }
+                    if (NULL == item){
+                        Py_CLEAR(pyValueList);
+                        break;
+                    }
+                    PyList_SET_ITEM(pyValueList, i, item);
+                }
+                if (NULL == pyValueList){
+                    delete []varType;
+                    return NULL;
                 }
-            
-                delete []varType;
-                varType = 0;
-                
-                result = Py_BuildValue("Oi", pyValueList, errLevel);
-                Py_DECREF(pyValueList);
             }
         }
-        else
-        {
-            result = Py_BuildValue("Oi", Py_None, errLevel);
+        delete []varType;
+        varType = 0;
+
+        if (NULL == pyValueList){
+            Py_INCREF(Py_None);
+            pyValueList = Py_None;
         }
-        return result;
+        return ValueAndError(pyValueList, errLevel);
     }
     
     PYINVOKESPSS_API PyObject * ext_SetCaseValue(PyObject *self, PyObject *args)
@@ -6730,7 +9038,7 @@ PyObject *
     {
         int result;
 
-        if(NULL == IsDistributedMode) {
+        if(!XD_AVAILABLE(IsDistributedMode)) {
           result = PY_FALSE;
         } else {
           result = IsDistributedMode();
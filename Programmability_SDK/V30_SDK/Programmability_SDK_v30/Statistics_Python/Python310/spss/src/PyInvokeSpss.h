@@ -55,6 +55,12 @@ typedef int              (*FP_StartSpss)(const char* commandline);
 typedef void             (*FP_StopSpss)();
 typedef int              (*FP_Submit)(const char* command, int length);
 typedef int              (*FP_QueueCommandPart)(const char* line, int length);
+typedef int              (*FP_SubmitBatch)(const char* const* cmds, const int* lens, int n, int* perCommandErr);
+typedef void             (*FP_SubmitCallback)(int ticket, int errLevel, void* userData);
+typedef int              (*FP_SubmitAsync)(const char* command, int length, int& ticket);
+typedef int              (*FP_PollSubmit)(int ticket, int& done, int& errLevel);
+typedef int              (*FP_WaitSubmit)(int ticket, int timeout, int& errLevel);
+typedef int              (*FP_SetSubmitCallback)(int ticket, FP_SubmitCallback callback, void* userData);
 typedef int              (*FP_PostSpssOutput)(const char* text, int length);
 typedef int              (*FP_GetVariableType)(int index,int& errCode);
 typedef unsigned         (*FP_GetVariableCount)(int& errCode);
@@ -80,10 +86,13 @@ typedef int              (*FP_GetNumericValue)(unsigned varindex, double &result
 typedef int              (*FP_GetStringValue)(unsigned varindex, char* &result, int bufferLength, int &isMissing);
 typedef int              (*FP_GetColumnCountInProcDS)(int &columnCount);
 typedef int              (*FP_NextCase)();
+typedef void*            (*FP_NextCasePtr)(int &caseSize, int &errLevel);
 typedef int              (*FP_RemoveCaseCursor)();
 typedef int              (*FP_GetVariableFormatType)(int index, int &formatType, int& formatWidth, int& formatDecimal);
 typedef int              (*FP_GetCursorPosition)(int &curPos);
 typedef int              (*FP_MakeCaseCursor)(const char*);
+typedef int              (*FP_GetCaseLength)(const char* dsName, int& errLevel);
+typedef int              (*FP_GetVarObsIndex)(const char* dsName, const int columnIndex, int& errLevel);
 typedef int              (*FP_StartProcedure)(const char* procName, const char* translatedName);
 typedef int              (*FP_SplitChange)(const char* procName);
 typedef int              (*FP_EndProcedure)();
@@ -104,6 +113,13 @@ typedef int              (*FP_SetStringCell)(const char* outline, const char* ti
 typedef int              (*FP_SetVarNameCell)(const char* outline, const char* title, const char* templateName,bool isSplit,const char* dimName,int place,int position,bool hideName,bool hideLabels,int cellVal);
 typedef int              (*FP_SetVarValueDoubleCell)(const char* outline, const char* title, const char* templateName,bool isSplit,const char* dimName,int place,int position,bool hideName,bool hideLabels,int cellVal, double d);
 typedef int              (*FP_SetVarValueStringCell)(const char* outline, const char* title, const char* templateName,bool isSplit,const char* dimName,int place,int position,bool hideName,bool hideLabels,int cellVal, const char* ch);
+typedef int              (*FP_SetNumberCellWithFormat)(const char* outline, const char* title, const char* templateName,bool isSplit,const char* dimName,int place,int position,bool hideName,bool hideLabels,double cellVal,int formatSpec,int varIndex);
+typedef int              (*FP_AddNumberCategoryWithFormat)(const char* outline, const char* title, const char* templateName,bool isSplit,const char* dimName,int place,int position,bool hideName,bool hideLabels,double category,int formatSpec,int varIndex);
+typedef int              (*FP_AddTextBlockLines)(const char* outLine,const char* name,const char* const lines[],const int nSkips[],int lineCount);
+typedef int              (*FP_SetNumberCells)(const char* outline, const char* title, const char* templateName,bool isSplit,
+                                            int dimCount,const char* const dimNames[],const int places[],const int positions[],
+                                            const bool hideNames[],const bool hideLabels[],const int categoryCounts[],
+                                            const char* const categories[],const double cells[],const int formatSpecs[],const int varIndexes[]);
 
 typedef int              (*FP_SetFormatSpecCoefficient)();
 typedef int              (*FP_SetFormatSpecCoefficientSE)();
@@ -342,6 +358,7 @@ typedef int             (*FP_GetXDriveMode)(int &currMode, int &originMode);
                                                                                         
 typedef const char*     (*FP_GetSPSSLocale)(int &errCode);
 typedef int             (*FP_GetCLocale)(char **xdlocale);
+typedef int             (*FP_GetCLocaleGeneration)(int &generation);
 typedef void            (*FP_SetOutputLanguage)(const char *language,int &errCode);
 typedef int             (*FP_GetNestDepth)(int &depth);
 typedef const char*     (*FP_GetOutputLanguage)(int& errCode);
@@ -807,6 +824,77 @@ typedef int             (*FP_IsUseOrFilter)(int &isUse);
                                            PyObject *args
                                            );
 
+    /**
+     * Make a read cursor for the raw cursor. Cases are read with NextCasePtr
+     * or NextCaseBlock and closed with close.
+     *
+     * @param self The argument is only used when the C function implements a
+     *             built-in method, not a function. It will always be a NULL
+     *             pointer, when we are defining a function, not a method.
+     * @param args No arguments.
+     * @return the error level.
+     */
+    PYINVOKESPSS_API PyObject * ext_MakeRawCursor( PyObject *self,
+                                                   PyObject *args
+                                                   );
+    /**
+     * Move the raw cursor to the next case.
+     *
+     * @param self The argument is only used when the C function implements a
+     *             built-in method, not a function. It will always be a NULL
+     *             pointer, when we are defining a function, not a method.
+     * @param args No arguments.
+     * @return a tuple of a read-only memoryview over the backend's case buffer,
+     *         or None at the end of data, the case size in bytes and the error
+     *         level. The memoryview is valid until the next case is read.
+     */
+    PYINVOKESPSS_API PyObject * ext_NextCasePtr( PyObject *self,
+                                                 PyObject *args
+                                                 );
+    /**
+     * Copy up to n cases from the raw cursor into one buffer.
+     *
+     * @param self The argument is only used when the C function implements a
+     *             built-in method, not a function. It will always be a NULL
+     *             pointer, when we are defining a function, not a method.
+     * @param args The number of cases.
+     * @return a tuple of a bytearray holding the cases one after another, the
+     *         number of cases, the case size in bytes and the error level.
+     */
+    PYINVOKESPSS_API PyObject * ext_NextCaseBlock( PyObject *self,
+                                                   PyObject *args
+                                                   );
+    /**
+     * Get the case length and the position of each variable in the case
+     * buffer, from GetCaseLength and GetVarObsIndex.
+     *
+     * @param self The argument is only used when the C function implements a
+     *             built-in method, not a function. It will always be a NULL
+     *             pointer, when we are defining a function, not a method.
+     * @param args The dataset name and a list of variable indexes.
+     * @return a tuple of the list of obs indexes, in units of 8 bytes, the case
+     *         length and the error level.
+     */
+    PYINVOKESPSS_API PyObject * ext_GetRawCaseLayout( PyObject *self,
+                                                      PyObject *args
+                                                      );
+    /**
+     * Decode cases from a case buffer.
+     *
+     * @param self The argument is only used when the C function implements a
+     *             built-in method, not a function. It will always be a NULL
+     *             pointer, when we are defining a function, not a method.
+     * @param args The buffer, the case size in bytes, the list of obs indexes,
+     *             the list of variable types (0 for numeric, the width for
+     *             string), the system missing value and 1 to decode strings
+     *             as UTF-8.
+     * @return a list of tuples, one for each case in the buffer. The system
+     *         missing value is returned as None.
+     */
+    PYINVOKESPSS_API PyObject * ext_DecodeCases( PyObject *self,
+                                                 PyObject *args
+                                                 );
+
     /**
      * Return datasrcInfo.
      * create the cursor object.
@@ -927,6 +1015,38 @@ typedef int             (*FP_IsUseOrFilter)(int &isUse);
     PYINVOKESPSS_API PyObject * ext_SetNumberCell( PyObject *self,
                                                  PyObject *args
                                                  );
+    /**
+     * Set a numeric cell together with its formatSpec, in one call.
+     *
+     * @param self The argument is only used when the C function implements a
+     *             built-in method, not a function. It will always be a NULL
+     *             pointer, when we are defining a function, not a method.
+     * @param args A tuple of arguments.
+     *             - args[0..8] The table and dimension, as for SetNumberCell.
+     *             - args[9] The cell value.
+     *             - args[10] The formatSpec, 0 to 15.
+     *             - args[11] The variable index for the formatSpec. Optional, 0 by default.
+     * @return the error level from PASW Statistics. 0 means success.
+     */
+    PYINVOKESPSS_API PyObject * ext_SetNumberCellWithFormat( PyObject *self,
+                                                 PyObject *args
+                                                 );
+    /**
+     * Add a numeric category together with its formatSpec, in one call.
+     *
+     * @param self The argument is only used when the C function implements a
+     *             built-in method, not a function. It will always be a NULL
+     *             pointer, when we are defining a function, not a method.
+     * @param args A tuple of arguments.
+     *             - args[0..8] The table and dimension, as for AddNumberCategory.
+     *             - args[9] The category value.
+     *             - args[10] The formatSpec, 0 to 15.
+     *             - args[11] The variable index for the formatSpec. Optional, 0 by default.
+     * @return the error level from PASW Statistics. 0 means success.
+     */
+    PYINVOKESPSS_API PyObject * ext_AddNumberCategoryWithFormat( PyObject *self,
+                                                 PyObject *args
+                                                 );
     PYINVOKESPSS_API PyObject * ext_SetStringCell( PyObject *self,
                                                  PyObject *args
                                                  );
@@ -939,6 +1059,186 @@ typedef int             (*FP_IsUseOrFilter)(int &isUse);
     PYINVOKESPSS_API PyObject * ext_SetVarValueStringCell( PyObject *self,
                                                  PyObject *args
                                                  );
+    /**
+     * Add a dense block of numeric cells to a pivot table in one call.
+     *
+     * @param self The argument is only used when the C function implements a
+     *             built-in method, not a function. It will always be a NULL
+     *             pointer, when we are defining a function, not a method.
+     * @param args A tuple of arguments.
+     *             - args[0..3] The outline, title, template name and isSplit of the table.
+     *             - args[4] A sequence of dimensions, each a tuple of
+     *               (name, place, position, hideName, hideLabels, categories),
+     *               where categories is a sequence of strings.
+     *             - args[5] The cell values in row-major order, the last dimension
+     *               varying fastest. Any C-contiguous buffer of doubles, or a list or tuple.
+     *             - args[6] Optional. The formatSpec of each cell, as a buffer of ints, a list or a tuple.
+     *             - args[7] Optional. The varIndex of each cell, as a buffer of ints, a list or a tuple.
+     * @return the error level from PASW Statistics. 0 means success.
+     */
+    PYINVOKESPSS_API PyObject * ext_SetNumberCells( PyObject *self,
+                                                 PyObject *args
+                                                 );
+    /**
+     * Turn deferred pivot tables on or off. While on, pivot table calls are
+     * recorded natively and sent to the backend by FlushPivotTables, SplitChange,
+     * AddTextBlock or EndProcedure. Turning it off flushes the recorded tables.
+     *
+     * @param self The argument is only used when the C function implements a
+     *             built-in method, not a function. It will always be a NULL
+     *             pointer, when we are defining a function, not a method.
+     * @param args A tuple of arguments.
+     *             - args[0] True to defer pivot tables, False to send each call immediately.
+     * @return the error level from PASW Statistics. 0 means success.
+     */
+    /**
+     * Add several lines to a text block in one call.
+     *
+     * @param self The argument is only used when the C function implements a
+     *             built-in method, not a function. It will always be a NULL
+     *             pointer, when we are defining a function, not a method.
+     * @param args A tuple of arguments.
+     *             - args[0] The outline title.
+     *             - args[1] The name of the text block.
+     *             - args[2] A list or tuple of strings, the lines.
+     *             - args[3] The number of new lines to skip before each line. Optional,
+     *                       a sequence of integers or a buffer of C ints. 1 for every line by default.
+     * @return the error level from PASW Statistics. 0 means success.
+     */
+    PYINVOKESPSS_API PyObject * ext_AddTextBlockLines( PyObject *self,
+                                                 PyObject *args
+                                                 );
+    PYINVOKESPSS_API PyObject * ext_SetDeferredPivotTables( PyObject *self,
+                                                 PyObject *args
+                                                 );
+    /**
+     * Send the recorded pivot tables to the backend.
+     *
+     * @param self The argument is only used when the C function implements a
+     *             built-in method, not a function. It will always be a NULL
+     *             pointer, when we are defining a function, not a method.
+     * @param args No arguments.
+     * @return the first error level from PASW Statistics. 0 means success.
+     */
+    PYINVOKESPSS_API PyObject * ext_FlushPivotTables( PyObject *self,
+                                                 PyObject *args
+                                                 );
+    /**
+     * Report the counters of the deferred pivot table model.
+     *
+     * @param self The argument is only used when the C function implements a
+     *             built-in method, not a function. It will always be a NULL
+     *             pointer, when we are defining a function, not a method.
+     * @param args No arguments.
+     * @return a dictionary with the keys deferred, recordedCalls, backendCalls,
+     *         denseTables and pendingRecords.
+     */
+    PYINVOKESPSS_API PyObject * ext_GetPivotTableStats( PyObject *self,
+                                                 PyObject *args
+                                                 );
+    /**
+     * Report the binding of the XD API functions. They are bound on first call,
+     * or all at import when the SPSSXD_BIND_NOW environment variable is set.
+     *
+     * @param self The argument is only used when the C function implements a
+     *             built-in method, not a function. It will always be a NULL
+     *             pointer, when we are defining a function, not a method.
+     * @param args Optional integer. 1 binds all functions first.
+     * @return a dictionary with the keys eager, bound, unbound and missing,
+     *         the names of the functions the backend does not export.
+     */
+    PYINVOKESPSS_API PyObject * ext_GetXDSymbolReport( PyObject *self,
+                                                 PyObject *args
+                                                 );
+    /**
+     * Report the profiled calls of the XD API functions. Calls are profiled
+     * when the SPSSXD_PROFILE environment variable is set as the backend is
+     * loaded; StopSpss then also writes the summary to stderr, or appends it
+     * to the file SPSSXD_PROFILE names.
+     *
+     * @param self The argument is only used when the C function implements a
+     *             built-in method, not a function. It will always be a NULL
+     *             pointer, when we are defining a function, not a method.
+     * @param args Optional integer. 1 resets the counters after reporting them.
+     * @return a dictionary with an entry for each function called: calls,
+     *         totalSeconds, maxSeconds and histogram, the calls by latency
+     *         bucket (<1us, <10us, ... <1s, >=1s). Empty when calls are not
+     *         profiled.
+     */
+    PYINVOKESPSS_API PyObject * ext_GetCallStats( PyObject *self,
+                                                 PyObject *args
+                                                 );
+    /**
+     * Queue a command and return without waiting for it to run. The queued
+     * commands run in order on a worker thread, through the backend's
+     * SubmitAsync when it exports one.
+     *
+     * @param self The argument is only used when the C function implements a
+     *             built-in method, not a function. It will always be a NULL
+     *             pointer, when we are defining a function, not a method.
+     * @param args The command, its length in bytes and an optional callable,
+     *             called as callable(ticket, errLevel) when the command has run.
+     * @return a tuple of the ticket and the error level.
+     */
+    /**
+     * Run a list of commands in one call. The mode and locale handling of
+     * Submit is done once for the batch.
+     *
+     * @param self The argument is only used when the C function implements a
+     *             built-in method, not a function. It will always be a NULL
+     *             pointer, when we are defining a function, not a method.
+     * @param args A list or tuple of commands. A command may hold several
+     *             lines separated by new-line characters.
+     * @return a tuple of the largest error level and the list of the error
+     *         level of each command.
+     */
+    PYINVOKESPSS_API PyObject * ext_SubmitBatch( PyObject *self,
+                                                 PyObject *args
+                                                 );
+    PYINVOKESPSS_API PyObject * ext_SubmitAsync( PyObject *self,
+                                                 PyObject *args
+                                                 );
+    /**
+     * Report whether the command of a ticket has run, without waiting.
+     *
+     * @param self The argument is only used when the C function implements a
+     *             built-in method, not a function. It will always be a NULL
+     *             pointer, when we are defining a function, not a method.
+     * @param args The ticket.
+     * @return a tuple of done, the error level of the command and the error
+     *         level of the call.
+     */
+    PYINVOKESPSS_API PyObject * ext_PollSubmit( PyObject *self,
+                                                 PyObject *args
+                                                 );
+    /**
+     * Wait until the command of a ticket has run. The GIL is released while
+     * waiting.
+     *
+     * @param self The argument is only used when the C function implements a
+     *             built-in method, not a function. It will always be a NULL
+     *             pointer, when we are defining a function, not a method.
+     * @param args The ticket and an optional timeout in milliseconds, -1 to
+     *             wait until the command has run.
+     * @return a tuple of the error level of the command and the error level of
+     *         the call.
+     */
+    PYINVOKESPSS_API PyObject * ext_WaitSubmit( PyObject *self,
+                                                 PyObject *args
+                                                 );
+    /**
+     * Apply the locale of IBM SPSS Statistics after a command submitted by
+     * SubmitAsync has run. Called by the thread that collects the result.
+     *
+     * @param self The argument is only used when the C function implements a
+     *             built-in method, not a function. It will always be a NULL
+     *             pointer, when we are defining a function, not a method.
+     * @param args No arguments.
+     * @return the error level of the call.
+     */
+    PYINVOKESPSS_API PyObject * ext_ResetSubmitLocale( PyObject *self,
+                                                 PyObject *args
+                                                 );
 
 
 
@@ -1199,11 +1499,13 @@ typedef int             (*FP_IsUseOrFilter)(int &isUse);
      *                 Type: string
      *             (2) value varibale's valule without null-terminated.
      *                 Type: string
+     * @parm nargs the number of arguments.
      *
      * @return     errro code. 0 means success. The othere means error.
      */
     PYINVOKESPSS_API PyObject * ext_SetValueChar( PyObject *self,
-                                                  PyObject *args
+                                                  PyObject *const *args,
+                                                  Py_ssize_t nargs
                                                   );
 
     /**
@@ -1218,11 +1520,13 @@ typedef int             (*FP_IsUseOrFilter)(int &isUse);
      *                 Type: string
      *             (2) variable's value
      *                 Type: double
+     * @parm nargs the number of arguments.
      *
      * @return     errro code. 0 means success. The othere means error.
      */
     PYINVOKESPSS_API PyObject *  ext_SetValueNumeric( PyObject *self,
-                                                      PyObject *args
+                                                      PyObject *const *args,
+                                                      Py_ssize_t nargs
                                                       );
 
     /**
@@ -1656,7 +1960,8 @@ typedef int             (*FP_IsUseOrFilter)(int &isUse);
                                                                                                                                                                         
         PYINVOKESPSS_API PyObject * ext_InsertCase(
                                                       PyObject *self,
-                                                      PyObject *args);
+                                                      PyObject *const *args,
+                                                      Py_ssize_t nargs);
                                                         
         PYINVOKESPSS_API PyObject * ext_DeleteCase(
                                                       PyObject *self,
@@ -1668,11 +1973,13 @@ typedef int             (*FP_IsUseOrFilter)(int &isUse);
                                                         
         PYINVOKESPSS_API PyObject * ext_GetNCellValue(
                                                       PyObject *self,
-                                                      PyObject *args);
+                                                      PyObject *const *args,
+                                                      Py_ssize_t nargs);
                                                         
         PYINVOKESPSS_API PyObject * ext_GetCCellValue(
                                                       PyObject *self,
-                                                      PyObject *args);
+                                                      PyObject *const *args,
+                                                      Py_ssize_t nargs);
                                                       
         PYINVOKESPSS_API PyObject * ext_GetCellsValue(
                                                       PyObject *self,
@@ -1680,11 +1987,13 @@ typedef int             (*FP_IsUseOrFilter)(int &isUse);
                                                         
         PYINVOKESPSS_API PyObject * ext_SetNCellValue(
                                                       PyObject *self,
-                                                      PyObject *args);
+                                                      PyObject *const *args,
+                                                      Py_ssize_t nargs);
                                                         
         PYINVOKESPSS_API PyObject * ext_SetCCellValue(
                                                       PyObject *self,
-                                                      PyObject *args);
+                                                      PyObject *const *args,
+                                                      Py_ssize_t nargs);
                                                       
         PYINVOKESPSS_API PyObject * ext_IsUTF8mode(PyObject *self,
                                                    PyObject *args);                                              
@@ -1837,7 +2146,8 @@ typedef int             (*FP_IsUseOrFilter)(int &isUse);
                                                        PyObject *args);
         PYINVOKESPSS_API PyObject * ext_GetCaseValue(
                                                         PyObject *self,
-                                                        PyObject *args);
+                                                        PyObject *const *args,
+                                                        Py_ssize_t nargs);
         PYINVOKESPSS_API PyObject * ext_SetCaseValue(
                                                         PyObject *self,
                                                         PyObject *args);
@@ -262,6 +262,98 @@ SPSSXD_API int Submit(const char* command, int length);
 */
 SPSSXD_API int QueueCommandPart(const char* line, int length);
 
+/** Run a list of IBM SPSS Statistics commands in one call. Each entry may span several lines
+    separated by new-line characters. The lines of an entry are queued as by QueueCommandPart,
+    and its last line is submitted as by Submit, so an entry may hold several commands or a
+    whole BEGIN PROGRAM - END PROGRAM block. A failing entry does not stop the batch; as with
+    Submit, the following entries still run. When a line of an entry can not be queued after
+    earlier lines of it were, nothing of the entry runs: the queued lines stay queued, as with
+    QueueCommandPart, and lead the next submitted command, so the batch stops and the entry
+    and the ones after it receive the return code of QueueCommandPart.
+  \param cmds The commands.
+  \param lens The length of each command in bytes.
+  \param n The number of commands.
+  \param perCommandErr Receives the return code of each command, as returned by Submit.
+         May be NULL.
+  \code
+     const char* cmds[] = {"get file='demo.sav'.", "frequencies\n /variables=all."};
+     int lens[] = {20, 30};
+     int errs[2];
+     int err = SubmitBatch(cmds,lens,2,errs);
+  \endcode
+  \return The largest of the return codes of the commands. \n
+          0=Success \n
+          1=Comment \n
+          2=Warning \n
+          3=Serious \n
+          4=Fatal \n
+          5=Catastrophic \n
+          17=IBM SPSS Statistics backend is not ready \n
+          98=Can't submit in data step
+*/
+SPSSXD_API int SubmitBatch(const char* const* cmds, const int* lens, int n, int* perCommandErr);
+
+/** The completion function of SubmitAsync. It is called on the backend worker thread
+    when the command of the ticket has run.
+  \param ticket The ticket returned by SubmitAsync.
+  \param errLevel The return code of the command, as returned by Submit.
+  \param userData The pointer given to SetSubmitCallback.
+*/
+typedef void (*SubmitCallback)(int ticket, int errLevel, void* userData);
+
+/** Queue a line of an IBM SPSS Statistics command, like Submit, but return without waiting
+    for it to run. The queued lines are run on a backend worker thread in the order they were
+    submitted. Use PollSubmit, WaitSubmit or SetSubmitCallback with the returned ticket to learn
+    the outcome; each ticket reports its outcome once.
+
+    While a command is running, the caller may do work that does not use the backend, for
+    example reading OMS output files. Submit and QueueCommandPart wait until the queued commands
+    have run; other XD API calls should not be made before then.
+  \param command The is the content of the line.
+  \param length The length of the line in bytes.
+  \param ticket The ticket of the queued command.
+  \code
+     int ticket = 0, errLevel = 0;
+     if( 0 == SubmitAsync("frequencies var=all.",20,ticket) ){
+        //prepare the next job here.
+        WaitSubmit(ticket,-1,errLevel);
+     }
+  \endcode
+  \return 0=The command is queued \n
+          17=IBM SPSS Statistics backend is not ready \n
+          98=Can't submit in data step
+*/
+SPSSXD_API int SubmitAsync(const char* command, int length, int& ticket);
+
+/** Report whether the command of a ticket has run, without waiting.
+  \param ticket The ticket returned by SubmitAsync.
+  \param done 1 when the command has run, otherwise 0.
+  \param errLevel The return code of the command when done is 1, as returned by Submit.
+  \return 0=No error \n
+          122=Invalid submit ticket
+*/
+SPSSXD_API int PollSubmit(int ticket, int& done, int& errLevel);
+
+/** Wait until the command of a ticket has run.
+  \param ticket The ticket returned by SubmitAsync.
+  \param timeout The longest wait in milliseconds. A negative value waits until the command has run.
+  \param errLevel The return code of the command, as returned by Submit.
+  \return 0=No error \n
+          122=Invalid submit ticket \n
+          123=The submitted command did not finish within the timeout
+*/
+SPSSXD_API int WaitSubmit(int ticket, int timeout, int& errLevel);
+
+/** Set the function that is called when the command of a ticket has run. When the command has
+    already run, the function is called before SetSubmitCallback returns.
+  \param ticket The ticket returned by SubmitAsync.
+  \param callback The completion function.
+  \param userData Passed to the completion function.
+  \return 0=No error \n
+          122=Invalid submit ticket
+*/
+SPSSXD_API int SetSubmitCallback(int ticket, SubmitCallback callback, void* userData);
+
 /** Adds a line to the IBM SPSS Statistics log. The IBM SPSS Statistics backend needs to be started before calling this function.
   \param text is the content of the line.
   \param length is the length of the line in bytes.
@@ -686,6 +778,21 @@ SPSSXD_API int GetStringValue(unsigned varIndex, char* &result, int bufferLength
 */
 SPSSXD_API int NextCase();
 
+/**   Moves the cursor to the next case, like NextCase, and returns the buffer of the case.
+      A numeric value is a double and a string value is its bytes padded with blanks to a
+      multiple of 8; each starts at 8 times the obs index of its variable (see GetVarObsIndex).
+      The buffer belongs to the backend and is valid until the cursor moves or is removed.
+      \param caseSize  The size of the case buffer in bytes.
+      \param errLevel  The return code. \n
+                       0=Success \n
+                       9=No data source \n
+                       17=IBM SPSS Statistics backend is not ready \n
+                       23=No more data
+      \sa
+          MakeCaseCursor
+      \return     The case buffer, or NULL when errLevel is not 0.
+*
+*/
 SPSSXD_API void* NextCasePtr(int &caseSize,int &errLevel);
 
 /**   Frees the storage for a case. It is an error if the cursor is not valid.
@@ -1994,6 +2101,183 @@ SPSSXD_API int GetCursorPosition(int& curPos);
                                        int cellVal,
                                        const char* ch);
 
+/**  Adds a dense block of numeric cells to the pivot table in one call. Every dimension
+     is given with its full list of string categories, and the cells are given as one
+     row-major array over those categories, where the last dimension varies fastest.
+     The cells are attached through the last dimension in the list, as SetNumberCell does.
+     Dimensions that do not exist yet are added.
+     *
+     * \param outLine   The outline title for the pivot table.
+     * \param title     The title for the pivot table.
+     * \param templateName  The OMS table subtype for the pivot table.
+     * \param isSplit   Indicates whether or not to enable split file processing for the pivot table.
+     * \param dimCount  The number of dimensions described by the following arrays.
+     * \param dimNames  The names of the dimensions.
+     * \param places    The placement of each dimension. \n
+                            0 = row \n
+                            1 = column \n
+                            2 = layer
+     * \param positions The position of each dimension. Starts from 1. The lowest number is the inner dimension.
+     * \param hideNames Specifies for each dimension whether the dimension name is hidden.
+     * \param hideLabels    Specifies for each dimension whether the dimension labels are hidden.
+     * \param categoryCounts    The number of categories of each dimension.
+     * \param categories    The string categories of all dimensions. The categoryCounts[0] categories
+                            of the first dimension come first, followed by those of the second dimension, and so on.
+     * \param cells     The cell values. The length is the product of categoryCounts.
+     * \param formatSpecs   The formatSpec of each cell, or NULL. The values are \n
+                            0 = Coefficient, 1 = CoefficientSE, 2 = CoefficientVar, 3 = Correlation, \n
+                            4 = GeneralStat, 5 = Mean, 6 = Count, 7 = Percent, 8 = PercentNoSign, \n
+                            9 = Proportion, 10 = Significance, 11 = Residual, 12 = Variable, \n
+                            13 = StdDev, 14 = Difference, 15 = Sum \n
+                            When NULL, the formatSpec set by the last SetFormatSpec... call is used for all cells.
+     * \param varIndexes    The variable index used by the Mean, Variable, StdDev, Difference and Sum
+                            formatSpecs for each cell, or NULL. It is ignored for the other formatSpecs.
+     *
+       \code
+          const char* dimNames[] = {"rowdim","coldim"};
+          int places[] = {0,1};
+          int positions[] = {1,1};
+          bool hideNames[] = {false,false};
+          bool hideLabels[] = {false,false};
+          int categoryCounts[] = {2,3};
+          const char* categories[] = {"row-1","row-2","col-1","col-2","col-3"};
+          double cells[] = {11,12,13,
+                            21,22,23};
+          int formatSpecs[] = {6,6,6,6,6,6};
+
+          StartProcedure("proc1");
+          StartPivotTable("outline","title","mytitle",false);
+          SetNumberCells("outline","title","mytitle",false,2,dimNames,places,positions,
+                         hideNames,hideLabels,categoryCounts,categories,cells,formatSpecs,NULL);
+          EndProcedure();
+       \endcode
+       \sa
+          SetNumberCell
+       \return          The return code. \n
+                        0=No error \n
+                        10=Invalid index \n
+                        17=IBM SPSS Statistics backend is not ready \n
+                        65=No procedure
+*/
+  SPSSXD_API int SetNumberCells(const char* outLine,
+                                const char* title,
+                                const char* templateName,
+                                bool isSplit,
+                                int dimCount,
+                                const char* const dimNames[],
+                                const int places[],
+                                const int positions[],
+                                const bool hideNames[],
+                                const bool hideLabels[],
+                                const int categoryCounts[],
+                                const char* const categories[],
+                                const double cells[],
+                                const int formatSpecs[],
+                                const int varIndexes[]);
+
+/**  Adds a numeric cell with its own formatSpec to the pivot table. It is the same as calling
+     the SetFormatSpec... function given by formatSpec followed by SetNumberCell, in one call.
+     The category must be added before calling this function.
+     *
+     * \param outLine   The outline title for the pivot table.
+     * \param title     The title for the pivot table.
+     * \param templateName  The OMS table subtype for the pivot table.
+     * \param isSplit   Indicates whether or not to enable split file processing for the pivot table.
+     * \param dimName   The name of the dimension.
+     * \param place     The placement of the dimension. \n
+                            0 = row \n
+                            1 = column \n
+                            2 = layer
+     * \param position  The position of the dimension. Starts from 1. The lowest number is the inner dimension.
+     * \param hideName  Specifies whether the dimension name is hidden.
+     * \param hideLabels    Specifies whether the dimension labels are hidden.
+     * \param cellVal   The cell value.
+     * \param formatSpec    The formatSpec of the value. \n
+                            0 = Coefficient, 1 = CoefficientSE, 2 = CoefficientVar, 3 = Correlation, \n
+                            4 = GeneralStat, 5 = Mean, 6 = Count, 7 = Percent, 8 = PercentNoSign, \n
+                            9 = Proportion, 10 = Significance, 11 = Residual, 12 = Variable, \n
+                            13 = StdDev, 14 = Difference, 15 = Sum
+     * \param varIndex  The variable index used by the Mean, Variable, StdDev, Difference and Sum
+                            formatSpecs. It is ignored for the other formatSpecs.
+     *
+       \code
+          StartProcedure("proc1");
+          StartPivotTable("outline","title","mytitle",false);
+          AddDimension("outline","title","mytitle",false,"rowdim",0,1,false,false);
+          AddDimension("outline","title","mytitle",false,"coldim",1,1,false,false);
+          AddStringCategory("outline","title","mytitle",false,"rowdim",0,1,false,false,"1");
+          AddStringCategory("outline","title","mytitle",false,"coldim",1,1,false,false,"count");
+          SetNumberCellWithFormat("outline","title","mytitle",false,"coldim",1,1,false,false,25,6,0);
+          AddStringCategory("outline","title","mytitle",false,"coldim",1,1,false,false,"mean");
+          SetNumberCellWithFormat("outline","title","mytitle",false,"coldim",1,1,false,false,3.25,5,2);
+          EndProcedure();
+       \endcode
+       \sa
+          SetNumberCell
+       \return          The return code. \n
+                        0=No error \n
+                        10=Invalid index \n
+                        17=IBM SPSS Statistics backend is not ready \n
+                        65=No procedure
+*/
+  SPSSXD_API int SetNumberCellWithFormat(const char* outLine,
+                                         const char* title,
+                                         const char* templateName,
+                                         bool isSplit,
+                                         const char* dimName,
+                                         int place,
+                                         int position,
+                                         bool hideName,
+                                         bool hideLabels,
+                                         double cellVal,
+                                         int formatSpec,
+                                         int varIndex);
+
+/**  Adds a numeric category with its own formatSpec to the pivot table. It is the same as calling
+     the SetFormatSpec... function given by formatSpec followed by AddNumberCategory, in one call.
+     *
+     * \param outLine   The outline title for the pivot table.
+     * \param title     The title for the pivot table.
+     * \param templateName  The OMS table subtype for the pivot table.
+     * \param isSplit   Indicates whether or not to enable split file processing for the pivot table.
+     * \param dimName   The name of the dimension.
+     * \param place     The placement of the dimension. \n
+                            0 = row \n
+                            1 = column \n
+                            2 = layer
+     * \param position  The position of the dimension. Starts from 1. The lowest number is the inner dimension.
+     * \param hideName  Specifies whether the dimension name is hidden.
+     * \param hideLabels    Specifies whether the dimension labels are hidden.
+     * \param category  The category value.
+     * \param formatSpec    The formatSpec of the value. \n
+                            0 = Coefficient, 1 = CoefficientSE, 2 = CoefficientVar, 3 = Correlation, \n
+                            4 = GeneralStat, 5 = Mean, 6 = Count, 7 = Percent, 8 = PercentNoSign, \n
+                            9 = Proportion, 10 = Significance, 11 = Residual, 12 = Variable, \n
+                            13 = StdDev, 14 = Difference, 15 = Sum
+     * \param varIndex  The variable index used by the Mean, Variable, StdDev, Difference and Sum
+                            formatSpecs. It is ignored for the other formatSpecs.
+     *
+       \sa
+          AddNumberCategory
+       \return          The return code. \n
+                        0=No error \n
+                        10=Invalid index \n
+                        17=IBM SPSS Statistics backend is not ready \n
+                        65=No procedure
+*/
+  SPSSXD_API int AddNumberCategoryWithFormat(const char* outLine,
+                                             const char* title,
+                                             const char* templateName,
+                                             bool isSplit,
+                                             const char* dimName,
+                                             int place,
+                                             int position,
+                                             bool hideName,
+                                             bool hideLabels,
+                                             double category,
+                                             int formatSpec,
+                                             int varIndex);
+
 /**  Adds footnotes to a pivot table cell which is indicated by a list of categories.
      Categories must exist prior to calling this function.
      *
@@ -2087,6 +2371,36 @@ SPSSXD_API int GetCursorPosition(int& curPos);
                                const char* line,
                                int nSkip=1);
 
+/**  Add several lines to a text block in the outline. It is the same as calling AddTextBlock
+     for each line in order, in one call.
+     *
+     * \param outLine   The outline title for the pivot table.
+     * \param name      The name for the text block.
+     * \param lines     The lines to add.
+     * \param nSkips    The number of new lines to skip before each line, or NULL to skip one new line before each.
+     * \param lineCount The number of lines.
+     *
+       \code
+          const char* lines[] = {"first line","second line","third line"};
+          int nSkips[] = {1,1,2};
+
+          StartProcedure("proc1");
+          AddTextBlockLines("outline","test",lines,nSkips,3);
+          EndProcedure();
+       \endcode
+       \sa
+          AddTextBlock
+       \return          The return code. \n
+                        0=No error \n
+                        17=IBM SPSS Statistics backend is not ready \n
+                        65=No procedure
+*/
+  SPSSXD_API int  AddTextBlockLines(const char* outLine,
+                                    const char* name,
+                                    const char* const lines[],
+                                    const int nSkips[],
+                                    int lineCount);
+
 /**  Applies a split change. Use IsEndSplit to detect the end of a split and userSplitChange to start the new split.
      *
      * \param procName  The name of the procedure.
@@ -6313,7 +6627,28 @@ SPSSXD_API int GetCursorPosition(int& curPos);
         \return A string specifying the locale of the IBM SPSS Statistics processor.
     */
     SPSSXD_API const char* GetSPSSLocale(int &errLevel);
-    
+
+    /** GetCLocaleGeneration returns a number that changes whenever the C locale of the IBM SPSS Statistics
+        processor changes, for example with SET LOCALE. A caller that keeps the locale it last applied can
+        compare the number instead of calling GetCLocale after each command.
+        \code
+            void func()
+            {
+                static int applied = -1;
+                int generation = 0;
+                if( 0 == GetCLocaleGeneration(generation) && generation != applied ){
+                    //get the locale with GetCLocale and apply it.
+                    applied = generation;
+                }
+            }
+        \endcode
+        \param generation The generation of the C locale.
+        \return The return code. \n
+                        0=Success \n
+                        17=IBM SPSS Statistics backend is not ready
+    */
+    SPSSXD_API int GetCLocaleGeneration(int &generation);
+
     /** GetOutputLanguage returns a string specifying the output language of the IBM SPSS Statistics processor.
         \code
             void func()
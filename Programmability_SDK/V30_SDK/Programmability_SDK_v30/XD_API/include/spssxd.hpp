@@ -0,0 +1,640 @@
+/************************************************************************
+** Licensed Materials - Property of IBM
+**
+** IBM SPSS Products: Statistics Common
+**
+** (C) Copyright IBM Corp. 1989, 2021
+**
+** US Government Users Restricted Rights - Use, duplication or disclosure
+** restricted by GSA ADP Schedule Contract with IBM Corp.
+************************************************************************/
+
+/**
+ * NAME
+ *     spssxd.hpp
+ *
+ * DESCRIPTION
+ *     A header-only C++17 layer over spssxd.h. A session starts and stops the
+ *     backend, a cursor makes and removes the case cursor, the cases of a cursor
+ *     can be walked with a range-based for, and typed columns are filled a batch
+ *     of cases at a time into buffers they own. A non-zero XD API return code
+ *     is thrown as spssxd::error; the try_ functions return a spssxd::result
+ *     that holds the value or the code instead.
+ *
+ *--------------------------------------------------------
+ *
+ */
+
+/** \page cpp C++ Wrapper
+
+spssxd.hpp needs a C++17 compiler and links with the same library as spssxd.h.
+
+\code
+    spssxd::session spss;
+    spss.submit("GET FILE='demo.sav'.");
+
+    //read a batch of cases at a time into typed columns.
+    spssxd::cursor cur;
+    spssxd::column<double> age(0);
+    spssxd::column<spssxd::fixed_string<8>> name(1);
+    while(cur.fetch(1024, age, name)) {
+        for(std::size_t i = 0; i < age.size(); ++i) {
+            if(!age.missing(i)) {
+                std::cout << name[i].view() << " " << age[i] << std::endl;
+            }
+        }
+    }
+
+    //or one case at a time.
+    spssxd::cursor all;
+    for(auto c : all) {
+        std::optional<double> value = c.numeric(0);
+    }
+\endcode
+
+The cursor of the XD API reads forward once, so a cursor can be iterated, or
+fetched from, until it reaches the end of the data. Only one cursor may be open
+at a time.
+*/
+
+#ifndef __SPSSXD_HPP__
+#define __SPSSXD_HPP__
+
+#if __cplusplus < 201703L && !(defined(_MSVC_LANG) && _MSVC_LANG >= 201703L)
+# error spssxd.hpp requires C++17
+#endif
+
+#include <cstddef>
+#include <cstring>
+#include <iterator>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "spssxd.h"
+
+namespace spssxd {
+
+/** XD API error codes the wrapper acts on; see spssxd.h for the full list. */
+namespace errc {
+    constexpr int invalid_index = 10;
+    constexpr int not_ready = 17;
+    constexpr int no_more_data = 23;
+    constexpr int wrong_type = 24;
+}
+
+/** The highest Submit error level that is a warning rather than an error. */
+constexpr int max_warning_level = 2;
+
+/** The error code of a failed XD API call, with the name of the call. */
+class error : public std::runtime_error {
+public:
+    explicit error(int code, const char* call = "XD API")
+        : std::runtime_error(std::string(call) + " failed with error " + std::to_string(code)),
+          errCode(code) {}
+
+    int code() const noexcept { return errCode; }
+
+private:
+    int errCode;
+};
+
+/** Throws spssxd::error when code is not 0. */
+inline void check(int code, const char* call)
+{
+    if(code != 0) {
+        throw error(code, call);
+    }
+}
+
+/** The failed state of a result, made with spssxd::fail. */
+struct failure {
+    int code;
+};
+
+inline failure fail(int code) { return failure{code}; }
+
+/** The value of a call, or the XD API error code it failed with. */
+template<class T>
+class result {
+public:
+    result(T v) : val(std::move(v)), errCode(0) {}
+    result(failure f) : errCode(f.code) {}
+
+    explicit operator bool() const noexcept { return errCode == 0; }
+    bool has_value() const noexcept { return errCode == 0; }
+    int error_code() const noexcept { return errCode; }
+
+    /** The value; throws spssxd::error if the call failed. */
+    T& value() &
+    {
+        if(errCode != 0) {
+            throw error(errCode);
+        }
+        return *val;
+    }
+    const T& value() const &
+    {
+        if(errCode != 0) {
+            throw error(errCode);
+        }
+        return *val;
+    }
+    T&& value() &&
+    {
+        if(errCode != 0) {
+            throw error(errCode);
+        }
+        return std::move(*val);
+    }
+    T value_or(T other) const { return errCode == 0 ? *val : other; }
+
+    T& operator*() { return *val; }
+    const T& operator*() const { return *val; }
+    T* operator->() { return &*val; }
+    const T* operator->() const { return &*val; }
+
+private:
+    std::optional<T> val;
+    int errCode;
+};
+
+template<>
+class result<void> {
+public:
+    result() : errCode(0) {}
+    result(failure f) : errCode(f.code) {}
+
+    explicit operator bool() const noexcept { return errCode == 0; }
+    bool has_value() const noexcept { return errCode == 0; }
+    int error_code() const noexcept { return errCode; }
+    void value() const
+    {
+        if(errCode != 0) {
+            throw error(errCode);
+        }
+    }
+
+private:
+    int errCode;
+};
+
+/** A string value of at most N bytes, padded with blanks as the backend stores it. */
+template<std::size_t N>
+struct fixed_string {
+    static constexpr std::size_t capacity = N;
+    char data[N];
+
+    /** The value without the trailing blanks. */
+    std::string_view view() const noexcept
+    {
+        std::size_t len = N;
+        while(len > 0 && (data[len - 1] == ' ' || data[len - 1] == '\0')) {
+            --len;
+        }
+        return std::string_view(data, len);
+    }
+    std::string str() const { return std::string(view()); }
+    operator std::string_view() const noexcept { return view(); }
+};
+
+/**
+ * How a column type is read from the current case. varType is the value of
+ * GetVariableType: 0 for a numeric variable, the width for a string variable.
+ */
+template<class T>
+struct column_traits;
+
+template<>
+struct column_traits<double> {
+    static bool accepts(int varType) { return varType == 0; }
+    static int read(unsigned varIndex, int, double& value, int& isMissing)
+    {
+        return GetNumericValue(varIndex, value, isMissing);
+    }
+};
+
+template<std::size_t N>
+struct column_traits<fixed_string<N>> {
+    static bool accepts(int varType) { return varType > 0 && (std::size_t)varType <= N; }
+    static int read(unsigned varIndex, int varType, fixed_string<N>& value, int& isMissing)
+    {
+        char buffer[N + 1];
+        char* p = buffer;
+        std::memset(buffer, ' ', N);
+        buffer[varType] = '\0';
+        int err = GetStringValue(varIndex, p, varType + 1, isMissing);
+        std::size_t len = std::strlen(buffer);
+        if(len < N) {
+            std::memset(buffer + len, ' ', N - len);
+        }
+        std::memcpy(value.data, buffer, N);
+        return err;
+    }
+};
+
+template<>
+struct column_traits<std::string> {
+    static bool accepts(int varType) { return varType > 0; }
+    static int read(unsigned varIndex, int varType, std::string& value, int& isMissing)
+    {
+        value.assign(varType + 1, '\0');
+        char* p = &value[0];
+        int err = GetStringValue(varIndex, p, varType + 1, isMissing);
+        value.resize(std::strlen(value.c_str()));
+        while(!value.empty() && value.back() == ' ') {
+            value.pop_back();
+        }
+        return err;
+    }
+};
+
+class cursor;
+
+/**
+ * The values of one variable for a batch of cases, filled by cursor::fetch.
+ * The buffers are kept between batches, so a fetch loop does not allocate
+ * once the first batch is read.
+ */
+template<class T>
+class column {
+public:
+    typedef T value_type;
+    typedef typename std::vector<T>::const_iterator const_iterator;
+
+    explicit column(unsigned varIndex) : var(varIndex), varType(0) {}
+
+    unsigned index() const noexcept { return var; }
+    std::size_t size() const noexcept { return values.size(); }
+    bool empty() const noexcept { return values.empty(); }
+
+    const T& operator[](std::size_t row) const { return values[row]; }
+    bool missing(std::size_t row) const { return missingFlags[row] != 0; }
+    std::optional<T> get(std::size_t row) const
+    {
+        return missingFlags[row] ? std::nullopt : std::optional<T>(values[row]);
+    }
+
+    const T* data() const noexcept { return values.data(); }
+    const_iterator begin() const { return values.begin(); }
+    const_iterator end() const { return values.end(); }
+
+private:
+    friend class cursor;
+
+    void reset(std::size_t rows, int type)
+    {
+        if(!column_traits<T>::accepts(type)) {
+            throw error(errc::wrong_type, "column");
+        }
+        varType = type;
+        values.clear();
+        missingFlags.clear();
+        values.reserve(rows);
+        missingFlags.reserve(rows);
+    }
+
+    void append()
+    {
+        int isMissing = 0;
+        values.emplace_back();
+        check(column_traits<T>::read(var, varType, values.back(), isMissing), "column");
+        missingFlags.push_back(isMissing ? 1 : 0);
+    }
+
+    unsigned var;
+    int varType;
+    std::vector<T> values;
+    std::vector<unsigned char> missingFlags;
+};
+
+/**
+ * The case cursor of the active dataset. It is made by the constructor and
+ * removed by the destructor.
+ */
+class cursor {
+public:
+    /** The current case of a cursor, as seen while iterating it. */
+    class case_ref {
+    public:
+        explicit case_ref(const cursor* c) : cur(c) {}
+
+        /** The value of a variable, empty when it is missing. */
+        template<class T>
+        std::optional<T> get(unsigned varIndex) const
+        {
+            int type = cur->type(varIndex);
+            if(!column_traits<T>::accepts(type)) {
+                throw error(errc::wrong_type, "get");
+            }
+            T value{};
+            int isMissing = 0;
+            check(column_traits<T>::read(varIndex, type, value, isMissing), "get");
+            return isMissing ? std::nullopt : std::optional<T>(std::move(value));
+        }
+
+        std::optional<double> numeric(unsigned varIndex) const { return get<double>(varIndex); }
+
+        /** A string value without the trailing blanks. */
+        std::optional<std::string> string(unsigned varIndex) const { return get<std::string>(varIndex); }
+
+    private:
+        const cursor* cur;
+    };
+
+    /** An input iterator over the remaining cases; every step moves the cursor. */
+    class iterator {
+    public:
+        typedef std::input_iterator_tag iterator_category;
+        typedef case_ref value_type;
+        typedef std::ptrdiff_t difference_type;
+        typedef const case_ref* pointer;
+        typedef case_ref reference;
+
+        iterator() : cur(nullptr) {}
+        explicit iterator(cursor* c) : cur(c) {}
+
+        case_ref operator*() const { return case_ref(cur); }
+        iterator& operator++()
+        {
+            if(!cur->next()) {
+                cur = nullptr;
+            }
+            return *this;
+        }
+        void operator++(int) { ++*this; }
+        bool operator==(const iterator& other) const { return cur == other.cur; }
+        bool operator!=(const iterator& other) const { return cur != other.cur; }
+
+    private:
+        cursor* cur;
+    };
+
+    explicit cursor(const char* accessType = "r") : open(false), atEnd(false)
+    {
+        check(MakeCaseCursor(accessType), "MakeCaseCursor");
+        open = true;
+        try {
+            loadTypes();
+        } catch(...) {
+            close();
+            throw;
+        }
+    }
+
+    ~cursor() { close(); }
+
+    cursor(const cursor&) = delete;
+    cursor& operator=(const cursor&) = delete;
+
+    cursor(cursor&& other) noexcept
+        : open(other.open), atEnd(other.atEnd), types(std::move(other.types))
+    {
+        other.open = false;
+    }
+
+    cursor& operator=(cursor&& other) noexcept
+    {
+        if(this != &other) {
+            close();
+            open = other.open;
+            atEnd = other.atEnd;
+            types = std::move(other.types);
+            other.open = false;
+        }
+        return *this;
+    }
+
+    /** Makes a cursor, or returns the error code of MakeCaseCursor. */
+    static result<cursor> try_open(const char* accessType = "r")
+    {
+        try {
+            return cursor(accessType);
+        } catch(const error& e) {
+            return fail(e.code());
+        }
+    }
+
+    void close() noexcept
+    {
+        if(open) {
+            RemoveCaseCursor();
+            open = false;
+        }
+    }
+
+    /** Moves to the next case; false at the end of the data. */
+    bool next()
+    {
+        if(atEnd) {
+            return false;
+        }
+        int err = NextCase();
+        if(err == errc::no_more_data) {
+            atEnd = true;
+            return false;
+        }
+        check(err, "NextCase");
+        return true;
+    }
+
+    /** Moves to the next case; the result holds false at the end of the data. */
+    result<bool> try_next()
+    {
+        try {
+            return next();
+        } catch(const error& e) {
+            return fail(e.code());
+        }
+    }
+
+    /**
+     * Moves to the next case and returns its buffer (see NextCasePtr), which is
+     * valid until the cursor moves; NULL at the end of the data.
+     */
+    const char* next_ptr(int& caseSize)
+    {
+        if(atEnd) {
+            return nullptr;
+        }
+        int err = 0;
+        void* buffer = NextCasePtr(caseSize, err);
+        if(err == errc::no_more_data) {
+            atEnd = true;
+            return nullptr;
+        }
+        check(err, "NextCasePtr");
+        return static_cast<const char*>(buffer);
+    }
+
+    /**
+     * Reads up to rows cases into the columns, replacing what they held, and
+     * returns the number of cases read; 0 at the end of the data. Throws
+     * spssxd::error with code errc::wrong_type if a column type does not fit its variable.
+     */
+    template<class... T>
+    std::size_t fetch(std::size_t rows, column<T>&... cols)
+    {
+        (cols.reset(rows, type(cols.index())), ...);
+        std::size_t n = 0;
+        while(n < rows && next()) {
+            (cols.append(), ...);
+            ++n;
+        }
+        return n;
+    }
+
+    /** The first step moves to the first remaining case. */
+    iterator begin() { return next() ? iterator(this) : iterator(); }
+    iterator end() { return iterator(); }
+
+    /** 0 for a numeric variable, the width for a string variable. */
+    int type(unsigned varIndex) const
+    {
+        if(varIndex >= types.size()) {
+            throw error(errc::invalid_index, "GetVariableType");
+        }
+        return types[varIndex];
+    }
+
+    std::size_t variable_count() const noexcept { return types.size(); }
+
+private:
+    void loadTypes()
+    {
+        int err = 0;
+        unsigned count = GetVariableCount(err);
+        check(err, "GetVariableCount");
+        types.resize(count);
+        for(unsigned i = 0; i < count; ++i) {
+            types[i] = GetVariableType((int)i, err);
+            check(err, "GetVariableType");
+        }
+    }
+
+    bool open;
+    bool atEnd;
+    std::vector<int> types;
+};
+
+/**
+ * A started backend. The constructor starts the backend unless it is already
+ * running, and the destructor stops it if this session started it.
+ */
+class session {
+public:
+    explicit session(const char* commandline = 0) : owner(false)
+    {
+        if(!IsBackendReady()) {
+            check(StartSpss(commandline), "StartSpss");
+            owner = true;
+        }
+    }
+
+    ~session()
+    {
+        if(owner && IsXDriven()) {
+            StopSpss();
+        }
+    }
+
+    session(const session&) = delete;
+    session& operator=(const session&) = delete;
+
+    session(session&& other) noexcept : owner(other.owner) { other.owner = false; }
+
+    /**
+     * Runs the syntax, one or more lines separated by '\n', and returns its
+     * error level. Throws spssxd::error if the level is above maxLevel, so by
+     * default comments and warnings do not throw. If a line can not be queued,
+     * nothing runs and the lines before it stay queued in the backend.
+     */
+    int submit(std::string_view syntax, int maxLevel = max_warning_level)
+    {
+        int level = run(syntax);
+        if(level > maxLevel) {
+            throw error(level, "Submit");
+        }
+        return level;
+    }
+
+    /**
+     * Runs the syntax; the result holds the error level, or fails with it when
+     * it is above maxLevel, as submit would throw.
+     */
+    result<int> try_submit(std::string_view syntax, int maxLevel = max_warning_level)
+    {
+        int level = run(syntax);
+        if(level > maxLevel) {
+            return fail(level);
+        }
+        return level;
+    }
+
+    unsigned variable_count() const
+    {
+        int err = 0;
+        unsigned count = GetVariableCount(err);
+        check(err, "GetVariableCount");
+        return count;
+    }
+
+    long row_count() const
+    {
+        int err = 0;
+        long count = GetRowCount(err);
+        check(err, "GetRowCount");
+        return count;
+    }
+
+    std::string variable_name(int index) const
+    {
+        int err = 0;
+        const char* name = GetVariableName(index, err);
+        check(err, "GetVariableName");
+        return name ? std::string(name) : std::string();
+    }
+
+    int variable_type(int index) const
+    {
+        int err = 0;
+        int type = GetVariableType(index, err);
+        check(err, "GetVariableType");
+        return type;
+    }
+
+private:
+    //queue every line but the last, and submit the last one.
+    static int run(std::string_view syntax)
+    {
+        while(!syntax.empty() && (syntax.back() == '\n' || syntax.back() == '\r')) {
+            syntax.remove_suffix(1);
+        }
+        std::size_t start = 0;
+        for(std::size_t eol = syntax.find('\n'); eol != std::string_view::npos; eol = syntax.find('\n', start)) {
+            std::string_view line = syntax.substr(start, eol - start);
+            if(!line.empty() && line.back() == '\r') {
+                line.remove_suffix(1);
+            }
+            int err = QueueCommandPart(line.data(), (int)line.size());
+            if(err != 0) {
+                //the backend can not discard the lines already queued, and submitting
+                //the last line would run part of the syntax, so stop here as the
+                //Python plug-in does for a batch entry.
+                return err;
+            }
+            start = eol + 1;
+        }
+        std::string_view last = syntax.substr(start);
+        return Submit(last.data(), (int)last.size());
+    }
+
+    bool owner;
+};
+
+} // namespace spssxd
+
+#endif
@@ -0,0 +1,304 @@
+/************************************************************************
+** Licensed Materials - Property of IBM
+**
+** IBM SPSS Products: Statistics Common
+**
+** (C) Copyright IBM Corp. 1989, 2021
+**
+** US Government Users Restricted Rights - Use, duplication or disclosure
+** restricted by GSA ADP Schedule Contract with IBM Corp.
+************************************************************************/
+
+/**
+ * NAME
+ *     spssxd_schema.hpp
+ *
+ * DESCRIPTION
+ *     Decoders generated at compile time from a fixed variable layout. A
+ *     schema lists the type of each variable it reads; a decoder checks the
+ *     live dictionary against it once, finds where each variable sits in the
+ *     case buffer (GetCaseLength/GetVarObsIndex), and then copies the case
+ *     buffers of NextCasePtr into one array per variable without looking at a
+ *     variable type again.
+ *
+ *--------------------------------------------------------
+ *
+ */
+
+/** \page schema Schema Decoders
+
+\code
+    typedef spssxd::schema<spssxd::numeric, spssxd::string<8>, spssxd::numeric> people;
+
+    spssxd::session spss;
+    spss.submit("GET FILE='demo.sav'.");
+
+    //the variables by name; by index is spssxd::decoder<people> dec({0, 3, 5}).
+    spssxd::decoder<people> dec({"age", "name", "income"});
+    people::columns cols;
+    spssxd::cursor cur;
+    while(dec.fetch(cur, 4096, cols)) {
+        const std::vector<double>& age = std::get<0>(cols);
+        const std::vector<double>& income = std::get<2>(cols);
+        for(std::size_t i = 0; i < age.size(); ++i) {
+            if(age[i] != dec.sysmis()) {
+                total += income[i];
+            }
+        }
+    }
+\endcode
+
+A numeric value is read as the double the backend stores, so a missing value
+is the system-missing value (decoder::sysmis); user-missing values are not
+applied. A string<N> variable must have a width of exactly N bytes.
+*/
+
+#ifndef __SPSSXD_SCHEMA_HPP__
+#define __SPSSXD_SCHEMA_HPP__
+
+#include <array>
+#include <cstring>
+#include <string>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+#include "spssxd.hpp"
+
+namespace spssxd {
+
+/** A numeric variable of a schema, read into a std::vector<double>. */
+struct numeric {
+    typedef double value_type;
+    static constexpr int type = 0;
+};
+
+/** A string variable of width N of a schema, read into a std::vector<fixed_string<N>>. */
+template<std::size_t N>
+struct string {
+    static_assert(N > 0, "a string variable has a width of at least 1");
+    typedef fixed_string<N> value_type;
+    static constexpr int type = (int)N;
+};
+
+/** A variable of the dictionary that does not match its field of a schema. */
+struct mismatch {
+    std::size_t field;      // the position in the schema
+    unsigned varIndex;      // the variable index in the dictionary
+    int expectedType;       // 0 for numeric, the width for a string
+    int actualType;         // -1 when the variable does not exist
+};
+
+/** The types of a fixed variable layout, in the order they are read. */
+template<class... Fields>
+class schema {
+public:
+    static constexpr std::size_t size = sizeof...(Fields);
+    static constexpr std::array<int, sizeof...(Fields)> types = {{Fields::type...}};
+
+    /** One array per field. */
+    typedef std::tuple<std::vector<typename Fields::value_type>...> columns;
+
+    typedef std::tuple<Fields...> fields;
+
+    /**
+     * Compares the active dictionary with the schema; the variables are the
+     * dictionary indexes of the fields. Returns the fields that do not match,
+     * none when the dictionary matches.
+     */
+    static std::vector<mismatch> validate(const std::array<unsigned, sizeof...(Fields)>& vars)
+    {
+        std::vector<mismatch> result;
+        int err = 0;
+        unsigned varCount = GetVariableCount(err);
+        check(err, "GetVariableCount");
+        for(std::size_t i = 0; i < size; ++i) {
+            int actual = -1;
+            if(vars[i] < varCount) {
+                actual = GetVariableType((int)vars[i], err);
+                check(err, "GetVariableType");
+            }
+            if(actual != types[i]) {
+                result.push_back(mismatch{i, vars[i], types[i], actual});
+            }
+        }
+        return result;
+    }
+};
+
+/**
+ * Reads the cases of a cursor into the columns of a schema. The constructor
+ * checks the dictionary and throws spssxd::error with code 24 if it does not
+ * match the schema (schema::validate tells which variables differ).
+ */
+template<class Schema>
+class decoder {
+public:
+    typedef typename Schema::columns columns;
+    static constexpr std::size_t size = Schema::size;
+
+    explicit decoder(const std::array<unsigned, Schema::size>& varIndexes) : vars(varIndexes)
+    {
+        init();
+    }
+
+    /** The variables by name. Throws spssxd::error with code 10 for an unknown name. */
+    explicit decoder(const std::array<const char*, Schema::size>& names)
+    {
+        int err = 0;
+        unsigned varCount = GetVariableCount(err);
+        check(err, "GetVariableCount");
+        std::size_t i = 0;
+        for(const char* name : names) {
+            unsigned index = 0;
+            for(; name && index < varCount; ++index) {
+                const char* varName = GetVariableName((int)index, err);
+                check(err, "GetVariableName");
+                if(varName && 0 == std::strcmp(varName, name)) {
+                    break;
+                }
+            }
+            if(!name || index == varCount) {
+                throw error(10, "decoder");
+            }
+            vars[i++] = index;
+        }
+        init();
+    }
+
+    /** The byte offset of each field in a case buffer. */
+    const std::array<std::size_t, Schema::size>& offsets() const noexcept { return offset; }
+
+    /** The case buffer size the layout needs, in bytes. */
+    std::size_t case_size() const noexcept { return caseSize; }
+
+    double sysmis() const noexcept { return sysmisValue; }
+
+    /**
+     * Appends one case buffer to the columns. buffer must hold at least
+     * case_size() bytes.
+     */
+    void decode(const char* buffer, columns& cols) const
+    {
+        decodeRows(buffer, caseSize, 1, cols, std::make_index_sequence<Schema::size>());
+    }
+
+    /**
+     * Reads up to rows cases of the cursor into the columns, replacing what
+     * they held, and returns the number of cases read; 0 at the end of the data.
+     * The cases are copied to one block first and each column is then filled
+     * with one strided loop.
+     */
+    std::size_t fetch(cursor& cur, std::size_t rows, columns& cols)
+    {
+        clear(cols, std::make_index_sequence<Schema::size>());
+        if(block.size() < rows * caseSize) {
+            block.resize(rows * caseSize);
+        }
+        std::size_t n = 0;
+        int bufferSize = 0;
+        for(const char* buffer; n < rows && (buffer = cur.next_ptr(bufferSize)) != nullptr; ++n) {
+            if((std::size_t)bufferSize < caseSize) {
+                throw error(24, "decoder");
+            }
+            std::memcpy(&block[n * caseSize], buffer, caseSize);
+        }
+        if(n > 0) {
+            decodeRows(block.data(), caseSize, n, cols, std::make_index_sequence<Schema::size>());
+        }
+        return n;
+    }
+
+private:
+    void init()
+    {
+        if(!Schema::validate(vars).empty()) {
+            throw error(24, "decoder");
+        }
+        check(GetSystemMissingValue(sysmisValue), "GetSystemMissingValue");
+
+        //the obs index of each variable, from the backend when it knows them,
+        //otherwise from the dictionary order.
+        int err = 0;
+        const char* dsName = GetActive(err);
+        bool known = err == 0 && dsName != nullptr;
+        if(known) {
+            GetCaseLength(dsName, err);
+            known = err == 0;
+            for(std::size_t i = 0; known && i < size; ++i) {
+                int obs = GetVarObsIndex(dsName, (int)vars[i], err);
+                known = err == 0 && obs >= 0;
+                offset[i] = (std::size_t)obs * 8;
+            }
+        }
+        if(!known) {
+            unsigned varCount = GetVariableCount(err);
+            check(err, "GetVariableCount");
+            std::vector<std::size_t> obs(varCount);
+            std::size_t nextObs = 0;
+            for(unsigned i = 0; i < varCount; ++i) {
+                obs[i] = nextObs;
+                int type = GetVariableType((int)i, err);
+                check(err, "GetVariableType");
+                nextObs += 0 == type ? 1 : (type + 7) / 8;
+            }
+            for(std::size_t i = 0; i < size; ++i) {
+                offset[i] = obs[vars[i]] * 8;
+            }
+        }
+
+        //only the bytes up to the end of the last field are copied; fetch
+        //checks that the case buffers are that long.
+        caseSize = 0;
+        for(std::size_t i = 0; i < size; ++i) {
+            std::size_t fieldEnd = offset[i] + (0 == Schema::types[i] ? 8 : (std::size_t)Schema::types[i]);
+            if(fieldEnd > caseSize) {
+                caseSize = fieldEnd;
+            }
+        }
+    }
+
+    template<std::size_t... I>
+    static void clear(columns& cols, std::index_sequence<I...>)
+    {
+        (std::get<I>(cols).clear(), ...);
+    }
+
+    template<std::size_t... I>
+    void decodeRows(const char* base, std::size_t stride, std::size_t rows,
+                    columns& cols, std::index_sequence<I...>) const
+    {
+        (readColumn(base + offset[I], stride, rows, std::get<I>(cols)), ...);
+    }
+
+    static void readColumn(const char* src, std::size_t stride, std::size_t rows, std::vector<double>& out)
+    {
+        std::size_t first = out.size();
+        out.resize(first + rows);
+        double* dst = out.data() + first;
+        for(std::size_t r = 0; r < rows; ++r) {
+            std::memcpy(dst + r, src + r * stride, sizeof(double));
+        }
+    }
+
+    template<std::size_t N>
+    static void readColumn(const char* src, std::size_t stride, std::size_t rows, std::vector<fixed_string<N>>& out)
+    {
+        std::size_t first = out.size();
+        out.resize(first + rows);
+        fixed_string<N>* dst = out.data() + first;
+        for(std::size_t r = 0; r < rows; ++r) {
+            std::memcpy(dst[r].data, src + r * stride, N);
+        }
+    }
+
+    std::array<unsigned, Schema::size> vars;
+    std::array<std::size_t, Schema::size> offset;
+    std::size_t caseSize;
+    double sysmisValue;
+    std::vector<char> block;
+};
+
+} // namespace spssxd
+
+#endif
@@ -0,0 +1,171 @@
+/************************************************************************
+** Licensed Materials - Property of IBM
+**
+** IBM SPSS Products: Statistics Common
+**
+** (C) Copyright IBM Corp. 1989, 2021
+**
+** US Government Users Restricted Rights - Use, duplication or disclosure
+** restricted by GSA ADP Schedule Contract with IBM Corp.
+************************************************************************/
+
+/**
+ * poolclient.cpp -
+ *     an example client of spsspool. It leases a backend, submits each command,
+ *     reads the active file with a cursor and releases the backend. -repeat runs
+ *     the whole job several times and reports how long each lease took.
+ *
+ * USAGE
+ *     poolclient [-socket path] [-repeat n] command...
+ */
+
+#include <string>
+#include <vector>
+#include <iostream>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/time.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+static double Now()
+{
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+    return tv.tv_sec + tv.tv_usec / 1e6;
+}
+
+//a leased backend of spsspool.
+class PoolSession {
+public:
+    PoolSession() : in(NULL), out(NULL) {}
+    ~PoolSession() { Release(); }
+
+    //connect and wait for a backend. returns its pid, or -1.
+    int Lease(const std::string& path)
+    {
+        struct sockaddr_un address;
+        int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+        if(fd < 0 || path.size() >= sizeof(address.sun_path)) {
+            return -1;
+        }
+        memset(&address, 0, sizeof(address));
+        address.sun_family = AF_UNIX;
+        strcpy(address.sun_path, path.c_str());
+        if(connect(fd, (struct sockaddr*)&address, sizeof(address)) != 0) {
+            close(fd);
+            return -1;
+        }
+        in = fdopen(fd, "r");
+        out = fdopen(dup(fd), "w");
+        std::string reply = ReadLine();
+        int pid = -1;
+        if(sscanf(reply.c_str(), "LEASE %d", &pid) != 1) {
+            return -1;
+        }
+        return pid;
+    }
+
+    //send one request and return the reply line.
+    std::string Request(const std::string& request)
+    {
+        fprintf(out, "%s\n", request.c_str());
+        fflush(out);
+        return ReadLine();
+    }
+
+    int Submit(const std::string& syntax)
+    {
+        fprintf(out, "SUBMIT %d\n", (int)syntax.length());
+        fwrite(syntax.data(), 1, syntax.length(), out);
+        fflush(out);
+        return atoi(ReadLine().c_str());
+    }
+
+    void Release()
+    {
+        if(out) {
+            Request("RELEASE");
+            fclose(out);
+            out = NULL;
+        }
+        if(in) {
+            fclose(in);
+            in = NULL;
+        }
+    }
+
+private:
+    std::string ReadLine()
+    {
+        char line[4096];
+        if(NULL == in || NULL == fgets(line, sizeof(line), in)) {
+            return "";
+        }
+        line[strcspn(line, "\r\n")] = '\0';
+        return line;
+    }
+
+    FILE* in;
+    FILE* out;
+};
+
+int main(int argc, char* argv[])
+{
+    std::string path = "/tmp/spsspool.sock";
+    int repeat = 1;
+    std::vector<std::string> commands;
+    for(int i = 1; i < argc; i++) {
+        if(0 == strcmp(argv[i], "-socket") && i + 1 < argc) {
+            path = argv[++i];
+        } else if(0 == strcmp(argv[i], "-repeat") && i + 1 < argc) {
+            repeat = atoi(argv[++i]);
+        } else {
+            commands.push_back(argv[i]);
+        }
+    }
+
+    for(int run = 0; run < repeat; run++) {
+        double start = Now();
+        PoolSession session;
+        int pid = session.Lease(path);
+        if(pid < 0) {
+            std::cout << "Cannot lease a backend from " << path << std::endl;
+            return 1;
+        }
+        double leased = Now();
+
+        for(size_t i = 0; i < commands.size(); i++) {
+            int err = session.Submit(commands[i]);
+            if(err != 0) {
+                std::cout << "Submit failure! error level = " << err << ": " << commands[i] << std::endl;
+            }
+        }
+        int err = 0, varCount = 0, rowCount = 0;
+        sscanf(session.Request("VARCOUNT").c_str(), "%d %d", &err, &varCount);
+        sscanf(session.Request("ROWCOUNT").c_str(), "%d %d", &err, &rowCount);
+        double sum = 0.0;
+        if(varCount > 0 && 0 == atoi(session.Request("CURSOR r").c_str())) {
+            while(0 == atoi(session.Request("NEXT").c_str())) {
+                for(int v = 0; v < varCount; v++) {
+                    int isMissing = 0;
+                    double value = 0.0;
+                    char request[32];
+                    sprintf(request, "NUM %d", v);
+                    if(sscanf(session.Request(request).c_str(), "%d %d %lf", &err, &isMissing, &value) == 3 &&
+                       0 == err && !isMissing) {
+                        sum += value;
+                    }
+                }
+            }
+            session.Request("CLOSE");
+        }
+        session.Release();
+
+        printf("run %d: backend %d, lease wait %.3f s, job %.3f s, %d variables, %d cases, sum %g\n",
+               run + 1, pid, leased - start, Now() - leased, varCount, rowCount, sum);
+    }
+    return 0;
+}
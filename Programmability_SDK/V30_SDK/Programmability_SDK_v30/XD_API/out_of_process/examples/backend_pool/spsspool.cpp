@@ -0,0 +1,611 @@
+/************************************************************************
+** Licensed Materials - Property of IBM
+**
+** IBM SPSS Products: Statistics Common
+**
+** (C) Copyright IBM Corp. 1989, 2021
+**
+** US Government Users Restricted Rights - Use, duplication or disclosure
+** restricted by GSA ADP Schedule Contract with IBM Corp.
+************************************************************************/
+
+/**
+ * spsspool.cpp -
+ *     keeps started IBM SPSS Statistics backends and leases them to clients
+ *     over a Unix domain socket, so short jobs do not pay for StartSpss.
+ *
+ *     Each backend runs in its own worker process, which loads spssxd_p
+ *     dynamically after the fork and calls StartSpss once. The daemon accepts
+ *     the clients and hands each connection to an idle worker. Workers that
+ *     stay idle longer than -idle seconds are stopped while more than -warm
+ *     are running, and idle workers are checked with IsBackendReady every
+ *     -check seconds. See spsspool.h for the client protocol.
+ *
+ * USAGE
+ *     spsspool [-socket path] [-size n] [-warm n] [-idle seconds] [-check seconds]
+ *              [-lib path] [-cmdline "StartSpss command line"] [-reset syntax]...
+ */
+
+#include <string>
+#include <vector>
+#include <deque>
+#include <algorithm>
+#include <iostream>
+#include <stdio.h>
+#include <stdarg.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <errno.h>
+#include <signal.h>
+#include <unistd.h>
+#include <poll.h>
+#include <dlfcn.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+
+#include "spsspool.h"
+
+#ifdef __MACOSX__
+  #define LIBNAME      "libspssxd_p.dylib"
+#else
+  #define LIBNAME      "libspssxd_p.so"
+#endif
+
+struct PoolOptions {
+    std::string socketPath;
+    std::string libPath;
+    std::string commandLine;
+    int size;                           // most backends started at once
+    int warm;                           // backends kept started while idle
+    int idleSeconds;
+    int checkSeconds;
+    std::vector<std::string> reset;     // syntax submitted after each lease
+};
+
+static PoolOptions options;
+static volatile sig_atomic_t stopping = 0;
+
+static void Log(const char* format, ...)
+{
+    char stamp[32];
+    time_t now = time(NULL);
+    strftime(stamp, sizeof(stamp), "%H:%M:%S", localtime(&now));
+    printf("%s [%d] ", stamp, (int)getpid());
+    va_list args;
+    va_start(args, format);
+    vprintf(format, args);
+    va_end(args);
+    printf("\n");
+    fflush(stdout);
+}
+
+//send a one byte message, with a descriptor attached when fd >= 0.
+static bool SendMessage(int channel, char message, int fd = -1)
+{
+    struct msghdr msg;
+    struct iovec iov;
+    char control[CMSG_SPACE(sizeof(int))];
+    memset(&msg, 0, sizeof(msg));
+    iov.iov_base = &message;
+    iov.iov_len = 1;
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    if(fd >= 0) {
+        memset(control, 0, sizeof(control));
+        msg.msg_control = control;
+        msg.msg_controllen = sizeof(control);
+        struct cmsghdr* cmsg = CMSG_FIRSTHDR(&msg);
+        cmsg->cmsg_level = SOL_SOCKET;
+        cmsg->cmsg_type = SCM_RIGHTS;
+        cmsg->cmsg_len = CMSG_LEN(sizeof(int));
+        memcpy(CMSG_DATA(cmsg), &fd, sizeof(int));
+    }
+    return sendmsg(channel, &msg, 0) == 1;
+}
+
+//receive a one byte message and the attached descriptor, if any.
+//returns false when the other process has gone.
+static bool ReceiveMessage(int channel, char& message, int& fd)
+{
+    struct msghdr msg;
+    struct iovec iov;
+    char control[CMSG_SPACE(sizeof(int))];
+    memset(&msg, 0, sizeof(msg));
+    iov.iov_base = &message;
+    iov.iov_len = 1;
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = control;
+    msg.msg_controllen = sizeof(control);
+    fd = -1;
+    ssize_t n;
+    while((n = recvmsg(channel, &msg, 0)) < 0 && errno == EINTR) {
+    }
+    if(n <= 0) {
+        return false;
+    }
+    struct cmsghdr* cmsg = CMSG_FIRSTHDR(&msg);
+    if(cmsg && cmsg->cmsg_level == SOL_SOCKET && cmsg->cmsg_type == SCM_RIGHTS) {
+        memcpy(&fd, CMSG_DATA(cmsg), sizeof(int));
+    }
+    return true;
+}
+
+/*
+ * The worker process.
+ */
+
+static FP_IsBackendReady     IsBackendReady = NULL;
+static FP_StartSpss          StartSpss = NULL;
+static FP_StopSpss           StopSpss = NULL;
+static FP_Submit             Submit = NULL;
+static FP_GetVariableCount   GetVariableCount = NULL;
+static FP_GetRowCount        GetRowCount = NULL;
+static FP_GetVariableName    GetVariableName = NULL;
+static FP_MakeCaseCursor     MakeCaseCursor = NULL;
+static FP_NextCase           NextCase = NULL;
+static FP_GetNumericValue    GetNumericValue = NULL;
+static FP_GetStringValue     GetStringValue = NULL;
+static FP_HasCursor          HasCursor = NULL;
+static FP_RemoveCaseCursor   RemoveCaseCursor = NULL;
+
+//load spssxd_p. -lib, then SPSS_HOME/lib, then the library search path.
+static bool LoadLib()
+{
+    std::string libPath = options.libPath;
+    if(libPath.empty()) {
+        const char* spssHome = getenv("SPSS_HOME");
+        libPath = spssHome ? std::string(spssHome) + "/lib/" + LIBNAME : LIBNAME;
+    }
+    void* pLib = dlopen(libPath.c_str(), RTLD_NOW | RTLD_GLOBAL);
+    if(NULL == pLib) {
+        Log("dlopen fails with error: %s", dlerror());
+        return false;
+    }
+    IsBackendReady = (FP_IsBackendReady)dlsym(pLib, "IsBackendReady");
+    StartSpss = (FP_StartSpss)dlsym(pLib, "StartSpss");
+    StopSpss = (FP_StopSpss)dlsym(pLib, "StopSpss");
+    Submit = (FP_Submit)dlsym(pLib, "Submit");
+    GetVariableCount = (FP_GetVariableCount)dlsym(pLib, "GetVariableCount");
+    GetRowCount = (FP_GetRowCount)dlsym(pLib, "GetRowCount");
+    GetVariableName = (FP_GetVariableName)dlsym(pLib, "GetVariableName");
+    MakeCaseCursor = (FP_MakeCaseCursor)dlsym(pLib, "MakeCaseCursor");
+    NextCase = (FP_NextCase)dlsym(pLib, "NextCase");
+    GetNumericValue = (FP_GetNumericValue)dlsym(pLib, "GetNumericValue");
+    GetStringValue = (FP_GetStringValue)dlsym(pLib, "GetStringValue");
+    HasCursor = (FP_HasCursor)dlsym(pLib, "HasCursor");
+    RemoveCaseCursor = (FP_RemoveCaseCursor)dlsym(pLib, "RemoveCaseCursor");
+    if(!IsBackendReady || !StartSpss || !StopSpss || !Submit || !GetVariableCount || !GetRowCount ||
+       !GetVariableName || !MakeCaseCursor || !NextCase || !GetNumericValue || !GetStringValue ||
+       !HasCursor || !RemoveCaseCursor) {
+        Log("%s does not export the XD API", libPath.c_str());
+        return false;
+    }
+    return true;
+}
+
+//answer the requests of one client until RELEASE or until it disconnects.
+static void ServeClient(int client)
+{
+    FILE* in = fdopen(client, "r");
+    FILE* out = fdopen(dup(client), "w");
+    if(NULL == in || NULL == out) {
+        if(in) fclose(in); else close(client);
+        if(out) fclose(out);
+        return;
+    }
+    fprintf(out, "LEASE %d\n", (int)getpid());
+    fflush(out);
+
+    char line[1024];
+    while(fgets(line, sizeof(line), in)) {
+        line[strcspn(line, "\r\n")] = '\0';
+        char request[16] = "";
+        int first = 0, second = 0;
+        int args = sscanf(line, "%15s %d %d", request, &first, &second);
+        int err = 0;
+
+        if(0 == strcmp(request, "SUBMIT") && args >= 2 && first >= 0) {
+            std::string syntax(first, '\0');
+            if(first > 0 && fread(&syntax[0], 1, first, in) != (size_t)first) {
+                break;
+            }
+            fprintf(out, "%d\n", Submit(syntax.c_str(), first));
+        } else if(0 == strcmp(request, "READY")) {
+            fprintf(out, "0 %d\n", IsBackendReady() ? 1 : 0);
+        } else if(0 == strcmp(request, "VARCOUNT")) {
+            unsigned count = GetVariableCount(err);
+            fprintf(out, "%d %u\n", err, count);
+        } else if(0 == strcmp(request, "ROWCOUNT")) {
+            long count = GetRowCount(err);
+            fprintf(out, "%d %ld\n", err, count);
+        } else if(0 == strcmp(request, "VARNAME") && args >= 2) {
+            const char* name = GetVariableName(first, err);
+            fprintf(out, "%d %s\n", err, name ? name : "");
+        } else if(0 == strcmp(request, "CURSOR")) {
+            char accessType[8] = "r";
+            sscanf(line, "%*s %7s", accessType);
+            fprintf(out, "%d\n", MakeCaseCursor(accessType));
+        } else if(0 == strcmp(request, "NEXT")) {
+            fprintf(out, "%d\n", NextCase());
+        } else if(0 == strcmp(request, "NUM") && args >= 2) {
+            double value = 0.0;
+            int isMissing = 0;
+            err = GetNumericValue(first, value, isMissing);
+            fprintf(out, "%d %d %.17g\n", err, isMissing, value);
+        } else if(0 == strcmp(request, "STR") && args >= 3 && second >= 0) {
+            std::vector<char> buffer(second + 1, '\0');
+            char* value = &buffer[0];
+            int isMissing = 0;
+            err = GetStringValue(first, value, second + 1, isMissing);
+            fprintf(out, "%d %d %s\n", err, isMissing, value ? value : "");
+        } else if(0 == strcmp(request, "CLOSE")) {
+            fprintf(out, "%d\n", RemoveCaseCursor());
+        } else if(0 == strcmp(request, "RELEASE")) {
+            fprintf(out, "0\n");
+            fflush(out);
+            break;
+        } else {
+            fprintf(out, "-1 unknown request\n");
+        }
+        fflush(out);
+    }
+    fclose(in);
+    fclose(out);
+}
+
+//make the backend ready for the next client. returns IsBackendReady.
+static bool ResetBackend()
+{
+    int hasCursor = 0;
+    if(0 == HasCursor(hasCursor) && hasCursor) {
+        RemoveCaseCursor();
+    }
+    for(size_t i = 0; i < options.reset.size(); i++) {
+        // an error, such as OMSEND without an active OMS request, is not a failure of the backend.
+        Submit(options.reset[i].c_str(), (int)options.reset[i].length());
+    }
+    return IsBackendReady();
+}
+
+static void WorkerMain(int channel)
+{
+    signal(SIGINT, SIG_IGN);
+    signal(SIGTERM, SIG_DFL);
+    if(!LoadLib()) {
+        SendMessage(channel, POOL_FAILED);
+        _exit(1);
+    }
+    int err = StartSpss(options.commandLine.c_str());
+    if(err != 0) {
+        Log("Start IBM SPSS Statistics failure! error level = %d", err);
+        SendMessage(channel, POOL_FAILED);
+        _exit(1);
+    }
+    SendMessage(channel, POOL_STARTED);
+
+    char message;
+    int client;
+    while(ReceiveMessage(channel, message, client)) {
+        if(POOL_LEASE == message && client >= 0) {
+            ServeClient(client);
+            if(!ResetBackend()) {
+                SendMessage(channel, POOL_UNHEALTHY);
+                break;
+            }
+            SendMessage(channel, POOL_DONE);
+        } else if(POOL_CHECK == message) {
+            if(!IsBackendReady()) {
+                SendMessage(channel, POOL_UNHEALTHY);
+                break;
+            }
+            SendMessage(channel, POOL_HEALTHY);
+        } else if(POOL_QUIT == message) {
+            break;
+        } else if(client >= 0) {
+            close(client);
+        }
+    }
+    StopSpss();
+    _exit(0);
+}
+
+/*
+ * The daemon.
+ */
+
+enum WorkerState { W_STARTING, W_IDLE, W_LEASED, W_CHECKING, W_QUITTING };
+
+struct Worker {
+    pid_t       pid;
+    int         channel;
+    WorkerState state;
+    time_t      idleSince;
+    time_t      checkedAt;
+};
+
+static std::vector<Worker> workers;
+static std::deque<int> waitingClients;
+static int listenSocket = -1;
+
+static bool SpawnWorker()
+{
+    int channels[2];
+    if(socketpair(AF_UNIX, SOCK_DGRAM, 0, channels) != 0) {
+        Log("socketpair fails: %s", strerror(errno));
+        return false;
+    }
+    pid_t pid = fork();
+    if(pid < 0) {
+        Log("fork fails: %s", strerror(errno));
+        close(channels[0]);
+        close(channels[1]);
+        return false;
+    }
+    if(0 == pid) {
+        close(listenSocket);
+        close(channels[0]);
+        for(size_t i = 0; i < workers.size(); i++) {
+            close(workers[i].channel);
+        }
+        for(size_t i = 0; i < waitingClients.size(); i++) {
+            close(waitingClients[i]);
+        }
+        WorkerMain(channels[1]);
+    }
+    close(channels[1]);
+    Worker worker = {pid, channels[0], W_STARTING, time(NULL), time(NULL)};
+    workers.push_back(worker);
+    return true;
+}
+
+static void RemoveWorker(size_t index)
+{
+    close(workers[index].channel);
+    workers.erase(workers.begin() + index);
+}
+
+static int CountWorkers(WorkerState state)
+{
+    int count = 0;
+    for(size_t i = 0; i < workers.size(); i++) {
+        count += workers[i].state == state;
+    }
+    return count;
+}
+
+static int OpenSocket(const std::string& path)
+{
+    struct sockaddr_un address;
+    if(path.size() >= sizeof(address.sun_path)) {
+        Log("socket path is too long: %s", path.c_str());
+        return -1;
+    }
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if(fd < 0) {
+        Log("socket fails: %s", strerror(errno));
+        return -1;
+    }
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    strcpy(address.sun_path, path.c_str());
+    unlink(path.c_str());
+    if(bind(fd, (struct sockaddr*)&address, sizeof(address)) != 0 || listen(fd, 64) != 0) {
+        Log("cannot listen on %s: %s", path.c_str(), strerror(errno));
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+static void OnSignal(int)
+{
+    stopping = 1;
+}
+
+//handle one message of a worker. returns false when the worker has gone.
+static bool HandleWorker(Worker& worker, int& startFailures)
+{
+    char message;
+    int fd;
+    if(!ReceiveMessage(worker.channel, message, fd)) {
+        return false;
+    }
+    if(fd >= 0) {
+        close(fd);
+    }
+    time_t now = time(NULL);
+    switch(message) {
+    case POOL_STARTED:
+        Log("backend %d started", (int)worker.pid);
+        startFailures = 0;
+        worker.state = W_IDLE;
+        worker.idleSince = worker.checkedAt = now;
+        break;
+    case POOL_DONE:
+        worker.state = W_IDLE;
+        worker.idleSince = worker.checkedAt = now;
+        break;
+    case POOL_HEALTHY:
+        worker.state = W_IDLE;
+        worker.checkedAt = now;
+        break;
+    case POOL_FAILED:
+        startFailures++;
+        return false;
+    case POOL_UNHEALTHY:
+        Log("backend %d is not ready, replacing it", (int)worker.pid);
+        return false;
+    }
+    return true;
+}
+
+static void RunPool()
+{
+    int startFailures = 0;
+    while(!stopping) {
+        time_t now = time(NULL);
+
+        // keep -warm backends started, and start more while clients wait, up to -size.
+        // a backend being checked is about to be free as well.
+        int starting = CountWorkers(W_STARTING) + CountWorkers(W_CHECKING);
+        while((int)workers.size() < options.size &&
+              ((int)workers.size() < options.warm || (int)waitingClients.size() > starting)) {
+            if(startFailures >= 3) {
+                Log("StartSpss failed %d times in a row, giving up", startFailures);
+                return;
+            }
+            if(!SpawnWorker()) {
+                break;
+            }
+            starting++;
+        }
+
+        // lease idle backends to waiting clients.
+        for(size_t i = 0; i < workers.size() && !waitingClients.empty(); i++) {
+            if(W_IDLE == workers[i].state) {
+                int client = waitingClients.front();
+                waitingClients.pop_front();
+                if(SendMessage(workers[i].channel, POOL_LEASE, client)) {
+                    workers[i].state = W_LEASED;
+                }
+                close(client);
+            }
+        }
+
+        // evict backends idle too long, and check the others.
+        for(size_t i = 0; i < workers.size(); i++) {
+            Worker& worker = workers[i];
+            if(W_CHECKING == worker.state && now - worker.checkedAt >= std::max(options.checkSeconds, 10)) {
+                Log("backend %d does not answer, killing it", (int)worker.pid);
+                kill(worker.pid, SIGKILL);
+                worker.state = W_QUITTING;
+                continue;
+            }
+            if(W_IDLE != worker.state) {
+                continue;
+            }
+            if(options.idleSeconds > 0 && now - worker.idleSince >= options.idleSeconds &&
+               (int)workers.size() - CountWorkers(W_QUITTING) > options.warm) {
+                Log("backend %d idle for %ld seconds, stopping it", (int)worker.pid, (long)(now - worker.idleSince));
+                SendMessage(worker.channel, POOL_QUIT);
+                worker.state = W_QUITTING;
+            } else if(options.checkSeconds > 0 && now - worker.checkedAt >= options.checkSeconds) {
+                SendMessage(worker.channel, POOL_CHECK);
+                worker.state = W_CHECKING;
+                worker.checkedAt = now;
+            }
+        }
+
+        std::vector<struct pollfd> fds(1 + workers.size());
+        fds[0].fd = listenSocket;
+        fds[0].events = POLLIN;
+        for(size_t i = 0; i < workers.size(); i++) {
+            fds[i + 1].fd = workers[i].channel;
+            fds[i + 1].events = POLLIN;
+        }
+        if(poll(&fds[0], fds.size(), 1000) < 0 && errno != EINTR) {
+            Log("poll fails: %s", strerror(errno));
+            return;
+        }
+
+        if(fds[0].revents & POLLIN) {
+            int client = accept(listenSocket, NULL, NULL);
+            if(client >= 0) {
+                waitingClients.push_back(client);
+            }
+        }
+        for(size_t i = workers.size(); i > 0; i--) {
+            if(fds[i].revents && !HandleWorker(workers[i - 1], startFailures)) {
+                RemoveWorker(i - 1);
+            }
+        }
+        while(waitpid(-1, NULL, WNOHANG) > 0) {
+        }
+    }
+}
+
+static void Usage()
+{
+    std::cout << "usage: spsspool [-socket path] [-size n] [-warm n] [-idle seconds] [-check seconds]" << std::endl
+              << "                [-lib path] [-cmdline \"StartSpss command line\"] [-reset syntax]..." << std::endl;
+}
+
+int main(int argc, char* argv[])
+{
+    options.socketPath = "/tmp/spsspool.sock";
+    options.size = 4;
+    options.warm = 1;
+    options.idleSeconds = 600;
+    options.checkSeconds = 60;
+    bool defaultReset = true;
+    for(int i = 1; i < argc; i++) {
+        std::string option(argv[i]);
+        if(i + 1 >= argc) {
+            Usage();
+            return 1;
+        }
+        const char* value = argv[++i];
+        if(option == "-socket") {
+            options.socketPath = value;
+        } else if(option == "-size") {
+            options.size = atoi(value);
+        } else if(option == "-warm") {
+            options.warm = atoi(value);
+        } else if(option == "-idle") {
+            options.idleSeconds = atoi(value);
+        } else if(option == "-check") {
+            options.checkSeconds = atoi(value);
+        } else if(option == "-lib") {
+            options.libPath = value;
+        } else if(option == "-cmdline") {
+            options.commandLine = value;
+        } else if(option == "-reset") {
+            // -reset "" turns the reset off.
+            defaultReset = false;
+            if(*value) {
+                options.reset.push_back(value);
+            }
+        } else {
+            Usage();
+            return 1;
+        }
+    }
+    if(options.size < 1 || options.warm < 0 || options.warm > options.size) {
+        Usage();
+        return 1;
+    }
+    if(defaultReset) {
+        options.reset.push_back("DATASET CLOSE ALL.");
+        options.reset.push_back("NEW FILE.");
+        options.reset.push_back("OMSEND.");
+    }
+
+    listenSocket = OpenSocket(options.socketPath);
+    if(listenSocket < 0) {
+        return 1;
+    }
+    signal(SIGPIPE, SIG_IGN);
+    signal(SIGINT, OnSignal);
+    signal(SIGTERM, OnSignal);
+    Log("listening on %s, size %d, warm %d", options.socketPath.c_str(), options.size, options.warm);
+
+    RunPool();
+    Log("stopping %d backends", (int)workers.size());
+
+    for(size_t i = 0; i < workers.size(); i++) {
+        SendMessage(workers[i].channel, POOL_QUIT);
+        close(workers[i].channel);
+    }
+    for(size_t i = 0; i < waitingClients.size(); i++) {
+        close(waitingClients[i]);
+    }
+    while(wait(NULL) > 0) {
+    }
+    close(listenSocket);
+    unlink(options.socketPath.c_str());
+    return stopping ? 0 : 1;
+}
@@ -0,0 +1,73 @@
+/************************************************************************
+** Licensed Materials - Property of IBM
+**
+** IBM SPSS Products: Statistics Common
+**
+** (C) Copyright IBM Corp. 1989, 2021
+**
+** US Government Users Restricted Rights - Use, duplication or disclosure
+** restricted by GSA ADP Schedule Contract with IBM Corp.
+************************************************************************/
+
+/**
+ * spsspool.h -
+ *     a pool of started IBM SPSS Statistics backends, leased to clients
+ *     over a Unix domain socket.
+ *
+ * PROTOCOL
+ *     A client connects to the socket of spsspool. When a backend is free the
+ *     daemon answers with the line
+ *         LEASE <pid>
+ *     and the client owns that backend until it sends RELEASE or closes the
+ *     connection. Each request is one line, each reply is one line that starts
+ *     with the error level of the XD API call:
+ *         SUBMIT <length>\n<length bytes of syntax>  ->  <err>
+ *         READY                                      ->  0 <1|0>
+ *         VARCOUNT                                   ->  <err> <count>
+ *         ROWCOUNT                                   ->  <err> <count>
+ *         VARNAME <index>                            ->  <err> <name>
+ *         CURSOR <accessType>                        ->  <err>
+ *         NEXT                                       ->  <err>
+ *         NUM <index>                                ->  <err> <isMissing> <value>
+ *         STR <index> <width>                        ->  <err> <isMissing> <value>
+ *         CLOSE                                      ->  <err>
+ *         RELEASE                                    ->  0
+ *     An unknown request is answered with "-1 unknown request".
+ *     After a lease the backend is reset with the -reset syntax, any cursor is
+ *     closed, and it is checked with IsBackendReady before the next lease.
+ */
+
+#ifndef _SPSSPOOL_H_
+#define _SPSSPOOL_H_
+
+/**
+ *typedef function object.
+ */
+typedef bool                  (*FP_IsBackendReady)();
+typedef int                   (*FP_StartSpss)(const char* commandline);
+typedef void                  (*FP_StopSpss)();
+typedef int                   (*FP_Submit)(const char* command, int length);
+typedef unsigned              (*FP_GetVariableCount)(int& errCode);
+typedef long                  (*FP_GetRowCount)(int& errCode);
+typedef const char*           (*FP_GetVariableName)(int index,int& errCode);
+typedef int                   (*FP_MakeCaseCursor)(const char *accessType);
+typedef int                   (*FP_NextCase)();
+typedef int                   (*FP_GetNumericValue)(unsigned varindex, double &result, int &isMissing);
+typedef int                   (*FP_GetStringValue)(unsigned varindex, char* &result, int bufferLength, int &isMissing);
+typedef int                   (*FP_HasCursor)(int &hasCur);
+typedef int                   (*FP_RemoveCaseCursor)();
+
+/**
+ * messages between the daemon and a worker process, one byte each.
+ * A lease message carries the client socket.
+ */
+const char POOL_STARTED    = 'S';     // worker: the backend is started
+const char POOL_FAILED     = 'F';     // worker: StartSpss failed
+const char POOL_LEASE      = 'L';     // daemon: serve the attached client
+const char POOL_DONE       = 'D';     // worker: the lease is over, the backend is reset
+const char POOL_CHECK      = 'C';     // daemon: report IsBackendReady
+const char POOL_HEALTHY    = 'H';     // worker: IsBackendReady is true
+const char POOL_UNHEALTHY  = 'U';     // worker: IsBackendReady is false, the worker exits
+const char POOL_QUIT       = 'Q';     // daemon: stop the backend and exit
+
+#endif
@@ -0,0 +1,759 @@
+/************************************************************************
+** Licensed Materials - Property of IBM
+**
+** IBM SPSS Products: Statistics Common
+**
+** (C) Copyright IBM Corp. 1989, 2021
+**
+** US Government Users Restricted Rights - Use, duplication or disclosure
+** restricted by GSA ADP Schedule Contract with IBM Corp.
+************************************************************************/
+
+/**
+ * xdbench.cpp -
+ *     times the hot paths of the XD API and writes the results as JSON, to
+ *     track them from one build or backend to the next.
+ *
+ *     For each shape of data (narrow or wide, numeric, string or mixed) it
+ *     builds a dataset in a data step and times
+ *         insert_case           InsertCase and Set[N|C]CellValue for each variable
+ *         cursor_get_value      NextCase and Get[Numeric|String]Value for each variable
+ *         cursor_next_case_ptr  NextCasePtr, decoding each value from the case buffer
+ *         datastep_get_cell     Get[N|C]CellValue for each cell
+ *         datastep_set_cell     Set[N|C]CellValue for each cell
+ *     and, once, the emission of the cells of a pivot table (pivot_cells) and
+ *     the latency of Submit for a command that does no work (submit_latency).
+ *
+ *     spssxd_p is loaded dynamically, so the same program runs against an
+ *     installation of IBM SPSS Statistics or against the reference backend of
+ *     XD_API/reference. A benchmark whose functions the library does not
+ *     export is reported as skipped.
+ *
+ *     Each benchmark runs -repeat times; seconds is the fastest run, which the
+ *     rates are computed from, and median_seconds the median. bytes counts the
+ *     values as the backend stores them: 8 bytes for a number, the width for
+ *     a string.
+ *
+ * USAGE
+ *     xdbench [-lib path] [-cmdline "StartSpss command line"] [-cases n]
+ *             [-cells n] [-submits n] [-repeat n] [-only name] [-out file.json]
+ */
+
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <iostream>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <dlfcn.h>
+#include <sys/utsname.h>
+
+#include "spssxd.h"
+
+#ifdef __MACOSX__
+  #define LIBNAME      "libspssxd_p.dylib"
+#else
+  #define LIBNAME      "libspssxd_p.so"
+#endif
+
+//the functions xdbench calls, as pointers into the loaded library.
+#define XD_FUNCTIONS(X) \
+    X(IsBackendReady) X(StartSpss) X(StopSpss) X(Submit) \
+    X(MakeCaseCursor) X(NextCase) X(NextCasePtr) X(GetNumericValue) X(GetStringValue) X(RemoveCaseCursor) \
+    X(StartDataStep) X(EndDataStep) X(CreateDataset) X(CloseDataset) X(SetActive) \
+    X(InsertVariable) X(InsertCase) X(GetNCellValue) X(GetCCellValue) X(SetNCellValue) X(SetCCellValue) \
+    X(StartProcedure) X(EndProcedure) X(StartPivotTable) X(AddDimension) X(AddStringCategory) \
+    X(SetFormatSpecCount) X(SetNumberCell)
+
+namespace xd {
+#define XD_DECLARE(name) static decltype(&::name) name = NULL;
+    XD_FUNCTIONS(XD_DECLARE)
+#undef XD_DECLARE
+}
+
+struct Options {
+    std::string libPath;
+    std::string commandLine;
+    std::string only;
+    std::string outPath;
+    long cases;
+    long cells;
+    long submits;
+    int repeat;
+};
+
+struct Shape {
+    const char* name;
+    int numeric;
+    int strings;
+    int width;
+};
+
+static const Shape shapes[] = {
+    {"narrow_numeric",   4,   0,  0},
+    {"wide_numeric",   200,   0,  0},
+    {"narrow_string",    0,   4, 16},
+    {"wide_string",      0, 100, 32},
+    {"narrow_mixed",     4,   4,  8},
+    {"wide_mixed",     100, 100,  8},
+};
+
+struct Result {
+    std::string benchmark;
+    const Shape* shape;             // NULL for pivot_cells and submit_latency
+    std::string unit;               // what count counts: case, cell or command
+    long count;
+    double bytes;
+    std::vector<double> seconds;    // one per run
+    std::vector<double> latencies;  // submit_latency only, in seconds
+    std::string status;             // ok, skipped or error
+    std::string detail;             // the missing function or the failing call
+    int error;
+};
+
+static Options options;
+static volatile double sink;        // keeps the values read from being unused
+
+static double Now()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+//load spssxd_p. -lib, then SPSS_HOME/lib, then the library search path.
+static bool LoadLib()
+{
+    std::string libPath = options.libPath;
+    if(libPath.empty()) {
+        const char* spssHome = getenv("SPSS_HOME");
+        libPath = spssHome ? std::string(spssHome) + "/lib/" + LIBNAME : LIBNAME;
+        options.libPath = libPath;
+    }
+    void* pLib = dlopen(libPath.c_str(), RTLD_NOW | RTLD_GLOBAL);
+    if(NULL == pLib) {
+        std::cerr << "dlopen fails with error: " << dlerror() << std::endl;
+        return false;
+    }
+#define XD_LOAD(name) xd::name = (decltype(xd::name))dlsym(pLib, #name);
+    XD_FUNCTIONS(XD_LOAD)
+#undef XD_LOAD
+    if(!xd::IsBackendReady || !xd::StartSpss || !xd::StopSpss || !xd::Submit) {
+        std::cerr << libPath << " does not export the XD API" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+/*
+ * Results
+ */
+
+static bool Selected(const std::string& benchmark, const Shape* shape)
+{
+    std::string name = shape ? benchmark + "/" + shape->name : benchmark;
+    return options.only.empty() || name.find(options.only) != std::string::npos;
+}
+
+static double CaseBytes(const Shape& shape)
+{
+    return shape.numeric * 8.0 + shape.strings * (double)shape.width;
+}
+
+static Result NewResult(const std::string& benchmark, const Shape* shape, const std::string& unit, long count)
+{
+    Result result;
+    result.benchmark = benchmark;
+    result.shape = shape;
+    result.unit = unit;
+    result.count = count;
+    result.bytes = 0;
+    result.status = "ok";
+    result.error = 0;
+    return result;
+}
+
+//mark the result skipped when the library lacks a function. returns true when it does.
+static bool Lacks(Result& result, void* function, const char* name)
+{
+    if(function) {
+        return false;
+    }
+    if(result.status == "ok") {
+        result.status = "skipped";
+        result.detail = name;
+    }
+    return true;
+}
+#define LACKS(result, name) Lacks(result, (void*)xd::name, #name)
+
+//mark the result failed. returns true when errLevel is an error.
+static bool Failed(Result& result, int errLevel, const char* call)
+{
+    if(0 == errLevel) {
+        return false;
+    }
+    if(result.status == "ok") {
+        result.status = "error";
+        result.detail = call;
+        result.error = errLevel;
+    }
+    return true;
+}
+
+static void Report(const Result& result)
+{
+    std::string name = result.shape ? result.benchmark + "/" + result.shape->name : result.benchmark;
+    if(result.status != "ok") {
+        fprintf(stderr, "%-36s %s %s", name.c_str(), result.status.c_str(), result.detail.c_str());
+        if(result.error) {
+            fprintf(stderr, " (error %d)", result.error);
+        }
+        fprintf(stderr, "\n");
+        return;
+    }
+    double best = *std::min_element(result.seconds.begin(), result.seconds.end());
+    fprintf(stderr, "%-36s %12.0f %s/s", name.c_str(), best > 0 ? result.count / best : 0.0, result.unit.c_str());
+    if(result.bytes > 0) {
+        fprintf(stderr, " %10.2f MB/s", best > 0 ? result.bytes / best / 1e6 : 0.0);
+    }
+    fprintf(stderr, "\n");
+}
+
+/*
+ * The data of a shape
+ */
+
+static void VarName(const Shape& shape, int index, char* name)
+{
+    if(index < shape.numeric) {
+        sprintf(name, "n%d", index + 1);
+    } else {
+        sprintf(name, "s%d", index - shape.numeric + 1);
+    }
+}
+
+static double NumberOf(long row, int index)
+{
+    return row * 0.5 + index;
+}
+
+//the string value of a cell, at most width bytes long.
+static void StringOf(long row, int index, int width, char* value)
+{
+    char text[48];
+    sprintf(text, "r%ldc%d", row, index);
+    text[width < (int)sizeof(text) ? width : (int)sizeof(text) - 1] = '\0';
+    strcpy(value, text);
+}
+
+//create dsName with the variables of the shape and time filling it case by
+//case. the last run leaves dsName active.
+static void InsertCases(const Shape& shape, const char* dsName, Result& result)
+{
+    if(LACKS(result, StartDataStep) | LACKS(result, EndDataStep) | LACKS(result, CreateDataset) |
+       LACKS(result, CloseDataset) | LACKS(result, SetActive) | LACKS(result, InsertVariable) |
+       LACKS(result, InsertCase) | LACKS(result, SetNCellValue) | LACKS(result, SetCCellValue)) {
+        return;
+    }
+    int vars = shape.numeric + shape.strings;
+    char name[16];
+    char value[48];
+    for(int run = 0; run < options.repeat; run++) {
+        if(Failed(result, xd::StartDataStep(), "StartDataStep") ||
+           Failed(result, xd::CreateDataset(dsName, false, false), "CreateDataset")) {
+            xd::EndDataStep();
+            return;
+        }
+        int errLevel = 0;
+        for(int i = 0; i < vars && 0 == errLevel; i++) {
+            VarName(shape, i, name);
+            errLevel = xd::InsertVariable(dsName, i, name, i < shape.numeric ? 0 : shape.width);
+        }
+        double start = Now();
+        for(long r = 0; r < options.cases && 0 == errLevel; r++) {
+            errLevel = xd::InsertCase(dsName, r);
+            for(int i = 0; i < shape.numeric && 0 == errLevel; i++) {
+                errLevel = xd::SetNCellValue(dsName, r, i, NumberOf(r, i));
+            }
+            for(int i = shape.numeric; i < vars && 0 == errLevel; i++) {
+                StringOf(r, i, shape.width, value);
+                errLevel = xd::SetCCellValue(dsName, r, i, value);
+            }
+        }
+        result.seconds.push_back(Now() - start);
+        if(0 == errLevel) {
+            errLevel = run + 1 < options.repeat ? xd::CloseDataset(dsName) : xd::SetActive(dsName);
+        }
+        Failed(result, errLevel, "InsertCase");
+        if(Failed(result, xd::EndDataStep(), "EndDataStep") || errLevel) {
+            return;
+        }
+    }
+    result.bytes = CaseBytes(shape) * options.cases;
+}
+
+static void CursorGetValue(const Shape& shape, Result& result)
+{
+    if(LACKS(result, MakeCaseCursor) | LACKS(result, NextCase) | LACKS(result, GetNumericValue) |
+       LACKS(result, GetStringValue) | LACKS(result, RemoveCaseCursor)) {
+        return;
+    }
+    int vars = shape.numeric + shape.strings;
+    std::vector<char> buffer(shape.width + 1);
+    for(int run = 0; run < options.repeat; run++) {
+        if(Failed(result, xd::MakeCaseCursor("r"), "MakeCaseCursor")) {
+            return;
+        }
+        double sum = 0;
+        long cases = 0;
+        int errLevel = 0;
+        double start = Now();
+        while(0 == (errLevel = xd::NextCase())) {
+            for(int i = 0; i < shape.numeric && 0 == errLevel; i++) {
+                double value;
+                int isMissing;
+                errLevel = xd::GetNumericValue(i, value, isMissing);
+                sum += value;
+            }
+            for(int i = shape.numeric; i < vars && 0 == errLevel; i++) {
+                char* value = &buffer[0];
+                int isMissing;
+                errLevel = xd::GetStringValue(i, value, shape.width, isMissing);
+                sum += value[0];
+            }
+            if(errLevel) {
+                break;
+            }
+            cases++;
+        }
+        result.seconds.push_back(Now() - start);
+        xd::RemoveCaseCursor();
+        sink = sum;
+        if(Failed(result, 23 == errLevel ? 0 : errLevel, "NextCase")) {
+            return;
+        }
+        result.count = cases;
+    }
+    result.bytes = CaseBytes(shape) * result.count;
+}
+
+static void CursorNextCasePtr(const Shape& shape, Result& result)
+{
+    if(LACKS(result, MakeCaseCursor) | LACKS(result, NextCasePtr) | LACKS(result, RemoveCaseCursor)) {
+        return;
+    }
+    // the variables are made numeric first, so a string starts after the numbers,
+    // each taking its width rounded up to 8 bytes.
+    int stringStride = (shape.width + 7) / 8 * 8;
+    int caseNeeded = shape.numeric * 8 + shape.strings * stringStride;
+    std::vector<char> value(shape.width + 1);
+    for(int run = 0; run < options.repeat; run++) {
+        if(Failed(result, xd::MakeCaseCursor("r"), "MakeCaseCursor")) {
+            return;
+        }
+        double sum = 0;
+        long cases = 0;
+        int errLevel = 0;
+        double start = Now();
+        for(;;) {
+            int caseSize = 0;
+            const char* buffer = (const char*)xd::NextCasePtr(caseSize, errLevel);
+            if(NULL == buffer || errLevel) {
+                break;
+            }
+            if(caseSize < caseNeeded) {
+                errLevel = -1;
+                break;
+            }
+            // decode every value, as GetNumericValue and GetStringValue do for NextCase.
+            for(int i = 0; i < shape.numeric; i++) {
+                double number;
+                memcpy(&number, buffer + i * 8, sizeof(number));
+                sum += number;
+            }
+            const char* strings = buffer + shape.numeric * 8;
+            for(int i = 0; i < shape.strings; i++) {
+                memcpy(&value[0], strings + i * stringStride, shape.width);
+                sum += value[0];
+            }
+            cases++;
+        }
+        result.seconds.push_back(Now() - start);
+        xd::RemoveCaseCursor();
+        sink = sum;
+        if(Failed(result, 23 == errLevel ? 0 : errLevel, "NextCasePtr")) {
+            return;
+        }
+        result.count = cases;
+    }
+    result.bytes = CaseBytes(shape) * result.count;
+}
+
+static void DataStepGetCell(const Shape& shape, const char* dsName, Result& result)
+{
+    if(LACKS(result, StartDataStep) | LACKS(result, EndDataStep) | LACKS(result, GetNCellValue) |
+       LACKS(result, GetCCellValue)) {
+        return;
+    }
+    int vars = shape.numeric + shape.strings;
+    if(Failed(result, xd::StartDataStep(), "StartDataStep")) {
+        return;
+    }
+    for(int run = 0; run < options.repeat; run++) {
+        double sum = 0;
+        int errLevel = 0;
+        double start = Now();
+        for(long r = 0; r < options.cases && 0 == errLevel; r++) {
+            int isMissing;
+            for(int i = 0; i < shape.numeric && 0 == errLevel; i++) {
+                sum += xd::GetNCellValue(dsName, r, i, isMissing, errLevel);
+            }
+            for(int i = shape.numeric; i < vars && 0 == errLevel; i++) {
+                const char* value = xd::GetCCellValue(dsName, r, i, isMissing, errLevel);
+                sum += value ? value[0] : 0;
+            }
+        }
+        result.seconds.push_back(Now() - start);
+        sink = sum;
+        if(Failed(result, errLevel, "GetCellValue")) {
+            break;
+        }
+    }
+    Failed(result, xd::EndDataStep(), "EndDataStep");
+    result.bytes = CaseBytes(shape) * options.cases;
+}
+
+static void DataStepSetCell(const Shape& shape, const char* dsName, Result& result)
+{
+    if(LACKS(result, StartDataStep) | LACKS(result, EndDataStep) | LACKS(result, SetNCellValue) |
+       LACKS(result, SetCCellValue)) {
+        return;
+    }
+    int vars = shape.numeric + shape.strings;
+    char value[48];
+    if(Failed(result, xd::StartDataStep(), "StartDataStep")) {
+        return;
+    }
+    for(int run = 0; run < options.repeat; run++) {
+        int errLevel = 0;
+        double start = Now();
+        for(long r = 0; r < options.cases && 0 == errLevel; r++) {
+            for(int i = 0; i < shape.numeric && 0 == errLevel; i++) {
+                errLevel = xd::SetNCellValue(dsName, r, i, NumberOf(r, i) + run);
+            }
+            for(int i = shape.numeric; i < vars && 0 == errLevel; i++) {
+                StringOf(r + run, i, shape.width, value);
+                errLevel = xd::SetCCellValue(dsName, r, i, value);
+            }
+        }
+        result.seconds.push_back(Now() - start);
+        if(Failed(result, errLevel, "SetCellValue")) {
+            break;
+        }
+    }
+    Failed(result, xd::EndDataStep(), "EndDataStep");
+    result.bytes = CaseBytes(shape) * options.cases;
+}
+
+static void RunShape(const Shape& shape, std::vector<Result>& results)
+{
+    const char* benchmarks[] = {"insert_case", "cursor_get_value", "cursor_next_case_ptr",
+                                "datastep_get_cell", "datastep_set_cell"};
+    bool any = false;
+    for(size_t i = 0; i < sizeof(benchmarks) / sizeof(benchmarks[0]); i++) {
+        any = any || Selected(benchmarks[i], &shape);
+    }
+    if(!any) {
+        return;
+    }
+    std::string dsName = std::string("xdbench_") + shape.name;
+
+    //the data is built even when insert_case is not selected, and the other
+    //benchmarks read it.
+    Result insert = NewResult("insert_case", &shape, "case", options.cases);
+    InsertCases(shape, dsName.c_str(), insert);
+    if(Selected(insert.benchmark, &shape)) {
+        Report(insert);
+        results.push_back(insert);
+    }
+    bool built = insert.status == "ok";
+
+    for(size_t i = 1; i < sizeof(benchmarks) / sizeof(benchmarks[0]); i++) {
+        if(!Selected(benchmarks[i], &shape)) {
+            continue;
+        }
+        Result result = NewResult(benchmarks[i], &shape, "case", options.cases);
+        if(!built) {
+            result.status = insert.status;
+            result.detail = insert.detail;
+            result.error = insert.error;
+        } else if(1 == i) {
+            CursorGetValue(shape, result);
+        } else if(2 == i) {
+            CursorNextCasePtr(shape, result);
+        } else if(3 == i) {
+            DataStepGetCell(shape, dsName.c_str(), result);
+        } else {
+            DataStepSetCell(shape, dsName.c_str(), result);
+        }
+        Report(result);
+        results.push_back(result);
+    }
+
+    const char* cleanup[] = {"DATASET CLOSE ALL.", "NEW FILE."};
+    for(size_t i = 0; i < sizeof(cleanup) / sizeof(cleanup[0]); i++) {
+        xd::Submit(cleanup[i], (int)strlen(cleanup[i]));
+    }
+}
+
+/*
+ * Pivot tables and Submit
+ */
+
+//a square table of about -cells cells, emitted row by row the way the
+//Python plug-in emits a SimplePivotTable.
+static void PivotCells(Result& result)
+{
+    if(LACKS(result, StartProcedure) | LACKS(result, EndProcedure) | LACKS(result, StartPivotTable) |
+       LACKS(result, AddDimension) | LACKS(result, AddStringCategory) | LACKS(result, SetNumberCell)) {
+        return;
+    }
+    long side = 1;
+    while((side + 1) * (side + 1) <= options.cells) {
+        side++;
+    }
+    result.count = side * side;
+    const char* outline = "xdbench";
+    const char* title = "Cells";
+    const char* templ = "xdbench";
+    char category[24];
+    for(int run = 0; run < options.repeat; run++) {
+        int errLevel = 0;
+        double start = Now();
+        if(Failed(result, xd::StartProcedure("xdbench", NULL), "StartProcedure")) {
+            return;
+        }
+        errLevel = xd::StartPivotTable(outline, title, templ, false);
+        if(0 == errLevel) {
+            errLevel = xd::AddDimension(outline, title, templ, false, "rows", 0, 1, false, false);
+        }
+        if(0 == errLevel) {
+            errLevel = xd::AddDimension(outline, title, templ, false, "columns", 1, 1, false, false);
+        }
+        for(long r = 0; r < side && 0 == errLevel; r++) {
+            sprintf(category, "r%ld", r + 1);
+            errLevel = xd::AddStringCategory(outline, title, templ, false, "rows", 0, 1, false, false, category);
+            for(long c = 0; c < side && 0 == errLevel; c++) {
+                sprintf(category, "c%ld", c + 1);
+                errLevel = xd::AddStringCategory(outline, title, templ, false, "columns", 1, 1, false, false, category);
+                if(0 == errLevel && xd::SetFormatSpecCount) {
+                    errLevel = xd::SetFormatSpecCount();
+                }
+                if(0 == errLevel) {
+                    errLevel = xd::SetNumberCell(outline, title, templ, false, "columns", 1, 1, false, false,
+                                                 (double)(r * side + c));
+                }
+            }
+        }
+        int endLevel = xd::EndProcedure();
+        result.seconds.push_back(Now() - start);
+        if(Failed(result, errLevel, "SetNumberCell") || Failed(result, endLevel, "EndProcedure")) {
+            return;
+        }
+    }
+}
+
+static void SubmitLatency(Result& result)
+{
+    const char* command = "SET MXWARNS=10.";
+    int length = (int)strlen(command);
+    for(int run = 0; run < options.repeat; run++) {
+        double start = Now();
+        for(long i = 0; i < options.submits; i++) {
+            double callStart = Now();
+            int errLevel = xd::Submit(command, length);
+            result.latencies.push_back(Now() - callStart);
+            if(Failed(result, errLevel, "Submit")) {
+                return;
+            }
+        }
+        result.seconds.push_back(Now() - start);
+    }
+}
+
+/*
+ * JSON
+ */
+
+static std::string Quote(const std::string& text)
+{
+    std::string result = "\"";
+    for(size_t i = 0; i < text.size(); i++) {
+        unsigned char ch = (unsigned char)text[i];
+        if('"' == ch || '\\' == ch) {
+            result += '\\';
+            result += (char)ch;
+        } else if(ch < 0x20) {
+            char escape[8];
+            sprintf(escape, "\\u%04x", ch);
+            result += escape;
+        } else {
+            result += (char)ch;
+        }
+    }
+    return result + "\"";
+}
+
+static double Percentile(std::vector<double> values, double p)
+{
+    if(values.empty()) {
+        return 0;
+    }
+    std::sort(values.begin(), values.end());
+    size_t index = (size_t)(p * (values.size() - 1) + 0.5);
+    return values[index];
+}
+
+static void WriteJson(FILE* out, const std::vector<Result>& results)
+{
+    struct utsname host;
+    if(uname(&host) != 0) {
+        strcpy(host.nodename, "unknown");
+        strcpy(host.sysname, "unknown");
+        strcpy(host.machine, "unknown");
+    }
+    fprintf(out, "{\n");
+    fprintf(out, "  \"tool\": \"xdbench\",\n");
+    fprintf(out, "  \"format\": 1,\n");
+    fprintf(out, "  \"time\": %ld,\n", (long)time(NULL));
+    fprintf(out, "  \"host\": %s,\n", Quote(host.nodename).c_str());
+    fprintf(out, "  \"platform\": %s,\n", Quote(std::string(host.sysname) + " " + host.machine).c_str());
+    fprintf(out, "  \"library\": %s,\n", Quote(options.libPath).c_str());
+    fprintf(out, "  \"cases\": %ld,\n", options.cases);
+    fprintf(out, "  \"repeat\": %d,\n", options.repeat);
+    fprintf(out, "  \"results\": [");
+    for(size_t i = 0; i < results.size(); i++) {
+        const Result& result = results[i];
+        fprintf(out, "%s\n    {\"benchmark\": %s", i ? "," : "", Quote(result.benchmark).c_str());
+        if(result.shape) {
+            fprintf(out, ", \"shape\": %s, \"numeric\": %d, \"strings\": %d, \"width\": %d",
+                    Quote(result.shape->name).c_str(), result.shape->numeric, result.shape->strings,
+                    result.shape->width);
+        }
+        fprintf(out, ", \"status\": %s", Quote(result.status).c_str());
+        if(result.status != "ok") {
+            fprintf(out, ", \"detail\": %s, \"error\": %d}", Quote(result.detail).c_str(), result.error);
+            continue;
+        }
+        double best = *std::min_element(result.seconds.begin(), result.seconds.end());
+        fprintf(out, ",\n     \"unit\": %s, \"count\": %ld, \"bytes\": %.0f, \"runs\": %d",
+                Quote(result.unit).c_str(), result.count, result.bytes, (int)result.seconds.size());
+        fprintf(out, ",\n     \"seconds\": %.9f, \"median_seconds\": %.9f", best, Percentile(result.seconds, 0.5));
+        fprintf(out, ",\n     \"per_sec\": %.3f, \"bytes_per_sec\": %.3f",
+                best > 0 ? result.count / best : 0.0, best > 0 ? result.bytes / best : 0.0);
+        if(!result.latencies.empty()) {
+            double total = 0;
+            for(size_t j = 0; j < result.latencies.size(); j++) {
+                total += result.latencies[j];
+            }
+            fprintf(out, ",\n     \"latency_us\": {\"mean\": %.3f, \"p50\": %.3f, \"p95\": %.3f, \"p99\": %.3f, \"max\": %.3f}",
+                    total / result.latencies.size() * 1e6, Percentile(result.latencies, 0.5) * 1e6,
+                    Percentile(result.latencies, 0.95) * 1e6, Percentile(result.latencies, 0.99) * 1e6,
+                    Percentile(result.latencies, 1.0) * 1e6);
+        }
+        fprintf(out, "}");
+    }
+    fprintf(out, "\n  ]\n}\n");
+}
+
+static void Usage()
+{
+    std::cout << "usage: xdbench [-lib path] [-cmdline \"StartSpss command line\"] [-cases n]" << std::endl
+              << "               [-cells n] [-submits n] [-repeat n] [-only name] [-out file.json]" << std::endl;
+}
+
+int main(int argc, char* argv[])
+{
+    options.cases = 10000;
+    options.cells = 10000;
+    options.submits = 200;
+    options.repeat = 3;
+    for(int i = 1; i < argc; i++) {
+        std::string option(argv[i]);
+        if(i + 1 >= argc) {
+            Usage();
+            return 1;
+        }
+        const char* value = argv[++i];
+        if(option == "-lib") {
+            options.libPath = value;
+        } else if(option == "-cmdline") {
+            options.commandLine = value;
+        } else if(option == "-cases") {
+            options.cases = atol(value);
+        } else if(option == "-cells") {
+            options.cells = atol(value);
+        } else if(option == "-submits") {
+            options.submits = atol(value);
+        } else if(option == "-repeat") {
+            options.repeat = atoi(value);
+        } else if(option == "-only") {
+            options.only = value;
+        } else if(option == "-out") {
+            options.outPath = value;
+        } else {
+            Usage();
+            return 1;
+        }
+    }
+    if(options.cases < 1 || options.cells < 1 || options.submits < 1 || options.repeat < 1) {
+        Usage();
+        return 1;
+    }
+
+    if(!LoadLib()) {
+        return 1;
+    }
+    int errLevel = xd::StartSpss(options.commandLine.empty() ? NULL : options.commandLine.c_str());
+    if(errLevel != 0 || !xd::IsBackendReady()) {
+        std::cerr << "StartSpss fails with error " << errLevel << std::endl;
+        return 1;
+    }
+
+    std::vector<Result> results;
+    for(size_t i = 0; i < sizeof(shapes) / sizeof(shapes[0]); i++) {
+        RunShape(shapes[i], results);
+    }
+    if(Selected("pivot_cells", NULL)) {
+        Result result = NewResult("pivot_cells", NULL, "cell", 0);
+        PivotCells(result);
+        Report(result);
+        results.push_back(result);
+    }
+    if(Selected("submit_latency", NULL)) {
+        Result result = NewResult("submit_latency", NULL, "command", options.submits);
+        SubmitLatency(result);
+        Report(result);
+        results.push_back(result);
+    }
+    xd::StopSpss();
+
+    FILE* out = options.outPath.empty() ? stdout : fopen(options.outPath.c_str(), "w");
+    if(NULL == out) {
+        std::cerr << "cannot write " << options.outPath << std::endl;
+        return 1;
+    }
+    WriteJson(out, results);
+    if(out != stdout) {
+        fclose(out);
+    }
+    for(size_t i = 0; i < results.size(); i++) {
+        if(results[i].status == "error") {
+            return 2;
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,692 @@
+/************************************************************************
+** Licensed Materials - Property of IBM
+**
+** IBM SPSS Products: Statistics Common
+**
+** (C) Copyright IBM Corp. 1989, 2021
+**
+** US Government Users Restricted Rights - Use, duplication or disclosure
+** restricted by GSA ADP Schedule Contract with IBM Corp.
+************************************************************************/
+
+/**
+ * xdreplay.cpp -
+ *     issues the XD API calls of a trace again, against another backend, and
+ *     reports the time of each function in the trace and in the replay.
+ *
+ *     The Python plug-in records a trace when SPSSXD_RECORD names a file; see
+ *     "Call recording" in PyInvokeSpss.cpp for the format. Without
+ *     SPSSXD_RECORD_VALUES=1 the trace has the integers and the lengths of the
+ *     strings but not the strings or the doubles: xdreplay passes strings of x
+ *     of the same length and zeros, so the calls have the same shape but the
+ *     backend may answer them with errors. Pointers to numbers or buffers get
+ *     zeroed scratch memory. Not replayed, and reported as skipped, are
+ *         - the functions xdreplay does not know or the library does not export
+ *         - the functions with a list of strings or a callback argument
+ *         - the Free functions, as the memory they release is not reproduced
+ *     StartSpss is called with -cmdline in place of the recorded command line.
+ *
+ *     recorded_seconds and replay_seconds are the time spent in the functions,
+ *     in the trace and in the replay; span_seconds is the time the trace
+ *     covers, including the time spent between the calls.
+ *
+ * USAGE
+ *     xdreplay -trace file [-lib path] [-cmdline "StartSpss command line"] [-out file.json]
+ */
+
+#include <string>
+#include <vector>
+#include <tuple>
+#include <type_traits>
+#include <algorithm>
+#include <iostream>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <dlfcn.h>
+#include <sys/utsname.h>
+
+#include "spssxd.h"
+
+#ifdef __MACOSX__
+  #define LIBNAME      "libspssxd_p.dylib"
+#else
+  #define LIBNAME      "libspssxd_p.so"
+#endif
+
+//the functions of spssxd.h, which xdreplay issues with the types it declares.
+#define XD_FUNCTIONS(X) \
+    X(IsBackendReady) X(IsXDriven) X(StartSpss) X(StopSpss) X(Submit) X(QueueCommandPart) \
+    X(PostSpssOutput) X(GetVariableCount) X(GetRowCount) X(GetVariableName) X(GetVariableLabel) \
+    X(GetVariableType) X(GetVariableFormat) X(GetVariableMeasurementLevel) X(CreateXPathDictionary) \
+    X(RemoveXPathHandle) X(EvaluateXPath) X(GetStringListLength) X(GetStringFromList) \
+    X(RemoveStringList) X(GetXmlUtf16) X(GetImage) X(GetSetting) X(GetOMSTagList) X(GetHandleList) \
+    X(GetFileHandles) X(GetNumericValue) X(GetStringValue) X(NextCase) X(RemoveCaseCursor) \
+    X(GetVariableFormatType) X(GetCursorPosition) X(MakeCaseCursor) X(NextCasePtr) X(GetCaseLength) \
+    X(GetVarObsIndex) X(StartProcedure) X(SplitChange) X(EndProcedure) X(StartPivotTable) \
+    X(HidePivotTableTitle) X(PivotTableCaption) X(AddDimension) X(AddNumberCategory) \
+    X(AddStringCategory) X(AddVarNameCategory) X(AddVarValueDoubleCategory) \
+    X(AddVarValueStringCategory) X(SetNumberCell) X(SetStringCell) X(SetVarNameCell) \
+    X(SetVarValueDoubleCell) X(SetVarValueStringCell) X(SetNumberCellWithFormat) \
+    X(AddNumberCategoryWithFormat) X(AddTextBlockLines) X(SetNumberCells) \
+    X(SetFormatSpecCoefficient) X(SetFormatSpecCoefficientSE) X(SetFormatSpecCoefficientVar) \
+    X(SetFormatSpecCorrelation) X(SetFormatSpecGeneralStat) X(SetFormatSpecMean) \
+    X(SetFormatSpecCount) X(SetFormatSpecPercent) X(SetFormatSpecPercentNoSign) \
+    X(SetFormatSpecProportion) X(SetFormatSpecSignificance) X(SetFormatSpecResidual) \
+    X(SetFormatSpecVariable) X(SetFormatSpecStdDev) X(SetFormatSpecDifference) X(SetFormatSpecSum) \
+    X(AddCellFootnotes) X(AddProcFootnotes) X(AddOutlineFootnotes) X(AddTitleFootnotes) \
+    X(AddDimFootnotes) X(AddCategoryFootnotes) X(AddTextBlock) X(MinDataColumnWidth) \
+    X(MaxDataColumnWidth) X(HasCursor) X(GetRowCountInProcDS) X(GetVariableCountInProcDS) \
+    X(GetVariableLabelInProcDS) X(GetVariableMeasurementLevelInProcDS) \
+    X(GetVariableFormatTypeInProcDS) X(GetVariableNameInProcDS) X(GetVariableTypeInProcDS) \
+    X(GetVarAttributeNamesInProcDS) X(GetVarAttributesInProcDS) X(GetVarCMissingValuesInProcDS) \
+    X(GetVarNMissingValuesInProcDS) X(GetVarCMissingValues) X(GetVarNMissingValues) \
+    X(GetVarAttributeNames) X(FreeAttributeNames) X(GetVarAttributes) X(FreeAttributes) \
+    X(SetVarAttributes) X(GetVariableFormatInProcDS) X(SetVarNameAndType) X(SetVarLabel) \
+    X(SetVarCValueLabel) X(SetVarNValueLabel) X(SetVarCMissingValues) X(SetVarNMissingValues) \
+    X(SetVarMeasureLevel) X(SetVarAlignment) X(SetVarFormat) X(CommitHeader) X(SetValueChar) \
+    X(SetValueNumeric) X(CommitCaseRecord) X(CommitNewCase) X(EndChanges) X(IsEndSplit) \
+    X(HasProcedure) X(GetSPSSLowHigh) X(GetWeightVar) X(ResetDataPass) X(AllocNewVarsBuffer) \
+    X(SetOneVarNameAndType) X(SetXDriveMode) X(StartDataStep) X(EndDataStep) X(CreateDataset) \
+    X(SetDatasetName) X(GetNewDatasetName) X(GetActive) X(SetActive) X(CopyDataset) \
+    X(GetSpssDatasets) X(GetDatastepDatasets) X(FreeStringArray) X(CloseDataset) X(InsertVariable) \
+    X(DeleteVariable) X(GetVarCountInDS) X(GetVarNameInDS) X(SetVarNameInDS) X(GetVarLabelInDS) \
+    X(SetVarLabelInDS) X(GetVarTypeInDS) X(SetVarTypeInDS) X(GetVarFormatInDS) X(SetVarFormatInDS) \
+    X(GetVarAlignmentInDS) X(SetVarAlignmentInDS) X(GetVarMeasurementLevelInDS) \
+    X(SetVarMeasurementLevelInDS) X(GetVarNMissingValuesInDS) X(GetVarCMissingValuesInDS) \
+    X(SetVarNMissingValuesInDS) X(SetVarCMissingValuesInDS) X(GetVarAttributesNameInDS) \
+    X(GetVarAttributesInDS) X(SetVarAttributesInDS) X(DelVarAttributesInDS) X(GetVarNValueLabelInDS) \
+    X(FreeDoubleArray) X(GetVarCValueLabelInDS) X(SetVarNValueLabelInDS) X(SetVarCValueLabelInDS) \
+    X(DelVarValueLabelInDS) X(DelVarNValueLabelInDS) X(DelVarCValueLabelInDS) X(InsertCase) \
+    X(DeleteCase) X(GetCaseCountInDS) X(GetNCellValue) X(GetCCellValue) X(SetNCellValue) \
+    X(SetCCellValue) X(IsUTF8mode) X(GetSplitVariableNames) X(GetDataFileAttributes) \
+    X(GetDataFileAttributeNames) X(GetDataFileAttributesInProcDS) \
+    X(GetDataFileAttributeNamesInProcDS) X(GetMultiResponseSetNames) X(GetMultiResponseSet) \
+    X(GetMultiResponseSetNamesInProcDS) X(GetMultiResponseSetInProcDS) X(SetDataFileAttributesInDS) \
+    X(SetMultiResponseSetInDS) X(FreeString) X(GetDataFileAttributeNamesInDS) \
+    X(GetDataFileAttributesInDS) X(GetMultiResponseSetNamesInDS) X(GetMultiResponseSetInDS) \
+    X(GetVarColumnWidthInDS) X(SetVarColumnWidthInDS) X(DelDataFileAttributesInDS) \
+    X(DelMultiResponseSetInDS) X(GetXDriveMode) X(GetSPSSLocale) X(GetCLocaleGeneration) \
+    X(SetOutputLanguage) X(GetNestDepth) X(GetOutputLanguage) X(TransCode) X(GetVariableRole) \
+    X(GetVariableRoleInProcDS) X(SetVarRole) X(GetVarRoleInDS) X(SetVarRoleInDS) \
+    X(GetDataFromTempFile) X(SaveDataToTempFile) X(GetSplitEndIndex) X(SetMode) \
+    X(GetRowCountInTempFile) X(GetCaseValue) X(SetCacheInDS) X(IsDistributedMode) \
+    X(GetXmlUtf16Length) X(IsUseOrFilter) X(SubmitAsync) X(PollSubmit) X(WaitSubmit) \
+    X(SetSubmitCallback) X(SubmitBatch)
+
+//the functions of libspssxd_p the Python plug-in calls that spssxd.h does not
+//declare, with their types in PyInvokeSpss.h.
+#define XD_PLUGIN_FUNCTIONS(X) \
+    X(SetXNameAndSHome, void (*)(const char*, const char*)) \
+    X(GetColumnCountInProcDS, int (*)(int&)) \
+    X(GetNCellValueCache, double (*)(const char*, long, int, int&, int&)) \
+    X(GetCCellValueCache, const char* (*)(const char*, long, int, int&, int&)) \
+    X(GetRowList, void (*)(const char*, long, int, long&, long&, long&, int&)) \
+    X(GetVarTypeInDSCache, void (*)(int*, int, int&)) \
+    X(ClearDatastepBatch, void (*)()) \
+    X(GetNCellValueFromCache, double (*)(const char*, int, int&, int&)) \
+    X(GetCCellValueFromCache, const char* (*)(const char*, int, int&)) \
+    X(SetNCellValueFromCache, int (*)(const char*, int, double)) \
+    X(SetCCellValueFromCache, int (*)(const char*, int, const char*)) \
+    X(GetVarInfo, void (*)(const char*, int**, int&)) \
+    X(SetCasePartValue, int (*)(const char*, int, int*, bool, int))
+
+struct Options {
+    std::string libPath;
+    std::string commandLine;
+    std::string tracePath;
+    std::string outPath;
+};
+
+static Options options;
+
+static long long NowNs()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+/*
+ * The trace
+ */
+
+enum Tag { TRACE_VOID, TRACE_INT, TRACE_DOUBLE, TRACE_STRING, TRACE_LENGTH, TRACE_POINTER, TRACE_MASKED };
+
+struct Value {
+    int tag;
+    long long integer;
+    double number;
+    bool null;                      // a NULL string
+    size_t length;                  // of a string
+    std::string text;               // of a TRACE_STRING
+};
+
+struct Call {
+    int function;                   // index into the names of the trace
+    long long startNs;              // from the start of the previous call
+    long long ns;
+    std::vector<Value> args;
+    Value result;
+};
+
+class TraceReader {
+public:
+    TraceReader() : values(false), file(NULL) {}
+    ~TraceReader() { if(file) fclose(file); }
+
+    bool Open(const std::string& path)
+    {
+        file = fopen(path.c_str(), "rb");
+        if(NULL == file) {
+            std::cerr << "cannot read " << path << std::endl;
+            return false;
+        }
+        char magic[8];
+        unsigned long long flags, count;
+        if(fread(magic, 1, sizeof(magic), file) != sizeof(magic) || memcmp(magic, "SPSSXDT1", 8) != 0 ||
+           !Varint(flags) || !Varint(count)) {
+            std::cerr << path << " is not an SPSSXD trace" << std::endl;
+            return false;
+        }
+        values = (flags & 1) != 0;
+        for(unsigned long long i = 0; i < count; i++) {
+            unsigned long long length;
+            std::string name;
+            if(!Varint(length) || !Bytes(name, length)) {
+                std::cerr << path << " is not an SPSSXD trace" << std::endl;
+                return false;
+            }
+            names.push_back(name);
+        }
+        return true;
+    }
+
+    //the next call. false at the end of the trace.
+    bool Next(Call& call)
+    {
+        unsigned long long function, ns, argc;
+        long long startNs;
+        int ch = getc(file);
+        if(EOF == ch) {
+            return false;
+        }
+        ungetc(ch, file);
+        if(!Varint(function) || !Signed(startNs) || !Varint(ns) || !Varint(argc) || function >= names.size()) {
+            return Truncated();
+        }
+        call.function = (int)function;
+        call.startNs = startNs;
+        call.ns = (long long)ns;
+        call.args.resize((size_t)argc);
+        for(size_t i = 0; i < call.args.size(); i++) {
+            if(!ReadValue(call.args[i])) {
+                return Truncated();
+            }
+        }
+        return ReadValue(call.result) || Truncated();
+    }
+
+    std::vector<std::string> names;
+    bool values;                    // the strings and doubles were recorded
+
+private:
+    bool Truncated()
+    {
+        std::cerr << "the trace ends in the middle of a call" << std::endl;
+        return false;
+    }
+
+    bool Varint(unsigned long long& value)
+    {
+        value = 0;
+        for(int shift = 0; shift < 64; shift += 7) {
+            int ch = getc(file);
+            if(EOF == ch) {
+                return false;
+            }
+            value |= (unsigned long long)(ch & 0x7f) << shift;
+            if(0 == (ch & 0x80)) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    bool Signed(long long& value)
+    {
+        unsigned long long zigzag;
+        if(!Varint(zigzag)) {
+            return false;
+        }
+        value = (long long)(zigzag >> 1) ^ -(long long)(zigzag & 1);
+        return true;
+    }
+
+    bool Bytes(std::string& text, unsigned long long length)
+    {
+        text.resize((size_t)length);
+        return 0 == length || fread(&text[0], 1, (size_t)length, file) == length;
+    }
+
+    bool ReadValue(Value& value)
+    {
+        int tag = getc(file);
+        value.tag = tag;
+        value.integer = 0;
+        value.number = 0;
+        value.null = false;
+        value.length = 0;
+        value.text.clear();
+        unsigned long long length;
+        switch(tag) {
+        case TRACE_INT:
+            return Signed(value.integer);
+        case TRACE_DOUBLE:
+            return fread(&value.number, 1, sizeof(value.number), file) == sizeof(value.number);
+        case TRACE_STRING:
+        case TRACE_LENGTH:
+            if(!Varint(length)) {
+                return false;
+            }
+            value.null = 0 == length;
+            value.length = value.null ? 0 : (size_t)length - 1;
+            return TRACE_LENGTH == tag || Bytes(value.text, value.length);
+        case TRACE_VOID:
+        case TRACE_POINTER:
+        case TRACE_MASKED:
+            return true;
+        default:
+            return false;
+        }
+    }
+
+    FILE* file;
+};
+
+/*
+ * Replaying a call
+ */
+
+enum ReplayStatus { REPLAY_OK, REPLAY_ARGUMENTS, REPLAY_ARITY };
+
+enum SlotKind { SLOT_NUMBER, SLOT_STRING, SLOT_BUFFER, SLOT_OUTPUT, SLOT_OTHER };
+
+static const int MAX_ARGS = 24;
+static const size_t SCRATCH_SIZE = 1 << 16;
+//the memory behind the pointer arguments, one block for each position.
+alignas(16) static char scratch[MAX_ARGS][SCRATCH_SIZE];
+
+//how an argument of type A is replayed. A pointer to a pointer is taken for
+//an output, as in GetVarAttributeNames(index, char*** name, ...), except a
+//char** or a pointer to const, which are lists of strings passed in.
+template<typename A> struct KindOf {
+    typedef typename std::remove_cv<typename std::remove_reference<A>::type>::type T;
+    typedef typename std::remove_pointer<T>::type Pointee;
+    typedef typename std::remove_cv<typename std::remove_pointer<Pointee>::type>::type Pointee2;
+    static const bool scalarPointer = std::is_pointer<T>::value &&
+        (std::is_arithmetic<typename std::remove_cv<Pointee>::type>::value || std::is_void<Pointee>::value);
+    static const bool outputPointer = std::is_pointer<T>::value && std::is_pointer<Pointee>::value &&
+        !std::is_const<Pointee>::value && !std::is_same<Pointee2, char>::value &&
+        (std::is_pointer<Pointee2>::value || std::is_arithmetic<Pointee2>::value);
+    static const SlotKind value =
+        std::is_reference<A>::value ?
+            (std::is_arithmetic<T>::value || std::is_enum<T>::value ? SLOT_NUMBER :
+             std::is_pointer<T>::value && !std::is_const<typename std::remove_reference<A>::type>::value ? SLOT_OUTPUT :
+             SLOT_OTHER) :
+        std::is_same<T, const char*>::value ? SLOT_STRING :
+        std::is_arithmetic<T>::value || std::is_enum<T>::value ? SLOT_NUMBER :
+        scalarPointer || outputPointer ? SLOT_BUFFER :
+        SLOT_OTHER;
+};
+
+//holds one argument of a replayed call: the recorded value, or what stands in for it.
+template<typename A, SlotKind K = KindOf<A>::value> struct Slot {
+    typedef typename std::remove_cv<typename std::remove_reference<A>::type>::type T;
+    static const bool replayable = false;
+    T value;
+    Slot(const Value&, size_t) : value() {}
+    A get() { return value; }
+};
+
+template<typename A> struct Slot<A, SLOT_NUMBER> {
+    typedef typename std::remove_cv<typename std::remove_reference<A>::type>::type T;
+    static const bool replayable = true;
+    T value;
+    Slot(const Value& recorded, size_t)
+        : value(TRACE_INT == recorded.tag ? (T)recorded.integer :
+                TRACE_DOUBLE == recorded.tag ? (T)recorded.number : T()) {}
+    A get() { return value; }
+};
+
+template<typename A> struct Slot<A, SLOT_OUTPUT> {
+    typedef typename std::remove_reference<A>::type T;
+    static const bool replayable = true;
+    T value;
+    Slot(const Value&, size_t) : value() {}
+    A get() { return value; }
+};
+
+template<typename A> struct Slot<A, SLOT_STRING> {
+    static const bool replayable = true;
+    bool null;
+    std::string text;
+    Slot(const Value& recorded, size_t)
+        : null(recorded.null),
+          text(TRACE_STRING == recorded.tag ? recorded.text : std::string(recorded.length, 'x')) {}
+    A get() { return null ? NULL : text.c_str(); }
+};
+
+template<typename A> struct Slot<A, SLOT_BUFFER> {
+    static const bool replayable = true;
+    char* buffer;
+    Slot(const Value&, size_t position) : buffer(scratch[position])
+    {
+        memset(buffer, 0, SCRATCH_SIZE);
+    }
+    A get() { return (A)(void*)buffer; }
+};
+
+template<size_t... I> struct Indices {};
+template<size_t N, size_t... I> struct MakeIndices : MakeIndices<N - 1, N - 1, I...> {};
+template<size_t... I> struct MakeIndices<0, I...> { typedef Indices<I...> type; };
+
+template<typename FP> struct Replayer;
+template<typename R, typename... A> struct Replayer<R (*)(A...)> {
+    static_assert(sizeof...(A) <= MAX_ARGS, "too many arguments for the scratch memory");
+
+    static ReplayStatus Run(void* address, const Call& call, long long& ns)
+    {
+        if(call.args.size() != sizeof...(A)) {
+            return REPLAY_ARITY;
+        }
+        bool replayable[] = {true, Slot<A>::replayable...};
+        for(size_t i = 0; i < sizeof(replayable) / sizeof(replayable[0]); i++) {
+            if(!replayable[i]) {
+                return REPLAY_ARGUMENTS;
+            }
+        }
+        Issue(address, call, ns, typename MakeIndices<sizeof...(A)>::type());
+        return REPLAY_OK;
+    }
+
+    template<size_t... I> static void Issue(void* address, const Call& call, long long& ns, Indices<I...>)
+    {
+        std::tuple<Slot<A>...> slots(Slot<A>(call.args[I], I)...);
+        (void)slots;
+        long long start = NowNs();
+        ((R (*)(A...))address)(std::get<I>(slots).get()...);
+        ns = NowNs() - start;
+    }
+};
+
+struct Function {
+    const char* name;
+    void* address;
+    ReplayStatus (*replay)(void* address, const Call& call, long long& ns);
+};
+
+static Function functions[] = {
+#define XD_FUNCTION(name) {#name, NULL, Replayer<decltype(&::name)>::Run},
+    XD_FUNCTIONS(XD_FUNCTION)
+#undef XD_FUNCTION
+#define XD_PLUGIN_FUNCTION(name, type) {#name, NULL, Replayer<type>::Run},
+    XD_PLUGIN_FUNCTIONS(XD_PLUGIN_FUNCTION)
+#undef XD_PLUGIN_FUNCTION
+};
+
+//what each function of the trace took, in the trace and in the replay.
+struct Stats {
+    std::string name;
+    Function* function;             // NULL when xdreplay does not know it
+    long long calls;
+    long long replayed;
+    long long recordedNs;           // of all calls
+    long long replayedRecordedNs;   // of the calls replayed, to compare with replayNs
+    long long replayNs;
+    std::string skipped;            // why calls were not replayed
+};
+
+//load spssxd_p. -lib, then SPSS_HOME/lib, then the library search path.
+static bool LoadLib()
+{
+    std::string libPath = options.libPath;
+    if(libPath.empty()) {
+        const char* spssHome = getenv("SPSS_HOME");
+        libPath = spssHome ? std::string(spssHome) + "/lib/" + LIBNAME : LIBNAME;
+        options.libPath = libPath;
+    }
+    void* pLib = dlopen(libPath.c_str(), RTLD_NOW | RTLD_GLOBAL);
+    if(NULL == pLib) {
+        std::cerr << "dlopen fails with error: " << dlerror() << std::endl;
+        return false;
+    }
+    for(size_t i = 0; i < sizeof(functions) / sizeof(functions[0]); i++) {
+        functions[i].address = dlsym(pLib, functions[i].name);
+    }
+    return true;
+}
+
+static Function* FindFunction(const char* name)
+{
+    for(size_t i = 0; i < sizeof(functions) / sizeof(functions[0]); i++) {
+        if(0 == strcmp(functions[i].name, name)) {
+            return &functions[i];
+        }
+    }
+    return NULL;
+}
+
+static const char* Skip(Stats& stats, const char* reason)
+{
+    if(stats.skipped.empty()) {
+        stats.skipped = reason;
+    }
+    return reason;
+}
+
+static void ReplayCall(Stats& stats, Call& call)
+{
+    stats.calls++;
+    stats.recordedNs += call.ns;
+    if(NULL == stats.function) {
+        Skip(stats, "unknown to xdreplay");
+        return;
+    }
+    if(NULL == stats.function->address) {
+        Skip(stats, "not exported by the library");
+        return;
+    }
+    if(0 == strncmp(stats.name.c_str(), "Free", 4)) {
+        Skip(stats, "frees memory of the recorded calls");
+        return;
+    }
+    if(stats.name == "StartSpss" && 1 == call.args.size()) {
+        Value& commandLine = call.args[0];
+        commandLine.tag = TRACE_STRING;
+        commandLine.null = options.commandLine.empty();
+        commandLine.text = options.commandLine;
+    }
+    long long ns = 0;
+    switch(stats.function->replay(stats.function->address, call, ns)) {
+    case REPLAY_OK:
+        stats.replayed++;
+        stats.replayedRecordedNs += call.ns;
+        stats.replayNs += ns;
+        break;
+    case REPLAY_ARGUMENTS:
+        Skip(stats, "has a list or callback argument");
+        break;
+    case REPLAY_ARITY:
+        Skip(stats, "recorded with another number of arguments");
+        break;
+    }
+}
+
+/*
+ * Reports
+ */
+
+static std::string Quote(const std::string& text)
+{
+    std::string result = "\"";
+    for(size_t i = 0; i < text.size(); i++) {
+        unsigned char ch = (unsigned char)text[i];
+        if('"' == ch || '\\' == ch) {
+            result += '\\';
+            result += (char)ch;
+        } else if(ch < 0x20) {
+            char escape[8];
+            sprintf(escape, "\\u%04x", ch);
+            result += escape;
+        } else {
+            result += (char)ch;
+        }
+    }
+    return result + "\"";
+}
+
+static void Report(const std::vector<Stats*>& called)
+{
+    for(size_t i = 0; i < called.size(); i++) {
+        const Stats& stats = *called[i];
+        fprintf(stderr, "%-36s %9lld calls %12.3f ms recorded", stats.name.c_str(), stats.calls,
+                stats.recordedNs / 1e6);
+        if(stats.replayed > 0) {
+            fprintf(stderr, " %12.3f ms replayed", stats.replayNs / 1e6);
+        }
+        if(stats.replayed < stats.calls) {
+            fprintf(stderr, " (%lld skipped: %s)", stats.calls - stats.replayed, stats.skipped.c_str());
+        }
+        fprintf(stderr, "\n");
+    }
+}
+
+static void WriteJson(FILE* out, const TraceReader& trace, const std::vector<Stats*>& called, long long spanNs)
+{
+    struct utsname host;
+    if(uname(&host) != 0) {
+        strcpy(host.nodename, "unknown");
+        strcpy(host.sysname, "unknown");
+        strcpy(host.machine, "unknown");
+    }
+    long long calls = 0, replayed = 0, recordedNs = 0, replayedRecordedNs = 0, replayNs = 0;
+    for(size_t i = 0; i < called.size(); i++) {
+        calls += called[i]->calls;
+        replayed += called[i]->replayed;
+        recordedNs += called[i]->recordedNs;
+        replayedRecordedNs += called[i]->replayedRecordedNs;
+        replayNs += called[i]->replayNs;
+    }
+    fprintf(out, "{\n");
+    fprintf(out, "  \"tool\": \"xdreplay\",\n");
+    fprintf(out, "  \"format\": 1,\n");
+    fprintf(out, "  \"time\": %ld,\n", (long)time(NULL));
+    fprintf(out, "  \"host\": %s,\n", Quote(host.nodename).c_str());
+    fprintf(out, "  \"platform\": %s,\n", Quote(std::string(host.sysname) + " " + host.machine).c_str());
+    fprintf(out, "  \"library\": %s,\n", Quote(options.libPath).c_str());
+    fprintf(out, "  \"trace\": %s,\n", Quote(options.tracePath).c_str());
+    fprintf(out, "  \"values\": %s,\n", trace.values ? "true" : "false");
+    fprintf(out, "  \"calls\": %lld,\n", calls);
+    fprintf(out, "  \"replayed\": %lld,\n", replayed);
+    fprintf(out, "  \"span_seconds\": %.9f,\n", spanNs / 1e9);
+    fprintf(out, "  \"recorded_seconds\": %.9f,\n", recordedNs / 1e9);
+    fprintf(out, "  \"replayed_recorded_seconds\": %.9f,\n", replayedRecordedNs / 1e9);
+    fprintf(out, "  \"replay_seconds\": %.9f,\n", replayNs / 1e9);
+    fprintf(out, "  \"functions\": [");
+    for(size_t i = 0; i < called.size(); i++) {
+        const Stats& stats = *called[i];
+        fprintf(out, "%s\n    {\"name\": %s, \"calls\": %lld, \"replayed\": %lld", i ? "," : "",
+                Quote(stats.name).c_str(), stats.calls, stats.replayed);
+        fprintf(out, ",\n     \"recorded_seconds\": %.9f, \"replayed_recorded_seconds\": %.9f, \"replay_seconds\": %.9f",
+                stats.recordedNs / 1e9, stats.replayedRecordedNs / 1e9, stats.replayNs / 1e9);
+        if(stats.replayed < stats.calls) {
+            fprintf(out, ",\n     \"skipped\": %s", Quote(stats.skipped).c_str());
+        }
+        fprintf(out, "}");
+    }
+    fprintf(out, "\n  ]\n}\n");
+}
+
+static void Usage()
+{
+    std::cout << "usage: xdreplay -trace file [-lib path] [-cmdline \"StartSpss command line\"] [-out file.json]"
+              << std::endl;
+}
+
+int main(int argc, char* argv[])
+{
+    for(int i = 1; i < argc; i++) {
+        std::string option(argv[i]);
+        if(i + 1 >= argc) {
+            Usage();
+            return 1;
+        }
+        const char* value = argv[++i];
+        if(option == "-trace") {
+            options.tracePath = value;
+        } else if(option == "-lib") {
+            options.libPath = value;
+        } else if(option == "-cmdline") {
+            options.commandLine = value;
+        } else if(option == "-out") {
+            options.outPath = value;
+        } else {
+            Usage();
+            return 1;
+        }
+    }
+    if(options.tracePath.empty()) {
+        Usage();
+        return 1;
+    }
+
+    TraceReader trace;
+    if(!trace.Open(options.tracePath) || !LoadLib()) {
+        return 1;
+    }
+    std::vector<Stats> stats(trace.names.size());
+    for(size_t i = 0; i < stats.size(); i++) {
+        stats[i].name = trace.names[i];
+        stats[i].function = FindFunction(trace.names[i].c_str());
+        stats[i].calls = stats[i].replayed = 0;
+        stats[i].recordedNs = stats[i].replayedRecordedNs = stats[i].replayNs = 0;
+    }
+
+    Call call;
+    long long spanNs = 0, lastNs = 0;
+    while(trace.Next(call)) {
+        spanNs += call.startNs;
+        lastNs = call.ns;
+        ReplayCall(stats[call.function], call);
+    }
+    spanNs += lastNs;
+    Function* isBackendReady = FindFunction("IsBackendReady");
+    Function* stopSpss = FindFunction("StopSpss");
+    if(isBackendReady->address && stopSpss->address && ((bool (*)())isBackendReady->address)()) {
+        ((void (*)())stopSpss->address)();
+    }
+
+    std::vector<Stats*> called;
+    for(size_t i = 0; i < stats.size(); i++) {
+        if(stats[i].calls > 0) {
+            called.push_back(&stats[i]);
+        }
+    }
+    std::sort(called.begin(), called.end(), [](const Stats* a, const Stats* b) {
+        return a->recordedNs > b->recordedNs;
+    });
+    Report(called);
+
+    FILE* out = options.outPath.empty() ? stdout : fopen(options.outPath.c_str(), "w");
+    if(NULL == out) {
+        std::cerr << "cannot write " << options.outPath << std::endl;
+        return 1;
+    }
+    WriteJson(out, trace, called, spanNs);
+    if(out != stdout) {
+        fclose(out);
+    }
+    return 0;
+}
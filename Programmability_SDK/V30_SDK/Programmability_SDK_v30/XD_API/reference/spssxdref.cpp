@@ -0,0 +1,2230 @@
+/************************************************************************
+** Licensed Materials - Property of IBM
+**
+** IBM SPSS Products: Statistics Common
+**
+** (C) Copyright IBM Corp. 1989, 2021
+**
+** US Government Users Restricted Rights - Use, duplication or disclosure
+** restricted by GSA ADP Schedule Contract with IBM Corp.
+************************************************************************/
+
+/**
+ * spssxdref.cpp -
+ *     an in-memory reference libspssxd_p. It implements the session, Submit,
+ *     dictionary, case cursor (read, write and append), data step and pivot
+ *     table functions of spssxd.h over synthetic datasets, so the SDK (PyInvokeSpss, the testxd examples,
+ *     spssxd.hpp) can be built, tested and timed without an installation of
+ *     IBM SPSS Statistics. The functions it does not implement are missing from
+ *     the library, which PyInvokeSpss reports as error 1076.
+ *
+ *     The active dataset of a started backend is synthetic: NUMERIC numeric
+ *     variables N1, N2, ... and STRINGS string variables S1, S2, ... of WIDTH
+ *     bytes, with CASES cases. Numeric value v of case r is ((r*7 + v*13) % 1000)/10
+ *     and every MISSING-th case (0 = none) has system-missing numeric values;
+ *     string value s of case r is "s<s>r<r>". A case is stored as the backend
+ *     stores it: 8 bytes per numeric, the string bytes padded with blanks to a
+ *     multiple of 8, so NextCasePtr and GetVarObsIndex give the real layout.
+ *
+ *     The environment sets the defaults when the backend starts:
+ *         SPSSXD_REF_CASES       the number of cases (default 1000)
+ *         SPSSXD_REF_NUMERIC     the number of numeric variables (default 8)
+ *         SPSSXD_REF_STRINGS     the number of string variables (default 2)
+ *         SPSSXD_REF_WIDTH       the width of the string variables (default 8)
+ *         SPSSXD_REF_MISSING     every n-th case is missing (default 0)
+ *     and the latency added to the calls:
+ *         SPSSXD_REF_STARTUP_MS  StartSpss, in milliseconds
+ *         SPSSXD_REF_SUBMIT_US   each command of Submit, in microseconds
+ *         SPSSXD_REF_CASE_US     NextCase and NextCasePtr, in microseconds
+ *         SPSSXD_REF_CALL_US     every other call, in microseconds
+ *
+ *     Submit understands these commands; any other command succeeds and is
+ *     only written to the output:
+ *         NEW FILE.                                  empties the active dataset
+ *         REFERENCE DATA [CASES=n] [NUMERIC=n] [STRINGS=n] [WIDTH=n] [MISSING=n].
+ *                                                    replaces the active dataset
+ *         REFERENCE ERROR LEVEL=n.                   returns error level n
+ *         SET LOCALE=name.                           changes the locale
+ *         DATASET NAME name. / DATASET ACTIVATE name.
+ *         DATASET CLOSE name. / DATASET CLOSE ALL.
+ *         ADD FILES /FILE=* /FILE='name'.            appends the cases of name
+ *         MATCH FILES /FILE=* ... /FILE='name' ...   copies the values of name
+ *                                                    into the variables of the
+ *                                                    same name, case by case
+ *
+ *     The output of StartSpss -out "file" receives each command and a summary
+ *     of each procedure with its pivot tables.
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <float.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+
+#include "spssxd.h"
+
+//the error codes of spssxd.h.
+static const int NO_DATA_SOURCE     = 9;
+static const int INVALID_INDEX      = 10;
+static const int NOT_READY          = 17;
+static const int CURSOR_RUNNING     = 20;
+static const int NO_CURSOR          = 21;
+static const int NO_MORE_DATA       = 23;
+static const int WRONG_TYPE         = 24;
+static const int DUPLICATE_NAME     = 25;
+static const int INVALID_NAME       = 27;
+static const int INVALID_BUFFER     = 50;
+static const int NO_WRITE_CURSOR    = 60;     // no cursor of the mode the call needs
+static const int INVALID_VAR_TYPE   = 62;
+static const int NO_PROCEDURE       = 65;
+static const int INVALID_DATASET    = 87;
+static const int NOT_IN_DATA_STEP   = 89;
+static const int INVALID_ROW        = 97;
+static const int INVALID_POSITION   = 111;
+
+static const double SYSMIS = -DBL_MAX;
+
+struct Variable {
+    std::string name;
+    std::string label;
+    int type;                   // 0 for numeric, the width for a string
+    int obs;                    // the first 8 byte slot of the value in a case
+};
+
+struct Dataset {
+    std::vector<Variable> vars;
+    int slots;                  // the case length in 8 byte slots
+    long rows;
+    std::vector<double> data;   // rows * slots
+
+    Dataset() : slots(0), rows(0) {}
+};
+
+struct Config {
+    long cases;
+    int numeric;
+    int strings;
+    int width;
+    long missing;
+    long startupMs;
+    long submitUs;
+    long caseUs;
+    long callUs;
+};
+
+struct PivotTable {
+    std::string outline;
+    std::string title;
+    int dimensions;
+    long categories;
+    long cells;
+};
+
+static std::recursive_mutex backendMutex;
+static Config config;
+static bool started = false;
+static int currentMode = 0;
+static int originMode = 0;
+static FILE* output = NULL;
+static std::string locale = "en_US.UTF-8";
+static int localeGeneration = 0;
+static std::string pending;                     // the lines of QueueCommandPart
+
+static std::map<std::string, Dataset> datasets;
+static std::string activeName;
+static int datasetSerial = 0;
+static bool inDataStep = false;
+
+static Dataset* cursorDs = NULL;
+static long cursorRow = -1;                     // -1 when there is no cursor
+static char cursorMode = 'r';                   // 'r', 'w' or 'a'
+static std::vector<Variable> newVars;           // the variables CommitHeader adds
+static Dataset* writeDs = NULL;                 // the dataset of the write cursor, with the new variables
+static std::vector<double> caseBuffer;          // the values of SetValueNumeric and SetValueChar
+static std::vector<char> caseSet;               // which variables of caseBuffer are set
+static std::vector<double> newCases;            // the cases of CommitNewCase until EndChanges
+
+static std::string procedure;
+static std::vector<PivotTable> tables;
+static long textBlocks = 0;
+
+//wait for us microseconds; a short wait spins so that it is exact.
+static void Delay(long us)
+{
+    if(us <= 0) {
+        return;
+    }
+    if(us >= 1000) {
+        std::this_thread::sleep_for(std::chrono::microseconds(us));
+        return;
+    }
+    std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now() + std::chrono::microseconds(us);
+    while(std::chrono::steady_clock::now() < end) {
+    }
+}
+
+#define ENTER() \
+    std::lock_guard<std::recursive_mutex> lock(backendMutex); \
+    Delay(config.callUs)
+
+static long EnvLong(const char* name, long value)
+{
+    const char* text = getenv(name);
+    return text ? atol(text) : value;
+}
+
+static void Configure()
+{
+    config.cases = EnvLong("SPSSXD_REF_CASES", 1000);
+    config.numeric = (int)EnvLong("SPSSXD_REF_NUMERIC", 8);
+    config.strings = (int)EnvLong("SPSSXD_REF_STRINGS", 2);
+    config.width = (int)EnvLong("SPSSXD_REF_WIDTH", 8);
+    config.missing = EnvLong("SPSSXD_REF_MISSING", 0);
+    config.startupMs = EnvLong("SPSSXD_REF_STARTUP_MS", 0);
+    config.submitUs = EnvLong("SPSSXD_REF_SUBMIT_US", 0);
+    config.caseUs = EnvLong("SPSSXD_REF_CASE_US", 0);
+    config.callUs = EnvLong("SPSSXD_REF_CALL_US", 0);
+}
+
+static void Output(const char* format, const std::string& text)
+{
+    if(output) {
+        fprintf(output, format, text.c_str());
+        fflush(output);
+    }
+}
+
+/************************************************************************
+ * Datasets
+ ************************************************************************/
+
+static Dataset* Active()
+{
+    std::map<std::string, Dataset>::iterator it = datasets.find(activeName);
+    return it == datasets.end() ? NULL : &it->second;
+}
+
+//a dataset by name; "*" is the active dataset.
+static Dataset* Find(const char* name)
+{
+    if(NULL == name) {
+        return NULL;
+    }
+    if(0 == strcmp(name, "*")) {
+        return Active();
+    }
+    std::map<std::string, Dataset>::iterator it = datasets.find(name);
+    return it == datasets.end() ? NULL : &it->second;
+}
+
+static std::string NewDatasetName()
+{
+    std::string name;
+    do {
+        char buffer[24];
+        sprintf(buffer, "DataSet%d", ++datasetSerial);
+        name = buffer;
+    } while(datasets.count(name));
+    return name;
+}
+
+static char* Value(Dataset& ds, long row, const Variable& var)
+{
+    return (char*)&ds.data[row * ds.slots + var.obs];
+}
+
+static int Slots(int type)
+{
+    return 0 == type ? 1 : (type + 7) / 8;
+}
+
+//set every value of the case at values, laid out as the cases of ds, to
+//system-missing or blanks.
+static void BlankCase(const Dataset& ds, double* values)
+{
+    for(size_t i = 0; i < ds.vars.size(); i++) {
+        const Variable& var = ds.vars[i];
+        if(0 == var.type) {
+            values[var.obs] = SYSMIS;
+        } else {
+            memset(&values[var.obs], ' ', Slots(var.type) * 8);
+        }
+    }
+}
+
+static void ClearCase(Dataset& ds, long row)
+{
+    BlankCase(ds, &ds.data[row * ds.slots]);
+}
+
+//give the variables new obs indexes and move the values to them.
+static void Relayout(Dataset& ds, const std::vector<Variable>& vars)
+{
+    Dataset result;
+    result.vars = vars;
+    result.rows = ds.rows;
+    for(size_t i = 0; i < result.vars.size(); i++) {
+        result.vars[i].obs = result.slots;
+        result.slots += Slots(result.vars[i].type);
+    }
+    result.data.assign(result.rows * result.slots, 0.0);
+    for(long r = 0; r < result.rows; r++) {
+        ClearCase(result, r);
+        for(size_t i = 0; i < result.vars.size(); i++) {
+            for(size_t j = 0; j < ds.vars.size(); j++) {
+                if(ds.vars[j].name == result.vars[i].name && ds.vars[j].type == result.vars[i].type) {
+                    memcpy(Value(result, r, result.vars[i]), Value(ds, r, ds.vars[j]), Slots(ds.vars[j].type) * 8);
+                    break;
+                }
+            }
+        }
+    }
+    ds = result;
+}
+
+static void Generate(Dataset& ds, const Config& c)
+{
+    std::vector<Variable> vars;
+    for(int i = 0; i < c.numeric + c.strings; i++) {
+        Variable var;
+        char name[16];
+        if(i < c.numeric) {
+            sprintf(name, "N%d", i + 1);
+            var.type = 0;
+        } else {
+            sprintf(name, "S%d", i - c.numeric + 1);
+            var.type = c.width > 0 ? c.width : 1;
+        }
+        var.name = name;
+        var.obs = 0;
+        vars.push_back(var);
+    }
+    ds = Dataset();
+    ds.rows = c.cases > 0 ? c.cases : 0;
+    Relayout(ds, vars);
+    for(long r = 0; r < ds.rows; r++) {
+        bool missing = c.missing > 0 && (r + 1) % c.missing == 0;
+        for(size_t i = 0; i < ds.vars.size(); i++) {
+            const Variable& var = ds.vars[i];
+            if(0 == var.type) {
+                *(double*)Value(ds, r, var) = missing ? SYSMIS : ((r * 7 + (long)i * 13) % 1000) / 10.0;
+            } else {
+                char text[48];
+                int length = sprintf(text, "s%dr%ld", (int)i - c.numeric + 1, r + 1);
+                memcpy(Value(ds, r, var), text, std::min(length, var.type));
+            }
+        }
+    }
+}
+
+/************************************************************************
+ * Session
+ ************************************************************************/
+
+bool IsBackendReady()
+{
+    return started;
+}
+
+bool IsXDriven()
+{
+    return true;
+}
+
+int StartSpss(const char* commandline)
+{
+    std::lock_guard<std::recursive_mutex> lock(backendMutex);
+    if(started) {
+        return 0;
+    }
+    Configure();
+    Delay(config.startupMs * 1000);
+
+    //-out "file" or -out file
+    const char* out = commandline ? strstr(commandline, "-out") : NULL;
+    if(out) {
+        out += 4;
+        while(' ' == *out) {
+            out++;
+        }
+        std::string path;
+        if('"' == *out) {
+            const char* end = strchr(out + 1, '"');
+            path.assign(out + 1, end ? end - out - 1 : strlen(out + 1));
+        } else {
+            path.assign(out, strcspn(out, " "));
+        }
+        output = path.empty() ? NULL : fopen(path.c_str(), "w");
+    }
+
+    datasets.clear();
+    activeName = NewDatasetName();
+    Generate(datasets[activeName], config);
+    started = true;
+    return 0;
+}
+
+void StopSpss()
+{
+    std::lock_guard<std::recursive_mutex> lock(backendMutex);
+    started = false;
+    datasets.clear();
+    cursorDs = NULL;
+    cursorRow = -1;
+    inDataStep = false;
+    pending.clear();
+    procedure.clear();
+    tables.clear();
+    if(output) {
+        fclose(output);
+        output = NULL;
+    }
+}
+
+int SetXDriveMode(int mode)
+{
+    ENTER();
+    if(0 == originMode) {
+        originMode = mode;
+    }
+    currentMode = mode;
+    return 0;
+}
+
+int GetXDriveMode(int& currMode, int& origin)
+{
+    ENTER();
+    currMode = currentMode;
+    origin = originMode;
+    return 0;
+}
+
+//Submit runs no BEGIN PROGRAM blocks, so the caller is never nested.
+int GetNestDepth(int& depth)
+{
+    ENTER();
+    depth = 0;
+    return started ? 0 : NOT_READY;
+}
+
+int IsUTF8mode()
+{
+    return 1;
+}
+
+bool IsDistributedMode()
+{
+    return false;
+}
+
+const char* GetSPSSLocale(int& errLevel)
+{
+    ENTER();
+    errLevel = started ? 0 : NOT_READY;
+    return locale.c_str();
+}
+
+extern "C" int GetCLocale(char** xdlocale)
+{
+    ENTER();
+    *xdlocale = new char[2];
+    strcpy(*xdlocale, "C");
+    return started ? 0 : NOT_READY;
+}
+
+int GetCLocaleGeneration(int& generation)
+{
+    ENTER();
+    generation = localeGeneration;
+    return started ? 0 : NOT_READY;
+}
+
+const char* GetOutputLanguage(int& errLevel)
+{
+    ENTER();
+    errLevel = started ? 0 : NOT_READY;
+    return "English";
+}
+
+int GetSystemMissingValue(double& sysMissing)
+{
+    sysMissing = SYSMIS;
+    return 0;
+}
+
+int FreeString(char* str)
+{
+    delete [] str;
+    return 0;
+}
+
+int FreeStringArray(char** array, const int length)
+{
+    for(int i = 0; i < length; i++) {
+        delete [] array[i];
+    }
+    delete [] array;
+    return 0;
+}
+
+//a string list handle is a std::vector<std::string>.
+int GetStringListLength(void* listHandle)
+{
+    return listHandle ? (int)((std::vector<std::string>*)listHandle)->size() : 0;
+}
+
+const char* GetStringFromList(void* listHandle, int index)
+{
+    std::vector<std::string>* list = (std::vector<std::string>*)listHandle;
+    if(NULL == list || index < 0 || index >= (int)list->size()) {
+        return NULL;
+    }
+    return (*list)[index].c_str();
+}
+
+void RemoveStringList(void* listHandle)
+{
+    delete (std::vector<std::string>*)listHandle;
+}
+
+/************************************************************************
+ * Submit
+ ************************************************************************/
+
+static std::string Upper(const std::string& text)
+{
+    std::string result(text);
+    for(size_t i = 0; i < result.size(); i++) {
+        result[i] = (char)toupper((unsigned char)result[i]);
+    }
+    return result;
+}
+
+//the value of KEYWORD=n in a command, or value.
+static long Keyword(const std::string& command, const char* keyword, long value)
+{
+    size_t at = command.find(std::string(keyword) + "=");
+    return at == std::string::npos ? value : atol(command.c_str() + at + strlen(keyword) + 1);
+}
+
+//the word after prefix, without quotes and the command terminator.
+static std::string Argument(const std::string& command, size_t prefix)
+{
+    std::string word = command.substr(prefix);
+    word.erase(0, word.find_first_not_of(" ='\""));
+    word.erase(word.find_last_not_of(" .'\"") + 1);
+    return word;
+}
+
+//ADD FILES /FILE=* /FILE='name' appends the cases of name to the active
+//dataset, and MATCH FILES /FILE=* ... /FILE='name' ... replaces the values of
+//the active dataset's variables with those of the same name in name, case by
+//case; the other subcommands, such as the /RENAME and /DROP the Python Cursor
+//adds, are ignored.
+static int CombineFiles(const std::string& text, bool add, Dataset& active)
+{
+    size_t at = Upper(text).find("/FILE='");
+    if(at == std::string::npos) {
+        return 3;
+    }
+    at += 7;
+    std::string name = text.substr(at, text.find('\'', at) - at);
+    std::map<std::string, Dataset>::iterator it = datasets.find(name);
+    if(it == datasets.end() || &it->second == &active) {
+        return 3;
+    }
+    Dataset& other = it->second;
+    long firstRow = active.rows;
+    if(add) {
+        active.data.resize((active.rows + other.rows) * active.slots);
+        active.rows += other.rows;
+        for(long r = firstRow; r < active.rows; r++) {
+            ClearCase(active, r);
+        }
+    }
+    for(size_t i = 0; i < active.vars.size(); i++) {
+        for(size_t j = 0; j < other.vars.size(); j++) {
+            const Variable& to = active.vars[i];
+            const Variable& from = other.vars[j];
+            if(to.name != from.name || to.type != from.type) {
+                continue;
+            }
+            long rows = add ? other.rows : std::min(active.rows, other.rows);
+            for(long r = 0; r < rows; r++) {
+                memcpy(Value(active, (add ? firstRow : 0) + r, to), Value(other, r, from), Slots(to.type) * 8);
+            }
+            break;
+        }
+    }
+    return 0;
+}
+
+static int RunCommand(const std::string& command)
+{
+    Delay(config.submitUs);
+    Output("%s\n", command);
+
+    std::string text = command;
+    text.erase(0, text.find_first_not_of(" \t\r\n"));
+    std::string upper = Upper(text);
+    Dataset* active = Active();
+
+    if(0 == upper.compare(0, 9, "NEW FILE.") || upper == "NEW FILE") {
+        if(active) {
+            *active = Dataset();
+        }
+    } else if(0 == upper.compare(0, 14, "REFERENCE DATA")) {
+        Config c = config;
+        c.cases = Keyword(upper, "CASES", c.cases);
+        c.numeric = (int)Keyword(upper, "NUMERIC", c.numeric);
+        c.strings = (int)Keyword(upper, "STRINGS", c.strings);
+        c.width = (int)Keyword(upper, "WIDTH", c.width);
+        c.missing = Keyword(upper, "MISSING", c.missing);
+        if(active) {
+            Generate(*active, c);
+        }
+    } else if(0 == upper.compare(0, 15, "REFERENCE ERROR")) {
+        return (int)Keyword(upper, "LEVEL", 3);
+    } else if(0 == upper.compare(0, 10, "SET LOCALE")) {
+        locale = Argument(text, 10);
+        localeGeneration++;
+    } else if(0 == upper.compare(0, 12, "DATASET NAME") && active) {
+        std::string name = Argument(text, 12);
+        if(!name.empty() && name != activeName) {
+            if(active == cursorDs) {
+                cursorRow = -1;
+                cursorDs = NULL;
+            }
+            datasets[name] = *active;
+            datasets.erase(activeName);
+            activeName = name;
+        }
+    } else if(0 == upper.compare(0, 16, "DATASET ACTIVATE")) {
+        std::string name = Argument(text, 16);
+        if(!datasets.count(name)) {
+            return 3;
+        }
+        activeName = name;
+    } else if(0 == upper.compare(0, 17, "DATASET CLOSE ALL")) {
+        for(std::map<std::string, Dataset>::iterator it = datasets.begin(); it != datasets.end();) {
+            if(it->first == activeName) {
+                ++it;
+            } else {
+                datasets.erase(it++);
+            }
+        }
+    } else if(0 == upper.compare(0, 13, "DATASET CLOSE")) {
+        std::string name = Argument(text, 13);
+        if(!datasets.count(name)) {
+            return 3;
+        }
+        if(name != activeName) {
+            if(&datasets[name] == cursorDs) {
+                cursorRow = -1;
+                cursorDs = NULL;
+            }
+            datasets.erase(name);
+        }
+    } else if((0 == upper.compare(0, 9, "ADD FILES") || 0 == upper.compare(0, 11, "MATCH FILES")) && active) {
+        return CombineFiles(text, 'A' == upper[0], *active);
+    }
+    return 0;
+}
+
+int QueueCommandPart(const char* line, int length)
+{
+    ENTER();
+    if(!started) {
+        return NOT_READY;
+    }
+    pending.append(line, length);
+    pending.append("\n");
+    return 0;
+}
+
+//run the queued lines and line, one command per line that ends with '.'.
+int Submit(const char* command, int length)
+{
+    ENTER();
+    if(!started) {
+        return NOT_READY;
+    }
+    std::string lines = pending + std::string(command, length);
+    pending.clear();
+
+    int errLevel = 0;
+    std::string current;
+    size_t start = 0;
+    while(start <= lines.size()) {
+        size_t end = lines.find('\n', start);
+        std::string line = lines.substr(start, end == std::string::npos ? std::string::npos : end - start);
+        current += current.empty() ? line : "\n" + line;
+        size_t last = line.find_last_not_of(" \t\r");
+        if(last != std::string::npos && '.' == line[last]) {
+            errLevel = std::max(errLevel, RunCommand(current));
+            current.clear();
+        }
+        if(end == std::string::npos) {
+            break;
+        }
+        start = end + 1;
+    }
+    if(current.find_first_not_of(" \t\r\n") != std::string::npos) {
+        errLevel = std::max(errLevel, RunCommand(current));
+    }
+    return errLevel;
+}
+
+int SubmitBatch(const char* const* cmds, const int* lens, int n, int* perCommandErr)
+{
+    ENTER();
+    int errLevel = 0;
+    for(int i = 0; i < n; i++) {
+        int level = Submit(cmds[i], lens[i]);
+        if(perCommandErr) {
+            perCommandErr[i] = level;
+        }
+        errLevel = std::max(errLevel, level);
+    }
+    return errLevel;
+}
+
+/************************************************************************
+ * Dictionary of the active dataset
+ ************************************************************************/
+
+//the indexed variable of the active dataset, or NULL with errCode set.
+static const Variable* ActiveVariable(int index, int& errCode)
+{
+    Dataset* ds = Active();
+    if(!started) {
+        errCode = NOT_READY;
+    } else if(NULL == ds) {
+        errCode = NO_DATA_SOURCE;
+    } else if(index < 0 || index >= (int)ds->vars.size()) {
+        errCode = INVALID_INDEX;
+    } else {
+        errCode = 0;
+        return &ds->vars[index];
+    }
+    return NULL;
+}
+
+unsigned GetVariableCount(int& errCode)
+{
+    ENTER();
+    Dataset* ds = Active();
+    errCode = started ? 0 : NOT_READY;
+    return ds ? (unsigned)ds->vars.size() : 0;
+}
+
+long GetRowCount(int& errCode)
+{
+    ENTER();
+    Dataset* ds = Active();
+    errCode = started ? 0 : NOT_READY;
+    return ds ? ds->rows : 0;
+}
+
+const char* GetVariableName(int index, int& errCode)
+{
+    ENTER();
+    const Variable* var = ActiveVariable(index, errCode);
+    return var ? var->name.c_str() : NULL;
+}
+
+int GetVariableType(int index, int& errCode)
+{
+    ENTER();
+    const Variable* var = ActiveVariable(index, errCode);
+    return var ? var->type : 0;
+}
+
+const char* GetVariableLabel(int index, int& errCode)
+{
+    ENTER();
+    const Variable* var = ActiveVariable(index, errCode);
+    return var ? var->label.c_str() : NULL;
+}
+
+//F8.2 for numeric variables, Aw for strings; valid until the next call.
+static const char* Format(const Variable* var)
+{
+    static char format[16];
+    if(NULL == var) {
+        return NULL;
+    }
+    if(0 == var->type) {
+        strcpy(format, "F8.2");
+    } else {
+        sprintf(format, "A%d", var->type);
+    }
+    return format;
+}
+
+const char* GetVariableFormat(int index, int& errCode)
+{
+    ENTER();
+    return Format(ActiveVariable(index, errCode));
+}
+
+int GetVariableFormatType(int varIndex, int& formatType, int& formatWidth, int& formatDecimal)
+{
+    ENTER();
+    int errCode = 0;
+    const Variable* var = ActiveVariable(varIndex, errCode);
+    if(var) {
+        formatType = 0 == var->type ? 5 : 1;
+        formatWidth = 0 == var->type ? 8 : var->type;
+        formatDecimal = 0 == var->type ? 2 : 0;
+    }
+    return errCode;
+}
+
+//scale for numeric variables, nominal for strings.
+int GetVariableMeasurementLevel(int index, int& errCode)
+{
+    ENTER();
+    const Variable* var = ActiveVariable(index, errCode);
+    return var ? (0 == var->type ? 4 : 2) : 0;
+}
+
+int GetVarNMissingValues(const int index, int* missingFormat, double* v1, double* v2, double* v3)
+{
+    ENTER();
+    int errCode = 0;
+    const Variable* var = ActiveVariable(index, errCode);
+    if(var && var->type != 0) {
+        errCode = WRONG_TYPE;
+    }
+    *missingFormat = 0;
+    return errCode;
+}
+
+int GetVarCMissingValues(const int index, int* missingFormat, char* v1, char* v2, char* v3)
+{
+    ENTER();
+    int errCode = 0;
+    const Variable* var = ActiveVariable(index, errCode);
+    if(var && 0 == var->type) {
+        errCode = WRONG_TYPE;
+    }
+    *missingFormat = 0;
+    return errCode;
+}
+
+const char* GetWeightVar(int& errLevel)
+{
+    ENTER();
+    errLevel = started ? 0 : NOT_READY;
+    return NULL;
+}
+
+/************************************************************************
+ * Case cursor
+ ************************************************************************/
+
+//forget the new variables and the values not committed yet.
+static void ClearWriteState()
+{
+    delete writeDs;
+    writeDs = NULL;
+    newVars.clear();
+    newCases.clear();
+    caseBuffer.clear();
+    caseSet.clear();
+}
+
+int MakeCaseCursor(const char* accessType)
+{
+    ENTER();
+    if(!started) {
+        return NOT_READY;
+    }
+    if(cursorRow >= 0) {
+        return CURSOR_RUNNING;
+    }
+    cursorDs = Active();
+    if(NULL == cursorDs) {
+        return NO_DATA_SOURCE;
+    }
+    cursorRow = 0;
+    cursorMode = (accessType && ('w' == *accessType || 'a' == *accessType)) ? *accessType : 'r';
+    ClearWriteState();
+    return 0;
+}
+
+int HasCursor(int& hasCur)
+{
+    ENTER();
+    hasCur = cursorRow >= 0 ? 1 : 0;
+    return 0;
+}
+
+//cursorRow is the number of cases read: the current case is cursorRow - 1.
+int NextCase()
+{
+    std::lock_guard<std::recursive_mutex> lock(backendMutex);
+    Delay(config.caseUs);
+    if(!started) {
+        return NOT_READY;
+    }
+    if(cursorRow < 0) {
+        return NO_CURSOR;
+    }
+    if(cursorRow >= cursorDs->rows) {
+        return NO_MORE_DATA;
+    }
+    cursorRow++;
+    return 0;
+}
+
+void* NextCasePtr(int& caseSize, int& errLevel)
+{
+    std::lock_guard<std::recursive_mutex> lock(backendMutex);
+    errLevel = NextCase();
+    if(errLevel != 0) {
+        caseSize = 0;
+        return NULL;
+    }
+    caseSize = cursorDs->slots * 8;
+    return &cursorDs->data[(cursorRow - 1) * cursorDs->slots];
+}
+
+//the indexed variable of the current case, or NULL with errCode set.
+static const Variable* CaseVariable(unsigned varIndex, int& errCode)
+{
+    if(!started) {
+        errCode = NOT_READY;
+    } else if(cursorRow < 0) {
+        errCode = NO_CURSOR;
+    } else if(varIndex >= cursorDs->vars.size()) {
+        errCode = INVALID_INDEX;
+    } else if(0 == cursorRow) {
+        errCode = INVALID_POSITION;
+    } else if(cursorRow > cursorDs->rows) {
+        errCode = NO_MORE_DATA;
+    } else {
+        errCode = 0;
+        return &cursorDs->vars[varIndex];
+    }
+    return NULL;
+}
+
+int GetNumericValue(unsigned varIndex, double& result, int& isMissing)
+{
+    ENTER();
+    int errCode = 0;
+    const Variable* var = CaseVariable(varIndex, errCode);
+    if(NULL == var) {
+        return errCode;
+    }
+    if(var->type != 0) {
+        return WRONG_TYPE;
+    }
+    result = *(double*)Value(*cursorDs, cursorRow - 1, *var);
+    isMissing = SYSMIS == result ? 2 : 0;
+    return 0;
+}
+
+//copies the value, and a terminating NUL when bufferLength leaves room for it.
+int GetStringValue(unsigned varIndex, char* &result, int bufferLength, int &isMissing)
+{
+    ENTER();
+    int errCode = 0;
+    const Variable* var = CaseVariable(varIndex, errCode);
+    if(NULL == var) {
+        return errCode;
+    }
+    if(0 == var->type) {
+        return WRONG_TYPE;
+    }
+    if(bufferLength < var->type) {
+        return INVALID_INDEX;
+    }
+    memcpy(result, Value(*cursorDs, cursorRow - 1, *var), var->type);
+    if(bufferLength > var->type) {
+        result[var->type] = '\0';
+    }
+    isMissing = 0;
+    return 0;
+}
+
+int GetCursorPosition(int& curPos)
+{
+    ENTER();
+    if(cursorRow < 0) {
+        return NO_CURSOR;
+    }
+    curPos = (int)cursorRow - 1;
+    return 0;
+}
+
+//the new variables of a write cursor and their values join the dataset when the cursor ends.
+int RemoveCaseCursor()
+{
+    ENTER();
+    if(cursorDs && writeDs) {
+        *cursorDs = *writeDs;
+    }
+    cursorRow = -1;
+    cursorDs = NULL;
+    ClearWriteState();
+    return started ? 0 : NOT_READY;
+}
+
+/************************************************************************
+ * Write and append cursor
+ ************************************************************************/
+
+//0 when a cursor of mode is running, else its error code.
+static int WriteCursor(char mode)
+{
+    if(!started) {
+        return NOT_READY;
+    }
+    if(cursorRow < 0 || cursorMode != mode) {
+        return NO_WRITE_CURSOR;
+    }
+    return 0;
+}
+
+//a name starts with a letter or @, #, $ and has at most 64 bytes of letters,
+//digits and . _ @ # $.
+static bool ValidName(const char* name)
+{
+    size_t length = name ? strlen(name) : 0;
+    if(0 == length || length > 64 || !(isalpha((unsigned char)name[0]) || strchr("@#$", name[0]))) {
+        return false;
+    }
+    for(size_t i = 1; i < length; i++) {
+        if(!isalnum((unsigned char)name[i]) && !strchr("._@#$", name[i])) {
+            return false;
+        }
+    }
+    return true;
+}
+
+//add a variable to the ones CommitHeader adds; names compare as SPSS does, ignoring case.
+static int AddNewVariable(const char* varName, int varType)
+{
+    if(!ValidName(varName)) {
+        return INVALID_NAME;
+    }
+    if(varType < 0 || varType > 32767) {
+        return INVALID_VAR_TYPE;
+    }
+    std::string upper = Upper(varName);
+    const Dataset* ds = writeDs ? writeDs : cursorDs;
+    for(size_t i = 0; i < ds->vars.size(); i++) {
+        if(Upper(ds->vars[i].name) == upper) {
+            return DUPLICATE_NAME;
+        }
+    }
+    for(size_t i = 0; i < newVars.size(); i++) {
+        if(Upper(newVars[i].name) == upper) {
+            return DUPLICATE_NAME;
+        }
+    }
+    Variable var;
+    var.name = varName;
+    var.type = varType;
+    var.obs = 0;
+    newVars.push_back(var);
+    return 0;
+}
+
+//the buffer needs no room in memory: CommitHeader lays the new variables out.
+int AllocNewVarsBuffer(unsigned int size)
+{
+    ENTER();
+    int errLevel = WriteCursor('w');
+    if(0 == errLevel && 0 == size) {
+        errLevel = INVALID_BUFFER;
+    }
+    return errLevel;
+}
+
+int SetOneVarNameAndType(const char* varName, int varType)
+{
+    ENTER();
+    int errLevel = WriteCursor('w');
+    return errLevel ? errLevel : AddNewVariable(varName, varType);
+}
+
+//adds none of the variables when one of them is invalid.
+int SetVarNameAndType(char* varName[], const int* varType, const unsigned int numOfVar)
+{
+    ENTER();
+    int errLevel = WriteCursor('w');
+    if(errLevel) {
+        return errLevel;
+    }
+    size_t count = newVars.size();
+    for(unsigned int i = 0; i < numOfVar && 0 == errLevel; i++) {
+        errLevel = AddNewVariable(varName[i], varType[i]);
+    }
+    if(errLevel) {
+        newVars.resize(count);
+    }
+    return errLevel;
+}
+
+//the dataset of the cursor with the new variables appended, their values
+//system-missing or blank until CommitCaseRecord sets them. It replaces the
+//dataset of the cursor at RemoveCaseCursor, so the cases read until then, and
+//SaveDataToTempFile, keep the variables the cursor started with.
+int CommitHeader()
+{
+    ENTER();
+    int errLevel = WriteCursor('w');
+    if(errLevel) {
+        return errLevel;
+    }
+    if(NULL == writeDs) {
+        writeDs = new Dataset(*cursorDs);
+    }
+    std::vector<Variable> vars = writeDs->vars;
+    vars.insert(vars.end(), newVars.begin(), newVars.end());
+    Relayout(*writeDs, vars);
+    newVars.clear();
+    caseBuffer.clear();
+    caseSet.clear();
+    return 0;
+}
+
+//the dataset SetValueNumeric, SetValueChar and CommitCaseRecord write.
+static Dataset& CaseDataset()
+{
+    return writeDs ? *writeDs : *cursorDs;
+}
+
+//the named variable of CaseDataset for SetValueNumeric and SetValueChar, with
+//caseBuffer ready to hold its value, or NULL with errLevel set.
+static const Variable* CaseBufferVariable(const char* varName, bool numeric, int& errLevel)
+{
+    errLevel = WriteCursor('a' == cursorMode ? 'a' : 'w');
+    if(errLevel) {
+        return NULL;
+    }
+    Dataset& ds = CaseDataset();
+    if('w' == cursorMode && (0 == cursorRow || cursorRow > ds.rows)) {
+        errLevel = NO_MORE_DATA;
+        return NULL;
+    }
+    const Variable* var = NULL;
+    for(size_t i = 0; i < ds.vars.size() && NULL == var; i++) {
+        if(varName && ds.vars[i].name == varName) {
+            var = &ds.vars[i];
+        }
+    }
+    if(NULL == var) {
+        errLevel = INVALID_NAME;
+        return NULL;
+    }
+    if(numeric != (0 == var->type)) {
+        errLevel = WRONG_TYPE;
+        return NULL;
+    }
+    if(caseBuffer.size() != (size_t)ds.slots) {
+        caseBuffer.assign(ds.slots, 0.0);
+        BlankCase(ds, caseBuffer.data());
+        caseSet.assign(ds.vars.size(), 0);
+    }
+    caseSet[var - &ds.vars[0]] = 1;
+    return var;
+}
+
+int SetValueNumeric(const char* varName, const double value)
+{
+    ENTER();
+    int errLevel = 0;
+    const Variable* var = CaseBufferVariable(varName, true, errLevel);
+    if(var) {
+        caseBuffer[var->obs] = value;
+    }
+    return errLevel;
+}
+
+//the value is cut to the width of the variable and padded with blanks.
+int SetValueChar(const char* varName, const char* value, const int length)
+{
+    ENTER();
+    int errLevel = 0;
+    const Variable* var = CaseBufferVariable(varName, false, errLevel);
+    if(var) {
+        char* cell = (char*)&caseBuffer[var->obs];
+        memset(cell, ' ', var->type);
+        memcpy(cell, value, std::max(0, std::min(length, var->type)));
+    }
+    return errLevel;
+}
+
+//write the values set since the last commit into the current case.
+int CommitCaseRecord()
+{
+    ENTER();
+    int errLevel = WriteCursor('w');
+    if(errLevel) {
+        return errLevel;
+    }
+    Dataset& ds = CaseDataset();
+    if(0 == cursorRow || cursorRow > ds.rows) {
+        return NO_MORE_DATA;
+    }
+    for(size_t i = 0; i < caseSet.size(); i++) {
+        if(caseSet[i]) {
+            const Variable& var = ds.vars[i];
+            memcpy(Value(ds, cursorRow - 1, var), &caseBuffer[var.obs], Slots(var.type) * 8);
+        }
+    }
+    caseBuffer.clear();
+    caseSet.clear();
+    return 0;
+}
+
+//keep the case until EndChanges; the values not set are system-missing or blank.
+int CommitNewCase()
+{
+    ENTER();
+    int errLevel = WriteCursor('a');
+    if(errLevel) {
+        return errLevel;
+    }
+    if(caseBuffer.size() != (size_t)cursorDs->slots) {
+        caseBuffer.assign(cursorDs->slots, 0.0);
+        BlankCase(*cursorDs, caseBuffer.data());
+    }
+    newCases.insert(newCases.end(), caseBuffer.begin(), caseBuffer.end());
+    caseBuffer.clear();
+    caseSet.clear();
+    return 0;
+}
+
+//append the cases of CommitNewCase to the dataset of the cursor.
+int EndChanges()
+{
+    ENTER();
+    int errLevel = WriteCursor('a');
+    if(errLevel) {
+        return errLevel;
+    }
+    cursorDs->data.insert(cursorDs->data.end(), newCases.begin(), newCases.end());
+    cursorDs->rows += (long)(newCases.size() / std::max(1, cursorDs->slots));
+    newCases.clear();
+    return 0;
+}
+
+static long tempFileRows = 0;
+
+//write the values of the variables, all of them when keepCount is 0, case
+//after case as the case buffer holds them. The Python Cursor reads this file.
+int SaveDataToTempFile(const char* filename, int varIndexes[], int keepCount)
+{
+    ENTER();
+    Dataset* ds = Active();
+    if(!started) {
+        return NOT_READY;
+    }
+    if(NULL == ds) {
+        return NO_DATA_SOURCE;
+    }
+    std::vector<const Variable*> vars;
+    for(int i = 0; i < (keepCount > 0 ? keepCount : (int)ds->vars.size()); i++) {
+        int index = keepCount > 0 ? varIndexes[i] : i;
+        if(index < 0 || index >= (int)ds->vars.size()) {
+            return INVALID_INDEX;
+        }
+        vars.push_back(&ds->vars[index]);
+    }
+    FILE* file = fopen(filename, "wb");
+    if(NULL == file) {
+        return INVALID_DATASET;
+    }
+    for(long r = 0; r < ds->rows; r++) {
+        for(size_t i = 0; i < vars.size(); i++) {
+            fwrite(Value(*ds, r, *vars[i]), 8, Slots(vars[i]->type), file);
+        }
+    }
+    fclose(file);
+    tempFileRows = ds->rows;
+    return 0;
+}
+
+long GetRowCountInTempFile(int& errLevel)
+{
+    ENTER();
+    errLevel = started ? 0 : NOT_READY;
+    return tempFileRows;
+}
+
+//read the cases the binary Python Cursor writes, laid out as SaveDataToTempFile
+//writes them, into a new active dataset: the cases to append when newVarCount is 0,
+//else the values of the last newVarCount variables of the active dataset, which
+//MATCH FILES copies back.
+int GetDataFromTempFile(const char* filename, int newVarCount, int caseLen)
+{
+    ENTER();
+    Dataset* ds = Active();
+    if(!started) {
+        return NOT_READY;
+    }
+    if(NULL == ds) {
+        return NO_DATA_SOURCE;
+    }
+    if(newVarCount < 0 || newVarCount > (int)ds->vars.size()) {
+        return INVALID_INDEX;
+    }
+    std::vector<Variable> vars(ds->vars.end() - (newVarCount > 0 ? newVarCount : ds->vars.size()), ds->vars.end());
+    Dataset result;
+    Relayout(result, vars);
+    if(caseLen != result.slots * 8 || 0 == caseLen) {
+        return INVALID_BUFFER;
+    }
+    FILE* file = fopen(filename, "rb");
+    if(NULL == file) {
+        return INVALID_DATASET;
+    }
+    std::vector<double> values(result.slots);
+    while(fread(values.data(), caseLen, 1, file) == 1) {
+        result.data.insert(result.data.end(), values.begin(), values.end());
+        result.rows++;
+    }
+    fclose(file);
+    activeName = NewDatasetName();
+    datasets[activeName] = result;
+    return 0;
+}
+
+//the reference datasets have no splits and no filter.
+int* GetSplitEndIndex(int& size, int& errLevel)
+{
+    ENTER();
+    size = 0;
+    errLevel = started ? 0 : NOT_READY;
+    return NULL;
+}
+
+int IsEndSplit(int& endSplit)
+{
+    ENTER();
+    endSplit = 0;
+    return started ? 0 : NOT_READY;
+}
+
+int IsUseOrFilter(int& isUse)
+{
+    ENTER();
+    isUse = 0;
+    return started ? 0 : NOT_READY;
+}
+
+int SetMode(int mode)
+{
+    ENTER();
+    return started ? 0 : NOT_READY;
+}
+
+int ResetDataPass()
+{
+    ENTER();
+    if(cursorRow < 0) {
+        return NO_CURSOR;
+    }
+    cursorRow = 0;
+    return 0;
+}
+
+/************************************************************************
+ * Data step
+ ************************************************************************/
+
+//the named dataset of the data step, or NULL with errLevel set.
+static Dataset* StepDataset(const char* dsName, int& errLevel)
+{
+    Dataset* ds = Find(dsName);
+    if(!started) {
+        errLevel = NOT_READY;
+    } else if(!inDataStep) {
+        errLevel = NOT_IN_DATA_STEP;
+    } else if(NULL == ds) {
+        errLevel = INVALID_DATASET;
+    } else {
+        errLevel = 0;
+    }
+    return errLevel ? NULL : ds;
+}
+
+int StartDataStep()
+{
+    ENTER();
+    if(!started) {
+        return NOT_READY;
+    }
+    inDataStep = true;
+    return 0;
+}
+
+int EndDataStep()
+{
+    ENTER();
+    inDataStep = false;
+    return started ? 0 : NOT_READY;
+}
+
+int GetNewDatasetName(char* dsName)
+{
+    ENTER();
+    strcpy(dsName, NewDatasetName().c_str());
+    return started ? 0 : NOT_READY;
+}
+
+const char* GetActive(int& errLevel)
+{
+    ENTER();
+    errLevel = started ? 0 : NOT_READY;
+    return activeName.c_str();
+}
+
+int SetActive(const char* name)
+{
+    ENTER();
+    if(!started) {
+        return NOT_READY;
+    }
+    if(!Find(name)) {
+        return INVALID_DATASET;
+    }
+    if(strcmp(name, "*") != 0) {
+        activeName = name;
+    }
+    return 0;
+}
+
+int GetSpssDatasets(char*** nameList, int& length)
+{
+    ENTER();
+    length = (int)datasets.size();
+    *nameList = new char*[length];
+    int i = 0;
+    for(std::map<std::string, Dataset>::iterator it = datasets.begin(); it != datasets.end(); ++it, ++i) {
+        (*nameList)[i] = new char[it->first.size() + 1];
+        strcpy((*nameList)[i], it->first.c_str());
+    }
+    return started ? 0 : NOT_READY;
+}
+
+int CreateDataset(const char* name, const bool isEmpty, const bool hidden)
+{
+    ENTER();
+    if(!started) {
+        return NOT_READY;
+    }
+    std::string dsName = (name && strcmp(name, "*") != 0) ? name : NewDatasetName();
+    datasets[dsName] = Dataset();
+    return 0;
+}
+
+int CloseDataset(const char* name)
+{
+    ENTER();
+    Dataset* ds = Find(name);
+    if(NULL == ds) {
+        return INVALID_DATASET;
+    }
+    if(ds == cursorDs) {
+        cursorRow = -1;
+        cursorDs = NULL;
+    }
+    std::string dsName = (0 == strcmp(name, "*")) ? activeName : name;
+    datasets.erase(dsName);
+    return 0;
+}
+
+int CopyDataset(const char* oriDs, const char* desDs)
+{
+    ENTER();
+    Dataset* ds = Find(oriDs);
+    if(NULL == ds) {
+        return INVALID_DATASET;
+    }
+    Dataset copy = *ds;
+    datasets[desDs] = copy;
+    return 0;
+}
+
+int SetCacheInDS(const char* dsName, bool isCache)
+{
+    ENTER();
+    return Find(dsName) ? 0 : INVALID_DATASET;
+}
+
+unsigned GetVarCountInDS(const char* dsName, int& errLevel)
+{
+    ENTER();
+    Dataset* ds = StepDataset(dsName, errLevel);
+    return ds ? (unsigned)ds->vars.size() : 0;
+}
+
+long GetCaseCountInDS(const char* dsName, int& errLevel)
+{
+    ENTER();
+    Dataset* ds = StepDataset(dsName, errLevel);
+    return ds ? ds->rows : 0;
+}
+
+//the indexed variable of a data step dataset, or NULL with errLevel set.
+static Variable* StepVariable(const char* dsName, int index, int& errLevel)
+{
+    Dataset* ds = StepDataset(dsName, errLevel);
+    if(ds && (index < 0 || index >= (int)ds->vars.size())) {
+        errLevel = INVALID_INDEX;
+    }
+    return errLevel ? NULL : &ds->vars[index];
+}
+
+const char* GetVarNameInDS(const char* dsName, const int index, int& errLevel)
+{
+    ENTER();
+    Variable* var = StepVariable(dsName, index, errLevel);
+    return var ? var->name.c_str() : NULL;
+}
+
+int SetVarNameInDS(const char* dsName, const int index, const char* varName)
+{
+    ENTER();
+    int errLevel = 0;
+    Variable* var = StepVariable(dsName, index, errLevel);
+    if(var) {
+        var->name = varName;
+    }
+    return errLevel;
+}
+
+const char* GetVarLabelInDS(const char* dsName, const int index, int& errLevel)
+{
+    ENTER();
+    Variable* var = StepVariable(dsName, index, errLevel);
+    return var ? var->label.c_str() : NULL;
+}
+
+int SetVarLabelInDS(const char* dsName, const int index, const char* varLabel)
+{
+    ENTER();
+    int errLevel = 0;
+    Variable* var = StepVariable(dsName, index, errLevel);
+    if(var) {
+        var->label = varLabel;
+    }
+    return errLevel;
+}
+
+int GetVarTypeInDS(const char* dsName, const int index, int& errLevel)
+{
+    ENTER();
+    Variable* var = StepVariable(dsName, index, errLevel);
+    return var ? var->type : 0;
+}
+
+const char* GetVarFormatInDS(const char* dsName, const int index, int& errLevel)
+{
+    ENTER();
+    return Format(StepVariable(dsName, index, errLevel));
+}
+
+//the reference variables have no attributes and no value labels.
+int GetVarAttributesNameInDS(const char* dsName, const int index, char*** names, int& length)
+{
+    ENTER();
+    int errLevel = 0;
+    StepVariable(dsName, index, errLevel);
+    *names = new char*[1];
+    length = 0;
+    return errLevel;
+}
+
+int GetVarNValueLabelInDS(const char* dsName, const int index, double** values, char*** labels, int& num)
+{
+    ENTER();
+    int errLevel = 0;
+    StepVariable(dsName, index, errLevel);
+    *values = new double[1];
+    *labels = new char*[1];
+    num = 0;
+    return errLevel;
+}
+
+int GetVarCValueLabelInDS(const char* dsName, const int index, char*** values, char*** labels, int& num)
+{
+    ENTER();
+    int errLevel = 0;
+    StepVariable(dsName, index, errLevel);
+    *values = new char*[1];
+    *labels = new char*[1];
+    num = 0;
+    return errLevel;
+}
+
+//the reference datasets have no file attributes and no multiple response sets.
+int GetDataFileAttributeNamesInDS(const char* dsName, char*** name, int* numOfNames)
+{
+    ENTER();
+    int errLevel = 0;
+    StepDataset(dsName, errLevel);
+    *name = new char*[1];
+    *numOfNames = 0;
+    return errLevel;
+}
+
+int GetDataFileAttributesInDS(const char* dsName, const char* attrName, char*** attr, int* numOfAttr)
+{
+    ENTER();
+    int errLevel = 0;
+    StepDataset(dsName, errLevel);
+    *attr = new char*[1];
+    *numOfAttr = 0;
+    return errLevel;
+}
+
+void* GetMultiResponseSetNamesInDS(const char* dsName, int& errLevel)
+{
+    ENTER();
+    StepDataset(dsName, errLevel);
+    return errLevel ? NULL : new std::vector<std::string>();
+}
+
+int GetVarNMissingValuesInDS(const char* dsName, const int index, int& missingFormat,
+                             double* missingValue1, double* missingValue2, double* missingValue3)
+{
+    ENTER();
+    int errLevel = 0;
+    Variable* var = StepVariable(dsName, index, errLevel);
+    if(var && var->type != 0) {
+        errLevel = WRONG_TYPE;
+    }
+    missingFormat = 0;
+    return errLevel;
+}
+
+int GetVarCMissingValuesInDS(const char* dsName, const int index, int& missingFormat,
+                             char* missingValue1, char* missingValue2, char* missingValue3)
+{
+    ENTER();
+    int errLevel = 0;
+    Variable* var = StepVariable(dsName, index, errLevel);
+    if(var && 0 == var->type) {
+        errLevel = WRONG_TYPE;
+    }
+    missingFormat = 0;
+    return errLevel;
+}
+
+const char* GetVarMeasurementLevelInDS(const char* dsName, const int index, int& errLevel)
+{
+    ENTER();
+    Variable* var = StepVariable(dsName, index, errLevel);
+    return var ? (0 == var->type ? "SCALE" : "NOMINAL") : NULL;
+}
+
+//right aligned numbers, left aligned strings.
+int GetVarAlignmentInDS(const char* dsName, const int index, int& errLevel)
+{
+    ENTER();
+    Variable* var = StepVariable(dsName, index, errLevel);
+    return var ? (0 == var->type ? 1 : 0) : 0;
+}
+
+int GetVarColumnWidthInDS(const char* dsName, const int index, int& errLevel)
+{
+    ENTER();
+    Variable* var = StepVariable(dsName, index, errLevel);
+    return var ? std::max(8, var->type) : 0;
+}
+
+//every variable is an input.
+int GetVarRoleInDS(const char* dsName, const int index, int& errLevel)
+{
+    ENTER();
+    StepVariable(dsName, index, errLevel);
+    return 0;
+}
+
+int FreeDoubleArray(double* array, int length)
+{
+    delete [] array;
+    return 0;
+}
+
+//the case length in 8 byte slots.
+int GetCaseLength(const char* dsName, int& errLevel)
+{
+    ENTER();
+    Dataset* ds = StepDataset(dsName, errLevel);
+    return ds ? ds->slots : 0;
+}
+
+int GetVarObsIndex(const char* dsName, const int columnIndex, int& errLevel)
+{
+    ENTER();
+    Variable* var = StepVariable(dsName, columnIndex, errLevel);
+    return var ? var->obs : 0;
+}
+
+//an index out of range appends the variable.
+int InsertVariable(const char* dsName, const int index, const char* varName, const int type)
+{
+    ENTER();
+    int errLevel = 0;
+    Dataset* ds = StepDataset(dsName, errLevel);
+    if(NULL == ds) {
+        return errLevel;
+    }
+    std::vector<Variable> vars = ds->vars;
+    Variable var;
+    var.name = varName;
+    var.type = type;
+    var.obs = 0;
+    size_t at = (index < 0 || index > (int)vars.size()) ? vars.size() : (size_t)index;
+    vars.insert(vars.begin() + at, var);
+    Relayout(*ds, vars);
+    return 0;
+}
+
+int DeleteVariable(const char* dsName, const int index)
+{
+    ENTER();
+    int errLevel = 0;
+    Dataset* ds = StepDataset(dsName, errLevel);
+    if(NULL == ds) {
+        return errLevel;
+    }
+    if(index < 0 || index >= (int)ds->vars.size()) {
+        return INVALID_INDEX;
+    }
+    std::vector<Variable> vars = ds->vars;
+    vars.erase(vars.begin() + index);
+    Relayout(*ds, vars);
+    return 0;
+}
+
+//a row index out of range appends the case.
+int InsertCase(const char* dsName, const long rowIndex)
+{
+    ENTER();
+    int errLevel = 0;
+    Dataset* ds = StepDataset(dsName, errLevel);
+    if(NULL == ds) {
+        return errLevel;
+    }
+    long at = (rowIndex < 0 || rowIndex > ds->rows) ? ds->rows : rowIndex;
+    ds->data.insert(ds->data.begin() + at * ds->slots, ds->slots, 0.0);
+    ds->rows++;
+    ClearCase(*ds, at);
+    return 0;
+}
+
+int DeleteCase(const char* dsName, const long rowIndex)
+{
+    ENTER();
+    int errLevel = 0;
+    Dataset* ds = StepDataset(dsName, errLevel);
+    if(NULL == ds) {
+        return errLevel;
+    }
+    if(rowIndex < 0 || rowIndex >= ds->rows) {
+        return INVALID_ROW;
+    }
+    ds->data.erase(ds->data.begin() + rowIndex * ds->slots, ds->data.begin() + (rowIndex + 1) * ds->slots);
+    ds->rows--;
+    return 0;
+}
+
+//the cell of a data step dataset, or NULL with errLevel set.
+static char* Cell(const char* dsName, long rowIndex, int columnIndex, bool numeric, const Variable** var, int& errLevel)
+{
+    Dataset* ds = StepDataset(dsName, errLevel);
+    if(NULL == ds) {
+        return NULL;
+    }
+    if(columnIndex < 0 || columnIndex >= (int)ds->vars.size()) {
+        errLevel = INVALID_INDEX;
+    } else if(rowIndex < 0 || rowIndex >= ds->rows) {
+        errLevel = INVALID_ROW;
+    } else if(numeric != (0 == ds->vars[columnIndex].type)) {
+        errLevel = WRONG_TYPE;
+    } else {
+        *var = &ds->vars[columnIndex];
+        return Value(*ds, rowIndex, **var);
+    }
+    return NULL;
+}
+
+double GetNCellValue(const char* dsName, const long rowIndex, const int columnIndex, int& isMissing, int& errLevel)
+{
+    ENTER();
+    const Variable* var = NULL;
+    char* cell = Cell(dsName, rowIndex, columnIndex, true, &var, errLevel);
+    double value = cell ? *(double*)cell : SYSMIS;
+    isMissing = SYSMIS == value ? 2 : 0;
+    return value;
+}
+
+//the value without the trailing blanks; valid until the next call.
+const char* GetCCellValue(const char* dsName, const long rowIndex, const int columnIndex, int& isMissing, int& errLevel)
+{
+    ENTER();
+    static std::string value;
+    const Variable* var = NULL;
+    char* cell = Cell(dsName, rowIndex, columnIndex, false, &var, errLevel);
+    isMissing = 0;
+    if(NULL == cell) {
+        return NULL;
+    }
+    value.assign(cell, var->type);
+    value.erase(value.find_last_not_of(' ') + 1);
+    return value.c_str();
+}
+
+int SetNCellValue(const char* dsName, const long rowIndex, const int columnIndex, const double value)
+{
+    ENTER();
+    int errLevel = 0;
+    const Variable* var = NULL;
+    char* cell = Cell(dsName, rowIndex, columnIndex, true, &var, errLevel);
+    if(cell) {
+        *(double*)cell = value;
+    }
+    return errLevel;
+}
+
+int SetCCellValue(const char* dsName, const long rowIndex, const int columnIndex, const char* value)
+{
+    ENTER();
+    int errLevel = 0;
+    const Variable* var = NULL;
+    char* cell = Cell(dsName, rowIndex, columnIndex, false, &var, errLevel);
+    if(cell) {
+        memset(cell, ' ', var->type);
+        memcpy(cell, value, std::min((int)strlen(value), var->type));
+    }
+    return errLevel;
+}
+
+//the case of GetCaseValue, read and written a cell at a time by the
+//...FromCache functions and written back by SetCasePartValue.
+static std::vector<double> caseCache;
+
+extern "C" void GetVarInfo(const char* dsName, int** varInfo, int& size)
+{
+    ENTER();
+    int errLevel = 0;
+    Dataset* ds = StepDataset(dsName, errLevel);
+    size = ds ? (int)ds->vars.size() : 0;
+    *varInfo = new int[size > 0 ? size : 1];
+    for(int i = 0; i < size; i++) {
+        (*varInfo)[i] = ds->vars[i].type;
+    }
+}
+
+void* GetCaseValue(const char* dsName, const long rowIndex, bool isCache, int& len, int& errLevel)
+{
+    ENTER();
+    errLevel = 0;
+    Dataset* ds = StepDataset(dsName, errLevel);
+    int row = (int)rowIndex;
+    if(ds && (row < 0 || row >= ds->rows)) {
+        errLevel = INVALID_ROW;
+    }
+    if(errLevel) {
+        len = 0;
+        return NULL;
+    }
+    caseCache.assign(ds->data.begin() + (long)row * ds->slots, ds->data.begin() + ((long)row + 1) * ds->slots);
+    len = ds->slots * 8;
+    return caseCache.data();
+}
+
+//the cell of the cached case, or NULL with errLevel set.
+static char* CacheCell(const char* dsName, int columnIndex, bool numeric, const Variable** var, int& errLevel)
+{
+    Dataset* ds = StepDataset(dsName, errLevel);
+    if(NULL == ds) {
+        return NULL;
+    }
+    if(columnIndex < 0 || columnIndex >= (int)ds->vars.size()) {
+        errLevel = INVALID_INDEX;
+    } else if(numeric != (0 == ds->vars[columnIndex].type)) {
+        errLevel = WRONG_TYPE;
+    } else {
+        *var = &ds->vars[columnIndex];
+        if((int)caseCache.size() != ds->slots) {
+            //a new case: SetCasePartValue without GetCaseValue first.
+            caseCache.assign(ds->slots, 0.0);
+        }
+        return (char*)&caseCache[(*var)->obs];
+    }
+    return NULL;
+}
+
+extern "C" double GetNCellValueFromCache(const char* dsName, const int columnIndex, int& isMissing, int& errLevel)
+{
+    ENTER();
+    errLevel = 0;
+    const Variable* var = NULL;
+    char* cell = CacheCell(dsName, columnIndex, true, &var, errLevel);
+    double value = cell ? *(double*)cell : SYSMIS;
+    isMissing = SYSMIS == value ? 2 : 0;
+    return value;
+}
+
+//the value without the trailing blanks, to be freed with FreeString.
+extern "C" const char* GetCCellValueFromCache(const char* dsName, const int columnIndex, int& errLevel)
+{
+    ENTER();
+    errLevel = 0;
+    const Variable* var = NULL;
+    char* cell = CacheCell(dsName, columnIndex, false, &var, errLevel);
+    std::string value;
+    if(cell) {
+        value.assign(cell, var->type);
+        value.erase(value.find_last_not_of(' ') + 1);
+    }
+    char* result = new char[value.size() + 1];
+    strcpy(result, value.c_str());
+    return result;
+}
+
+extern "C" int SetNCellValueFromCache(const char* dsName, const int columnIndex, const double value)
+{
+    ENTER();
+    int errLevel = 0;
+    const Variable* var = NULL;
+    char* cell = CacheCell(dsName, columnIndex, true, &var, errLevel);
+    if(cell) {
+        *(double*)cell = value;
+    }
+    return errLevel;
+}
+
+extern "C" int SetCCellValueFromCache(const char* dsName, const int columnIndex, const char* value)
+{
+    ENTER();
+    int errLevel = 0;
+    const Variable* var = NULL;
+    char* cell = CacheCell(dsName, columnIndex, false, &var, errLevel);
+    if(cell) {
+        memset(cell, ' ', var->type);
+        memcpy(cell, value, std::min((int)strlen(value), var->type));
+    }
+    return errLevel;
+}
+
+//copy the listed columns of the cached case to a row.
+extern "C" int SetCasePartValue(const char* dsName, const int rowIndex, int* columnIndexList, bool isCache, int size)
+{
+    ENTER();
+    int errLevel = 0;
+    Dataset* ds = StepDataset(dsName, errLevel);
+    if(NULL == ds) {
+        return errLevel;
+    }
+    if(rowIndex < 0 || rowIndex >= ds->rows) {
+        return INVALID_ROW;
+    }
+    if((int)caseCache.size() != ds->slots) {
+        return INVALID_ROW;
+    }
+    for(int i = 0; i < size; i++) {
+        int column = columnIndexList[i];
+        if(column < 0 || column >= (int)ds->vars.size()) {
+            return INVALID_INDEX;
+        }
+        const Variable& var = ds->vars[column];
+        memcpy(Value(*ds, rowIndex, var), &caseCache[var.obs], Slots(var.type) * 8);
+    }
+    return 0;
+}
+
+/************************************************************************
+ * Procedures and pivot tables
+ ************************************************************************/
+
+int StartProcedure(const char* procName, const char* translatedName)
+{
+    ENTER();
+    if(!started) {
+        return NOT_READY;
+    }
+    procedure = procName ? procName : "";
+    tables.clear();
+    textBlocks = 0;
+    return 0;
+}
+
+//write a summary of the procedure to the output.
+int EndProcedure()
+{
+    ENTER();
+    if(procedure.empty()) {
+        return NO_PROCEDURE;
+    }
+    Output("Procedure %s\n", procedure);
+    for(size_t i = 0; i < tables.size(); i++) {
+        char counts[96];
+        sprintf(counts, ": %d dimensions, %ld categories, %ld cells\n",
+                tables[i].dimensions, tables[i].categories, tables[i].cells);
+        Output("  Table %s", tables[i].title + counts);
+    }
+    procedure.clear();
+    tables.clear();
+    return 0;
+}
+
+//the pivot table of outLine and title, added if needed; NULL outside a procedure.
+static PivotTable* Table(const char* outLine, const char* title)
+{
+    if(procedure.empty()) {
+        return NULL;
+    }
+    for(size_t i = 0; i < tables.size(); i++) {
+        if(tables[i].outline == outLine && tables[i].title == title) {
+            return &tables[i];
+        }
+    }
+    PivotTable table;
+    table.outline = outLine;
+    table.title = title;
+    table.dimensions = 0;
+    table.categories = 0;
+    table.cells = 0;
+    tables.push_back(table);
+    return &tables.back();
+}
+
+int StartPivotTable(const char* outLine, const char* title, const char* templateName, bool isSplit)
+{
+    ENTER();
+    return Table(outLine, title) ? 0 : NO_PROCEDURE;
+}
+
+int HidePivotTableTitle(const char* outLine, const char* title, const char* templateName, bool isSplit)
+{
+    ENTER();
+    return Table(outLine, title) ? 0 : NO_PROCEDURE;
+}
+
+int AddDimension(const char* outLine, const char* title, const char* templateName, bool isSplit,
+                 const char* dimName, int place, int position, bool hideName, bool hideLabels)
+{
+    ENTER();
+    PivotTable* table = Table(outLine, title);
+    if(NULL == table) {
+        return NO_PROCEDURE;
+    }
+    table->dimensions++;
+    return 0;
+}
+
+int AddStringCategory(const char* outLine, const char* title, const char* templateName, bool isSplit,
+                      const char* dimName, int place, int position, bool hideName, bool hideLabels,
+                      const char* category)
+{
+    ENTER();
+    PivotTable* table = Table(outLine, title);
+    if(NULL == table) {
+        return NO_PROCEDURE;
+    }
+    table->categories++;
+    return 0;
+}
+
+int AddNumberCategory(const char* outLine, const char* title, const char* templateName, bool isSplit,
+                      const char* dimName, int place, int position, bool hideName, bool hideLabels,
+                      double category)
+{
+    ENTER();
+    PivotTable* table = Table(outLine, title);
+    if(NULL == table) {
+        return NO_PROCEDURE;
+    }
+    table->categories++;
+    return 0;
+}
+
+int AddNumberCategoryWithFormat(const char* outLine, const char* title, const char* templateName, bool isSplit,
+                                const char* dimName, int place, int position, bool hideName, bool hideLabels,
+                                double category, int formatSpec, int varIndex)
+{
+    return AddNumberCategory(outLine, title, templateName, isSplit, dimName, place, position,
+                             hideName, hideLabels, category);
+}
+
+int SetNumberCell(const char* outLine, const char* title, const char* templateName, bool isSplit,
+                  const char* dimName, int place, int position, bool hideName, bool hideLabels,
+                  double cellVal)
+{
+    ENTER();
+    PivotTable* table = Table(outLine, title);
+    if(NULL == table) {
+        return NO_PROCEDURE;
+    }
+    table->cells++;
+    return 0;
+}
+
+int SetNumberCellWithFormat(const char* outLine, const char* title, const char* templateName, bool isSplit,
+                            const char* dimName, int place, int position, bool hideName, bool hideLabels,
+                            double cellVal, int formatSpec, int varIndex)
+{
+    return SetNumberCell(outLine, title, templateName, isSplit, dimName, place, position,
+                         hideName, hideLabels, cellVal);
+}
+
+int SetStringCell(const char* outLine, const char* title, const char* templateName, bool isSplit,
+                  const char* dimName, int place, int position, bool hideName, bool hideLabels,
+                  const char* cellVal)
+{
+    return SetNumberCell(outLine, title, templateName, isSplit, dimName, place, position,
+                         hideName, hideLabels, 0.0);
+}
+
+//a category or cell named by a variable of the active dataset, or by one of its values.
+static int VariableEntry(const char* outLine, const char* title, int varIndex, bool cell)
+{
+    PivotTable* table = Table(outLine, title);
+    if(NULL == table) {
+        return NO_PROCEDURE;
+    }
+    int errLevel = 0;
+    if(NULL == ActiveVariable(varIndex, errLevel)) {
+        return errLevel;
+    }
+    if(cell) {
+        table->cells++;
+    } else {
+        table->categories++;
+    }
+    return 0;
+}
+
+int AddVarNameCategory(const char* outLine, const char* title, const char* templateName, bool isSplit,
+                       const char* dimName, int place, int position, bool hideName, bool hideLabels,
+                       int category)
+{
+    ENTER();
+    return VariableEntry(outLine, title, category, false);
+}
+
+int AddVarValueDoubleCategory(const char* outLine, const char* title, const char* templateName, bool isSplit,
+                              const char* dimName, int place, int position, bool hideName, bool hideLabels,
+                              int category, double d)
+{
+    ENTER();
+    return VariableEntry(outLine, title, category, false);
+}
+
+int AddVarValueStringCategory(const char* outLine, const char* title, const char* templateName, bool isSplit,
+                              const char* dimName, int place, int position, bool hideName, bool hideLabels,
+                              int category, const char* ch)
+{
+    ENTER();
+    return VariableEntry(outLine, title, category, false);
+}
+
+int SetVarNameCell(const char* outLine, const char* title, const char* templateName, bool isSplit,
+                   const char* dimName, int place, int position, bool hideName, bool hideLabels,
+                   int cellVal)
+{
+    ENTER();
+    return VariableEntry(outLine, title, cellVal, true);
+}
+
+int SetVarValueDoubleCell(const char* outLine, const char* title, const char* templateName, bool isSplit,
+                          const char* dimName, int place, int position, bool hideName, bool hideLabels,
+                          int cellVal, double d)
+{
+    ENTER();
+    return VariableEntry(outLine, title, cellVal, true);
+}
+
+int SetVarValueStringCell(const char* outLine, const char* title, const char* templateName, bool isSplit,
+                          const char* dimName, int place, int position, bool hideName, bool hideLabels,
+                          int cellVal, const char* ch)
+{
+    ENTER();
+    return VariableEntry(outLine, title, cellVal, true);
+}
+
+//one cell per combination of the categories of the dimensions.
+int SetNumberCells(const char* outLine, const char* title, const char* templateName, bool isSplit,
+                   int dimCount, const char* const dimNames[], const int places[], const int positions[],
+                   const bool hideNames[], const bool hideLabels[], const int categoryCounts[],
+                   const char* const categories[], const double cells[], const int formatSpecs[],
+                   const int varIndexes[])
+{
+    ENTER();
+    PivotTable* table = Table(outLine, title);
+    if(NULL == table) {
+        return NO_PROCEDURE;
+    }
+    long cellCount = 1;
+    for(int i = 0; i < dimCount; i++) {
+        table->dimensions++;
+        table->categories += categoryCounts[i];
+        cellCount *= categoryCounts[i];
+    }
+    table->cells += cellCount;
+    return 0;
+}
+
+int AddTextBlock(const char* outLine, const char* name, const char* line, int nSkip)
+{
+    ENTER();
+    if(procedure.empty()) {
+        return NO_PROCEDURE;
+    }
+    textBlocks++;
+    return 0;
+}
+
+int AddTextBlockLines(const char* outLine, const char* name, const char* const lines[],
+                      const int nSkips[], int lineCount)
+{
+    ENTER();
+    if(procedure.empty()) {
+        return NO_PROCEDURE;
+    }
+    textBlocks += lineCount;
+    return 0;
+}
+
+//the format of the next cell; the reference backend does not format cells.
+#define FORMAT_SPEC(name) \
+    int name() { ENTER(); return procedure.empty() ? NO_PROCEDURE : 0; }
+#define FORMAT_SPEC_VAR(name) \
+    int name(int varIndex) { ENTER(); return procedure.empty() ? NO_PROCEDURE : 0; }
+
+FORMAT_SPEC(SetFormatSpecCoefficient)
+FORMAT_SPEC(SetFormatSpecCoefficientSE)
+FORMAT_SPEC(SetFormatSpecCoefficientVar)
+FORMAT_SPEC(SetFormatSpecCorrelation)
+FORMAT_SPEC(SetFormatSpecGeneralStat)
+FORMAT_SPEC_VAR(SetFormatSpecMean)
+FORMAT_SPEC(SetFormatSpecCount)
+FORMAT_SPEC(SetFormatSpecPercent)
+FORMAT_SPEC(SetFormatSpecPercentNoSign)
+FORMAT_SPEC(SetFormatSpecProportion)
+FORMAT_SPEC(SetFormatSpecSignificance)
+FORMAT_SPEC(SetFormatSpecResidual)
+FORMAT_SPEC_VAR(SetFormatSpecVariable)
+FORMAT_SPEC_VAR(SetFormatSpecStdDev)
+FORMAT_SPEC_VAR(SetFormatSpecDifference)
+FORMAT_SPEC_VAR(SetFormatSpecSum)